@@ -39,7 +39,7 @@
     #define RGCONV
 #endif // defined(_WIN32)
 
-#define RG_RTGL_VERSION_API "001.006.000"
+#define RG_RTGL_VERSION_API "001.007.000"
 
 #ifdef RG_USE_SURFACE_WIN32
     #include <windows.h>
@@ -185,6 +185,7 @@ typedef enum RgStructureType
     RG_STRUCTURE_TYPE_START_FRAME_RENDER_RESOLUTION_PARAMS  = 33,
     RG_STRUCTURE_TYPE_SPAWN_FLUID_INFO                      = 34,
     RG_STRUCTURE_TYPE_START_FRAME_FLUID_PARAMS              = 35,
+    RG_STRUCTURE_TYPE_INSTANCE_JOB_SYSTEM_EXT               = 36,
 } RgStructureType;
 
 typedef enum RgTextureSwizzling
@@ -301,6 +302,28 @@ typedef struct RgInstanceCreateInfo
     float                       importedLightIntensityScaleSpot;
 } RgInstanceCreateInfo;
 
+typedef void( RGAPI_PTR* PFN_rgJobEntry )( void* pJobData );
+// Must call pfnEntry( pJobData ) exactly once, on any thread.
+// All scheduled calls must be completed before rgDestroyInstance returns.
+typedef void( RGAPI_PTR* PFN_rgScheduleJob )( PFN_rgJobEntry pfnEntry,
+                                             void*          pJobData,
+                                             void*          pUserData );
+
+// Can be linked to RgInstanceCreateInfo.
+// The library uses a job system for importing, texture loading, exporting, etc.
+typedef struct RgInstanceJobSystemEXT
+{
+    RgStructureType             sType;
+    void*                       pNext;
+    // Count of worker threads that the library creates.
+    // If 0, it is derived from the count of CPU cores.
+    uint32_t                    workerThreadCount;
+    // Optional. If not null, the library doesn't create its own worker threads,
+    // and all its jobs are passed to the host's scheduler.
+    PFN_rgScheduleJob           pfnScheduleJob;
+    void*                       pSchedulerUserData;
+} RgInstanceJobSystemEXT;
+
 typedef struct RgInterface RgInterface;
 
 typedef RgResult( RGAPI_PTR* PFN_rgCreateInstance )( const RgInstanceCreateInfo* pInfo,
@@ -696,6 +719,9 @@ typedef struct RgLightInfo
 } RgLightInfo;
 
 typedef RgResult( RGAPI_PTR* PFN_rgUploadLight)(const RgLightInfo* pInfo );
+// Same as calling rgUploadLight for each element of pInfos, but encodes the lights
+// in a batch. Preferable when there are many lights, e.g. hundreds of flickering ones.
+typedef RgResult( RGAPI_PTR* PFN_rgUploadLights)(const RgLightInfo* pInfos, uint32_t count );
 
 
 
@@ -1271,6 +1297,7 @@ typedef struct RgInterface
     PFN_rgUtilGetSupportedFeatures        rgUtilGetSupportedFeatures;
     // Additional
     PFN_rgSpawnFluid                      rgSpawnFluid;
+    PFN_rgUploadLights                    rgUploadLights;
 } RgInterface;
 
 #if defined( _WIN32 )
@@ -44,7 +44,7 @@ namespace
 }
 
 
-ASBuilder::ASBuilder( std::shared_ptr< ChunkedStackAllocator > _commonScratchBuffer )
+ASBuilder::ASBuilder( std::shared_ptr< DeviceSuballocator > _commonScratchBuffer )
     : scratchBuffer( std::move( _commonScratchBuffer ) )
 {
 }
@@ -128,7 +128,7 @@ void ASBuilder::AddBLAS( VkAccelerationStructureKHR
         .pGeometries              = geometries.data(),
         .ppGeometries             = nullptr,
         .scratchData = {
-            .deviceAddress = scratchBuffer->Push( scratchSize ).address,
+            .deviceAddress = scratchBuffer->Allocate( scratchSize ).address,
         },
     };
 
@@ -190,7 +190,7 @@ void ASBuilder::AddTLAS( VkAccelerationStructureKHR                      as,
         .pGeometries              = instance,
         .ppGeometries             = nullptr,
         .scratchData = {
-            .deviceAddress = scratchBuffer->Push( scratchSize ).address,
+            .deviceAddress = scratchBuffer->Allocate( scratchSize ).address,
         },
     };
 
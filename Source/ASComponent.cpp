@@ -36,7 +36,13 @@ VkDeviceAddress FetchASAddress( VkDevice device, VkAccelerationStructureKHR as )
 }
 
 RTGL1::ASComponent::ASComponent( VkDevice _device, const char* _debugName )
-    : device{ _device }, as{ VK_NULL_HANDLE }, asSize{ 0 }, asAddress{ 0 }, debugName{ _debugName }
+    : device{ _device }
+    , as{ VK_NULL_HANDLE }
+    , asSize{ 0 }
+    , asAddress{ 0 }
+    , memoryOwner{ nullptr }
+    , memory{}
+    , debugName{ _debugName }
 {
 }
 
@@ -82,28 +88,27 @@ void RTGL1::ASComponent::DestroyAS()
     }
     asSize = 0;
     asAddress = 0;
+
+    if( memoryOwner )
+    {
+        memoryOwner->Free( memory );
+        memoryOwner = nullptr;
+    }
 }
 
 bool RTGL1::ASComponent::RecreateIfNotValid(
-    const VkAccelerationStructureBuildSizesInfoKHR& buildSizes,
-    ChunkedStackAllocator&                          allocator,
-    bool                                            resetAllocOnCreate )
+    const VkAccelerationStructureBuildSizesInfoKHR& buildSizes, DeviceSuballocator& allocator )
 {
     if( !as || asSize < buildSizes.accelerationStructureSize )
     {
-        // destroy
+        // destroy, and free its memory range
         DestroyAS();
 
-        if( resetAllocOnCreate )
-        {
-            allocator.Reset();
-        }
-
         // get range in common buffer, and create
-        const auto allocation = allocator.Push( buildSizes.accelerationStructureSize );
+        memory      = allocator.Allocate( buildSizes.accelerationStructureSize );
+        memoryOwner = &allocator;
 
-        as = CreateAS(
-            allocation.buffer, allocation.offsetInBuffer, buildSizes.accelerationStructureSize );
+        as = CreateAS( memory.buffer, memory.offsetInBuffer, buildSizes.accelerationStructureSize );
         asSize = buildSizes.accelerationStructureSize;
         asAddress = FetchASAddress( device, as );
 
@@ -42,9 +42,9 @@ public:
     ASComponent& operator=( const ASComponent& other )     = delete;
     ASComponent& operator=( ASComponent&& other ) noexcept = delete;
 
+    // If recreated, previous memory range is returned to its allocator
     bool RecreateIfNotValid( const VkAccelerationStructureBuildSizesInfoKHR& buildSizes,
-                             ChunkedStackAllocator&                          allocator,
-                             bool                                            resetAllocOnCreate = false );
+                             DeviceSuballocator&                             allocator );
 
     [[nodiscard]] VkAccelerationStructureKHR GetAS() const
     {
@@ -72,6 +72,9 @@ protected:
     VkDeviceSize               asSize;
     VkDeviceSize               asAddress;
 
+    DeviceSuballocator*            memoryOwner;
+    DeviceSuballocator::Allocation memory;
+
     const char* debugName;
 };
 
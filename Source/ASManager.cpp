@@ -24,6 +24,7 @@
 #include "DrawFrameInfo.h"
 #include "Fluid.h"
 #include "GeomInfoManager.h"
+#include "LibraryConfig.h"
 #include "Matrix.h"
 #include "Utils.h"
 
@@ -60,6 +61,8 @@ RTGL1::ASManager::ASManager( VkDevice                                _device,
                              std::shared_ptr< MemoryAllocator >      _allocator,
                              std::shared_ptr< CommandBufferManager > _cmdManager,
                              std::shared_ptr< GeomInfoManager >      _geomInfoManager,
+                             std::shared_ptr< JobSystem >            _jobSystem,
+                             std::shared_ptr< FrameArenas >          _frameArenas,
                              uint64_t                                _maxReplacementsVerts,
                              uint64_t                                _maxDynamicVerts,
                              bool                                    _enableTexCoordLayer1,
@@ -70,6 +73,7 @@ RTGL1::ASManager::ASManager( VkDevice                                _device,
     , staticCopyFence( VK_NULL_HANDLE )
     , cmdManager( std::move( _cmdManager ) )
     , geomInfoMgr( std::move( _geomInfoManager ) )
+    , frameArenas( std::move( _frameArenas ) )
     , descPool( VK_NULL_HANDLE )
     , buffersDescSetLayout( VK_NULL_HANDLE )
     , buffersDescSets{}
@@ -85,11 +89,12 @@ RTGL1::ASManager::ASManager( VkDevice                                _device,
         const uint32_t scratchOffsetAligment =
             _physDevice.GetASProperties().minAccelerationStructureScratchOffsetAlignment;
 
-        scratchBuffer = std::make_shared< ChunkedStackAllocator >(
+        scratchBuffer = std::make_shared< DeviceSuballocator >(
             allocator,
             VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
             32 * 1024 * 1024,
             scratchOffsetAligment,
+            DeviceSuballocator::Strategy::Linear,
             "Scratch buffer" );
 
         asBuilder = std::make_unique< ASBuilder >( scratchBuffer );
@@ -101,26 +106,48 @@ RTGL1::ASManager::ASManager( VkDevice                                _device,
                                VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT |
                                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
 
-        allocStaticGeom = std::make_unique< ChunkedStackAllocator >(
-            allocator, usage, 16 * 1024 * 1024, asAlignment, "BLAS common buffer for static" );
+        using Strategy = DeviceSuballocator::Strategy;
+
+        allocStaticGeom = std::make_unique< DeviceSuballocator >( allocator,
+                                                                  usage,
+                                                                  16 * 1024 * 1024,
+                                                                  asAlignment,
+                                                                  Strategy::General,
+                                                                  "BLAS common buffer for static" );
 
         allocReplacementsGeom =
-            std::make_unique< ChunkedStackAllocator >( allocator,
-                                                       usage,
-                                                       64 * 1024 * 1024,
-                                                       asAlignment,
-                                                       "BLAS common buffer for replacements" );
+            std::make_unique< DeviceSuballocator >( allocator,
+                                                    usage,
+                                                    64 * 1024 * 1024,
+                                                    asAlignment,
+                                                    Strategy::General,
+                                                    "BLAS common buffer for replacements" );
 
         for( uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++ )
         {
-            allocDynamicGeom[ i ] = std::make_unique< ChunkedStackAllocator >(
-                allocator, usage, 16 * 1024 * 1024, asAlignment, "BLAS common buffer for dynamic" );
-
-            allocTlas[ i ] = std::make_unique< ChunkedStackAllocator >(
-                allocator, usage, 16 * 1024 * 1024, asAlignment, "TLAS common buffer" );
+            allocDynamicGeom[ i ] =
+                std::make_unique< DeviceSuballocator >( allocator,
+                                                        usage,
+                                                        16 * 1024 * 1024,
+                                                        asAlignment,
+                                                        Strategy::Linear,
+                                                        "BLAS common buffer for dynamic" );
+
+            // TLAS is recreated only when it grows, so the previous range is freed
+            allocTlas[ i ] = std::make_unique< DeviceSuballocator >( allocator,
+                                                                     usage,
+                                                                     16 * 1024 * 1024,
+                                                                     asAlignment,
+                                                                     Strategy::General,
+                                                                     "TLAS common buffer" );
         }
     }
 
+    stagingCopier =
+        std::make_shared< StagingCopier >( std::move( _jobSystem ),
+                                           LibConfig().stagingCopyWorkerCount,
+                                           size_t{ LibConfig().stagingCopyThresholdKB } * 1024 );
+
     _maxReplacementsVerts = _maxReplacementsVerts > 0 ? _maxReplacementsVerts : 2097152;
     {
         const size_t maxVertsPerLayer[] = {
@@ -132,7 +159,7 @@ RTGL1::ASManager::ASManager( VkDevice                                _device,
         const size_t maxIndices = _maxReplacementsVerts * 3;
 
         collectorStatic = std::make_unique< VertexCollector >(
-            device, *allocator, maxVertsPerLayer, maxIndices, false, "Static" );
+            device, *allocator, stagingCopier, maxVertsPerLayer, maxIndices, false, "Static" );
     }
 
     _maxDynamicVerts = _maxDynamicVerts > 0 ? _maxDynamicVerts : 2097152;
@@ -146,7 +173,7 @@ RTGL1::ASManager::ASManager( VkDevice                                _device,
         const size_t maxIndices = _maxDynamicVerts * 3;
 
         collectorDynamic[ 0 ] = std::make_unique< VertexCollector >(
-            device, *allocator, maxVertsPerLayer, maxIndices, true, "Dynamic 0" );
+            device, *allocator, stagingCopier, maxVertsPerLayer, maxIndices, true, "Dynamic 0" );
 
         // share device-local buffer with 0
         collectorDynamic[ 1 ] = VertexCollector::CreateWithSameDeviceLocalBuffers(
@@ -170,7 +197,7 @@ RTGL1::ASManager::ASManager( VkDevice                                _device,
 
 
     // instance buffer for TLAS
-    instanceBuffer = std::make_unique< AutoBuffer >( allocator );
+    instanceBuffer = std::make_unique< AutoBuffer >( allocator, AutoBuffer::Staging::PerFrame );
 
     constexpr VkDeviceSize instanceBufferSize =
         MAX_INSTANCE_COUNT * sizeof( VkAccelerationStructureInstanceKHR );
@@ -659,11 +686,12 @@ RTGL1::StaticGeometryToken RTGL1::ASManager::BeginStaticGeometry( bool freeRepla
         builtReplacements.clear();
     }
 
-    // free AS memory
-    allocStaticGeom->Reset();
+    // AS memory ranges were returned to the allocators by destructors,
+    // give back chunks that became unused
+    allocStaticGeom->ReleaseEmptyChunks();
     if( freeReplacements )
     {
-        allocReplacementsGeom->Reset();
+        allocReplacementsGeom->ReleaseEmptyChunks();
     }
 
     erase_if( curFrame_objects, []( const Object& o ) { return o.isStatic; } );
@@ -737,8 +765,7 @@ RTGL1::DynamicGeometryToken RTGL1::ASManager::BeginDynamicGeometry( VkCommandBuf
 
     // dynamic vertices are refilled each frame
     collectorDynamic[ frameIndex ]->Reset( nullptr );
-    // destroy dynamic instances from N-2
-    builtDynamicInstances[ frameIndex ].clear();
+    // dynamic instances from N-2 were destroyed with the frame arena
     allocDynamicGeom[ frameIndex ]->Reset();
 
     erase_if( curFrame_objects, []( const Object& o ) { return !o.isStatic; } );
@@ -750,8 +777,9 @@ RTGL1::DynamicGeometryToken RTGL1::ASManager::BeginDynamicGeometry( VkCommandBuf
 auto RTGL1::ASManager::UploadAndBuildAS( const RgMeshPrimitiveInfo&     primitive,
                                          VertexCollectorFilterTypeFlags geomFlags,
                                          VertexCollector&               vertexAlloc,
-                                         ChunkedStackAllocator&         accelStructAlloc,
-                                         const bool isDynamic ) -> std::unique_ptr< BuiltAS >
+                                         DeviceSuballocator&            accelStructAlloc,
+                                         const bool                     isDynamic,
+                                         FrameArena*                    frameArena ) -> BuiltAS*
 {
     auto uploadedData = vertexAlloc.Upload( geomFlags, primitive );
     if( !uploadedData )
@@ -759,13 +787,10 @@ auto RTGL1::ASManager::UploadAndBuildAS( const RgMeshPrimitiveInfo&     primitiv
         return {};
     }
 
-    // NOTE: dedicated allocation, so pointers in asBuilder
+    // NOTE: stable address, so pointers in asBuilder
     //       are valid until end of the frame
-    auto newlyBuilt = new BuiltAS{
-        .flags    = geomFlags,
-        .blas     = BLASComponent{ device },
-        .geometry = *uploadedData,
-    };
+    auto newlyBuilt = frameArena ? frameArena->New< BuiltAS >( device, geomFlags, *uploadedData )
+                                 : new BuiltAS{ device, geomFlags, *uploadedData };
     {
         const bool fastTrace = isDynamic ? false : true;
 
@@ -786,7 +811,7 @@ auto RTGL1::ASManager::UploadAndBuildAS( const RgMeshPrimitiveInfo&     primitiv
                             false,
                             false );
     }
-    return std::unique_ptr< BuiltAS >{ newlyBuilt };
+    return newlyBuilt;
 }
 
 bool RTGL1::ASManager::AddMeshPrimitive( uint32_t                   frameIndex,
@@ -851,21 +876,29 @@ bool RTGL1::ASManager::AddMeshPrimitive( uint32_t                   frameIndex,
             return false;
         }
 
-        std ::unique_ptr< BuiltAS > created =
-            UploadAndBuildAS( primitive,
-                              geomFlags,
-                              isStatic ? *collectorStatic : *collectorDynamic[ frameIndex ],
-                              isStatic ? *allocStaticGeom : *( allocDynamicGeom[ frameIndex ] ),
-                              !isStatic );
-        builtInstance = created.get();
-
         if( isStatic )
         {
-            builtStaticInstances.push_back( std::move( created ) );
+            builtInstance = UploadAndBuildAS(
+                primitive, geomFlags, *collectorStatic, *allocStaticGeom, false, nullptr );
+
+            if( builtInstance )
+            {
+                builtStaticInstances.emplace_back( builtInstance );
+            }
         }
         else
         {
-            builtDynamicInstances[ frameIndex ].push_back( std::move( created ) );
+            builtInstance = UploadAndBuildAS( primitive,
+                                              geomFlags,
+                                              *collectorDynamic[ frameIndex ],
+                                              *allocDynamicGeom[ frameIndex ],
+                                              true,
+                                              &frameArenas->Get( frameIndex ) );
+        }
+
+        if( !builtInstance )
+        {
+            return false;
         }
     }
 
@@ -987,8 +1020,8 @@ void RTGL1::ASManager::CacheReplacement( std::string_view           meshName,
     const auto geomFlags =
         VertexCollectorFilterTypeFlags_GetForGeometry( {}, primitive, isStatic, isReplacement );
 
-    std::unique_ptr< BuiltAS > builtInstance = UploadAndBuildAS(
-        primitive, geomFlags, *collectorStatic, *allocReplacementsGeom, isDynamic );
+    auto builtInstance = std::unique_ptr< BuiltAS >{ UploadAndBuildAS(
+        primitive, geomFlags, *collectorStatic, *allocReplacementsGeom, isDynamic, nullptr ) };
 
     if( !builtInstance )
     {
@@ -1147,18 +1180,18 @@ auto RTGL1::ASManager::MakeVkTLAS( const BuiltAS&                 builtAS,
 }
 
 
-auto RTGL1::ASManager::MakeUniqueIDToTlasID( bool disableRTGeometry ) const -> UniqueIDToTlasID
+void RTGL1::ASManager::MakeUniqueIDToTlasID( bool disableRTGeometry, UniqueIDToTlasID& dst ) const
 {
-    auto all = UniqueIDToTlasID{};
+    // keeps the allocated memory
+    dst.clear();
     if( !disableRTGeometry )
     {
-        all.reserve( curFrame_objects.size() );
+        dst.reserve( curFrame_objects.size() );
         for( uint32_t i = 0; i < curFrame_objects.size(); i++ )
         {
-            all[ curFrame_objects[ i ].uniqueID ] = i;
+            dst[ curFrame_objects[ i ].uniqueID ] = i;
         }
     }
-    return all;
 }
 
 void RTGL1::ASManager::BuildTLAS( VkCommandBuffer cmd,
@@ -1169,7 +1202,8 @@ void RTGL1::ASManager::BuildTLAS( VkCommandBuffer cmd,
     auto label = CmdLabel{ cmd, "Building TLAS" };
 
 
-    auto allVkTlas = std::vector< VkAccelerationStructureInstanceKHR >{};
+    auto allVkTlas =
+        FrameVector< VkAccelerationStructureInstanceKHR >{ &frameArenas->Get( frameIndex ) };
     if( !disableRTGeometry )
     {
         allVkTlas.reserve( curFrame_objects.size() );
@@ -1192,20 +1226,27 @@ void RTGL1::ASManager::BuildTLAS( VkCommandBuffer cmd,
             allVkTlas.push_back( *vkTlas );
         }
     }
-    assert( MakeUniqueIDToTlasID( disableRTGeometry ).size() == allVkTlas.size() );
+#ifndef NDEBUG
+    {
+        auto check = UniqueIDToTlasID{};
+        MakeUniqueIDToTlasID( disableRTGeometry, check );
+        assert( check.size() == allVkTlas.size() );
+    }
+#endif
 
 
     if( !allVkTlas.empty() )
     {
-        // fill buffer
-        auto mapped =
-            instanceBuffer->GetMappedAs< VkAccelerationStructureInstanceKHR* >( frameIndex );
+        const VkDeviceSize instancesSize =
+            allVkTlas.size() * sizeof( VkAccelerationStructureInstanceKHR );
+
+        // fill buffer, only the instances of this frame take space in the upload ring
+        auto mapped = instanceBuffer->GetMappedAs< VkAccelerationStructureInstanceKHR* >(
+            frameIndex, instancesSize );
 
-        memcpy( mapped,
-                allVkTlas.data(),
-                allVkTlas.size() * sizeof( VkAccelerationStructureInstanceKHR ) );
+        memcpy( mapped, allVkTlas.data(), instancesSize );
 
-        instanceBuffer->CopyFromStaging( cmd, frameIndex );
+        instanceBuffer->CopyFromStaging( cmd, frameIndex, instancesSize );
     }
 
 
@@ -1239,7 +1280,7 @@ void RTGL1::ASManager::BuildTLAS( VkCommandBuffer cmd,
             device, instGeom, static_cast< uint32_t >( allVkTlas.size() ), fastTrace );
 
         // if previous buffer's size is not enough
-        tlasWasRecreated = curTlas->RecreateIfNotValid( buildSizes, *( allocTlas[ frameIndex ] ), true );
+        tlasWasRecreated = curTlas->RecreateIfNotValid( buildSizes, *( allocTlas[ frameIndex ] ) );
 
         // ASBuilder requires 'instGeom', 'range' to be alive
         assert( asBuilder->IsEmpty() );
@@ -1343,3 +1384,18 @@ VkDescriptorSetLayout RTGL1::ASManager::GetTLASDescSetLayout() const
 {
     return asDescSetLayout;
 }
+
+auto RTGL1::ASManager::GetBLASMemoryStatistics() const -> DeviceSuballocator::Statistics
+{
+    const auto a = allocStaticGeom->GetStatistics();
+    const auto b = allocReplacementsGeom->GetStatistics();
+
+    return DeviceSuballocator::Statistics{
+        .capacity         = a.capacity + b.capacity,
+        .used             = a.used + b.used,
+        .largestFreeRange = std::max( a.largestFreeRange, b.largestFreeRange ),
+        .chunkCount       = a.chunkCount + b.chunkCount,
+        .allocationCount  = a.allocationCount + b.allocationCount,
+        .freeRangeCount   = a.freeRangeCount + b.freeRangeCount,
+    };
+}
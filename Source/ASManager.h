@@ -22,6 +22,7 @@
 
 #include "ASBuilder.h"
 #include "CommandBufferManager.h"
+#include "FrameArena.h"
 #include "GlobalUniform.h"
 #include "ScratchBuffer.h"
 #include "TextureManager.h"
@@ -41,6 +42,8 @@ public:
                std::shared_ptr< MemoryAllocator >      allocator,
                std::shared_ptr< CommandBufferManager > cmdManager,
                std::shared_ptr< GeomInfoManager >      geomInfoManager,
+               std::shared_ptr< JobSystem >            jobSystem,
+               std::shared_ptr< FrameArenas >          frameArenas,
                uint64_t                                maxReplacementsVerts,
                uint64_t                                maxDynamicVerts,
                bool                                    enableTexCoordLayer1,
@@ -88,7 +91,7 @@ public:
                            uint32_t                   index );
 
 
-    auto MakeUniqueIDToTlasID( bool disableRTGeometry ) const -> UniqueIDToTlasID;
+    void MakeUniqueIDToTlasID( bool disableRTGeometry, UniqueIDToTlasID& dst ) const;
     void BuildTLAS( VkCommandBuffer cmd,
                     uint32_t        frameIndex,
                     uint32_t        uniformData_rayCullMaskWorld,
@@ -110,6 +113,9 @@ public:
     VkDescriptorSetLayout GetBuffersDescSetLayout() const;
     VkDescriptorSetLayout GetTLASDescSetLayout() const;
 
+    // Memory of static and replacement BLAS-es
+    auto GetBLASMemoryStatistics() const -> DeviceSuballocator::Statistics;
+
 private:
     void CreateDescriptors();
     void UpdateBufferDescriptors( uint32_t frameIndex );
@@ -117,16 +123,25 @@ private:
 
     struct BuiltAS
     {
+        BuiltAS( VkDevice                             _device,
+                 VertexCollectorFilterTypeFlags       _flags,
+                 const VertexCollector::UploadResult& _geometry )
+            : flags{ _flags }, blas{ _device }, geometry{ _geometry }
+        {
+        }
+
         VertexCollectorFilterTypeFlags flags;
         BLASComponent                  blas;
         VertexCollector::UploadResult  geometry;
     };
 
+    // If frameArena is not null, the result is owned by it, otherwise by the caller
     auto UploadAndBuildAS( const RgMeshPrimitiveInfo&     primitive,
                            VertexCollectorFilterTypeFlags geomFlags,
                            VertexCollector&               vertexAlloc,
-                           ChunkedStackAllocator&         accelStructAlloc,
-                           const bool                     isDynamic ) -> std::unique_ptr< BuiltAS >;
+                           DeviceSuballocator&            accelStructAlloc,
+                           const bool                     isDynamic,
+                           FrameArena*                    frameArena ) -> BuiltAS*;
 
     static auto MakeVkTLAS( const BuiltAS&                 builtAS,
                             uint32_t                       rayCullMaskWorld,
@@ -148,22 +163,25 @@ private:
     Buffer                             previousDynamicIndices;
     VertexCollector::CopyRanges        collectorStatic_replacements{};
 
+    std::shared_ptr< StagingCopier > stagingCopier;
+    // dynamic instances are destroyed with the arena of their frame
+    std::shared_ptr< FrameArenas >   frameArenas;
+
     // building
-    std::shared_ptr< ChunkedStackAllocator > scratchBuffer;
-    std::unique_ptr< ASBuilder >             asBuilder;
+    std::shared_ptr< DeviceSuballocator > scratchBuffer;
+    std::unique_ptr< ASBuilder >          asBuilder;
 
     std::shared_ptr< CommandBufferManager > cmdManager;
     std::shared_ptr< TextureManager >       textureMgr;
     std::shared_ptr< GeomInfoManager >      geomInfoMgr;
 
-    std::unique_ptr< ChunkedStackAllocator > allocTlas[ MAX_FRAMES_IN_FLIGHT ];
-    std::unique_ptr< ChunkedStackAllocator > allocReplacementsGeom;
-    std::unique_ptr< ChunkedStackAllocator > allocStaticGeom;
-    std::unique_ptr< ChunkedStackAllocator > allocDynamicGeom[ MAX_FRAMES_IN_FLIGHT ];
+    std::unique_ptr< DeviceSuballocator > allocTlas[ MAX_FRAMES_IN_FLIGHT ];
+    std::unique_ptr< DeviceSuballocator > allocReplacementsGeom;
+    std::unique_ptr< DeviceSuballocator > allocStaticGeom;
+    std::unique_ptr< DeviceSuballocator > allocDynamicGeom[ MAX_FRAMES_IN_FLIGHT ];
 
     rgl::string_map< std::vector< std::unique_ptr< BuiltAS > > > builtReplacements;
     std::vector< std::unique_ptr< BuiltAS > >                    builtStaticInstances;
-    std::vector< std::unique_ptr< BuiltAS > > builtDynamicInstances[ MAX_FRAMES_IN_FLIGHT ];
 
     // Exists only in the current frame
     struct Object
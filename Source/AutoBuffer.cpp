@@ -20,8 +20,12 @@
 
 #include "AutoBuffer.h"
 
-RTGL1::AutoBuffer::AutoBuffer( std::shared_ptr< MemoryAllocator > _allocator )
-    : allocator( std::move( _allocator ) ), mapped{}
+#include "DebugPrint.h"
+#include "UploadRing.h"
+
+RTGL1::AutoBuffer::AutoBuffer( std::shared_ptr< MemoryAllocator > _allocator,
+                               Staging                            _stagingType )
+    : allocator( std::move( _allocator ) ), stagingType( _stagingType ), mapped{}
 {
 }
 
@@ -36,23 +40,6 @@ void RTGL1::AutoBuffer::Create( VkDeviceSize       size,
                                 uint32_t           frameCount )
 {
     assert( frameCount > 0 && frameCount <= MAX_FRAMES_IN_FLIGHT );
-
-    const std::string debugNameStaging = debugName + " - staging";
-
-    for( uint32_t i = 0; i < frameCount; i++ )
-    {
-        assert( !staging[ i ].IsInitted() );
-
-        staging[ i ].Init( *allocator,
-                           size,
-                           VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                           VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                               VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                           debugNameStaging.c_str() );
-
-        mapped[ i ] = staging[ i ].Map();
-    }
-
     assert( !deviceLocal.IsInitted() );
 
     deviceLocal.Init( *allocator,
@@ -60,6 +47,31 @@ void RTGL1::AutoBuffer::Create( VkDeviceSize       size,
                       usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
                       VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
                       debugName.c_str() );
+
+    debugNameStaging = debugName + " - staging";
+
+    // per-frame staging is taken from the upload ring, when it's written
+    if( stagingType == Staging::Dedicated )
+    {
+        for( uint32_t i = 0; i < frameCount; i++ )
+        {
+            CreateDedicatedStaging( i );
+        }
+    }
+}
+
+void RTGL1::AutoBuffer::CreateDedicatedStaging( uint32_t frameIndex )
+{
+    assert( !staging[ frameIndex ].IsInitted() );
+
+    staging[ frameIndex ].Init( *allocator,
+                                deviceLocal.GetSize(),
+                                VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                    VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                debugNameStaging.c_str() );
+
+    mapped[ frameIndex ] = staging[ frameIndex ].Map();
 }
 
 void RTGL1::AutoBuffer::Destroy()
@@ -72,11 +84,11 @@ void RTGL1::AutoBuffer::Destroy()
             staging[ i ].Destroy();
         }
 
-        mapped[ i ] = nullptr;
+        mapped[ i ]     = nullptr;
+        ringRegion[ i ] = {};
     }
 
     if( deviceLocal.IsInitted() )
-        ;
     {
         deviceLocal.Destroy();
     }
@@ -88,7 +100,6 @@ void RTGL1::AutoBuffer::CopyFromStaging( VkCommandBuffer cmd,
                                          VkDeviceSize    offset )
 {
     assert( frameIndex < MAX_FRAMES_IN_FLIGHT );
-    assert( staging[ frameIndex ].GetSize() == deviceLocal.GetSize() );
 
     if( size == VK_WHOLE_SIZE )
     {
@@ -96,7 +107,6 @@ void RTGL1::AutoBuffer::CopyFromStaging( VkCommandBuffer cmd,
     }
     else
     {
-        assert( offset + size <= staging[ frameIndex ].GetSize() );
         assert( offset + size <= deviceLocal.GetSize() );
     }
 
@@ -105,13 +115,20 @@ void RTGL1::AutoBuffer::CopyFromStaging( VkCommandBuffer cmd,
         return;
     }
 
+    VkBuffer     src;
+    VkDeviceSize srcBase;
+    if( !GetStagingSource( frameIndex, offset + size, &src, &srcBase ) )
+    {
+        return;
+    }
+
     VkBufferCopy info = {
-        .srcOffset = offset,
+        .srcOffset = srcBase + offset,
         .dstOffset = offset,
         .size      = size,
     };
 
-    vkCmdCopyBuffer( cmd, staging[ frameIndex ].GetBuffer(), deviceLocal.GetBuffer(), 1, &info );
+    vkCmdCopyBuffer( cmd, src, deviceLocal.GetBuffer(), 1, &info );
 
     // TODO: remove a barrier kludge
     VkBufferMemoryBarrier barrier = {
@@ -143,60 +160,179 @@ void RTGL1::AutoBuffer::CopyFromStaging( VkCommandBuffer     cmd,
                                          uint32_t            copyInfosCount )
 {
     assert( frameIndex < MAX_FRAMES_IN_FLIGHT );
-    assert( staging[ frameIndex ].GetSize() == deviceLocal.GetSize() );
 
     if( copyInfosCount == 0 )
     {
         return;
     }
 
-    vkCmdCopyBuffer( cmd,
-                     staging[ frameIndex ].GetBuffer(),
-                     deviceLocal.GetBuffer(),
-                     copyInfosCount,
-                     copyInfos );
+    tempCopies.clear();
+    tempBarriers.clear();
 
-    // TODO: remove a barrier kludge
     for( uint32_t i = 0; i < copyInfosCount; ++i )
     {
-        VkBufferMemoryBarrier barrier = {
+        const VkBufferCopy& c = copyInfos[ i ];
+
+        assert( c.dstOffset + c.size <= deviceLocal.GetSize() );
+
+        if( c.size == 0 )
+        {
+            continue;
+        }
+
+        // merge with the previous one, if contiguous in both buffers
+        if( !tempCopies.empty() )
+        {
+            VkBufferCopy& prev = tempCopies.back();
+
+            if( prev.srcOffset + prev.size == c.srcOffset &&
+                prev.dstOffset + prev.size == c.dstOffset )
+            {
+                prev.size += c.size;
+                continue;
+            }
+        }
+
+        tempCopies.push_back( c );
+    }
+
+    if( tempCopies.empty() )
+    {
+        return;
+    }
+
+    VkDeviceSize copyEnd = 0;
+    for( const VkBufferCopy& c : tempCopies )
+    {
+        copyEnd = std::max( copyEnd, c.srcOffset + c.size );
+    }
+
+    VkBuffer     src;
+    VkDeviceSize srcBase;
+    if( !GetStagingSource( frameIndex, copyEnd, &src, &srcBase ) )
+    {
+        return;
+    }
+
+    for( VkBufferCopy& c : tempCopies )
+    {
+        c.srcOffset += srcBase;
+
+        tempBarriers.push_back( VkBufferMemoryBarrier{
             .sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
             .srcAccessMask       = VK_ACCESS_MEMORY_WRITE_BIT,
             .dstAccessMask       = VK_ACCESS_MEMORY_READ_BIT,
             .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
             .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
             .buffer              = deviceLocal.GetBuffer(),
-            .offset              = copyInfos[ i ].dstOffset,
-            .size                = copyInfos[ i ].size,
-        };
-
-        vkCmdPipelineBarrier( cmd,
-                              VK_PIPELINE_STAGE_TRANSFER_BIT,
-                              VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-                              0,
-                              0,
-                              nullptr,
-                              1,
-                              &barrier,
-                              0,
-                              nullptr );
+            .offset              = c.dstOffset,
+            .size                = c.size,
+        } );
     }
+
+    vkCmdCopyBuffer( cmd,
+                     src,
+                     deviceLocal.GetBuffer(),
+                     uint32_t( tempCopies.size() ),
+                     tempCopies.data() );
+
+    // TODO: remove a barrier kludge
+    vkCmdPipelineBarrier( cmd,
+                          VK_PIPELINE_STAGE_TRANSFER_BIT,
+                          VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                          0,
+                          0,
+                          nullptr,
+                          uint32_t( tempBarriers.size() ),
+                          tempBarriers.data(),
+                          0,
+                          nullptr );
 }
 
-void* RTGL1::AutoBuffer::GetMapped( uint32_t frameIndex )
+void* RTGL1::AutoBuffer::GetMapped( uint32_t frameIndex, VkDeviceSize size )
 {
     assert( frameIndex < MAX_FRAMES_IN_FLIGHT );
-    assert( staging[ frameIndex ].IsMapped() );
 
+    if( staging[ frameIndex ].IsInitted() )
+    {
+        assert( staging[ frameIndex ].IsMapped() );
+        return mapped[ frameIndex ];
+    }
+    assert( stagingType == Staging::PerFrame );
+
+    if( size == VK_WHOLE_SIZE )
+    {
+        size = deviceLocal.GetSize();
+    }
+    assert( size <= deviceLocal.GetSize() );
+
+    UploadRing& ring   = allocator->GetUploadRing();
+    RingRegion& region = ringRegion[ frameIndex ];
+
+    const bool ofThisFrame = ( region.frameId == ring.GetFrameId() );
+    if( ofThisFrame && size <= region.size )
+    {
+        return mapped[ frameIndex ];
+    }
+
+    // the old region is still valid until the end of the frame
+    const VkDeviceSize toKeep = ofThisFrame ? region.size : 0;
+    void*              prev   = mapped[ frameIndex ];
+
+    if( auto r = ring.Allocate( size ) )
+    {
+        region = RingRegion{
+            .frameId = ring.GetFrameId(),
+            .offset  = r->offset,
+            .size    = size,
+        };
+        mapped[ frameIndex ] = r->mapped;
+    }
+    else
+    {
+        debug::Verbose( "Upload ring is full ({} / {} KB), allocating dedicated staging for {}",
+                        ring.GetUsedBytes() / 1024,
+                        ring.GetCapacity() / 1024,
+                        debugNameStaging );
+
+        region = {};
+        CreateDedicatedStaging( frameIndex );
+    }
+
+    if( toKeep > 0 )
+    {
+        memcpy( mapped[ frameIndex ], prev, toKeep );
+    }
     return mapped[ frameIndex ];
 }
 
-VkBuffer RTGL1::AutoBuffer::GetStaging( uint32_t frameIndex )
+bool RTGL1::AutoBuffer::GetStagingSource( uint32_t      frameIndex,
+                                          VkDeviceSize  copyEnd,
+                                          VkBuffer*     outBuffer,
+                                          VkDeviceSize* outOffset )
 {
-    assert( frameIndex < MAX_FRAMES_IN_FLIGHT );
-    assert( staging[ frameIndex ].IsInitted() );
+    if( staging[ frameIndex ].IsInitted() )
+    {
+        assert( copyEnd <= staging[ frameIndex ].GetSize() );
+
+        *outBuffer = staging[ frameIndex ].GetBuffer();
+        *outOffset = 0;
+        return true;
+    }
+
+    const UploadRing& ring   = allocator->GetUploadRing();
+    const RingRegion& region = ringRegion[ frameIndex ];
 
-    return staging[ frameIndex ].GetBuffer();
+    // GetMapped wasn't called in this frame
+    if( region.frameId != ring.GetFrameId() )
+    {
+        return false;
+    }
+    assert( copyEnd <= region.size );
+
+    *outBuffer = ring.GetBuffer();
+    *outOffset = region.offset;
+    return true;
 }
 
 VkBuffer RTGL1::AutoBuffer::GetDeviceLocal()
@@ -212,10 +348,5 @@ VkDeviceAddress RTGL1::AutoBuffer::GetDeviceAddress()
 
 VkDeviceSize RTGL1::AutoBuffer::GetSize() const
 {
-    for(const auto& i : staging)
-    {
-        assert( deviceLocal.GetSize() == i.GetSize() );
-    }
-
     return deviceLocal.GetSize();
 }
@@ -31,7 +31,19 @@ namespace RTGL1
 class AutoBuffer
 {
 public:
-    explicit AutoBuffer( std::shared_ptr< MemoryAllocator > allocator );
+    enum class Staging
+    {
+        // Staging buffer per frame in flight, its contents persist between frames,
+        // so it can be updated partially
+        Dedicated,
+        // Staging is taken from the shared upload ring on the first GetMapped of a frame,
+        // so it must be written and copied in the same frame, and only on the frame thread
+        PerFrame,
+    };
+
+public:
+    explicit AutoBuffer( std::shared_ptr< MemoryAllocator > allocator,
+                         Staging                            stagingType = Staging::Dedicated );
     ~AutoBuffer();
 
     AutoBuffer( const AutoBuffer& other )     = delete;
@@ -54,8 +66,9 @@ public:
                                      const VkBufferCopy* copyInfos,
                                      uint32_t            copyInfosCount );
 
-    VkBuffer        GetStaging( uint32_t frameIndex );
-    void*           GetMapped( uint32_t frameIndex );
+    // If Staging::PerFrame, the first call in a frame takes 'size' bytes from the start
+    // of the buffer; a later call with a larger size moves the written data
+    void*           GetMapped( uint32_t frameIndex, VkDeviceSize size = VK_WHOLE_SIZE );
 
     VkBuffer        GetDeviceLocal();
     VkDeviceAddress GetDeviceAddress();
@@ -65,18 +78,40 @@ public:
 public:
     template< typename T >
     requires( std::is_pointer_v< T > )
-    T GetMappedAs( uint32_t frameIndex )
+    T GetMappedAs( uint32_t frameIndex, VkDeviceSize size = VK_WHOLE_SIZE )
     {
-        return static_cast< T >( GetMapped( frameIndex ) );
+        return static_cast< T >( GetMapped( frameIndex, size ) );
     }
 
+private:
+    void CreateDedicatedStaging( uint32_t frameIndex );
+    // Returns false, if nothing was written to the staging of the frame
+    bool GetStagingSource( uint32_t      frameIndex,
+                           VkDeviceSize  copyEnd,
+                           VkBuffer*     outBuffer,
+                           VkDeviceSize* outOffset );
+
 private:
     std::shared_ptr< MemoryAllocator > allocator;
+    Staging                            stagingType;
+    std::string                        debugNameStaging;
 
     Buffer                             staging[ MAX_FRAMES_IN_FLIGHT ];
     Buffer                             deviceLocal;
 
     void*                              mapped[ MAX_FRAMES_IN_FLIGHT ];
+
+    // if Staging::PerFrame, and the upload ring had space
+    struct RingRegion
+    {
+        uint64_t     frameId{ 0 };
+        VkDeviceSize offset{ 0 };
+        VkDeviceSize size{ 0 };
+    };
+    RingRegion                         ringRegion[ MAX_FRAMES_IN_FLIGHT ];
+
+    std::vector< VkBufferCopy >          tempCopies;
+    std::vector< VkBufferMemoryBarrier > tempBarriers;
 };
 
 }
@@ -0,0 +1,436 @@
+/*
+
+Copyright (c) 2024 V.Shirokii
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#include "BlockCompression.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+
+// Bits are appended starting from the least significant bit of the first byte
+class BitWriter
+{
+public:
+    explicit BitWriter( uint8_t* _dst, size_t _size ) : dst{ _dst }
+    {
+        memset( dst, 0, _size );
+    }
+
+    void Put( uint32_t value, uint32_t bitCount )
+    {
+        for( uint32_t i = 0; i < bitCount; i++, offset++ )
+        {
+            if( value & ( 1u << i ) )
+            {
+                dst[ offset / 8 ] |= uint8_t( 1u << ( offset % 8 ) );
+            }
+        }
+    }
+
+private:
+    uint8_t* dst;
+    uint32_t offset{ 0 };
+};
+
+
+// BC7 mode 6: one subset, RGBA endpoints of 7 bits with a unique p-bit each, 4-bit indices.
+// It's the most versatile mode for a single-mode encoder.
+namespace bc7
+{
+    constexpr int Weights4[ 16 ] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    struct Endpoints
+    {
+        int c[ 2 ][ 4 ];
+        int p[ 2 ];
+    };
+
+    struct Encoded
+    {
+        Endpoints e;
+        uint8_t   indices[ 16 ];
+        float     error;
+    };
+
+    int Quantize( float v, int pbit )
+    {
+        return std::clamp( int( std::lround( ( v - float( pbit ) ) * 0.5f ) ), 0, 127 );
+    }
+
+    int Expand( int c7, int pbit )
+    {
+        return ( c7 << 1 ) | pbit;
+    }
+
+    // Choose the best index for each texel with the given quantized endpoints
+    float SelectIndices( const float texels[ 16 ][ 4 ], const Endpoints& e, uint8_t indices[ 16 ] )
+    {
+        float palette[ 16 ][ 4 ];
+        for( int i = 0; i < 16; i++ )
+        {
+            for( int ch = 0; ch < 4; ch++ )
+            {
+                int a = Expand( e.c[ 0 ][ ch ], e.p[ 0 ] );
+                int b = Expand( e.c[ 1 ][ ch ], e.p[ 1 ] );
+
+                palette[ i ][ ch ] =
+                    float( ( a * ( 64 - Weights4[ i ] ) + b * Weights4[ i ] + 32 ) >> 6 );
+            }
+        }
+
+        float total = 0;
+        for( int t = 0; t < 16; t++ )
+        {
+            float best      = FLT_MAX;
+            int   bestIndex = 0;
+            for( int i = 0; i < 16; i++ )
+            {
+                float err = 0;
+                for( int ch = 0; ch < 4; ch++ )
+                {
+                    float d = texels[ t ][ ch ] - palette[ i ][ ch ];
+                    err += d * d;
+                }
+                if( err < best )
+                {
+                    best      = err;
+                    bestIndex = i;
+                }
+            }
+            indices[ t ] = uint8_t( bestIndex );
+            total += best;
+        }
+        return total;
+    }
+
+    // Try all p-bit combinations for unquantized endpoints
+    Encoded Fit( const float texels[ 16 ][ 4 ], const float lo[ 4 ], const float hi[ 4 ] )
+    {
+        auto best  = Encoded{};
+        best.error = FLT_MAX;
+
+        for( int p0 = 0; p0 < 2; p0++ )
+        {
+            for( int p1 = 0; p1 < 2; p1++ )
+            {
+                auto candidate = Encoded{};
+
+                candidate.e.p[ 0 ] = p0;
+                candidate.e.p[ 1 ] = p1;
+                for( int ch = 0; ch < 4; ch++ )
+                {
+                    candidate.e.c[ 0 ][ ch ] = Quantize( lo[ ch ], p0 );
+                    candidate.e.c[ 1 ][ ch ] = Quantize( hi[ ch ], p1 );
+                }
+                candidate.error = SelectIndices( texels, candidate.e, candidate.indices );
+
+                if( candidate.error < best.error )
+                {
+                    best = candidate;
+                }
+            }
+        }
+        return best;
+    }
+
+    // Least squares endpoints for the given indices; false, if the system is degenerate
+    bool Refine( const float   texels[ 16 ][ 4 ],
+                 const uint8_t indices[ 16 ],
+                 float         lo[ 4 ],
+                 float         hi[ 4 ] )
+    {
+        float aa = 0, ab = 0, bb = 0;
+        float ra[ 4 ] = {}, rb[ 4 ] = {};
+
+        for( int t = 0; t < 16; t++ )
+        {
+            float w  = float( Weights4[ indices[ t ] ] ) / 64.0f;
+            float iw = 1.0f - w;
+
+            aa += iw * iw;
+            ab += iw * w;
+            bb += w * w;
+            for( int ch = 0; ch < 4; ch++ )
+            {
+                ra[ ch ] += iw * texels[ t ][ ch ];
+                rb[ ch ] += w * texels[ t ][ ch ];
+            }
+        }
+
+        float det = aa * bb - ab * ab;
+        if( std::abs( det ) < 1e-6f )
+        {
+            return false;
+        }
+
+        for( int ch = 0; ch < 4; ch++ )
+        {
+            lo[ ch ] = std::clamp( ( bb * ra[ ch ] - ab * rb[ ch ] ) / det, 0.0f, 255.0f );
+            hi[ ch ] = std::clamp( ( aa * rb[ ch ] - ab * ra[ ch ] ) / det, 0.0f, 255.0f );
+        }
+        return true;
+    }
+
+    // Endpoints along the principal axis of the texels
+    void PrincipalEndpoints( const float texels[ 16 ][ 4 ], float lo[ 4 ], float hi[ 4 ] )
+    {
+        float mean[ 4 ] = {};
+        for( int t = 0; t < 16; t++ )
+        {
+            for( int ch = 0; ch < 4; ch++ )
+            {
+                mean[ ch ] += texels[ t ][ ch ] / 16.0f;
+            }
+        }
+
+        float cov[ 4 ][ 4 ] = {};
+        for( int t = 0; t < 16; t++ )
+        {
+            float d[ 4 ];
+            for( int ch = 0; ch < 4; ch++ )
+            {
+                d[ ch ] = texels[ t ][ ch ] - mean[ ch ];
+            }
+            for( int i = 0; i < 4; i++ )
+            {
+                for( int j = 0; j < 4; j++ )
+                {
+                    cov[ i ][ j ] += d[ i ] * d[ j ];
+                }
+            }
+        }
+
+        // power iteration
+        float axis[ 4 ] = { 1, 1, 1, 1 };
+        for( int iter = 0; iter < 8; iter++ )
+        {
+            float next[ 4 ] = {};
+            for( int i = 0; i < 4; i++ )
+            {
+                for( int j = 0; j < 4; j++ )
+                {
+                    next[ i ] += cov[ i ][ j ] * axis[ j ];
+                }
+            }
+
+            float len = std::sqrt( next[ 0 ] * next[ 0 ] + next[ 1 ] * next[ 1 ] +
+                                   next[ 2 ] * next[ 2 ] + next[ 3 ] * next[ 3 ] );
+            if( len < 1e-6f )
+            {
+                break;
+            }
+            for( int i = 0; i < 4; i++ )
+            {
+                axis[ i ] = next[ i ] / len;
+            }
+        }
+
+        float tmin = FLT_MAX, tmax = -FLT_MAX;
+        for( int t = 0; t < 16; t++ )
+        {
+            float proj = 0;
+            for( int ch = 0; ch < 4; ch++ )
+            {
+                proj += ( texels[ t ][ ch ] - mean[ ch ] ) * axis[ ch ];
+            }
+            tmin = std::min( tmin, proj );
+            tmax = std::max( tmax, proj );
+        }
+
+        for( int ch = 0; ch < 4; ch++ )
+        {
+            lo[ ch ] = std::clamp( mean[ ch ] + tmin * axis[ ch ], 0.0f, 255.0f );
+            hi[ ch ] = std::clamp( mean[ ch ] + tmax * axis[ ch ], 0.0f, 255.0f );
+        }
+    }
+
+    void Pack( Encoded enc, uint8_t dst[ 16 ] )
+    {
+        // the most significant bit of the first index is implicitly 0
+        if( enc.indices[ 0 ] & 0b1000 )
+        {
+            std::swap( enc.e.c[ 0 ], enc.e.c[ 1 ] );
+            std::swap( enc.e.p[ 0 ], enc.e.p[ 1 ] );
+            for( auto& i : enc.indices )
+            {
+                i = uint8_t( 15 - i );
+            }
+        }
+
+        auto w = BitWriter{ dst, 16 };
+
+        // mode 6
+        w.Put( 1u << 6, 7 );
+        for( int ch = 0; ch < 4; ch++ )
+        {
+            w.Put( uint32_t( enc.e.c[ 0 ][ ch ] ), 7 );
+            w.Put( uint32_t( enc.e.c[ 1 ][ ch ] ), 7 );
+        }
+        w.Put( uint32_t( enc.e.p[ 0 ] ), 1 );
+        w.Put( uint32_t( enc.e.p[ 1 ] ), 1 );
+        for( int t = 0; t < 16; t++ )
+        {
+            w.Put( enc.indices[ t ], t == 0 ? 3 : 4 );
+        }
+    }
+}
+
+}
+
+void RTGL1::CompressBlockBC4( const uint8_t texels[ 16 ], uint8_t dst[ 8 ] )
+{
+    uint8_t lo = 255, hi = 0;
+    for( int t = 0; t < 16; t++ )
+    {
+        lo = std::min( lo, texels[ t ] );
+        hi = std::max( hi, texels[ t ] );
+    }
+
+    // r0 > r1 selects 6 interpolated values between the endpoints
+    int palette[ 8 ] = { hi, lo };
+    for( int i = 2; i < 8; i++ )
+    {
+        palette[ i ] = ( ( 8 - i ) * hi + ( i - 1 ) * lo + 3 ) / 7;
+    }
+
+    auto w = BitWriter{ dst, 8 };
+    w.Put( hi, 8 );
+    w.Put( lo, 8 );
+
+    for( int t = 0; t < 16; t++ )
+    {
+        int bestIndex = 0;
+        int best      = INT32_MAX;
+        // if hi == lo, index 0 is exact
+        for( int i = 0; i < ( hi > lo ? 8 : 1 ); i++ )
+        {
+            int err = std::abs( int( texels[ t ] ) - palette[ i ] );
+            if( err < best )
+            {
+                best      = err;
+                bestIndex = i;
+            }
+        }
+        w.Put( uint32_t( bestIndex ), 3 );
+    }
+}
+
+void RTGL1::CompressBlockBC7( const uint8_t texels[ 16 ][ 4 ], uint8_t dst[ 16 ] )
+{
+    float t[ 16 ][ 4 ];
+    for( int i = 0; i < 16; i++ )
+    {
+        for( int ch = 0; ch < 4; ch++ )
+        {
+            t[ i ][ ch ] = float( texels[ i ][ ch ] );
+        }
+    }
+
+    float lo[ 4 ], hi[ 4 ];
+    bc7::PrincipalEndpoints( t, lo, hi );
+
+    bc7::Encoded best = bc7::Fit( t, lo, hi );
+
+    // a couple of refinement passes usually give most of the gain
+    for( int iter = 0; iter < 2 && best.error > 0; iter++ )
+    {
+        if( !bc7::Refine( t, best.indices, lo, hi ) )
+        {
+            break;
+        }
+
+        bc7::Encoded refined = bc7::Fit( t, lo, hi );
+        if( refined.error >= best.error )
+        {
+            break;
+        }
+        best = refined;
+    }
+
+    bc7::Pack( best, dst );
+}
+
+size_t RTGL1::GetBlockCompressedSize( BlockFormat format, uint32_t width, uint32_t height )
+{
+    const size_t blockCount = size_t( ( width + 3 ) / 4 ) * ( ( height + 3 ) / 4 );
+    return blockCount * ( format == BlockFormat::BC4 ? 8 : 16 );
+}
+
+void RTGL1::BlockCompress( BlockFormat    format,
+                           const uint8_t* src,
+                           uint32_t       width,
+                           uint32_t       height,
+                           bool           swapRB,
+                           uint8_t*       dst )
+{
+    assert( width > 0 && height > 0 );
+
+    const uint32_t texelSize = format == BlockFormat::BC4 ? 1 : 4;
+    const size_t   blockSize = format == BlockFormat::BC4 ? 8 : 16;
+
+    for( uint32_t by = 0; by < height; by += 4 )
+    {
+        for( uint32_t bx = 0; bx < width; bx += 4 )
+        {
+            uint8_t block[ 16 ][ 4 ];
+            for( uint32_t y = 0; y < 4; y++ )
+            {
+                for( uint32_t x = 0; x < 4; x++ )
+                {
+                    uint32_t sx = std::min( bx + x, width - 1 );
+                    uint32_t sy = std::min( by + y, height - 1 );
+
+                    const uint8_t* s = &src[ ( size_t( sy ) * width + sx ) * texelSize ];
+                    memcpy( block[ y * 4 + x ], s, texelSize );
+
+                    if( swapRB && texelSize == 4 )
+                    {
+                        std::swap( block[ y * 4 + x ][ 0 ], block[ y * 4 + x ][ 2 ] );
+                    }
+                }
+            }
+
+            if( format == BlockFormat::BC4 )
+            {
+                uint8_t r[ 16 ];
+                for( int i = 0; i < 16; i++ )
+                {
+                    r[ i ] = block[ i ][ 0 ];
+                }
+                CompressBlockBC4( r, dst );
+            }
+            else
+            {
+                CompressBlockBC7( block, dst );
+            }
+            dst += blockSize;
+        }
+    }
+}
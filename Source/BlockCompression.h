@@ -0,0 +1,57 @@
+/*
+
+Copyright (c) 2024 V.Shirokii
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace RTGL1
+{
+
+enum class BlockFormat
+{
+    // single channel, 8 bytes per block
+    BC4,
+    // RGBA, 16 bytes per block
+    BC7,
+};
+
+size_t GetBlockCompressedSize( BlockFormat format, uint32_t width, uint32_t height );
+
+// Compress a whole image, texels outside of the image in edge blocks replicate the border.
+// Source is R8 for BC4, RGBA8 for BC7 (BGRA8, if swapRB is true).
+void BlockCompress( BlockFormat    format,
+                    const uint8_t* src,
+                    uint32_t       width,
+                    uint32_t       height,
+                    bool           swapRB,
+                    uint8_t*       dst );
+
+// 4x4 texels, row by row
+void CompressBlockBC4( const uint8_t texels[ 16 ], uint8_t dst[ 8 ] );
+void CompressBlockBC7( const uint8_t texels[ 16 ][ 4 ], uint8_t dst[ 16 ] );
+
+}
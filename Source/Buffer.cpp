@@ -40,8 +40,9 @@ VkDeviceSize findCommonAlignment( VkDeviceSize align_0, VkDeviceSize align_1 )
 
 Buffer::Buffer()
     : device( VK_NULL_HANDLE )
+    , allocator( nullptr )
     , buffer( VK_NULL_HANDLE )
-    , memory( VK_NULL_HANDLE )
+    , allocation( VK_NULL_HANDLE )
     , address( 0 )
     , size( 0 )
     , isMapped( false )
@@ -53,11 +54,12 @@ Buffer::~Buffer()
     Destroy();
 }
 
-void Buffer::Init( MemoryAllocator&      allocator,
+void Buffer::Init( MemoryAllocator&      _allocator,
                    VkDeviceSize          bsize,
                    VkBufferUsageFlags    usage,
                    VkMemoryPropertyFlags properties,
-                   const char*           debugName )
+                   const char*           debugName,
+                   VkDeviceSize          minAlignment )
 {
     if( bsize == 0 )
     {
@@ -65,9 +67,8 @@ void Buffer::Init( MemoryAllocator&      allocator,
         return;
     }
 
-    device = allocator.GetDevice();
-
-    VkResult r;
+    device    = _allocator.GetDevice();
+    allocator = &_allocator;
 
     VkBufferCreateInfo bufferInfo = {};
     bufferInfo.sType              = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -75,17 +76,8 @@ void Buffer::Init( MemoryAllocator&      allocator,
     bufferInfo.usage              = usage;
     bufferInfo.sharingMode        = VK_SHARING_MODE_EXCLUSIVE;
 
-    r = vkCreateBuffer( device, &bufferInfo, nullptr, &buffer );
-    VK_CHECKERROR( r );
-
-    VkMemoryRequirements memReq = {};
-    vkGetBufferMemoryRequirements( device, buffer, &memReq );
-
-    memory = allocator.AllocDedicated(
-        memReq, properties, MemoryAllocator::AllocType::WITH_ADDRESS_QUERY, debugName );
-
-    r = vkBindBufferMemory( device, buffer, memory, 0 );
-    VK_CHECKERROR( r );
+    buffer =
+        allocator->CreateBuffer( bufferInfo, properties, minAlignment, debugName, &allocation );
 
     if( bufferInfo.usage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT )
     {
@@ -110,17 +102,12 @@ void Buffer::Destroy()
         return;
     }
 
-    // memory is guaranteed to be dedicated
-    if( memory != VK_NULL_HANDLE )
-    {
-        MemoryAllocator::FreeDedicated( device, memory );
-        memory = VK_NULL_HANDLE;
-    }
-
     if( buffer != VK_NULL_HANDLE )
     {
-        vkDestroyBuffer( device, buffer, nullptr );
-        buffer = VK_NULL_HANDLE;
+        assert( allocator );
+        allocator->DestroyBuffer( buffer, allocation );
+        buffer     = VK_NULL_HANDLE;
+        allocation = VK_NULL_HANDLE;
     }
 
     address = 0;
@@ -131,15 +118,13 @@ void* Buffer::Map()
 {
     assert( device != VK_NULL_HANDLE );
     assert( !isMapped );
-    assert( memory != VK_NULL_HANDLE && size > 0 );
+    assert( allocation != VK_NULL_HANDLE && size > 0 );
 
     isMapped = true;
-    void* mapped;
-
-    VkResult r = vkMapMemory( device, memory, 0, size, 0, &mapped );
-    VK_CHECKERROR( r );
 
-    return mapped;
+    // memory block can be shared with other buffers, so map through the allocator,
+    // as it counts the mappings of a block
+    return allocator->MapBuffer( allocation );
 }
 
 void Buffer::Unmap()
@@ -147,7 +132,7 @@ void Buffer::Unmap()
     assert( device != VK_NULL_HANDLE );
     assert( isMapped );
     isMapped = false;
-    vkUnmapMemory( device, memory );
+    allocator->UnmapBuffer( allocation );
 }
 
 bool Buffer::TryUnmap()
@@ -169,12 +154,6 @@ VkBuffer Buffer::GetBuffer() const
     return buffer;
 }
 
-VkDeviceMemory Buffer::GetMemory() const
-{
-    assert( memory != VK_NULL_HANDLE );
-    return memory;
-}
-
 VkDeviceAddress Buffer::GetAddress() const
 {
     assert( address != 0 );
@@ -195,5 +174,5 @@ bool Buffer::IsMapped() const
 
 bool Buffer::IsInitted() const
 {
-    return buffer != VK_NULL_HANDLE && memory != VK_NULL_HANDLE;
+    return buffer != VK_NULL_HANDLE && allocation != VK_NULL_HANDLE;
 }
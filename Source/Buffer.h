@@ -32,12 +32,14 @@ public:
     Buffer();
     ~Buffer();
 
-    // Create VkBuffer, allocate memory and bind it
+    // Create VkBuffer and bind it to a suballocated memory region.
+    // If minAlignment is specified, the buffer's offset in the memory block is aligned by it
     void Init( MemoryAllocator&      allocator,
                VkDeviceSize          size,
                VkBufferUsageFlags    usage,
                VkMemoryPropertyFlags properties,
-               const char*           debugName = nullptr );
+               const char*           debugName    = nullptr,
+               VkDeviceSize          minAlignment = 1 );
     void Destroy();
 
     void* Map();
@@ -46,7 +48,6 @@ public:
 
 
     VkBuffer        GetBuffer() const;
-    VkDeviceMemory  GetMemory() const;
     // To get address usage flags must contain VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
     VkDeviceAddress GetAddress() const;
     VkDeviceSize    GetSize() const;
@@ -54,11 +55,12 @@ public:
     bool            IsInitted() const;
 
 protected:
-    VkDevice        device;
-    VkBuffer        buffer;
-    VkDeviceMemory  memory;
-    VkDeviceAddress address;
-    VkDeviceSize    size;
+    VkDevice         device;
+    MemoryAllocator* allocator;
+    VkBuffer         buffer;
+    VmaAllocation    allocation;
+    VkDeviceAddress  address;
+    VkDeviceSize     size;
 
 private:
     bool isMapped;
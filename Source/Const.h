@@ -20,6 +20,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string_view>
 
 namespace RTGL1
@@ -57,7 +58,9 @@ constexpr float MESH_TRANSLUCENT_ALPHA_THRESHOLD = 0.98f;
 
 constexpr std::string_view TEXTURES_FOLDER           = "mat";
 constexpr std::string_view TEXTURES_FOLDER_DEV       = "mat_dev";
+constexpr std::string_view TEXTURES_PACK             = "mat.rtpack";
 constexpr std::string_view TEXTURES_FOLDER_ORIGINALS = "mat_src";
+constexpr std::string_view TEXTURES_FOLDER_CACHE     = "mat_cache";
 constexpr std::string_view SCENES_FOLDER             = "scenes";
 constexpr std::string_view REPLACEMENTS_FOLDER       = "replace";
 constexpr std::string_view SHADERS_FOLDER            = "shaders";
@@ -90,7 +90,8 @@ RTGL1::CubemapManager::CubemapManager( VkDevice                           _devic
     imageLoader = std::make_shared< ImageLoader >();
     cubemapDesc = std::make_shared< TextureDescriptors >(
         device, samplerManager, MAX_CUBEMAP_COUNT, BINDING_CUBEMAPS );
-    cubemapUploader = std::make_shared< CubemapUploader >( device, allocator );
+    // cubemaps are rarely uploaded, dedicated staging buffers are enough
+    cubemapUploader = std::make_shared< CubemapUploader >( device, allocator, 0 );
 
     VkCommandBuffer cmd = _cmdManager.StartGraphicsCmd();
     {
@@ -155,7 +156,7 @@ RTGL1::CubemapManager::~CubemapManager()
 bool RTGL1::CubemapManager::TryCreateCubemap( VkCommandBuffer              cmd,
                                               uint32_t                     frameIndex,
                                               const RgOriginalCubemapInfo& info,
-                                              const std::filesystem::path& ovrdFolder )
+                                              const TextureFolderIndex&    ovrdIndex )
 {
     TextureUploader::UploadInfo upload = {
         .cmd          = cmd,
@@ -182,12 +183,12 @@ bool RTGL1::CubemapManager::TryCreateCubemap( VkCommandBuffer              cmd,
 
     // clang-format off
     TextureOverrides ovrd[] = {
-        TextureOverrides( ovrdFolder, faceNames[ 0 ], "", facePixels[ 0 ], size, VK_FORMAT_R8G8B8A8_SRGB, loaders ),
-        TextureOverrides( ovrdFolder, faceNames[ 1 ], "", facePixels[ 1 ], size, VK_FORMAT_R8G8B8A8_SRGB, loaders ),
-        TextureOverrides( ovrdFolder, faceNames[ 2 ], "", facePixels[ 2 ], size, VK_FORMAT_R8G8B8A8_SRGB, loaders ),
-        TextureOverrides( ovrdFolder, faceNames[ 3 ], "", facePixels[ 3 ], size, VK_FORMAT_R8G8B8A8_SRGB, loaders ),
-        TextureOverrides( ovrdFolder, faceNames[ 4 ], "", facePixels[ 4 ], size, VK_FORMAT_R8G8B8A8_SRGB, loaders ),
-        TextureOverrides( ovrdFolder, faceNames[ 5 ], "", facePixels[ 5 ], size, VK_FORMAT_R8G8B8A8_SRGB, loaders ),
+        TextureOverrides( ovrdIndex, faceNames[ 0 ], "", facePixels[ 0 ], size, VK_FORMAT_R8G8B8A8_SRGB, loaders ),
+        TextureOverrides( ovrdIndex, faceNames[ 1 ], "", facePixels[ 1 ], size, VK_FORMAT_R8G8B8A8_SRGB, loaders ),
+        TextureOverrides( ovrdIndex, faceNames[ 2 ], "", facePixels[ 2 ], size, VK_FORMAT_R8G8B8A8_SRGB, loaders ),
+        TextureOverrides( ovrdIndex, faceNames[ 3 ], "", facePixels[ 3 ], size, VK_FORMAT_R8G8B8A8_SRGB, loaders ),
+        TextureOverrides( ovrdIndex, faceNames[ 4 ], "", facePixels[ 4 ], size, VK_FORMAT_R8G8B8A8_SRGB, loaders ),
+        TextureOverrides( ovrdIndex, faceNames[ 5 ], "", facePixels[ 5 ], size, VK_FORMAT_R8G8B8A8_SRGB, loaders ),
     };
     // clang-format on
 
@@ -370,12 +371,12 @@ void RTGL1::CubemapManager::SubmitDescriptors( uint32_t frameIndex )
     {
         if( cubetxd.image != VK_NULL_HANDLE )
         {
-            cubemapDesc->UpdateTextureDesc( frameIndex, iter, cubetxd.view, cubetxd.samplerHandle );
+            cubemapDesc->SetTexture( iter, cubetxd.view, cubetxd.samplerHandle );
         }
         else
         {
             // reset descriptor to empty texture
-            cubemapDesc->ResetTextureDesc( frameIndex, iter );
+            cubemapDesc->ResetTexture( iter );
         }
 
         iter++;
@@ -383,11 +384,11 @@ void RTGL1::CubemapManager::SubmitDescriptors( uint32_t frameIndex )
 
     while( iter < MAX_CUBEMAP_COUNT )
     {
-        cubemapDesc->ResetTextureDesc( frameIndex, iter );
+        cubemapDesc->ResetTexture( iter );
         iter++;
     }
 
-    cubemapDesc->FlushDescWrites();
+    cubemapDesc->FlushDescWrites( frameIndex );
 }
 
 uint32_t RTGL1::CubemapManager::TryGetDescriptorIndex( const char* pTextureName )
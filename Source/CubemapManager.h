@@ -32,6 +32,7 @@
 #include "CubemapUploader.h"
 #include "CommandBufferManager.h"
 #include "ImageLoader.h"
+#include "TextureFolderIndex.h"
 
 namespace RTGL1
 {
@@ -72,7 +73,7 @@ public:
     bool TryCreateCubemap( VkCommandBuffer              cmd,
                            uint32_t                     frameIndex,
                            const RgOriginalCubemapInfo& info,
-                           const std::filesystem::path& folder );
+                           const TextureFolderIndex&    ovrdIndex );
     bool TryDestroyCubemap( uint32_t frameIndex, const char* pTextureName );
 
 
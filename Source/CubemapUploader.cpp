@@ -26,88 +26,6 @@ RTGL1::TextureUploader::UploadResult RTGL1::CubemapUploader::UploadImage( const
     // cubemaps can't be updateable
     assert( !info.isUpdateable );
 
-    constexpr uint32_t FaceCount = 6;
-
-    VkImage            image;
-    VkBuffer           stagingBuffers[ FaceCount ] = {};
-    void*              mappedData[ FaceCount ]     = {};
-
-
-    // allocate and fill buffer
-    const auto         faceSize = VkDeviceSize( info.dataSize );
-
-    VkBufferCreateInfo stagingInfo = {
-        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-        .size  = faceSize,
-        .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-    };
-
-    for( uint32_t i = 0; i < FaceCount; i++ )
-    {
-        stagingBuffers[ i ] = memAllocator->CreateStagingSrcTextureBuffer(
-            &stagingInfo, info.pDebugName, &mappedData[ i ] );
-
-        // if couldn't allocate memory
-        if( stagingBuffers[ i ] == VK_NULL_HANDLE )
-        {
-            // clear allocated
-            for( uint32_t j = 0; j < i; j++ )
-            {
-                memAllocator->DestroyStagingSrcTextureBuffer( stagingBuffers[ j ] );
-            }
-
-            return UploadResult{};
-        }
-
-        SET_DEBUG_NAME( device, stagingBuffers[ i ], VK_OBJECT_TYPE_BUFFER, info.pDebugName );
-    }
-
-
-    bool wasCreated = CreateImage( info, &image );
-    if( !wasCreated )
-    {
-        // clean created resources
-        for( VkBuffer b : stagingBuffers )
-        {
-            memAllocator->DestroyStagingSrcTextureBuffer( b );
-        }
-
-        return UploadResult{};
-    }
-
-
-    // copy image data to buffer
-    for( uint32_t i = 0; i < FaceCount; i++ )
-    {
-        memcpy( mappedData[ i ], info.cubemap.pFaces[ i ], faceSize );
-    }
-
-
-    // and copy it to image
-    PrepareImage( image, stagingBuffers, info, ImagePrepareType::INIT );
-
-
-    // create image view
-    VkImageView imageView = CreateImageView( image,
-                                             info.format,
-                                             info.isCubemap,
-                                             GetMipmapCount( info.baseSize, info ),
-                                             std::nullopt );
-    SET_DEBUG_NAME( device, imageView, VK_OBJECT_TYPE_IMAGE_VIEW, info.pDebugName );
-
-
-    // push staging buffer to be deleted when it won't be in use
-    for( VkBuffer b : stagingBuffers )
-    {
-        stagingToFree[ info.frameIndex ].push_back( b );
-    }
-
-
-    // return results
-
-    return UploadResult{
-        .wasUploaded = true,
-        .image       = image,
-        .view        = imageView,
-    };
+    // all faces are copied to one staging buffer
+    return TextureUploader::UploadImage( info );
 }
@@ -93,6 +93,7 @@ namespace detail
     template<> constexpr auto TypeToStructureType< RgOriginalTextureDetailsEXT          > = RG_STRUCTURE_TYPE_ORIGINAL_TEXTURE_DETAILS_EXT         ;
     template<> constexpr auto TypeToStructureType< RgSpawnFluidInfo                     > = RG_STRUCTURE_TYPE_SPAWN_FLUID_INFO                     ;
     template<> constexpr auto TypeToStructureType< RgStartFrameFluidParams              > = RG_STRUCTURE_TYPE_START_FRAME_FLUID_PARAMS             ;
+    template<> constexpr auto TypeToStructureType< RgInstanceJobSystemEXT               > = RG_STRUCTURE_TYPE_INSTANCE_JOB_SYSTEM_EXT              ;
     // clang-format on
 
     template< typename T >
@@ -136,6 +137,7 @@ namespace detail
     static_assert( CheckMembers< RgOriginalTextureDetailsEXT >() );
     static_assert( CheckMembers< RgSpawnFluidInfo >() );
     static_assert( CheckMembers< RgStartFrameFluidParams >() );
+    static_assert( CheckMembers< RgInstanceJobSystemEXT >() );
 
 
     template< typename T >
@@ -167,6 +169,7 @@ namespace detail
     template<> struct LinkRootHelper< RgDrawFrameSkyParams               >{ using Root = RgDrawFrameInfo; };
     template<> struct LinkRootHelper< RgDrawFrameTexturesParams          >{ using Root = RgDrawFrameInfo; };
     template<> struct LinkRootHelper< RgDrawFramePostEffectsParams       >{ using Root = RgDrawFrameInfo; };
+    template<> struct LinkRootHelper< RgInstanceJobSystemEXT             >{ using Root = RgInstanceCreateInfo; };
     // clang-format on
 
     template< typename T >
@@ -430,6 +433,20 @@ namespace detail
         };
     };
 
+    template<>
+    struct DefaultParams< RgInstanceJobSystemEXT >
+    {
+        constexpr static auto sType = detail::TypeToStructureType< RgInstanceJobSystemEXT >;
+
+        constexpr static RgInstanceJobSystemEXT value = {
+            .sType              = sType,
+            .pNext              = nullptr,
+            .workerThreadCount  = 0,
+            .pfnScheduleJob     = nullptr,
+            .pSchedulerUserData = nullptr,
+        };
+    };
+
     template< typename T >
     concept HasDefaultParams = requires( DefaultParams< T > t ) { t.value; };
 }
@@ -20,10 +20,10 @@
 
 #include "FolderObserver.h"
 
-#include <future>
-
 #include "Const.h"
 
+#include <algorithm>
+
 namespace fs = std::filesystem;
 
 namespace RTGL1
@@ -31,159 +31,142 @@ namespace RTGL1
 namespace
 {
     constexpr auto CHECK_FREQUENCY = std::chrono::milliseconds( 500 );
+}
+}
 
-    using Clock = std::filesystem::file_time_type::clock;
-
-
-    struct DependentFile
+void RTGL1::FolderObserver::InsertAllFolderFiles( std::deque< DependentFile >& dst,
+                                                  const fs::path&              folder )
+{
+    if( !fs::exists( folder ) )
     {
-        FileType              type;
-        std::filesystem::path path;
-        uint64_t              pathHash;
-        Clock::time_point     lastWriteTime;
-
-        friend std::strong_ordering operator<=>( const DependentFile& a,
-                                                 const DependentFile& b ) noexcept
-        {
-            // only path
-            return a.path <=> b.path;
-        }
-    };
-
+        return;
+    }
 
-    void InsertAllFolderFiles( std::deque< DependentFile >& dst, const fs::path& folder )
+    for( const fs::directory_entry& entry : fs::directory_iterator( folder ) )
     {
-        if( !fs::exists( folder ) )
+        if( entry.is_regular_file() )
         {
-            return;
-        }
+            FileType type = MakeFileType( entry.path() );
 
-        for( const fs::directory_entry& entry : fs::directory_iterator( folder ) )
-        {
-            if( entry.is_regular_file() )
+            if( type != FileType::Unknown )
             {
-                FileType type = MakeFileType( entry.path() );
-
-                if( type != FileType::Unknown )
-                {
-                    dst.push_back( DependentFile{
-                        .type          = type,
-                        .path          = entry.path(),
-                        .pathHash      = std::hash< fs::path >{}( entry.path() ),
-                        .lastWriteTime = entry.last_write_time(),
-                    } );
-                }
+                dst.push_back( DependentFile{
+                    .type          = type,
+                    .path          = entry.path(),
+                    .pathHash      = std::hash< fs::path >{}( entry.path() ),
+                    .lastWriteTime = entry.last_write_time(),
+                } );
             }
-            else if( entry.is_directory() )
+        }
+        else if( entry.is_directory() )
+        {
+            // ignore
+            if( entry.path().filename() == TEXTURES_FOLDER_JUNCTION )
             {
-                // ignore
-                if( entry.path().filename() == TEXTURES_FOLDER_JUNCTION )
-                {
-                    continue;
-                }
-
-                InsertAllFolderFiles( dst, entry.path() );
+                continue;
             }
+
+            InsertAllFolderFiles( dst, entry.path() );
         }
     }
 }
-}
 
-RTGL1::FolderObserver::FolderObserver( const fs::path& ovrdFolder )
-{
-    auto folders = std::vector{
+RTGL1::FolderObserver::FolderObserver( const fs::path&              ovrdFolder,
+                                       std::shared_ptr< JobSystem > jobSystem )
+    : m_jobs{ std::move( jobSystem ) }
+    , m_folders{
         ovrdFolder / DATABASE_FOLDER,     //
         ovrdFolder / SCENES_FOLDER,       //
         ovrdFolder / SHADERS_FOLDER,      //
         ovrdFolder / TEXTURES_FOLDER,     //
         ovrdFolder / TEXTURES_FOLDER_DEV, //
         ovrdFolder / REPLACEMENTS_FOLDER, //
-    };
-
-    m_asyncChecker = std::async(
-        std::launch::async,
-        [ this ](                                                      //
-            const std::vector< std::filesystem::path > foldersToCheck, //
-            std::stop_token                            token           //
-        ) {
-            auto s_lastCheck    = std::optional< Clock::time_point >{};
-            auto s_prevAllFiles = std::deque< DependentFile >{};
-
-            while( !token.stop_requested() )
+    }
+{
+}
+
+RTGL1::FolderObserver::~FolderObserver()
+{
+    m_jobs->Wait( m_scan );
+}
+
+void RTGL1::FolderObserver::ScanFolders()
+{
+    auto curAllFiles = std::deque< DependentFile >{};
+    auto changed     = std::vector< std::pair< FileType, std::filesystem::path > >{};
+    {
+        for( const fs::path& f : m_folders )
+        {
+            InsertAllFolderFiles( curAllFiles, f );
+        }
+
+        if( m_scannedOnce )
+        {
+            for( const auto& cur : curAllFiles )
             {
-                std::this_thread::sleep_for( CHECK_FREQUENCY );
+                bool foundInPrev = false;
 
-                auto curAllFiles = std::deque< DependentFile >{};
-                auto changed     = std::vector< std::pair< FileType, std::filesystem::path > >{};
+                for( const auto& prev : m_prevAllFiles )
                 {
-                    for( const fs::path& f : foldersToCheck )
+                    // if file previously existed
+                    if( cur.pathHash == prev.pathHash && cur.path == prev.path )
                     {
-                        InsertAllFolderFiles( curAllFiles, f );
-                    }
-
-                    if( s_lastCheck )
-                    {
-                        for( const auto& cur : curAllFiles )
+                        // if was changed
+                        if( cur.lastWriteTime != prev.lastWriteTime )
                         {
-                            bool foundInPrev = false;
-
-                            for( const auto& prev : s_prevAllFiles )
-                            {
-                                // if file previously existed
-                                if( cur.pathHash == prev.pathHash && cur.path == prev.path )
-                                {
-                                    // if was changed
-                                    if( cur.lastWriteTime != prev.lastWriteTime )
-                                    {
-                                        changed.emplace_back( cur.type, cur.path );
-                                    }
-
-                                    foundInPrev = true;
-                                    break;
-                                }
-                            }
-
-                            // if new file
-                            if( !foundInPrev )
-                            {
-                                changed.emplace_back( cur.type, cur.path );
-                            }
+                            changed.emplace_back( cur.type, cur.path );
                         }
+
+                        foundInPrev = true;
+                        break;
                     }
                 }
 
+                // if new file
+                if( !foundInPrev )
                 {
-                    auto l = std::lock_guard{ this->m_mutex };
+                    changed.emplace_back( cur.type, cur.path );
+                }
+            }
+        }
+    }
 
-                    for( auto& f : changed )
-                    {
-                        bool alreadyContains =
-                            std::ranges::find_if( this->m_changedFiles, [ &f ]( const auto& o ) {
-                                return o.second == f.second;
-                            } ) != this->m_changedFiles.end();
+    {
+        auto l = std::lock_guard{ this->m_mutex };
 
-                        if( !alreadyContains )
-                        {
-                            this->m_changedFiles.emplace_back( std::move( f ) );
-                        }
-                    }
-                }
+        for( auto& f : changed )
+        {
+            bool alreadyContains =
+                std::ranges::find_if( this->m_changedFiles, [ &f ]( const auto& o ) {
+                    return o.second == f.second;
+                } ) != this->m_changedFiles.end();
 
-                s_prevAllFiles = std::move( curAllFiles );
-                s_lastCheck    = Clock::now();
+            if( !alreadyContains )
+            {
+                this->m_changedFiles.emplace_back( std::move( f ) );
             }
-        },
-        std::move( folders ),
-        m_asyncStopSource.get_token() );
-}
+        }
+    }
 
-RTGL1::FolderObserver::~FolderObserver()
-{
-    m_asyncStopSource.request_stop();
+    m_prevAllFiles = std::move( curAllFiles );
+    m_scannedOnce  = true;
 }
 
 void RTGL1::FolderObserver::RecheckFiles()
 {
+    {
+        auto now = std::chrono::steady_clock::now();
+
+        bool scanInFlight = m_scan && !m_scan->IsDone();
+        bool isTime       = !m_lastScanStart || now - *m_lastScanStart >= CHECK_FREQUENCY;
+
+        if( !scanInFlight && isTime )
+        {
+            m_lastScanStart = now;
+            m_scan          = m_jobs->Submit( [ this ] { ScanFolders(); } );
+        }
+    }
+
     auto l = std::lock_guard{ this->m_mutex };
 
     for( const auto& [ type, path ] : this->m_changedFiles )
@@ -22,10 +22,12 @@
 
 #include "Containers.h"
 #include "IFileDependency.h"
+#include "JobSystem.h"
 
+#include <chrono>
 #include <deque>
 #include <filesystem>
-#include <future>
+#include <optional>
 
 namespace RTGL1
 {
@@ -33,7 +35,8 @@ namespace RTGL1
 class FolderObserver
 {
 public:
-    explicit FolderObserver( const std::filesystem::path& ovrdFolder );
+    explicit FolderObserver( const std::filesystem::path& ovrdFolder,
+                             std::shared_ptr< JobSystem > jobSystem );
     ~FolderObserver();
 
     FolderObserver( const FolderObserver& other )                = delete;
@@ -41,6 +44,8 @@ public:
     FolderObserver& operator=( const FolderObserver& other )     = delete;
     FolderObserver& operator=( FolderObserver&& other ) noexcept = delete;
 
+    // Notifies subscribers about the changes found by the previous scan,
+    // and starts a new scan job on the job system, if it's time
     void RecheckFiles();
 
     void Subscribe( const std::shared_ptr< IFileDependency >& subscriber )
@@ -61,9 +66,28 @@ private:
         }
     }
 
+    struct DependentFile
+    {
+        FileType                        type;
+        std::filesystem::path           path;
+        uint64_t                        pathHash;
+        std::filesystem::file_time_type lastWriteTime;
+    };
+
+    static void InsertAllFolderFiles( std::deque< DependentFile >& dst,
+                                      const std::filesystem::path& folder );
+    void        ScanFolders();
+
 private:
-    std::future< void > m_asyncChecker;
-    std::stop_source    m_asyncStopSource;
+    std::shared_ptr< JobSystem >         m_jobs;
+    std::vector< std::filesystem::path > m_folders;
+
+    JobSystem::Handle                                      m_scan{};
+    std::optional< std::chrono::steady_clock::time_point > m_lastScanStart{};
+
+    // accessed only by the scan job, and at most one is in flight
+    std::deque< DependentFile > m_prevAllFiles{};
+    bool                        m_scannedOnce{ false };
 
     std::mutex                                                  m_mutex;
     std::vector< std::pair< FileType, std::filesystem::path > > m_changedFiles;
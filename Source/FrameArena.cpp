@@ -0,0 +1,195 @@
+/*
+
+Copyright (c) 2024 V.Shirokii
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "FrameArena.h"
+
+#include <algorithm>
+#include <new>
+
+namespace
+{
+// to not share cache lines with other allocations
+constexpr size_t BLOCK_ALIGNMENT = 64;
+
+size_t AlignUp( size_t v, size_t alignment )
+{
+    return ( v + alignment - 1 ) & ~( alignment - 1 );
+}
+}
+
+RTGL1::FrameArena::FrameArena( size_t initialCapacity )
+{
+    // to not reallocate on AddBlock in a steady state
+    blocks.reserve( 16 );
+    AddBlock( std::max< size_t >( initialCapacity, 4096 ) );
+}
+
+RTGL1::FrameArena::~FrameArena()
+{
+    RunFinalizers();
+    FreeBlocks();
+}
+
+void* RTGL1::FrameArena::do_allocate( size_t bytes, size_t alignment )
+{
+    assert( !blocks.empty() );
+
+    if( alignment == 0 || ( alignment & ( alignment - 1 ) ) != 0 )
+    {
+        debug::Error( "Frame arena: alignment {} is not a power of two", alignment );
+        throw std::bad_alloc{};
+    }
+
+    // blocks are aligned by BLOCK_ALIGNMENT, larger alignments need a padding in a block
+    auto l_start = [ this, alignment ]() {
+        const auto base = reinterpret_cast< uintptr_t >( blocks.back().data );
+        return AlignUp( base + offset, alignment ) - base;
+    };
+
+    size_t start = l_start();
+
+    if( start + bytes > blocks.back().size )
+    {
+        usedInFullBlocks += offset;
+        AddBlock( bytes + ( alignment > BLOCK_ALIGNMENT ? alignment : 0 ) );
+        start = l_start();
+    }
+
+    offset = start + bytes;
+    return blocks.back().data + start;
+}
+
+void RTGL1::FrameArena::AddBlock( size_t minSize )
+{
+    // geometric growth
+    size_t size = blocks.empty() ? minSize : std::max( minSize, blocks.back().size * 2 );
+    size        = AlignUp( size, BLOCK_ALIGNMENT );
+
+    auto data = static_cast< std::byte* >(
+        ::operator new( size, std::align_val_t{ BLOCK_ALIGNMENT } ) );
+
+    blocks.push_back( Block{ .data = data, .size = size } );
+    offset = 0;
+
+    heapAllocationsCur++;
+}
+
+void RTGL1::FrameArena::FreeBlocks()
+{
+    for( const Block& b : blocks )
+    {
+        ::operator delete( b.data, std::align_val_t{ BLOCK_ALIGNMENT } );
+    }
+    blocks.clear();
+    offset           = 0;
+    usedInFullBlocks = 0;
+}
+
+void RTGL1::FrameArena::RunFinalizers()
+{
+    // in reverse order of creation
+    for( Finalizer* f = finalizers; f; f = f->next )
+    {
+        f->destroy( f->object );
+    }
+    finalizers = nullptr;
+}
+
+void RTGL1::FrameArena::Reset()
+{
+    RunFinalizers();
+
+    if( blocks.size() > 1 )
+    {
+        // merge into one block that fits everything
+        const size_t total = GetCapacity();
+
+        FreeBlocks();
+        AddBlock( total );
+
+#ifndef NDEBUG
+        debug::Verbose( "Frame arena has grown to {} KB", total / 1024 );
+#endif
+    }
+
+    offset           = 0;
+    usedInFullBlocks = 0;
+
+    heapAllocationsPrev = heapAllocationsCur;
+    heapAllocationsCur  = 0;
+}
+
+size_t RTGL1::FrameArena::GetUsedBytes() const
+{
+    return usedInFullBlocks + offset;
+}
+
+size_t RTGL1::FrameArena::GetCapacity() const
+{
+    size_t total = 0;
+    for( const Block& b : blocks )
+    {
+        total += b.size;
+    }
+    return total;
+}
+
+uint32_t RTGL1::FrameArena::GetHeapAllocationCount() const
+{
+    return heapAllocationsPrev;
+}
+
+
+RTGL1::FrameArenas::FrameArenas( size_t initialCapacity )
+{
+    for( auto& a : arenas )
+    {
+        a = std::make_unique< FrameArena >( initialCapacity );
+    }
+}
+
+void RTGL1::FrameArenas::PrepareForFrame( uint32_t frameIndex )
+{
+    arenas[ frameIndex ]->Reset();
+}
+
+void RTGL1::FrameArenas::ResetAll()
+{
+    for( auto& a : arenas )
+    {
+        a->Reset();
+    }
+}
+
+RTGL1::FrameArena& RTGL1::FrameArenas::Get( uint32_t frameIndex )
+{
+    assert( frameIndex < MAX_FRAMES_IN_FLIGHT );
+    return *arenas[ frameIndex ];
+}
+
+const RTGL1::FrameArena& RTGL1::FrameArenas::Get( uint32_t frameIndex ) const
+{
+    assert( frameIndex < MAX_FRAMES_IN_FLIGHT );
+    return *arenas[ frameIndex ];
+}
@@ -0,0 +1,146 @@
+/*
+
+Copyright (c) 2024 V.Shirokii
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "Common.h"
+
+#include <memory_resource>
+#include <vector>
+
+namespace RTGL1
+{
+
+// Linear allocator for CPU-side data that lives only during one frame.
+// Allocation is a pointer bump, deallocation is a no-op: all memory is reclaimed at once
+// by Reset. If a frame required more than one block, the blocks are merged into one
+// on Reset, so after a few frames, a steady-state frame does no heap allocations.
+class FrameArena final : public std::pmr::memory_resource
+{
+public:
+    explicit FrameArena( size_t initialCapacity );
+    ~FrameArena() override;
+
+    FrameArena( const FrameArena& other )                = delete;
+    FrameArena( FrameArena&& other ) noexcept            = delete;
+    FrameArena& operator=( const FrameArena& other )     = delete;
+    FrameArena& operator=( FrameArena&& other ) noexcept = delete;
+
+    // Destructor of the object is called on Reset
+    template< typename T, typename... Args >
+    T* New( Args&&... args );
+
+    // Destroy objects that were created with New, and reclaim all memory
+    void Reset();
+
+    [[nodiscard]] size_t GetUsedBytes() const;
+    [[nodiscard]] size_t GetCapacity() const;
+    // Count of heap allocations made by the arena during the previous frame
+    [[nodiscard]] uint32_t GetHeapAllocationCount() const;
+
+private:
+    void* do_allocate( size_t bytes, size_t alignment ) override;
+    void  do_deallocate( void* p, size_t bytes, size_t alignment ) override {}
+    bool  do_is_equal( const std::pmr::memory_resource& other ) const noexcept override
+    {
+        return this == &other;
+    }
+
+    void AddBlock( size_t minSize );
+    void FreeBlocks();
+    void RunFinalizers();
+
+private:
+    struct Block
+    {
+        std::byte* data;
+        size_t     size;
+    };
+
+    struct Finalizer
+    {
+        void ( *destroy )( void* );
+        void*      object;
+        Finalizer* next;
+    };
+
+    std::vector< Block > blocks;
+    size_t               offset{ 0 };
+    size_t               usedInFullBlocks{ 0 };
+
+    Finalizer* finalizers{ nullptr };
+
+    uint32_t heapAllocationsCur{ 0 };
+    uint32_t heapAllocationsPrev{ 0 };
+};
+
+template< typename T, typename... Args >
+T* FrameArena::New( Args&&... args )
+{
+    void* mem = allocate( sizeof( T ), alignof( T ) );
+    T*    obj = new( mem ) T{ std::forward< Args >( args )... };
+
+    if constexpr( !std::is_trivially_destructible_v< T > )
+    {
+        finalizers = new( allocate( sizeof( Finalizer ), alignof( Finalizer ) ) ) Finalizer{
+            .destroy = []( void* p ) { static_cast< T* >( p )->~T(); },
+            .object  = obj,
+            .next    = finalizers,
+        };
+    }
+
+    return obj;
+}
+
+// Container that allocates from a frame arena; must not outlive the arena's Reset
+template< typename T >
+using FrameVector = std::pmr::vector< T >;
+
+
+// One arena per frame in flight. Memory allocated from the arena of 'frameIndex'
+// is valid until the next PrepareForFrame( frameIndex ), i.e. until the fence
+// of that frame index is waited on.
+class FrameArenas
+{
+public:
+    explicit FrameArenas( size_t initialCapacity );
+    ~FrameArenas() = default;
+
+    FrameArenas( const FrameArenas& other )                = delete;
+    FrameArenas( FrameArenas&& other ) noexcept            = delete;
+    FrameArenas& operator=( const FrameArenas& other )     = delete;
+    FrameArenas& operator=( FrameArenas&& other ) noexcept = delete;
+
+    void PrepareForFrame( uint32_t frameIndex );
+    // Destroy objects of all frames, e.g. before their dependencies are destroyed
+    void ResetAll();
+
+    [[nodiscard]] FrameArena&       Get( uint32_t frameIndex );
+    [[nodiscard]] const FrameArena& Get( uint32_t frameIndex ) const;
+
+private:
+    std::unique_ptr< FrameArena > arenas[ MAX_FRAMES_IN_FLIGHT ];
+};
+
+}
@@ -0,0 +1,155 @@
+/*
+
+Copyright (c) 2024 V.Shirokii
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#include "FrameRingAllocator.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace
+{
+// not only a power of 2, as a texel block can be e.g. 12 bytes
+uint64_t AlignUp( uint64_t v, uint64_t alignment )
+{
+    assert( alignment > 0 );
+    return ( v + alignment - 1 ) / alignment * alignment;
+}
+}
+
+RTGL1::FrameRingAllocator::FrameRingAllocator( uint64_t _capacity ) : capacity( _capacity )
+{
+    assert( capacity > 0 );
+}
+
+void RTGL1::FrameRingAllocator::BeginFrame( uint32_t frameIndex )
+{
+    assert( frameIndex < MAX_FRAMES_IN_FLIGHT );
+
+    // allocations of the current frame end at head
+    frameEnd[ currentFrame ] = head;
+
+    // frames are released in the same order as they were allocated in,
+    // so everything before the end of this one is free
+    if( frameBytes[ frameIndex ] > 0 )
+    {
+        assert( used >= frameBytes[ frameIndex ] );
+
+        tail = frameEnd[ frameIndex ];
+        used -= frameBytes[ frameIndex ];
+        frameBytes[ frameIndex ] = 0;
+    }
+
+    // start from the beginning to not waste the space on wrapping
+    if( used == 0 )
+    {
+        head = 0;
+        tail = 0;
+    }
+
+    currentFrame = frameIndex;
+}
+
+auto RTGL1::FrameRingAllocator::Allocate( uint64_t size, uint64_t alignment )
+    -> std::optional< uint64_t >
+{
+    if( size == 0 || size > capacity )
+    {
+        return std::nullopt;
+    }
+
+    // full
+    if( used > 0 && head == tail )
+    {
+        return std::nullopt;
+    }
+
+    uint64_t offset;
+    uint64_t consumed;
+
+    const uint64_t aligned = AlignUp( head, alignment );
+
+    if( head >= tail )
+    {
+        // free: [head, capacity) and [0, tail)
+        if( aligned + size <= capacity )
+        {
+            offset   = aligned;
+            consumed = aligned + size - head;
+        }
+        else if( size <= tail )
+        {
+            // skip the rest until the end
+            offset   = 0;
+            consumed = capacity - head + size;
+        }
+        else
+        {
+            return std::nullopt;
+        }
+    }
+    else
+    {
+        // free: [head, tail)
+        if( aligned + size <= tail )
+        {
+            offset   = aligned;
+            consumed = aligned + size - head;
+        }
+        else
+        {
+            return std::nullopt;
+        }
+    }
+
+    head = offset + size;
+    if( head == capacity )
+    {
+        head = 0;
+    }
+
+    used += consumed;
+    frameBytes[ currentFrame ] += consumed;
+
+    assert( used <= capacity );
+    return offset;
+}
+
+auto RTGL1::FrameRingAllocator::GetMaxAllocationSize( uint64_t alignment ) const -> uint64_t
+{
+    if( used > 0 && head == tail )
+    {
+        return 0;
+    }
+
+    const uint64_t aligned = AlignUp( head, alignment );
+
+    if( head >= tail )
+    {
+        const uint64_t untilEnd = aligned < capacity ? capacity - aligned : 0;
+        return std::max( untilEnd, tail );
+    }
+
+    return aligned < tail ? tail - aligned : 0;
+}
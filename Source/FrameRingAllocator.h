@@ -0,0 +1,70 @@
+/*
+
+Copyright (c) 2024 V.Shirokii
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#pragma once
+
+#include "Common.h"
+
+#include <cstdint>
+#include <optional>
+
+namespace RTGL1
+{
+
+// Linear allocator over a fixed range that wraps around. Allocations are not freed
+// one by one: all allocations that were made during a frame are released together
+// on BeginFrame with the same index, as its fence was waited by then.
+// Only operates on offsets, so it doesn't depend on the memory it manages.
+class FrameRingAllocator
+{
+public:
+    explicit FrameRingAllocator( uint64_t capacity );
+
+    // Release the allocations of the previous frame with the same index
+    void BeginFrame( uint32_t frameIndex );
+
+    // Returns an offset, or nullopt, if there's not enough contiguous space until
+    // the allocations of the frames in flight are released
+    auto Allocate( uint64_t size, uint64_t alignment ) -> std::optional< uint64_t >;
+    // Largest size that Allocate can succeed with right now
+    auto GetMaxAllocationSize( uint64_t alignment ) const -> uint64_t;
+
+    auto GetCapacity() const -> uint64_t { return capacity; }
+    // Including the bytes that were skipped on wrapping
+    auto GetUsedBytes() const -> uint64_t { return used; }
+
+private:
+    uint64_t capacity;
+    // next allocation starts at head, the oldest live allocation at tail
+    uint64_t head{ 0 };
+    uint64_t tail{ 0 };
+    uint64_t used{ 0 };
+
+    uint32_t currentFrame{ 0 };
+    uint64_t frameEnd[ MAX_FRAMES_IN_FLIGHT ]{};
+    uint64_t frameBytes[ MAX_FRAMES_IN_FLIGHT ]{};
+};
+
+}
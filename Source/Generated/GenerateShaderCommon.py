@@ -245,6 +245,7 @@ CONST = {
     "BINDING_GLOBAL_UNIFORM"                    : 0,
     "BINDING_ACCELERATION_STRUCTURE_MAIN"       : 0,
     "BINDING_TEXTURES"                          : 0,
+    "BINDING_TEXTURE_FEEDBACK"                  : 1,
     "BINDING_CUBEMAPS"                          : 0,
     "BINDING_RENDER_CUBEMAP"                    : 0,
     "BINDING_BLUE_NOISE"                        : 0,
@@ -253,8 +254,9 @@ CONST = {
     "BINDING_LIGHT_SOURCES_PREV"                : 1,
     "BINDING_LIGHT_SOURCES_INDEX_PREV_TO_CUR"   : 2,
     "BINDING_LIGHT_SOURCES_INDEX_CUR_TO_PREV"   : 3,
-    "BINDING_INITIAL_LIGHTS_GRID"               : 4,
-    "BINDING_INITIAL_LIGHTS_GRID_PREV"          : 5,
+    "BINDING_LIGHT_TREE"                        : 4,
+    "BINDING_INITIAL_LIGHTS_GRID"               : 5,
+    "BINDING_INITIAL_LIGHTS_GRID_PREV"          : 6,
     "BINDING_LENS_FLARES_CULLING_INPUT"         : 0,
     "BINDING_LENS_FLARES_DRAW_CMDS"             : 1,
     "BINDING_DRAW_LENS_FLARES_INSTANCES"        : 0,
@@ -302,6 +304,8 @@ CONST = {
     
     "MATERIAL_NO_TEXTURE"                   : 0,
 
+    "TEXTURE_FEEDBACK_LOD_BIAS"             : 16,
+
     "MATERIAL_BLENDING_TYPE_OPAQUE"         : 0,
     "MATERIAL_BLENDING_TYPE_ALPHA"          : 1,
     "MATERIAL_BLENDING_TYPE_ADD"            : 2,
@@ -424,7 +428,10 @@ CONST = {
     "LIGHT_ARRAY_DIRECTIONAL_LIGHT_OFFSET"  : 0,
     "LIGHT_ARRAY_REGULAR_LIGHTS_OFFSET"     : 1,
 
-    "LIGHT_INDEX_NONE"                      : ((1 << 15) - 1),
+    "LIGHT_INDEX_NONE"                      : ((1 << 24) - 1),
+
+    "LIGHT_TREE_LEAF_FLAG"                  : BIT( 30 ),
+    "LIGHT_TREE_MAX_DEPTH"                  : 64,
 
     "LIGHT_GRID_ENABLED"                    : 0, # no effect on enabling?
 #   "LIGHT_GRID_SIZE_X"                     : 16,
@@ -599,7 +606,7 @@ GLOBAL_UNIFORM_STRUCT = [
 
     (TYPE_UINT32,       1,      "rayCullMaskWorld_Shadow",          1),
     (TYPE_UINT32,       1,      "volumeAllowTintUnderwater",        1),
-    (TYPE_UINT32,       1,      "_unused2",                         1),
+    (TYPE_UINT32,       1,      "lightTreeNodeCount",               1),
     (TYPE_UINT32,       1,      "twirlPortalNormal",                1),
 
     (TYPE_UINT32,       1,      "lightIndexIgnoreFPVShadows",       1),
@@ -625,7 +632,7 @@ GLOBAL_UNIFORM_STRUCT = [
     (TYPE_UINT32,       1,      "hdrDisplay",                       1),
     (TYPE_FLOAT32,      1,      "parallaxMaxDepth",                 1),
     (TYPE_UINT32,       1,      "fluidEnabled",                     1),
-    (TYPE_FLOAT32,      1,      "_pad3",                            1),
+    (TYPE_UINT32,       1,      "textureFeedbackEnabled",           1),
 
     (TYPE_FLOAT32,      4,      "fluidColor",                       1),
 
@@ -687,6 +694,18 @@ LIGHT_ENCODED_STRUCT = [
     (TYPE_FLOAT32,      1,      "ldata3",               1),
 ]
 
+# Interior node: first child is the next node, 'childOrLightIndex' is the second child.
+# Leaf: 'childOrLightIndex' is a light index with LIGHT_TREE_LEAF_FLAG.
+# 'cosThetaOE' is packed half2: normals bound and emission spread of the cone around 'coneAxis'.
+LIGHT_TREE_NODE_STRUCT = [
+    (TYPE_FLOAT32,      3,      "boundsMin",            1),
+    (TYPE_UINT32,       1,      "childOrLightIndex",    1),
+    (TYPE_FLOAT32,      3,      "boundsMax",            1),
+    (TYPE_FLOAT32,      1,      "power",                1),
+    (TYPE_FLOAT32,      3,      "coneAxis",             1),
+    (TYPE_UINT32,       1,      "cosThetaOE",           1),
+]
+
 # TODO: light index / target pdf - 16 bits
 LIGHT_IN_CELL = [
     (TYPE_UINT32,       1,      "selected_lightIndex",  1),
@@ -744,6 +763,7 @@ STRUCTS = {
     "ShTonemapping":            (TONEMAPPING_STRUCT,            False,  0,                          0),
     "ShLightEncoded":           (LIGHT_ENCODED_STRUCT,          False,  0,                          0),
     "ShLightInCell":            (LIGHT_IN_CELL,                 False,  STRUCT_ALIGNMENT_STD430,    0),
+    "ShLightTreeNode":          (LIGHT_TREE_NODE_STRUCT,        False,  STRUCT_ALIGNMENT_STD430,    0),
     "ShIndirectDrawCommand":    (INDIRECT_DRAW_CMD_STRUCT,      False,  STRUCT_ALIGNMENT_STD430,    0),
     # TODO: should be STRUCT_ALIGNMENT_STD430, but current generator is not great as it just adds pads at the end, so it's 0
     "ShLensFlareInstance":      (LENS_FLARES_INSTANCE_STRUCT,   False,  0,                          0),
@@ -26,6 +26,7 @@ namespace RTGL1
 #define BINDING_GLOBAL_UNIFORM (0)
 #define BINDING_ACCELERATION_STRUCTURE_MAIN (0)
 #define BINDING_TEXTURES (0)
+#define BINDING_TEXTURE_FEEDBACK (1)
 #define BINDING_CUBEMAPS (0)
 #define BINDING_RENDER_CUBEMAP (0)
 #define BINDING_BLUE_NOISE (0)
@@ -34,8 +35,9 @@ namespace RTGL1
 #define BINDING_LIGHT_SOURCES_PREV (1)
 #define BINDING_LIGHT_SOURCES_INDEX_PREV_TO_CUR (2)
 #define BINDING_LIGHT_SOURCES_INDEX_CUR_TO_PREV (3)
-#define BINDING_INITIAL_LIGHTS_GRID (4)
-#define BINDING_INITIAL_LIGHTS_GRID_PREV (5)
+#define BINDING_LIGHT_TREE (4)
+#define BINDING_INITIAL_LIGHTS_GRID (5)
+#define BINDING_INITIAL_LIGHTS_GRID_PREV (6)
 #define BINDING_LENS_FLARES_CULLING_INPUT (0)
 #define BINDING_LENS_FLARES_DRAW_CMDS (1)
 #define BINDING_DRAW_LENS_FLARES_INSTANCES (0)
@@ -74,6 +76,7 @@ namespace RTGL1
 #define SBT_INDEX_HITGROUP_FULLY_OPAQUE (0)
 #define SBT_INDEX_HITGROUP_ALPHA_TESTED (1)
 #define MATERIAL_NO_TEXTURE (0)
+#define TEXTURE_FEEDBACK_LOD_BIAS (16)
 #define MATERIAL_BLENDING_TYPE_OPAQUE (0)
 #define MATERIAL_BLENDING_TYPE_ALPHA (1)
 #define MATERIAL_BLENDING_TYPE_ADD (2)
@@ -171,7 +174,9 @@ namespace RTGL1
 #define TRIANGLE_LIGHTS (0)
 #define LIGHT_ARRAY_DIRECTIONAL_LIGHT_OFFSET (0)
 #define LIGHT_ARRAY_REGULAR_LIGHTS_OFFSET (1)
-#define LIGHT_INDEX_NONE (32767)
+#define LIGHT_INDEX_NONE (16777215)
+#define LIGHT_TREE_LEAF_FLAG (1 << 30)
+#define LIGHT_TREE_MAX_DEPTH (64)
 #define LIGHT_GRID_ENABLED (0)
 #define PORTAL_INDEX_NONE (63)
 #define PORTAL_MAX_COUNT (63)
@@ -279,7 +284,7 @@ struct ShGlobalUniform
     float primaryRayMinDist;
     uint32_t rayCullMaskWorld_Shadow;
     uint32_t volumeAllowTintUnderwater;
-    uint32_t _unused2;
+    uint32_t lightTreeNodeCount;
     uint32_t twirlPortalNormal;
     uint32_t lightIndexIgnoreFPVShadows;
     float gradientMultDiffuse;
@@ -300,7 +305,7 @@ struct ShGlobalUniform
     uint32_t hdrDisplay;
     float parallaxMaxDepth;
     uint32_t fluidEnabled;
-    float _pad3;
+    uint32_t textureFeedbackEnabled;
     float fluidColor[4];
     float viewProjCubemap[96];
     float skyCubemapRotationTransform[16];
@@ -364,6 +369,16 @@ struct ShLightInCell
     uint32_t __pad0;
 };
 
+struct ShLightTreeNode
+{
+    float boundsMin[3];
+    uint32_t childOrLightIndex;
+    float boundsMax[3];
+    float power;
+    float coneAxis[3];
+    uint32_t cosThetaOE;
+};
+
 struct ShIndirectDrawCommand
 {
     uint32_t indexCount;
@@ -19,6 +19,7 @@
 #define BINDING_GLOBAL_UNIFORM (0)
 #define BINDING_ACCELERATION_STRUCTURE_MAIN (0)
 #define BINDING_TEXTURES (0)
+#define BINDING_TEXTURE_FEEDBACK (1)
 #define BINDING_CUBEMAPS (0)
 #define BINDING_RENDER_CUBEMAP (0)
 #define BINDING_BLUE_NOISE (0)
@@ -27,8 +28,9 @@
 #define BINDING_LIGHT_SOURCES_PREV (1)
 #define BINDING_LIGHT_SOURCES_INDEX_PREV_TO_CUR (2)
 #define BINDING_LIGHT_SOURCES_INDEX_CUR_TO_PREV (3)
-#define BINDING_INITIAL_LIGHTS_GRID (4)
-#define BINDING_INITIAL_LIGHTS_GRID_PREV (5)
+#define BINDING_LIGHT_TREE (4)
+#define BINDING_INITIAL_LIGHTS_GRID (5)
+#define BINDING_INITIAL_LIGHTS_GRID_PREV (6)
 #define BINDING_LENS_FLARES_CULLING_INPUT (0)
 #define BINDING_LENS_FLARES_DRAW_CMDS (1)
 #define BINDING_DRAW_LENS_FLARES_INSTANCES (0)
@@ -67,6 +69,7 @@
 #define SBT_INDEX_HITGROUP_FULLY_OPAQUE (0)
 #define SBT_INDEX_HITGROUP_ALPHA_TESTED (1)
 #define MATERIAL_NO_TEXTURE (0)
+#define TEXTURE_FEEDBACK_LOD_BIAS (16)
 #define MATERIAL_BLENDING_TYPE_OPAQUE (0)
 #define MATERIAL_BLENDING_TYPE_ALPHA (1)
 #define MATERIAL_BLENDING_TYPE_ADD (2)
@@ -164,7 +167,9 @@
 #define TRIANGLE_LIGHTS (0)
 #define LIGHT_ARRAY_DIRECTIONAL_LIGHT_OFFSET (0)
 #define LIGHT_ARRAY_REGULAR_LIGHTS_OFFSET (1)
-#define LIGHT_INDEX_NONE (32767)
+#define LIGHT_INDEX_NONE (16777215)
+#define LIGHT_TREE_LEAF_FLAG (1 << 30)
+#define LIGHT_TREE_MAX_DEPTH (64)
 #define LIGHT_GRID_ENABLED (0)
 #define PORTAL_INDEX_NONE (63)
 #define PORTAL_MAX_COUNT (63)
@@ -274,7 +279,7 @@ struct ShGlobalUniform
     float primaryRayMinDist;
     uint rayCullMaskWorld_Shadow;
     uint volumeAllowTintUnderwater;
-    uint _unused2;
+    uint lightTreeNodeCount;
     uint twirlPortalNormal;
     uint lightIndexIgnoreFPVShadows;
     float gradientMultDiffuse;
@@ -295,7 +300,7 @@ struct ShGlobalUniform
     uint hdrDisplay;
     float parallaxMaxDepth;
     uint fluidEnabled;
-    float _pad3;
+    uint textureFeedbackEnabled;
     vec4 fluidColor;
     mat4 viewProjCubemap[6];
     mat4 skyCubemapRotationTransform;
@@ -359,6 +364,16 @@ struct ShLightInCell
     uint __pad0;
 };
 
+struct ShLightTreeNode
+{
+    vec3 boundsMin;
+    uint childOrLightIndex;
+    vec3 boundsMax;
+    float power;
+    vec3 coneAxis;
+    uint cosThetaOE;
+};
+
 struct ShIndirectDrawCommand
 {
     uint indexCount;
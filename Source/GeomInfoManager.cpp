@@ -228,7 +228,7 @@ RTGL1::GeomInfoManager::GeomInfoManager( VkDevice                            _de
 
 bool RTGL1::GeomInfoManager::CopyFromStaging( VkCommandBuffer    cmd,
                                               uint32_t           frameIndex,
-                                              UniqueIDToTlasID&& tlas )
+                                              UniqueIDToTlasID&  tlas )
 {
     auto label = CmdLabel{ cmd, "Copying geom infos" };
 
@@ -291,7 +291,7 @@ bool RTGL1::GeomInfoManager::CopyFromStaging( VkCommandBuffer    cmd,
     }
 
 
-    tlas_prev = std::move( tlas );
+    std::swap( tlas_prev, tlas );
 
 
     if( matchprev_range.valid() )
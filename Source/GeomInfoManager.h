@@ -74,7 +74,8 @@ public:
                                                const RgTransform&       transform );
 
 
-    bool CopyFromStaging( VkCommandBuffer cmd, uint32_t frameIndex, UniqueIDToTlasID&& tlas );
+    // 'tlas' is swapped with the previous frame's mapping, to reuse its memory
+    bool CopyFromStaging( VkCommandBuffer cmd, uint32_t frameIndex, UniqueIDToTlasID& tlas );
 
 
     VkBuffer GetBuffer() const;
@@ -34,7 +34,8 @@ GlobalUniform::GlobalUniform( VkDevice _device, std::shared_ptr< MemoryAllocator
 {
     uniformData = std::make_shared< ShGlobalUniform >();
 
-    uniformBuffer = std::make_shared< AutoBuffer >( std::move( _allocator ) );
+    uniformBuffer =
+        std::make_shared< AutoBuffer >( std::move( _allocator ), AutoBuffer::Staging::PerFrame );
     uniformBuffer->Create(
         sizeof( ShGlobalUniform ), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, "Uniform buffer" );
 
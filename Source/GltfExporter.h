@@ -41,12 +41,6 @@ struct GltfMeshNode
     bool     operator<( const GltfMeshNode& other ) const;
     uint64_t Hash() const;
 };
-
-struct PositionNormal
-{
-    RgFloat3D position;
-    RgFloat3D normal;
-};
 }
 
 template<>
@@ -81,13 +75,6 @@ public:
                         const std::filesystem::path& ovrdFolder,
                         bool                         isSceneGltf );
 
-    // TODO: allocators, to not pass references
-    static void MakeLightsForPrimitiveDynamic( const RgMeshInfo&              mesh,
-                                               const RgMeshPrimitiveInfo&     primitive,
-                                               float                          oneGameUnitInMeters,
-                                               std::vector< PositionNormal >& tempStorage,
-                                               std::vector< AnyLightEXT >&    resultStorage );
-
 private:
     MeshesToTheirPrimitives  scene;
     std::set< std::string >  sceneMaterials;
@@ -0,0 +1,161 @@
+/*
+
+Copyright (c) 2024 V.Shirokii
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#include "HeapAllocationCounter.h"
+
+#if RG_COUNT_HEAP_ALLOCATIONS
+
+    #include <algorithm>
+    #include <cassert>
+    #include <cstdlib>
+    #include <new>
+
+    #ifdef _MSC_VER
+        #include <malloc.h>
+    #endif
+
+namespace
+{
+
+// only the frame thread is counted, workers' allocations don't belong to a frame
+thread_local bool     t_counting = false;
+thread_local uint32_t t_paused   = 0;
+thread_local uint32_t t_count    = 0;
+
+void* Allocate( size_t size ) noexcept
+{
+    if( t_counting && t_paused == 0 )
+    {
+        t_count++;
+    }
+    return std::malloc( size > 0 ? size : 1 );
+}
+
+void* AllocateAligned( size_t size, std::align_val_t al ) noexcept
+{
+    if( t_counting && t_paused == 0 )
+    {
+        t_count++;
+    }
+
+    const auto alignment = static_cast< size_t >( al );
+    size                 = size > 0 ? size : 1;
+
+    #ifdef _MSC_VER
+    return _aligned_malloc( size, alignment );
+    #else
+    void* p = nullptr;
+    return posix_memalign( &p, std::max( alignment, sizeof( void* ) ), size ) == 0 ? p : nullptr;
+    #endif
+}
+
+void FreeAligned( void* p ) noexcept
+{
+    #ifdef _MSC_VER
+    _aligned_free( p );
+    #else
+    std::free( p );
+    #endif
+}
+
+void* AllocateOrThrow( size_t size )
+{
+    if( void* p = Allocate( size ) )
+    {
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+
+void* AllocateAlignedOrThrow( size_t size, std::align_val_t al )
+{
+    if( void* p = AllocateAligned( size, al ) )
+    {
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+
+}
+
+// clang-format off
+void* operator new  ( size_t size ) { return AllocateOrThrow( size ); }
+void* operator new[]( size_t size ) { return AllocateOrThrow( size ); }
+void* operator new  ( size_t size, const std::nothrow_t& ) noexcept { return Allocate( size ); }
+void* operator new[]( size_t size, const std::nothrow_t& ) noexcept { return Allocate( size ); }
+void* operator new  ( size_t size, std::align_val_t al ) { return AllocateAlignedOrThrow( size, al ); }
+void* operator new[]( size_t size, std::align_val_t al ) { return AllocateAlignedOrThrow( size, al ); }
+void* operator new  ( size_t size, std::align_val_t al, const std::nothrow_t& ) noexcept { return AllocateAligned( size, al ); }
+void* operator new[]( size_t size, std::align_val_t al, const std::nothrow_t& ) noexcept { return AllocateAligned( size, al ); }
+
+void operator delete  ( void* p ) noexcept { std::free( p ); }
+void operator delete[]( void* p ) noexcept { std::free( p ); }
+void operator delete  ( void* p, size_t ) noexcept { std::free( p ); }
+void operator delete[]( void* p, size_t ) noexcept { std::free( p ); }
+void operator delete  ( void* p, const std::nothrow_t& ) noexcept { std::free( p ); }
+void operator delete[]( void* p, const std::nothrow_t& ) noexcept { std::free( p ); }
+void operator delete  ( void* p, std::align_val_t ) noexcept { FreeAligned( p ); }
+void operator delete[]( void* p, std::align_val_t ) noexcept { FreeAligned( p ); }
+void operator delete  ( void* p, size_t, std::align_val_t ) noexcept { FreeAligned( p ); }
+void operator delete[]( void* p, size_t, std::align_val_t ) noexcept { FreeAligned( p ); }
+void operator delete  ( void* p, std::align_val_t, const std::nothrow_t& ) noexcept { FreeAligned( p ); }
+void operator delete[]( void* p, std::align_val_t, const std::nothrow_t& ) noexcept { FreeAligned( p ); }
+// clang-format on
+
+void RTGL1::HeapAllocationCounter::Begin()
+{
+    t_count    = 0;
+    t_counting = true;
+}
+
+uint32_t RTGL1::HeapAllocationCounter::End()
+{
+    t_counting = false;
+    return t_count;
+}
+
+void RTGL1::HeapAllocationCounter::Pause()
+{
+    t_paused++;
+}
+
+void RTGL1::HeapAllocationCounter::Resume()
+{
+    assert( t_paused > 0 );
+    t_paused--;
+}
+
+#else // !RG_COUNT_HEAP_ALLOCATIONS
+
+void RTGL1::HeapAllocationCounter::Begin() {}
+void RTGL1::HeapAllocationCounter::Pause() {}
+void RTGL1::HeapAllocationCounter::Resume() {}
+
+uint32_t RTGL1::HeapAllocationCounter::End()
+{
+    return 0;
+}
+
+#endif // RG_COUNT_HEAP_ALLOCATIONS
@@ -0,0 +1,70 @@
+/*
+
+Copyright (c) 2024 V.Shirokii
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#pragma once
+
+#include <cstdint>
+
+// Debug builds replace the global operator new / delete of the library,
+// to count heap allocations that are made during a frame. Only on Windows by default,
+// as a DLL's replacement is used only by the DLL itself; on other platforms,
+// it would be shared with the whole process, so the host's allocations would be counted too
+#ifndef RG_COUNT_HEAP_ALLOCATIONS
+    #if !defined( NDEBUG ) && defined( _WIN32 )
+        #define RG_COUNT_HEAP_ALLOCATIONS 1
+    #else
+        #define RG_COUNT_HEAP_ALLOCATIONS 0
+    #endif
+#endif
+
+namespace RTGL1::HeapAllocationCounter
+{
+
+constexpr bool IsEnabled()
+{
+    return RG_COUNT_HEAP_ALLOCATIONS;
+}
+
+// Start counting operator new calls of the calling thread
+void     Begin();
+// Stop counting, and return the count since Begin. Always 0, if not enabled
+uint32_t End();
+
+// Exclude the calls until Resume, e.g. of the developer tools; can be nested
+void Pause();
+void Resume();
+
+struct ScopedPause
+{
+    ScopedPause() { Pause(); }
+    ~ScopedPause() { Resume(); }
+
+    ScopedPause( const ScopedPause& other )                = delete;
+    ScopedPause( ScopedPause&& other ) noexcept            = delete;
+    ScopedPause& operator=( const ScopedPause& other )     = delete;
+    ScopedPause& operator=( ScopedPause&& other ) noexcept = delete;
+};
+
+}
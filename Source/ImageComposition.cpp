@@ -45,7 +45,9 @@ RTGL1::ImageComposition::ImageComposition( VkDevice                           _d
     , descPool( VK_NULL_HANDLE )
     , descSet( VK_NULL_HANDLE )
 {
-    lpmParams = std::make_unique< AutoBuffer >( std::move( _allocator ) );
+    // copied right after it's written
+    lpmParams =
+        std::make_unique< AutoBuffer >( std::move( _allocator ), AutoBuffer::Staging::PerFrame );
     lpmParams->Create( LPM_BUFFER_SIZE, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, "LPM Params" );
 
     CreateDescriptors();
@@ -20,15 +20,73 @@
 
 #include "ImageLoader.h"
 
+#include "JobSystem.h"
+#include "MappedFile.h"
+#include "Utils.h"
+
 #include <ktx.h>
 #include <ktxvulkan.h>
+#include <zstd.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cstring>
+
+namespace
+{
+
+constexpr uint8_t KTX2_IDENTIFIER[] = {
+    0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A,
+};
+
+constexpr uint32_t KTX2_SUPERCOMPRESSION_NONE = 0;
+constexpr uint32_t KTX2_SUPERCOMPRESSION_ZSTD = 2;
+
+struct Ktx2Header
+{
+    uint8_t  identifier[ 12 ];
+    uint32_t vkFormat;
+    uint32_t typeSize;
+    uint32_t pixelWidth;
+    uint32_t pixelHeight;
+    uint32_t pixelDepth;
+    uint32_t layerCount;
+    uint32_t faceCount;
+    uint32_t levelCount;
+    uint32_t supercompressionScheme;
+    uint32_t dfdByteOffset;
+    uint32_t dfdByteLength;
+    uint32_t kvdByteOffset;
+    uint32_t kvdByteLength;
+    uint64_t sgdByteOffset;
+    uint64_t sgdByteLength;
+};
+static_assert( sizeof( Ktx2Header ) == 80 );
+
+struct Ktx2LevelIndex
+{
+    uint64_t byteOffset;
+    uint64_t byteLength;
+    uint64_t uncompressedByteLength;
+};
+static_assert( sizeof( Ktx2LevelIndex ) == 24 );
+
+// enough for block-compressed formats, and bufferOffset of vkCmdCopyBufferToImage
+constexpr size_t DECOMPRESSED_LEVEL_ALIGNMENT = 16;
+
+}
+
+RTGL1::ImageLoader::ImageLoader( bool _deferDecompression, JobSystem* _jobs )
+    : deferDecompression{ _deferDecompression }
+    , jobs{ _jobs }
+{
+}
 
 RTGL1::ImageLoader::~ImageLoader()
 {
     assert( loadedImages.empty() );
+    assert( mappedFiles.empty() );
 }
 
 bool RTGL1::ImageLoader::LoadTextureFile( const std::filesystem::path& path,
@@ -48,6 +106,20 @@ std::optional< RTGL1::ImageLoader::ResultInfo > RTGL1::ImageLoader::Load(
         return std::nullopt;
     }
 
+    {
+        auto mapped = std::make_unique< MappedFile >( path );
+        if( !mapped->IsValid() )
+        {
+            return std::nullopt;
+        }
+
+        if( auto r = TryMakeMappedResult( mapped->GetData() ) )
+        {
+            mappedFiles.push_back( std::move( mapped ) );
+            return r;
+        }
+    }
+
     ktxTexture* pTexture = nullptr;
     bool        loaded   = LoadTextureFile( path, &pTexture );
 
@@ -56,6 +128,37 @@ std::optional< RTGL1::ImageLoader::ResultInfo > RTGL1::ImageLoader::Load(
         return std::nullopt;
     }
 
+    return MakeResult( pTexture );
+}
+
+std::optional< RTGL1::ImageLoader::ResultInfo > RTGL1::ImageLoader::Load(
+    std::span< const uint8_t > ktx2File )
+{
+    if( ktx2File.empty() )
+    {
+        return std::nullopt;
+    }
+
+    // the memory is owned by the caller, so nothing is copied
+    if( auto r = TryMakeMappedResult( ktx2File ) )
+    {
+        return r;
+    }
+
+    ktxTexture*    pTexture = nullptr;
+    KTX_error_code r        = ktxTexture_CreateFromMemory(
+        ktx2File.data(), ktx2File.size(), KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT, &pTexture );
+
+    if( r != KTX_SUCCESS )
+    {
+        return std::nullopt;
+    }
+
+    return MakeResult( pTexture );
+}
+
+RTGL1::ImageLoader::ResultInfo RTGL1::ImageLoader::MakeResult( ktxTexture* pTexture )
+{
     assert( pTexture->numDimensions == 2 );
     assert( pTexture->numLevels <= MAX_PREGENERATED_MIPMAP_LEVELS );
     assert( pTexture->numLayers == 1 );
@@ -71,6 +174,8 @@ std::optional< RTGL1::ImageLoader::ResultInfo > RTGL1::ImageLoader::Load(
         .dataSize       = ktxTexture_GetDataSize( pTexture ),
         .baseSize       = { pTexture->baseWidth, pTexture->baseHeight },
         .format         = ktxTexture_GetVkFormat( pTexture ),
+        .pZstdLevels    = nullptr,
+        .contentHash    = 0,
     };
 
     // get mipmap offsets / sizes
@@ -96,6 +201,165 @@ std::optional< RTGL1::ImageLoader::ResultInfo > RTGL1::ImageLoader::Load(
     return result;
 }
 
+auto RTGL1::ImageLoader::TryMakeMappedResult( std::span< const uint8_t > file )
+    -> std::optional< ResultInfo >
+{
+    auto header = Ktx2Header{};
+    if( file.size() < sizeof( header ) )
+    {
+        return std::nullopt;
+    }
+    memcpy( &header, file.data(), sizeof( header ) );
+
+    if( memcmp( header.identifier, KTX2_IDENTIFIER, sizeof( KTX2_IDENTIFIER ) ) != 0 )
+    {
+        return std::nullopt;
+    }
+
+    // everything else, e.g. Basis Universal or cubemaps, is left to libktx
+    if( header.vkFormat == VK_FORMAT_UNDEFINED || header.pixelHeight == 0 ||
+        header.pixelDepth != 0 || header.layerCount > 1 || header.faceCount != 1 ||
+        ( header.supercompressionScheme != KTX2_SUPERCOMPRESSION_NONE &&
+          header.supercompressionScheme != KTX2_SUPERCOMPRESSION_ZSTD ) )
+    {
+        return std::nullopt;
+    }
+
+    const uint32_t levelCount =
+        std::clamp( header.levelCount, 1u, MAX_PREGENERATED_MIPMAP_LEVELS );
+
+    if( file.size() < sizeof( header ) + sizeof( Ktx2LevelIndex ) * levelCount )
+    {
+        return std::nullopt;
+    }
+
+    Ktx2LevelIndex index[ MAX_PREGENERATED_MIPMAP_LEVELS ] = {};
+    memcpy( index, file.data() + sizeof( header ), sizeof( Ktx2LevelIndex ) * levelCount );
+
+    for( uint32_t level = 0; level < levelCount; level++ )
+    {
+        if( index[ level ].byteLength == 0 ||
+            index[ level ].byteOffset > file.size() ||
+            index[ level ].byteLength > file.size() - index[ level ].byteOffset )
+        {
+            return std::nullopt;
+        }
+    }
+
+    auto result = ResultInfo{
+        .levelOffsets   = {},
+        .levelSizes     = {},
+        .levelCount     = levelCount,
+        .isPregenerated = true,
+        .pData          = nullptr,
+        .dataSize       = 0,
+        .baseSize       = { header.pixelWidth, header.pixelHeight },
+        .format         = VkFormat( header.vkFormat ),
+        .pZstdLevels    = nullptr,
+        .contentHash    = 0,
+    };
+
+    if( header.supercompressionScheme == KTX2_SUPERCOMPRESSION_NONE )
+    {
+        // reference the levels in the file; the smallest level is the first in KTX2
+        size_t minOffset = SIZE_MAX;
+        size_t maxEnd    = 0;
+        for( uint32_t level = 0; level < levelCount; level++ )
+        {
+            minOffset = std::min< size_t >( minOffset, index[ level ].byteOffset );
+            maxEnd    = std::max< size_t >( maxEnd,
+                                         index[ level ].byteOffset + index[ level ].byteLength );
+        }
+
+        for( uint32_t level = 0; level < levelCount; level++ )
+        {
+            result.levelOffsets[ level ] = index[ level ].byteOffset - minOffset;
+            result.levelSizes[ level ]   = index[ level ].byteLength;
+        }
+        result.pData    = file.data() + minOffset;
+        result.dataSize = maxEnd - minOffset;
+
+        return result;
+    }
+
+    // zstd: levels are packed one after another in the decompressed layout
+    auto levels = std::make_unique< std::span< const uint8_t >[] >( levelCount );
+    for( uint32_t level = 0; level < levelCount; level++ )
+    {
+        if( index[ level ].uncompressedByteLength == 0 )
+        {
+            return std::nullopt;
+        }
+
+        result.dataSize = Utils::Align( result.dataSize, DECOMPRESSED_LEVEL_ALIGNMENT );
+
+        result.levelOffsets[ level ] = result.dataSize;
+        result.levelSizes[ level ]   = index[ level ].uncompressedByteLength;
+        result.dataSize += index[ level ].uncompressedByteLength;
+
+        levels[ level ] = file.subspan( index[ level ].byteOffset, index[ level ].byteLength );
+    }
+
+    if( deferDecompression )
+    {
+        result.pZstdLevels = levels.get();
+        zstdLevels.push_back( std::move( levels ) );
+        return result;
+    }
+
+    // one job per level, each is decompressed directly to its place in the owned buffer
+    auto dst        = std::make_unique< uint8_t[] >( result.dataSize );
+    auto failed     = std::atomic_bool{ false };
+    auto decompress = [ & ]( size_t begin, size_t end ) {
+        for( size_t i = begin; i < end; i++ )
+        {
+            if( !DecompressLevel(
+                    levels[ i ], &dst[ result.levelOffsets[ i ] ], result.levelSizes[ i ] ) )
+            {
+                failed = true;
+            }
+        }
+    };
+
+    if( jobs && levelCount > 1 )
+    {
+        jobs->ParallelFor( levelCount, 1, decompress );
+    }
+    else
+    {
+        decompress( 0, levelCount );
+    }
+
+    if( failed )
+    {
+        return std::nullopt;
+    }
+
+    result.pData = dst.get();
+    decompressed.push_back( std::move( dst ) );
+    return result;
+}
+
+bool RTGL1::ImageLoader::DecompressLevel( std::span< const uint8_t > src,
+                                          void*                      dst,
+                                          size_t                     dstSize )
+{
+    // one context per thread, to not reallocate it for each level
+    struct DCtxDeleter
+    {
+        void operator()( ZSTD_DCtx* p ) const { ZSTD_freeDCtx( p ); }
+    };
+    thread_local auto dctx = std::unique_ptr< ZSTD_DCtx, DCtxDeleter >{ ZSTD_createDCtx() };
+
+    if( !dctx )
+    {
+        return false;
+    }
+
+    size_t r = ZSTD_decompressDCtx( dctx.get(), dst, dstSize, src.data(), src.size() );
+    return !ZSTD_isError( r ) && r == dstSize;
+}
+
 std::optional< RTGL1::ImageLoader::LayeredResultInfo > RTGL1::ImageLoader::LoadLayered(
     const std::filesystem::path& path )
 {
@@ -151,4 +415,7 @@ void RTGL1::ImageLoader::FreeLoaded()
     }
 
     loadedImages.clear();
+    mappedFiles.clear();
+    zstdLevels.clear();
+    decompressed.clear();
 }
@@ -25,6 +25,7 @@
 #include "UserFunction.h"
 
 #include <filesystem>
+#include <memory>
 #include <optional>
 #include <span>
 #include <vector>
@@ -34,7 +35,12 @@ struct ktxTexture;
 namespace RTGL1
 {
 
+class JobSystem;
+class MappedFile;
+
 // Loading images from files.
+// KTX2 files that are not supercompressed or use zstd are memory-mapped and parsed directly,
+// so level data is referenced from the mapping instead of being read into a new allocation.
 class ImageLoader final
 {
 public:
@@ -48,6 +54,12 @@ public:
         size_t         dataSize;
         RgExtent2D     baseSize;
         VkFormat       format;
+        // If not null, pData is null, and each level i is a zstd frame pZstdLevels[i] that
+        // must be decompressed into levelSizes[i] bytes at levelOffsets[i], see DecompressLevel
+        const std::span< const uint8_t >* pZstdLevels;
+        // If not 0, the hash of the contents that a loader thread computed,
+        // see TextureDeduplicator::HashContents
+        uint64_t                          contentHash;
     };
 
     struct LayeredResultInfo
@@ -59,7 +71,12 @@ public:
     };
 
 public:
-    ImageLoader() = default;
+    // If deferDecompression is true, zstd levels are not decompressed by Load,
+    // so the caller can decompress them in parallel directly to their destination.
+    // Loaders on worker threads should not defer: staging memory is not available there,
+    // and the inflate would move to the render thread.
+    // If jobs is not null, the levels that are not deferred are decompressed in parallel
+    explicit ImageLoader( bool deferDecompression = false, JobSystem* jobs = nullptr );
     ~ImageLoader();
 
     ImageLoader( const ImageLoader& other )                = delete;
@@ -68,11 +85,16 @@ public:
     ImageLoader& operator=( ImageLoader&& other ) noexcept = delete;
 
     std::optional< ResultInfo >        Load( const std::filesystem::path& path );
+    // From a KTX2 file in memory, e.g. from a texture pack
+    std::optional< ResultInfo >        Load( std::span< const uint8_t > ktx2File );
     std::optional< LayeredResultInfo > LoadLayered( const std::filesystem::path& path );
 
     // Must be called after using the loaded data to free the allocated memory
     void FreeLoaded();
 
+    // Thread-safe
+    static bool DecompressLevel( std::span< const uint8_t > src, void* dst, size_t dstSize );
+
     static auto GetExtensions()
     {
         static const char* arr[] = { ".ktx2" };
@@ -81,10 +103,19 @@ public:
     static auto GetFolder() { return TEXTURES_FOLDER; }
 
 private:
-    bool LoadTextureFile( const std::filesystem::path& path, ktxTexture** ppTexture );
+    bool       LoadTextureFile( const std::filesystem::path& path, ktxTexture** ppTexture );
+    ResultInfo MakeResult( ktxTexture* pTexture );
+    // Parse a mapped KTX2 file without libktx, returns null if it's not supported
+    auto       TryMakeMappedResult( std::span< const uint8_t > ktx2File )
+        -> std::optional< ResultInfo >;
 
 private:
-    std::vector< ktxTexture* > loadedImages;
+    bool                                                           deferDecompression;
+    JobSystem*                                                     jobs;
+    std::vector< ktxTexture* >                                     loadedImages;
+    std::vector< std::unique_ptr< MappedFile > >                   mappedFiles;
+    std::vector< std::unique_ptr< std::span< const uint8_t >[] > > zstdLevels;
+    std::vector< std::unique_ptr< uint8_t[] > >                    decompressed;
 };
 
 }
\ No newline at end of file
@@ -66,6 +66,8 @@ std::optional< RTGL1::ImageLoader::ResultInfo > RTGL1::ImageLoaderDev::Load( con
         .dataSize       = dataSize,
         .baseSize       = { width, height },
         .format         = VK_FORMAT_R8G8B8A8_SRGB,
+        .pZstdLevels    = nullptr,
+        .contentHash    = 0,
     };
 
     loadedImages.push_back( static_cast< void* >( pData ) );
@@ -0,0 +1,700 @@
+/*
+
+Copyright (c) 2024 V.Shirokii
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "JobSystem.h"
+
+#include "DebugPrint.h"
+
+#include <algorithm>
+#include <cassert>
+#include <exception>
+#include <utility>
+
+namespace
+{
+
+// to identify jobs submitted from a worker of a specific job system
+thread_local const RTGL1::JobSystem* t_owner       = nullptr;
+thread_local uint32_t                t_workerIndex = 0;
+
+constexpr auto WAIT_SLICE = std::chrono::microseconds( 200 );
+
+}
+
+struct RTGL1::JobSystem::Task
+{
+    Job                  job;
+    Handle               counter;
+    std::atomic_uint32_t depsLeft;
+};
+
+// Memory for counters: a counter is created for each submitted job, and it's allocated
+// together with its control block. Kept alive by the allocators, as handles can outlive
+// the job system
+struct RTGL1::JobSystem::CounterPool
+{
+    // a counter with its control block
+    static constexpr size_t BLOCK_SIZE = 256;
+    static_assert( sizeof( Counter ) + 64 <= BLOCK_SIZE );
+
+    CounterPool() = default;
+    ~CounterPool()
+    {
+        for( void* b : blocks )
+        {
+            ::operator delete( b );
+        }
+    }
+
+    CounterPool( const CounterPool& other )                = delete;
+    CounterPool( CounterPool&& other ) noexcept            = delete;
+    CounterPool& operator=( const CounterPool& other )     = delete;
+    CounterPool& operator=( CounterPool&& other ) noexcept = delete;
+
+    void* Allocate( size_t size )
+    {
+        if( size > BLOCK_SIZE )
+        {
+            return ::operator new( size );
+        }
+        {
+            auto l = std::unique_lock{ mutex };
+            if( !blocks.empty() )
+            {
+                void* b = blocks.back();
+                blocks.pop_back();
+                return b;
+            }
+        }
+        return ::operator new( BLOCK_SIZE );
+    }
+
+    void Free( void* p, size_t size ) noexcept
+    {
+        if( size <= BLOCK_SIZE )
+        {
+            auto l = std::unique_lock{ mutex };
+            if( blocks.size() < blocks.capacity() || TryReserve() )
+            {
+                blocks.push_back( p );
+                return;
+            }
+        }
+        ::operator delete( p );
+    }
+
+private:
+    bool TryReserve() noexcept
+    {
+        try
+        {
+            blocks.reserve( std::max< size_t >( 64, blocks.size() * 2 ) );
+            return true;
+        }
+        catch( ... )
+        {
+            return false;
+        }
+    }
+
+    std::mutex           mutex;
+    std::vector< void* > blocks;
+};
+
+template< typename T >
+struct RTGL1::JobSystem::CounterAllocator
+{
+    static_assert( alignof( T ) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__ );
+
+    using value_type = T;
+
+    explicit CounterAllocator( std::shared_ptr< CounterPool > _pool ) : pool{ std::move( _pool ) }
+    {
+    }
+
+    template< typename U >
+    CounterAllocator( const CounterAllocator< U >& other ) : pool{ other.pool } {}
+
+    T* allocate( size_t n ) { return static_cast< T* >( pool->Allocate( sizeof( T ) * n ) ); }
+    void deallocate( T* p, size_t n ) noexcept { pool->Free( p, sizeof( T ) * n ); }
+
+    template< typename U >
+    bool operator==( const CounterAllocator< U >& other ) const
+    {
+        return pool == other.pool;
+    }
+
+    std::shared_ptr< CounterPool > pool;
+};
+
+// Subranges of one ParallelFor call, any thread that participates takes the next one
+struct RTGL1::JobSystem::RangeGroup
+{
+    // Groups are reused, so everything must be reset
+    void Reset( const std::function< void( size_t, size_t ) >* _f, size_t _count, size_t _grain )
+    {
+        f          = _f;
+        count      = _count;
+        grain      = _grain;
+        rangeCount = ( _count + _grain - 1 ) / _grain;
+        next       = 0;
+        failed     = false;
+        finished   = 0;
+        error      = nullptr;
+        assert( helpers.empty() );
+    }
+
+    // Returns false, if there are no subranges left
+    bool RunNext()
+    {
+        const size_t i = next.fetch_add( 1 );
+        if( i >= rangeCount )
+        {
+            return false;
+        }
+
+        // after a failure, the subranges are only counted
+        if( !failed.load() )
+        {
+            try
+            {
+                const size_t begin = i * grain;
+                ( *f )( begin, std::min( begin + grain, count ) );
+            }
+            catch( ... )
+            {
+                auto l = std::unique_lock{ mutex };
+                if( !error )
+                {
+                    error = std::current_exception();
+                }
+                failed = true;
+            }
+        }
+
+        {
+            auto l = std::unique_lock{ mutex };
+            finished++;
+        }
+        cv.notify_all();
+        return true;
+    }
+
+    void WaitFinished()
+    {
+        auto l = std::unique_lock{ mutex };
+        cv.wait( l, [ this ] { return finished == rangeCount; } );
+    }
+
+    // valid while not all subranges are finished, as the caller waits for them
+    const std::function< void( size_t, size_t ) >* f{ nullptr };
+    size_t                                         count{ 0 };
+    size_t                                         grain{ 1 };
+    size_t                                         rangeCount{ 0 };
+
+    std::atomic_size_t next{ 0 };
+    std::atomic_bool   failed{ false };
+
+    std::mutex              mutex;
+    std::condition_variable cv;
+    size_t                  finished{ 0 };
+    std::exception_ptr      error;
+
+    // jobs that run the subranges along with the calling thread
+    std::vector< Handle > helpers;
+};
+
+bool RTGL1::JobSystem::Counter::IsDone() const
+{
+    auto l = std::unique_lock{ mutex };
+    return done;
+}
+
+RTGL1::JobSystem::JobSystem( uint32_t workerCount )
+    : counterPool{ std::make_shared< CounterPool >() }
+{
+    if( workerCount == 0 )
+    {
+        // leave one core to the calling thread
+        workerCount = std::max( 1u, std::thread::hardware_concurrency() ) - 1;
+        workerCount = std::max( 1u, workerCount );
+    }
+
+    workerQueues.reserve( workerCount );
+    for( uint32_t i = 0; i < workerCount; i++ )
+    {
+        workerQueues.push_back( std::make_unique< Queue >() );
+    }
+
+    workers.reserve( workerCount );
+    for( uint32_t i = 0; i < workerCount; i++ )
+    {
+        workers.emplace_back(
+            [ this, i ]( std::stop_token stopToken ) { WorkerLoop( i, stopToken ); } );
+    }
+
+    debug::Verbose( "Job system: {} worker threads", workerCount );
+}
+
+RTGL1::JobSystem::JobSystem( PFN_rgScheduleJob _pfnScheduleJob, void* _pSchedulerUserData )
+    : pfnSchedule{ _pfnScheduleJob }
+    , pScheduleUserData{ _pSchedulerUserData }
+    , counterPool{ std::make_shared< CounterPool >() }
+{
+    assert( pfnSchedule );
+    debug::Verbose( "Job system: using the host's scheduler" );
+}
+
+RTGL1::JobSystem::~JobSystem()
+{
+    // finish everything that was submitted, as jobs reference the library's state
+    while( outstandingCount.load() > 0 || hostCallsInFlight.load() > 0 )
+    {
+        if( !TryRunOne() )
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    for( auto& w : workers )
+    {
+        w.request_stop();
+    }
+    sleepCv.notify_all();
+    workers.clear();
+
+    for( Task* t : freeTasks )
+    {
+        delete t;
+    }
+    for( RangeGroup* g : freeGroups )
+    {
+        delete g;
+    }
+}
+
+auto RTGL1::JobSystem::Create( const RgInstanceJobSystemEXT& info ) -> std::shared_ptr< JobSystem >
+{
+    if( info.pfnScheduleJob )
+    {
+        return std::make_shared< JobSystem >( info.pfnScheduleJob, info.pSchedulerUserData );
+    }
+    return std::make_shared< JobSystem >( info.workerThreadCount );
+}
+
+auto RTGL1::JobSystem::AcquireTask() -> Task*
+{
+    {
+        auto l = std::unique_lock{ freeMutex };
+        if( !freeTasks.empty() )
+        {
+            Task* t = freeTasks.back();
+            freeTasks.pop_back();
+            return t;
+        }
+    }
+    return new Task{};
+}
+
+void RTGL1::JobSystem::ReleaseTask( Task* task )
+{
+    // release the captures now, not when the task is reused
+    task->job = nullptr;
+    task->counter.reset();
+
+    auto l = std::unique_lock{ freeMutex };
+    freeTasks.push_back( task );
+}
+
+auto RTGL1::JobSystem::AcquireGroup() -> RangeGroup*
+{
+    {
+        auto l = std::unique_lock{ freeMutex };
+        if( !freeGroups.empty() )
+        {
+            RangeGroup* g = freeGroups.back();
+            freeGroups.pop_back();
+            return g;
+        }
+    }
+    return new RangeGroup{};
+}
+
+void RTGL1::JobSystem::ReleaseGroup( RangeGroup* group )
+{
+    group->helpers.clear();
+
+    auto l = std::unique_lock{ freeMutex };
+    freeGroups.push_back( group );
+}
+
+auto RTGL1::JobSystem::Submit( Job job, std::span< const Handle > dependencies ) -> Handle
+{
+    auto counter = std::allocate_shared< Counter >( CounterAllocator< Counter >{ counterPool } );
+
+    Task* task = AcquireTask();
+    {
+        task->job      = std::move( job );
+        task->counter  = counter;
+        task->depsLeft = static_cast< uint32_t >( dependencies.size() ) + 1;
+    }
+    outstandingCount++;
+
+    for( const Handle& dep : dependencies )
+    {
+        if( dep )
+        {
+            auto l = std::unique_lock{ dep->mutex };
+            if( !dep->done )
+            {
+                // will be decremented by Complete
+                dep->continuations.push_back( task );
+                counter->dependencies.push_back( dep );
+                continue;
+            }
+        }
+        task->depsLeft--;
+    }
+
+    // +1 was to not start the task while registering the continuations
+    if( task->depsLeft.fetch_sub( 1 ) == 1 )
+    {
+        Enqueue( task );
+    }
+
+    return counter;
+}
+
+void RTGL1::JobSystem::Enqueue( Task* task )
+{
+    // count first, so it never underflows if the task is popped right after the push
+    if( pfnSchedule )
+    {
+        queuedCount++;
+        {
+            auto l = std::unique_lock{ globalQueue.mutex };
+            globalQueue.tasks.push_back( task );
+        }
+        hostCallsInFlight++;
+        pfnSchedule( RunOneFromHost, this, pScheduleUserData );
+        return;
+    }
+
+    {
+        // under the lock, so a worker can't miss the wake up
+        auto l = std::unique_lock{ sleepMutex };
+        queuedCount++;
+    }
+    {
+        Queue& q = ( t_owner == this ) ? *workerQueues[ t_workerIndex ] : globalQueue;
+
+        auto l = std::unique_lock{ q.mutex };
+        q.tasks.push_back( task );
+    }
+    sleepCv.notify_one();
+}
+
+auto RTGL1::JobSystem::TryPop() -> Task*
+{
+    if( queuedCount.load() == 0 )
+    {
+        return nullptr;
+    }
+
+    auto popFrom = [ this ]( Queue& q, bool back ) -> Task* {
+        auto l = std::unique_lock{ q.mutex };
+        if( q.tasks.empty() )
+        {
+            return nullptr;
+        }
+        Task* t;
+        if( back )
+        {
+            t = q.tasks.back();
+            q.tasks.pop_back();
+        }
+        else
+        {
+            t = q.tasks.front();
+            q.tasks.erase( q.tasks.begin() );
+        }
+        queuedCount--;
+        return t;
+    };
+
+    const bool isWorker = ( t_owner == this );
+
+    // own jobs first, most recent ones are hot in cache
+    if( isWorker )
+    {
+        if( Task* t = popFrom( *workerQueues[ t_workerIndex ], true ) )
+        {
+            return t;
+        }
+    }
+
+    if( Task* t = popFrom( globalQueue, false ) )
+    {
+        return t;
+    }
+
+    // steal the oldest jobs from others
+    const size_t count = workerQueues.size();
+    const size_t start = isWorker ? t_workerIndex + 1 : 0;
+    for( size_t i = 0; i < count; i++ )
+    {
+        if( Task* t = popFrom( *workerQueues[ ( start + i ) % count ], false ) )
+        {
+            return t;
+        }
+    }
+
+    return nullptr;
+}
+
+auto RTGL1::JobSystem::TryPopTaskOf( const Counter& counter ) -> Task*
+{
+    if( queuedCount.load() == 0 )
+    {
+        return nullptr;
+    }
+
+    auto popFrom = [ & ]( Queue& q ) -> Task* {
+        auto l = std::unique_lock{ q.mutex };
+
+        // tasks in a queue are alive, so it's safe to check their counters
+        auto found = std::ranges::find_if(
+            q.tasks, [ & ]( const Task* t ) { return t->counter.get() == &counter; } );
+        if( found == q.tasks.end() )
+        {
+            return nullptr;
+        }
+
+        Task* t = *found;
+        q.tasks.erase( found );
+        queuedCount--;
+        return t;
+    };
+
+    if( Task* t = popFrom( globalQueue ) )
+    {
+        return t;
+    }
+    for( auto& q : workerQueues )
+    {
+        if( Task* t = popFrom( *q ) )
+        {
+            return t;
+        }
+    }
+    return nullptr;
+}
+
+bool RTGL1::JobSystem::TryRunTaskOrDependencyOf( const Counter& counter )
+{
+    if( Task* t = TryPopTaskOf( counter ) )
+    {
+        Run( t );
+        return true;
+    }
+
+    // if it's not queued, it's either running or waiting for its dependencies:
+    // a worker that waits must run them itself, as all other workers might be waiting too
+    for( const Handle& dep : counter.dependencies )
+    {
+        if( !dep->IsDone() && TryRunTaskOrDependencyOf( *dep ) )
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool RTGL1::JobSystem::TryRunOne()
+{
+    if( Task* t = TryPop() )
+    {
+        Run( t );
+        return true;
+    }
+    return false;
+}
+
+void RTGL1::JobSystem::Run( Task* task )
+{
+    try
+    {
+        task->job();
+    }
+    catch( std::exception& e )
+    {
+        debug::Error( "Job has thrown an exception: {}", e.what() );
+    }
+    catch( ... )
+    {
+        debug::Error( "Job has thrown an unknown exception" );
+    }
+
+    Handle counter = std::move( task->counter );
+    ReleaseTask( task );
+
+    Complete( *counter );
+    outstandingCount--;
+}
+
+void RTGL1::JobSystem::Complete( Counter& counter )
+{
+    std::vector< Task* > continuations;
+    {
+        auto l       = std::unique_lock{ counter.mutex };
+        counter.done = true;
+        std::swap( continuations, counter.continuations );
+    }
+    counter.cv.notify_all();
+
+    for( Task* t : continuations )
+    {
+        if( t->depsLeft.fetch_sub( 1 ) == 1 )
+        {
+            Enqueue( t );
+        }
+    }
+}
+
+void RTGL1::JobSystem::Wait( const Handle& handle )
+{
+    if( !handle )
+    {
+        return;
+    }
+
+    while( !handle->IsDone() )
+    {
+        if( TryRunTaskOrDependencyOf( *handle ) )
+        {
+            continue;
+        }
+
+        auto l = std::unique_lock{ handle->mutex };
+        handle->cv.wait_for( l, WAIT_SLICE, [ &handle ] { return handle->done; } );
+    }
+}
+
+void RTGL1::JobSystem::Wait( std::span< const Handle > handles )
+{
+    for( const Handle& h : handles )
+    {
+        Wait( h );
+    }
+}
+
+void RTGL1::JobSystem::ParallelFor( size_t                                         count,
+                                    size_t                                         grain,
+                                    const std::function< void( size_t, size_t ) >& f )
+{
+    if( count == 0 )
+    {
+        return;
+    }
+
+    grain                  = std::max< size_t >( grain, 1 );
+    const size_t numRanges = ( count + grain - 1 ) / grain;
+
+    if( numRanges == 1 || GetConcurrency() <= 1 )
+    {
+        f( 0, count );
+        return;
+    }
+
+    RangeGroup* group = AcquireGroup();
+    group->Reset( &f, count, grain );
+
+    // helpers take the subranges from the group, so they might find nothing left,
+    // if they were started late
+    const size_t helperCount = std::min< size_t >( numRanges, GetConcurrency() ) - 1;
+    for( size_t i = 0; i < helperCount; i++ )
+    {
+        group->helpers.push_back( Submit( [ group ] {
+            while( group->RunNext() )
+            {
+            }
+        } ) );
+    }
+
+    // calling thread doesn't wait for the helpers to start: it processes
+    // the subranges itself, so it waits only for the ones that are being run
+    while( group->RunNext() )
+    {
+    }
+    group->WaitFinished();
+
+    // the group is reused: the helpers must exit first, the late ones are run here,
+    // and they only find that there's nothing left
+    Wait( group->helpers );
+
+    auto error = std::exchange( group->error, nullptr );
+    ReleaseGroup( group );
+
+    if( error )
+    {
+        std::rethrow_exception( error );
+    }
+}
+
+uint32_t RTGL1::JobSystem::GetConcurrency() const
+{
+    if( pfnSchedule )
+    {
+        return std::max( 1u, std::thread::hardware_concurrency() );
+    }
+    return static_cast< uint32_t >( workers.size() ) + 1;
+}
+
+void RTGL1::JobSystem::WorkerLoop( uint32_t workerIndex, std::stop_token stopToken )
+{
+    t_owner       = this;
+    t_workerIndex = workerIndex;
+
+    while( !stopToken.stop_requested() )
+    {
+        if( TryRunOne() )
+        {
+            continue;
+        }
+
+        auto l = std::unique_lock{ sleepMutex };
+        sleepCv.wait( l, stopToken, [ this ] { return queuedCount.load() > 0; } );
+    }
+
+    t_owner = nullptr;
+}
+
+void RGAPI_PTR RTGL1::JobSystem::RunOneFromHost( void* pJobSystem )
+{
+    auto self = static_cast< JobSystem* >( pJobSystem );
+
+    // the job might have been already taken by a waiting thread
+    self->TryRunOne();
+    self->hostCallsInFlight--;
+}
@@ -0,0 +1,161 @@
+/*
+
+Copyright (c) 2024 V.Shirokii
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "RTGL1/RTGL1.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace RTGL1
+{
+
+// Work-stealing job system shared by the whole library.
+// Each worker has its own queue: jobs submitted from a worker are pushed to its queue,
+// and are popped in LIFO order; idle workers steal from the other end of other queues.
+// Jobs submitted from non-worker threads (e.g. the API caller) go to a global queue.
+// If the host provides its own scheduler, no threads are created: each submitted job
+// results in one pfnScheduleJob call, which runs any of the queued jobs.
+class JobSystem
+{
+private:
+    struct Task;
+    struct RangeGroup;
+    struct CounterPool;
+    template< typename T >
+    struct CounterAllocator;
+
+public:
+    class Counter
+    {
+    public:
+        [[nodiscard]] bool IsDone() const;
+
+    private:
+        friend class JobSystem;
+
+        mutable std::mutex                        mutex;
+        std::condition_variable                   cv;
+        bool                                      done{ false };
+        std::vector< Task* >                      continuations;
+        // dependencies that weren't done at submission, not changed after it
+        std::vector< std::shared_ptr< Counter > > dependencies;
+    };
+
+    using Handle = std::shared_ptr< Counter >;
+    using Job    = std::function< void() >;
+
+    // If workerCount is 0, it is derived from the hardware concurrency
+    explicit JobSystem( uint32_t workerCount );
+    explicit JobSystem( PFN_rgScheduleJob pfnScheduleJob, void* pSchedulerUserData );
+    ~JobSystem();
+
+    JobSystem( const JobSystem& other )                = delete;
+    JobSystem( JobSystem&& other ) noexcept            = delete;
+    JobSystem& operator=( const JobSystem& other )     = delete;
+    JobSystem& operator=( JobSystem&& other ) noexcept = delete;
+
+    static auto Create( const RgInstanceJobSystemEXT& info ) -> std::shared_ptr< JobSystem >;
+
+    // Job is started only after all of the dependencies are done
+    Handle Submit( Job job, std::span< const Handle > dependencies = {} );
+
+    // If the job or any of its unfinished dependencies are still queued, they're run on
+    // the calling thread, otherwise blocks. Other queued jobs are never run here: a short wait
+    // on the frame thread must not pick up an unrelated long job, or re-enter a subsystem
+    // that is not reentrant
+    void Wait( const Handle& handle );
+    void Wait( std::span< const Handle > handles );
+
+    // Call f( begin, end ) for subranges of [0, count), each subrange has at most 'grain'
+    // elements. The calling thread participates, but only in the subranges of this call.
+    // Returns when all subranges are processed. If f throws, the first exception is rethrown.
+    void ParallelFor( size_t                                         count,
+                      size_t                                         grain,
+                      const std::function< void( size_t, size_t ) >& f );
+
+    // How many threads can process jobs at the same time, including the calling one
+    [[nodiscard]] uint32_t GetConcurrency() const;
+
+private:
+    struct Queue
+    {
+        std::mutex mutex;
+        // not a deque: popping never frees the memory, so there are no allocations,
+        // once the queue has grown enough
+        std::vector< Task* > tasks;
+    };
+
+    auto AcquireTask() -> Task*;
+    void ReleaseTask( Task* task );
+    auto AcquireGroup() -> RangeGroup*;
+    void ReleaseGroup( RangeGroup* group );
+
+    void Enqueue( Task* task );
+    bool TryRunOne();
+    auto TryPop() -> Task*;
+    auto TryPopTaskOf( const Counter& counter ) -> Task*;
+    bool TryRunTaskOrDependencyOf( const Counter& counter );
+    void Run( Task* task );
+    void Complete( Counter& counter );
+
+    void WorkerLoop( uint32_t workerIndex, std::stop_token stopToken );
+
+    static void RGAPI_PTR RunOneFromHost( void* pJobSystem );
+
+private:
+    PFN_rgScheduleJob pfnSchedule{ nullptr };
+    void*             pScheduleUserData{ nullptr };
+
+    Queue                                   globalQueue;
+    std::vector< std::unique_ptr< Queue > > workerQueues;
+
+    std::mutex                  sleepMutex;
+    std::condition_variable_any sleepCv;
+    std::atomic_uint64_t        queuedCount{ 0 };
+
+    // submitted, but not yet finished
+    std::atomic_uint64_t outstandingCount{ 0 };
+    // calls of pfnSchedule that weren't yet returned by the host
+    std::atomic_uint64_t hostCallsInFlight{ 0 };
+
+    // finished tasks and counters are reused, so submitting the same jobs
+    // every frame doesn't allocate
+    std::shared_ptr< CounterPool > counterPool;
+    std::mutex                     freeMutex;
+    std::vector< Task* >           freeTasks;
+    std::vector< RangeGroup* >     freeGroups;
+
+    // must be last, to be destroyed first
+    std::vector< std::jthread > workers;
+};
+
+}
@@ -230,9 +230,24 @@ JSON_TYPE( RTGL1::LibraryConfig )
     , "dxgiToVkSwapchainSwitchHack", &T::dxgiToVkSwapchainSwitchHack
     , "dx12Validation", &T::dx12Validation
     , "fsrValidation", &T::fsrValidation
+    , "stagingCopyThresholdKB", &T::stagingCopyThresholdKB
+    , "stagingCopyWorkerCount", &T::stagingCopyWorkerCount
+    , "textureStagingRingSizeMB", &T::textureStagingRingSizeMB
+    , "textureStreaming", &T::textureStreaming
+    , "textureStreamingBudgetKB", &T::textureStreamingBudgetKB
+    , "mipStreaming", &T::mipStreaming
+    , "mipStreamingInitialSize", &T::mipStreamingInitialSize
+    , "mipStreamingBudgetMB", &T::mipStreamingBudgetMB
+    , "textureCompression", &T::textureCompression
+    , "importTextureLoadBudgetMB", &T::importTextureLoadBudgetMB
+    , "exportReadbackRingSizeMB", &T::exportReadbackRingSizeMB
+    , "uploadRingSizeMB", &T::uploadRingSizeMB
+    , "lightBudget", &T::lightBudget
+    , "lightCullThreshold", &T::lightCullThreshold
+    , "lightCullHysteresis", &T::lightCullHysteresis
 JSON_TYPE_END;
 // clang-format on
-static_assert( sizeof( RTGL1::LibraryConfig ) == 9, "Add definitions to parser" );
+static_assert( sizeof( RTGL1::LibraryConfig ) == 60, "Add definitions to parser" );
 
 auto RTGL1::json_parser::detail::ReadLibraryConfig( const std::filesystem::path& path )
     -> std::optional< LibraryConfig >
@@ -92,10 +92,11 @@ RTGL1::LensFlares::LensFlares( VkDevice                            _device,
     , cullDescSetLayout( VK_NULL_HANDLE )
     , isPointToCheckInScreenSpace( !LENSFLARES_IN_WORLDSPACE )
 {
-    cullingInput   = std::make_unique< AutoBuffer >( _allocator );
-    vertexBuffer   = std::make_unique< AutoBuffer >( _allocator );
-    indexBuffer    = std::make_unique< AutoBuffer >( _allocator );
-    instanceBuffer = std::make_unique< AutoBuffer >( _allocator );
+    // all are refilled every frame, and take space in the upload ring only if there are flares
+    cullingInput   = std::make_unique< AutoBuffer >( _allocator, AutoBuffer::Staging::PerFrame );
+    vertexBuffer   = std::make_unique< AutoBuffer >( _allocator, AutoBuffer::Staging::PerFrame );
+    indexBuffer    = std::make_unique< AutoBuffer >( _allocator, AutoBuffer::Staging::PerFrame );
+    instanceBuffer = std::make_unique< AutoBuffer >( _allocator, AutoBuffer::Staging::PerFrame );
 
 
     cullingInput->Create( LENS_FLARES_MAX_DRAW_CMD_COUNT * sizeof( ShIndirectDrawCommand ),
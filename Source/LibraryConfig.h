@@ -25,6 +25,8 @@ SOFTWARE.
 
 #pragma once
 
+#include <cstdint>
+
 namespace RTGL1
 {
 
@@ -42,6 +44,53 @@ struct LibraryConfig
     bool dx12Validation              = false;
     bool dxgiToVkSwapchainSwitchHack = true;
     bool dlssForceDefaultPreset      = false;
+    bool textureStreaming            = false;
+    bool mipStreaming                = false;
+    // Original textures are block-compressed on the job system,
+    // and cached in TEXTURES_FOLDER_CACHE of the override folder for the next launches
+    bool textureCompression          = false;
+
+    // Vertex data copies to staging that are larger than this are split across
+    // at most stagingCopyWorkerCount threads of the job system
+    uint32_t stagingCopyThresholdKB = 256;
+    uint32_t stagingCopyWorkerCount = 3;
+
+    // Size of the persistently mapped ring that texture data is copied through;
+    // textures that don't fit are copied over the next frames in parts
+    uint32_t textureStagingRingSizeMB = 64;
+
+    // If textureStreaming, override files of original materials are loaded on the job system,
+    // and at most textureStreamingBudgetKB of loaded data is uploaded per frame
+    uint32_t textureStreamingBudgetKB = 16384;
+
+    // If textureStreaming and mipStreaming, streamed textures start with only their levels
+    // that are not larger than mipStreamingInitialSize, and finer levels are loaded when
+    // shaders request them; least recently requested textures lose their finest levels,
+    // if more than mipStreamingBudgetMB are resident
+    uint32_t mipStreamingInitialSize = 64;
+    uint32_t mipStreamingBudgetMB    = 512;
+
+    // On scene import, texture files of the materials are loaded on the job system,
+    // new files are not loaded while more than this is decoded, but not uploaded yet
+    uint32_t importTextureLoadBudgetMB = 512;
+
+    // Size of the host-visible ring that exported textures are read back through;
+    // a texture that is larger gets its own buffer
+    uint32_t exportReadbackRingSizeMB = 64;
+
+    // Size of the host-visible ring for the per-frame uploads of small buffers
+    // (uniforms, TLAS instances, lens flares); a buffer that doesn't fit
+    // gets its own staging memory
+    uint32_t uploadRingSizeMB = 8;
+
+    // If not zero, at most this many dynamic regular lights are uploaded per frame, the ones
+    // with the highest estimated contribution to the view; static lights are not counted.
+    // If lightCullThreshold is not zero, the ones with a lower contribution are culled.
+    // Lights that were uploaded in the previous frame have their contribution increased
+    // by lightCullHysteresis (as a fraction), so they don't pop in and out every frame
+    uint32_t lightBudget         = 0;
+    float    lightCullThreshold  = 0.0f;
+    float    lightCullHysteresis = 0.25f;
 
     // When adding fields, modify the entry in JsonParser.cpp
 };
@@ -0,0 +1,182 @@
+/*
+
+Copyright (c) 2024 V.Shirokii
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#include "LightBudget.h"
+
+#include "Camera.h"
+#include "Matrix.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace
+{
+
+constexpr float PI = 3.14159265358979323846f;
+
+// Lights in the view light the visible surfaces around them even if they are far,
+// so the distance to the camera is only a weak term
+constexpr float CAMERA_DISTANCE_WEIGHT = 0.1f;
+// For a cone that faces directly away from the view
+constexpr float MIN_ORIENTATION_FACTOR = 0.1f;
+
+float Dot3( const float* a, const float* b )
+{
+    return a[ 0 ] * b[ 0 ] + a[ 1 ] * b[ 1 ] + a[ 2 ] * b[ 2 ];
+}
+
+}
+
+void RTGL1::LightBudget::SetView( const Camera& camera )
+{
+    float viewProj[ 16 ];
+    Matrix::Multiply( viewProj, camera.view, camera.projection );
+
+    // column-major, so a row is strided
+    auto l_row = [ &viewProj ]( int row, int column ) {
+        return viewProj[ column * 4 + row ];
+    };
+
+    // left, right, bottom, top
+    for( int i = 0; i < 4; i++ )
+    {
+        const int   axis = i / 2;
+        const float sign = i % 2 == 0 ? 1.0f : -1.0f;
+
+        for( int k = 0; k < 4; k++ )
+        {
+            planes[ i ][ k ] = l_row( 3, k ) + sign * l_row( axis, k );
+        }
+
+        const float len = std::sqrt( Dot3( planes[ i ], planes[ i ] ) );
+        if( len > 0 )
+        {
+            for( float& v : planes[ i ] )
+            {
+                v /= len;
+            }
+        }
+    }
+
+    cameraPosition[ 0 ] = camera.viewInverse[ 12 ];
+    cameraPosition[ 1 ] = camera.viewInverse[ 13 ];
+    cameraPosition[ 2 ] = camera.viewInverse[ 14 ];
+}
+
+float RTGL1::LightBudget::EstimateImportance( const LightTree::Item& item ) const
+{
+    float center[ 3 ];
+    float extent[ 3 ];
+    for( int k = 0; k < 3; k++ )
+    {
+        center[ k ] = 0.5f * ( item.boundsMin[ k ] + item.boundsMax[ k ] );
+        extent[ k ] = 0.5f * ( item.boundsMax[ k ] - item.boundsMin[ k ] );
+    }
+    const float radius = std::sqrt( Dot3( extent, extent ) );
+
+    const float toCamera[ 3 ] = {
+        cameraPosition[ 0 ] - center[ 0 ],
+        cameraPosition[ 1 ] - center[ 1 ],
+        cameraPosition[ 2 ] - center[ 2 ],
+    };
+    const float distToCamera = std::sqrt( Dot3( toCamera, toCamera ) );
+
+    // conservative: the farthest plane that the bounding sphere is outside of
+    float outside = 0;
+    for( const auto& p : planes )
+    {
+        outside = std::max( outside, -( Dot3( p, center ) + p[ 3 ] ) );
+    }
+    const float distToView = std::max( 0.0f, outside - radius );
+
+    float orientation = 1.0f;
+    if( distToView > 0 && distToCamera > radius )
+    {
+        // surfaces that are visible face the camera roughly, so if the camera is behind
+        // the cone of emission, the light is unlikely to illuminate them
+        const float bound =
+            std::acos( item.cosThetaO ) + std::acos( item.cosThetaE ) + PI * 0.5f;
+        if( bound < PI )
+        {
+            const float cosAngle = std::clamp(
+                Dot3( item.axis, toCamera ) / distToCamera, -1.0f, 1.0f );
+            const float angle = std::acos( cosAngle );
+
+            if( angle > bound )
+            {
+                const float t = ( angle - bound ) / ( PI - bound );
+                orientation   = 1.0f + t * ( MIN_ORIENTATION_FACTOR - 1.0f );
+            }
+        }
+    }
+
+    const float dist = distToView + CAMERA_DISTANCE_WEIGHT * distToCamera;
+
+    return item.power * orientation / std::max( dist * dist + radius * radius, 0.000001f );
+}
+
+void RTGL1::LightBudget::Select( std::span< const Candidate > candidates,
+                                 uint32_t                     budget,
+                                 float                        threshold,
+                                 float                        hysteresis,
+                                 std::vector< uint32_t >&     outKept )
+{
+    stats = Stats{ .candidates = uint32_t( candidates.size() ) };
+    scores.resize( candidates.size() );
+    outKept.clear();
+
+    for( uint32_t i = 0; i < candidates.size(); i++ )
+    {
+        scores[ i ] = candidates[ i ].importance *
+                      ( candidates[ i ].wasKept ? 1.0f + hysteresis : 1.0f );
+
+        if( threshold > 0 && scores[ i ] < threshold )
+        {
+            stats.culledByThreshold++;
+            continue;
+        }
+        outKept.push_back( i );
+    }
+
+    if( budget > 0 && outKept.size() > budget )
+    {
+        std::nth_element( outKept.begin(),
+                          outKept.begin() + budget,
+                          outKept.end(),
+                          [ this ]( uint32_t a, uint32_t b ) {
+                              return scores[ a ] > scores[ b ] ||
+                                     ( scores[ a ] == scores[ b ] && a < b );
+                          } );
+
+        stats.culledByBudget = uint32_t( outKept.size() ) - budget;
+        outKept.resize( budget );
+
+        // keep the submission order, so the light tree can be refitted if the set is the same
+        std::ranges::sort( outKept );
+    }
+
+    assert( stats.Kept() == outKept.size() );
+}
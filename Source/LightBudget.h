@@ -0,0 +1,97 @@
+/*
+
+Copyright (c) 2024 V.Shirokii
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#pragma once
+
+#include "LightTree.h"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace RTGL1
+{
+
+struct Camera;
+
+// Estimates how much each light can contribute to the visible image, to upload only
+// the most important ones when a frame has more lights than is useful.
+// The estimate is the light's power (that includes its lightstyle), attenuated by
+// the distance to the view frustum, and lowered for the cones that face away from the view.
+class LightBudget
+{
+public:
+    struct Candidate
+    {
+        float importance;
+        // If it was uploaded in the previous frame
+        bool  wasKept;
+    };
+
+    struct Stats
+    {
+        uint32_t candidates;
+        uint32_t culledByThreshold;
+        uint32_t culledByBudget;
+
+        uint32_t Kept() const { return candidates - culledByThreshold - culledByBudget; }
+    };
+
+public:
+    LightBudget()  = default;
+    ~LightBudget() = default;
+
+    LightBudget( const LightBudget& other )                = delete;
+    LightBudget( LightBudget&& other ) noexcept            = delete;
+    LightBudget& operator=( const LightBudget& other )     = delete;
+    LightBudget& operator=( LightBudget&& other ) noexcept = delete;
+
+    void  SetView( const Camera& camera );
+    float EstimateImportance( const LightTree::Item& item ) const;
+
+    // Candidates with an importance lower than 'threshold' are culled, and of the rest, only
+    // 'budget' most important ones are kept (if not zero). The importance of the ones
+    // that were kept in the previous frame is multiplied by (1 + 'hysteresis'), so lights
+    // around the limits don't pop in and out every frame.
+    // 'outKept' receives the indices of the kept candidates, in ascending order
+    void Select( std::span< const Candidate > candidates,
+                 uint32_t                     budget,
+                 float                        threshold,
+                 float                        hysteresis,
+                 std::vector< uint32_t >&     outKept );
+
+    const Stats& GetStats() const { return stats; }
+
+private:
+    // Side planes of the view frustum: normals are inward and normalized,
+    // xyz is the normal, w is the distance
+    float planes[ 4 ][ 4 ]{};
+    float cameraPosition[ 3 ]{};
+
+    Stats                stats{};
+    std::vector< float > scores;
+};
+
+}
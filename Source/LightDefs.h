@@ -31,6 +31,9 @@ namespace RTGL1
 using UniqueLightID = uint64_t;
 
 
+constexpr float MIN_SPHERE_LIGHT_RADIUS = 0.005f;
+
+
 // Index in the global light array.
 // Used to match lights by UniqueLightID between current and previous frames,
 // as indices for the same light in them can be different, and only UniqueLightID is constant.
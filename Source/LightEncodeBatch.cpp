@@ -0,0 +1,610 @@
+/*
+
+Copyright (c) 2024 V.Shirokii
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#include "LightEncodeBatch.h"
+
+#include "LightDefs.h"
+#include "Utils.h"
+
+#include "Generated/ShaderCommonC.h"
+
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+#if defined( _M_X64 ) || defined( _M_IX86 ) || defined( __SSE2__ )
+    #define RG_LIGHT_ENCODE_SSE2 1
+    #include <emmintrin.h>
+#else
+    #define RG_LIGHT_ENCODE_SSE2 0
+#endif
+
+#include "glm/glm.hpp"
+
+namespace
+{
+
+using namespace glm;
+#include "Shaders/Utils.h"
+
+}
+
+namespace
+{
+
+constexpr float PI = 3.14159265358979323846f;
+
+static_assert( sizeof( RTGL1::ShLightEncoded ) == 24, "Change encoding" );
+
+}
+
+uint32_t RTGL1::EncodeSpotLightCosAngles( float angleInner, float angleOuter )
+{
+    constexpr auto clampForCos = []( float a ) {
+        return std::clamp( a, 0.0f, Utils::DegToRad( 89 ) );
+    };
+
+    constexpr auto float01to8bit = []( float a ) {
+        assert( a >= 0 && a <= 1 );
+        return uint32_t( std::clamp( int( a * 255 ), 0, 255 ) );
+    };
+
+    angleInner = std::min( angleInner, angleOuter - Utils::DegToRad( 1 ) );
+
+    return ( float01to8bit( std::cos( clampForCos( angleInner ) ) ) << 8 ) |
+           ( float01to8bit( std::cos( clampForCos( angleOuter ) ) ) );
+}
+
+RTGL1::SphereLightBatch::SphereLightBatch( FrameArena& arena )
+    : posX( &arena )
+    , posY( &arena )
+    , posZ( &arena )
+    , radius( &arena )
+    , color( &arena )
+    , intensity( &arena )
+    , mult( &arena )
+{
+}
+
+void RTGL1::SphereLightBatch::Reserve( size_t count )
+{
+    for( auto* v : { &posX, &posY, &posZ, &radius, &intensity, &mult } )
+    {
+        v->reserve( count );
+    }
+    color.reserve( count );
+}
+
+void RTGL1::SphereLightBatch::Push( const RgLightSphericalEXT& info, float _mult )
+{
+    posX.push_back( info.position.data[ 0 ] );
+    posY.push_back( info.position.data[ 1 ] );
+    posZ.push_back( info.position.data[ 2 ] );
+    radius.push_back( info.radius );
+    color.push_back( info.color );
+    intensity.push_back( info.intensity );
+    mult.push_back( _mult );
+}
+
+RTGL1::SpotLightBatch::SpotLightBatch( FrameArena& arena )
+    : posX( &arena )
+    , posY( &arena )
+    , posZ( &arena )
+    , dirX( &arena )
+    , dirY( &arena )
+    , dirZ( &arena )
+    , radius( &arena )
+    , color( &arena )
+    , intensity( &arena )
+    , mult( &arena )
+    , cosAngles( &arena )
+{
+}
+
+void RTGL1::SpotLightBatch::Reserve( size_t count )
+{
+    for( auto* v : { &posX, &posY, &posZ, &dirX, &dirY, &dirZ, &radius, &intensity, &mult } )
+    {
+        v->reserve( count );
+    }
+    color.reserve( count );
+    cosAngles.reserve( count );
+}
+
+void RTGL1::SpotLightBatch::Push( const RgLightSpotEXT& info, float _mult )
+{
+    RgFloat3D direction = Utils::Normalize( info.direction );
+
+    posX.push_back( info.position.data[ 0 ] );
+    posY.push_back( info.position.data[ 1 ] );
+    posZ.push_back( info.position.data[ 2 ] );
+    dirX.push_back( direction.data[ 0 ] );
+    dirY.push_back( direction.data[ 1 ] );
+    dirZ.push_back( direction.data[ 2 ] );
+    radius.push_back( info.radius );
+    color.push_back( info.color );
+    intensity.push_back( info.intensity );
+    mult.push_back( _mult );
+    cosAngles.push_back( EncodeSpotLightCosAngles( info.angleInner, info.angleOuter ) );
+}
+
+void RTGL1::LightColorBatch::Clear()
+{
+    color.clear();
+    scale.clear();
+    power.clear();
+}
+
+void RTGL1::LightColorBatch::Push( const RgLightSphericalEXT& info )
+{
+    const float radius = std::max( MIN_SPHERE_LIGHT_RADIUS, info.radius );
+    const auto  fcolor = Utils::UnpackColor4DPacked32< RgFloat3D >( info.color );
+
+    color.push_back( info.color );
+    // disk is visible from the point
+    scale.push_back( info.intensity / ( PI * radius * radius ) );
+    power.push_back( Utils::Luminance( fcolor.data ) * info.intensity );
+}
+
+void RTGL1::LightColorBatch::Push( const RgLightSpotEXT& info )
+{
+    const float radius = std::max( MIN_SPHERE_LIGHT_RADIUS, info.radius );
+    const auto  fcolor = Utils::UnpackColor4DPacked32< RgFloat3D >( info.color );
+
+    color.push_back( info.color );
+    scale.push_back( info.intensity / ( PI * radius * radius ) );
+    power.push_back( Utils::Luminance( fcolor.data ) * info.intensity );
+}
+
+namespace
+{
+
+// Additional multiplier of the E5 color is in the high half of this field,
+// as e5 encoding might not preserve large values
+float& GetColorNormalizationField( RTGL1::ShLightEncoded& l )
+{
+    assert( l.lightType == LIGHT_TYPE_SPHERE || l.lightType == LIGHT_TYPE_SPOT );
+    return l.lightType == LIGHT_TYPE_SPOT ? l.ldata1 : l.ldata3;
+}
+
+void PatchColor( RTGL1::ShLightEncoded& l, uint32_t colorE5, uint32_t normHalf )
+{
+    float& field = GetColorNormalizationField( l );
+
+    l.colorE5 = colorE5;
+    field     = std::bit_cast< float >( ( std::bit_cast< uint32_t >( field ) & 0x0000FFFF ) |
+                                    ( normHalf << 16 ) );
+}
+
+}
+
+#if RG_LIGHT_ENCODE_SSE2
+
+namespace
+{
+
+// Lights are processed by 4: the last block is padded with zeros
+template< typename Vector >
+auto Load4( const Vector& v, size_t i )
+{
+    using T = typename Vector::value_type;
+
+    alignas( 16 ) T tmp[ 4 ] = {};
+
+    const T* src = &v[ i ];
+    if( i + 4 > v.size() )
+    {
+        std::copy( v.begin() + i, v.end(), tmp );
+        src = tmp;
+    }
+
+    if constexpr( std::is_same_v< T, float > )
+    {
+        return _mm_loadu_ps( src );
+    }
+    else
+    {
+        static_assert( sizeof( T ) == sizeof( uint32_t ) );
+        return _mm_loadu_si128( reinterpret_cast< const __m128i* >( src ) );
+    }
+}
+
+__m128i Select( __m128i mask, __m128i a, __m128i b )
+{
+    return _mm_or_si128( _mm_and_si128( mask, a ), _mm_andnot_si128( mask, b ) );
+}
+
+__m128 Select( __m128 mask, __m128 a, __m128 b )
+{
+    return _mm_or_ps( _mm_and_ps( mask, a ), _mm_andnot_ps( mask, b ) );
+}
+
+// round() for non-negative values
+__m128i RoundPositive( __m128 x )
+{
+    return _mm_cvttps_epi32( _mm_add_ps( x, _mm_set1_ps( 0.5f ) ) );
+}
+
+// exp2 for integers in [-126, 127]
+__m128 Exp2i( __m128i n )
+{
+    return _mm_castsi128_ps( _mm_slli_epi32( _mm_add_epi32( n, _mm_set1_epi32( 127 ) ), 23 ) );
+}
+
+template< int Shift >
+__m128 UnpackColorChannel( __m128i packed )
+{
+    __m128i c = _mm_and_si128( _mm_srli_epi32( packed, Shift ), _mm_set1_epi32( 255 ) );
+    return _mm_div_ps( _mm_cvtepi32_ps( c ), _mm_set1_ps( 255.0f ) );
+}
+
+// Same as encodeE5B9G9R9 from Shaders/Utils.h,
+// but floor(log2(x)) is taken from the exponent bits
+__m128i EncodeE5B9G9R9( __m128 r, __m128 g, __m128 b )
+{
+    constexpr int N   = ENCODE_E5B9G9R9_MANTISSA_BITS;
+    constexpr int Np2 = 1 << N;
+    constexpr int B   = ENCODE_E5B9G9R9_EXP_BIAS;
+
+    const __m128 zero   = _mm_setzero_ps();
+    const __m128 maxVal = _mm_set1_ps( ENCODE_E5B9G9R9_SHAREDEXP_MAX );
+
+    r = _mm_min_ps( _mm_max_ps( r, zero ), maxVal );
+    g = _mm_min_ps( _mm_max_ps( g, zero ), maxVal );
+    b = _mm_min_ps( _mm_max_ps( b, zero ), maxVal );
+
+    const __m128 maxC = _mm_max_ps( r, _mm_max_ps( g, b ) );
+
+    __m128i floorLog2 = _mm_sub_epi32( _mm_srli_epi32( _mm_castps_si128( maxC ), 23 ),
+                                       _mm_set1_epi32( 127 ) );
+    {
+        const __m128i lowest = _mm_set1_epi32( -B - 1 );
+        floorLog2 = Select( _mm_cmplt_epi32( floorLog2, lowest ), lowest, floorLog2 );
+    }
+
+    const __m128i expSharedP = _mm_add_epi32( floorLog2, _mm_set1_epi32( 1 + B ) );
+
+    const __m128i maxS = RoundPositive(
+        _mm_mul_ps( maxC, Exp2i( _mm_sub_epi32( _mm_set1_epi32( B + N ), expSharedP ) ) ) );
+
+    // +1, if max_s == Np2
+    const __m128i expShared =
+        _mm_sub_epi32( expSharedP, _mm_cmpeq_epi32( maxS, _mm_set1_epi32( Np2 ) ) );
+
+    const __m128 s = Exp2i( _mm_sub_epi32( _mm_set1_epi32( B + N ), expShared ) );
+
+    const __m128i rs = RoundPositive( _mm_mul_ps( r, s ) );
+    const __m128i gs = RoundPositive( _mm_mul_ps( g, s ) );
+    const __m128i bs = RoundPositive( _mm_mul_ps( b, s ) );
+
+    __m128i packed = _mm_or_si128(
+        _mm_or_si128( _mm_slli_epi32( expShared, 3 * N ), _mm_slli_epi32( bs, 2 * N ) ),
+        _mm_or_si128( _mm_slli_epi32( gs, 1 * N ), rs ) );
+
+    return _mm_andnot_si128( _mm_castps_si128( _mm_cmpeq_ps( maxC, zero ) ), packed );
+}
+
+// Same as encodeE5 in LightManager.cpp
+__m128i EncodeE5( __m128 r, __m128 g, __m128 b, __m128& outNormalization )
+{
+    const __m128 norm = _mm_div_ps( _mm_max_ps( r, _mm_max_ps( g, b ) ),
+                                    _mm_set1_ps( ENCODE_E5B9G9R9_SHAREDEXP_MAX ) );
+
+    // fallback: normalize to preserve colors, to not clamp to white
+    const __m128 needNorm = _mm_cmpgt_ps( norm, _mm_set1_ps( 1.0f ) );
+    r = Select( needNorm, _mm_div_ps( r, norm ), r );
+    g = Select( needNorm, _mm_div_ps( g, norm ), g );
+    b = Select( needNorm, _mm_div_ps( b, norm ), b );
+
+    outNormalization = norm;
+    return EncodeE5B9G9R9( r, g, b );
+}
+
+// Round-to-nearest-even float to half, from
+// https://gist.github.com/rygorous/2156668 (public domain).
+// Returns a half in the low 16 bits of each lane
+__m128i FloatToHalf( __m128 f )
+{
+    const __m128i f16max         = _mm_set1_epi32( ( 127 + 16 ) << 23 );
+    const __m128i nanBit         = _mm_set1_epi32( 0x200 );
+    const __m128i infAsHalf      = _mm_set1_epi32( 0x7c00 );
+    const __m128i minNormal      = _mm_set1_epi32( ( 127 - 14 ) << 23 );
+    const __m128i subnormalMagic = _mm_set1_epi32( ( ( 127 - 15 ) + ( 23 - 10 ) + 1 ) << 23 );
+    const __m128i normalBias     = _mm_set1_epi32( 0xfff - ( ( 127 - 15 ) << 23 ) );
+
+    const __m128  justSign  = _mm_and_ps( _mm_castsi128_ps( _mm_set1_epi32( 0x80000000 ) ), f );
+    const __m128  absF      = _mm_xor_ps( f, justSign );
+    const __m128i absFInt   = _mm_castps_si128( absF );
+    const __m128  isNan     = _mm_cmpunord_ps( absF, absF );
+    const __m128i isRegular = _mm_cmpgt_epi32( f16max, absFInt );
+    const __m128i infOrNan =
+        _mm_or_si128( _mm_and_si128( _mm_castps_si128( isNan ), nanBit ), infAsHalf );
+
+    const __m128i isSubnormal = _mm_cmpgt_epi32( minNormal, absFInt );
+
+    // result is subnormal
+    const __m128  subnormal1 = _mm_add_ps( absF, _mm_castsi128_ps( subnormalMagic ) );
+    const __m128i subnormal  = _mm_sub_epi32( _mm_castps_si128( subnormal1 ), subnormalMagic );
+
+    // result is normal
+    const __m128i mantissaOdd = _mm_srai_epi32( _mm_slli_epi32( absFInt, 31 - 13 ), 31 );
+    const __m128i rounded =
+        _mm_sub_epi32( _mm_add_epi32( absFInt, normalBias ), mantissaOdd );
+    const __m128i normal = _mm_srli_epi32( rounded, 13 );
+
+    const __m128i nonSpecial = Select( isSubnormal, subnormal, normal );
+    const __m128i joined     = Select( isRegular, nonSpecial, infOrNan );
+
+    const __m128i sign = _mm_srli_epi32( _mm_castps_si128( justSign ), 16 );
+    return _mm_or_si128( joined, sign );
+}
+
+// Same as glm::packHalf2x16( { x, y } )
+__m128i PackHalf2x16( __m128 x, __m128 y )
+{
+    return _mm_or_si128( FloatToHalf( x ), _mm_slli_epi32( FloatToHalf( y ), 16 ) );
+}
+
+// Multiplier of an unpacked color: intensity / area * mult
+__m128 CalcColorScale( const RTGL1::FrameVector< float >& radius,
+                       const RTGL1::FrameVector< float >& intensity,
+                       const RTGL1::FrameVector< float >& mult,
+                       size_t                             i,
+                       __m128&                            outRadius )
+{
+    outRadius = _mm_max_ps( Load4( radius, i ), _mm_set1_ps( RTGL1::MIN_SPHERE_LIGHT_RADIUS ) );
+
+    // disk is visible from the point
+    __m128 area = _mm_mul_ps( _mm_mul_ps( _mm_set1_ps( PI ), outRadius ), outRadius );
+
+    return _mm_mul_ps( _mm_div_ps( Load4( intensity, i ), area ), Load4( mult, i ) );
+}
+
+}
+
+void RTGL1::EncodeLightBatch( const SphereLightBatch& batch, std::span< ShLightEncoded > dst )
+{
+    assert( dst.size() >= batch.GetCount() );
+
+    for( size_t i = 0; i < batch.GetCount(); i += 4 )
+    {
+        __m128 radius;
+        __m128 k = CalcColorScale( batch.radius, batch.intensity, batch.mult, i, radius );
+
+        __m128i packedColor = Load4( batch.color, i );
+
+        __m128  norm;
+        __m128i colorE5 = EncodeE5( _mm_mul_ps( UnpackColorChannel< 0 >( packedColor ), k ),
+                                    _mm_mul_ps( UnpackColorChannel< 8 >( packedColor ), k ),
+                                    _mm_mul_ps( UnpackColorChannel< 16 >( packedColor ), k ),
+                                    norm );
+
+        // additional multiplier as e5 encoding might not preserve large values
+        __m128i radiusNorm = PackHalf2x16( radius, norm );
+
+        alignas( 16 ) uint32_t e5[ 4 ];
+        alignas( 16 ) uint32_t rn[ 4 ];
+        _mm_store_si128( reinterpret_cast< __m128i* >( e5 ), colorE5 );
+        _mm_store_si128( reinterpret_cast< __m128i* >( rn ), radiusNorm );
+
+        for( size_t l = 0; l < 4 && i + l < batch.GetCount(); l++ )
+        {
+            dst[ i + l ] = ShLightEncoded{
+                .lightType = LIGHT_TYPE_SPHERE,
+                .colorE5   = e5[ l ],
+                .ldata0    = batch.posX[ i + l ],
+                .ldata1    = batch.posY[ i + l ],
+                .ldata2    = batch.posZ[ i + l ],
+                .ldata3    = std::bit_cast< float >( rn[ l ] ),
+            };
+        }
+    }
+}
+
+void RTGL1::EncodeLightBatch( const SpotLightBatch& batch, std::span< ShLightEncoded > dst )
+{
+    assert( dst.size() >= batch.GetCount() );
+
+    for( size_t i = 0; i < batch.GetCount(); i += 4 )
+    {
+        __m128 radius;
+        __m128 k = CalcColorScale( batch.radius, batch.intensity, batch.mult, i, radius );
+
+        __m128i packedColor = Load4( batch.color, i );
+
+        __m128  norm;
+        __m128i colorE5 = EncodeE5( _mm_mul_ps( UnpackColorChannel< 0 >( packedColor ), k ),
+                                    _mm_mul_ps( UnpackColorChannel< 8 >( packedColor ), k ),
+                                    _mm_mul_ps( UnpackColorChannel< 16 >( packedColor ), k ),
+                                    norm );
+
+        __m128i data0 = PackHalf2x16( Load4( batch.posX, i ), Load4( batch.posY, i ) );
+        // additional multiplier as e5 encoding might not preserve large values
+        __m128i data1 = PackHalf2x16( Load4( batch.posZ, i ), norm );
+        __m128i data2 = PackHalf2x16( Load4( batch.dirX, i ), Load4( batch.dirY, i ) );
+        __m128i data3 = _mm_or_si128( _mm_slli_epi32( FloatToHalf( Load4( batch.dirZ, i ) ), 16 ),
+                                      Load4( batch.cosAngles, i ) );
+
+        alignas( 16 ) uint32_t e5[ 4 ], d0[ 4 ], d1[ 4 ], d2[ 4 ], d3[ 4 ];
+        _mm_store_si128( reinterpret_cast< __m128i* >( e5 ), colorE5 );
+        _mm_store_si128( reinterpret_cast< __m128i* >( d0 ), data0 );
+        _mm_store_si128( reinterpret_cast< __m128i* >( d1 ), data1 );
+        _mm_store_si128( reinterpret_cast< __m128i* >( d2 ), data2 );
+        _mm_store_si128( reinterpret_cast< __m128i* >( d3 ), data3 );
+
+        for( size_t l = 0; l < 4 && i + l < batch.GetCount(); l++ )
+        {
+            dst[ i + l ] = ShLightEncoded{
+                .lightType = LIGHT_TYPE_SPOT,
+                .colorE5   = e5[ l ],
+                .ldata0    = std::bit_cast< float >( d0[ l ] ),
+                .ldata1    = std::bit_cast< float >( d1[ l ] ),
+                .ldata2    = std::bit_cast< float >( d2[ l ] ),
+                .ldata3    = std::bit_cast< float >( d3[ l ] ),
+            };
+        }
+    }
+}
+
+void RTGL1::PatchLightColors( const LightColorBatch&      batch,
+                              size_t                      begin,
+                              size_t                      end,
+                              float                       mult,
+                              std::span< ShLightEncoded > dst )
+{
+    assert( begin <= end && end <= batch.GetCount() );
+    assert( dst.size() >= end - begin );
+
+    for( size_t i = begin; i < end; i += 4 )
+    {
+        __m128 k = _mm_mul_ps( Load4( batch.scale, i ), _mm_set1_ps( mult ) );
+
+        __m128i packedColor = Load4( batch.color, i );
+
+        __m128  norm;
+        __m128i colorE5 = EncodeE5( _mm_mul_ps( UnpackColorChannel< 0 >( packedColor ), k ),
+                                    _mm_mul_ps( UnpackColorChannel< 8 >( packedColor ), k ),
+                                    _mm_mul_ps( UnpackColorChannel< 16 >( packedColor ), k ),
+                                    norm );
+
+        alignas( 16 ) uint32_t e5[ 4 ], nh[ 4 ];
+        _mm_store_si128( reinterpret_cast< __m128i* >( e5 ), colorE5 );
+        _mm_store_si128( reinterpret_cast< __m128i* >( nh ), FloatToHalf( norm ) );
+
+        for( size_t l = 0; l < 4 && i + l < end; l++ )
+        {
+            PatchColor( dst[ i + l - begin ], e5[ l ], nh[ l ] );
+        }
+    }
+}
+
+#else // !RG_LIGHT_ENCODE_SSE2
+
+namespace
+{
+
+uint32_t EncodeE5( const vec3& c, float& outNormalization )
+{
+    const float norm = std::max( { c.x, c.y, c.z } ) / float{ ENCODE_E5B9G9R9_SHAREDEXP_MAX };
+
+    outNormalization = norm;
+    // fallback: normalize to preserve colors, to not clamp to white
+    return encodeE5B9G9R9( norm <= 1.0f ? c : c / norm );
+}
+
+float CalcColorScale( float radius, float intensity, float mult, float& outRadius )
+{
+    outRadius = std::max( RTGL1::MIN_SPHERE_LIGHT_RADIUS, radius );
+
+    // disk is visible from the point
+    float area = PI * outRadius * outRadius;
+
+    return intensity / area * mult;
+}
+
+vec3 UnpackColor( RgColor4DPacked32 c )
+{
+    auto f = RTGL1::Utils::UnpackColor4DPacked32< RgFloat3D >( c );
+    return { f.data[ 0 ], f.data[ 1 ], f.data[ 2 ] };
+}
+
+}
+
+void RTGL1::EncodeLightBatch( const SphereLightBatch& batch, std::span< ShLightEncoded > dst )
+{
+    assert( dst.size() >= batch.GetCount() );
+
+    for( size_t i = 0; i < batch.GetCount(); i++ )
+    {
+        float radius;
+        float k =
+            CalcColorScale( batch.radius[ i ], batch.intensity[ i ], batch.mult[ i ], radius );
+
+        float    norm;
+        uint32_t colorE5 = EncodeE5( UnpackColor( batch.color[ i ] ) * k, norm );
+
+        dst[ i ] = ShLightEncoded{
+            .lightType = LIGHT_TYPE_SPHERE,
+            .colorE5   = colorE5,
+            .ldata0    = batch.posX[ i ],
+            .ldata1    = batch.posY[ i ],
+            .ldata2    = batch.posZ[ i ],
+            .ldata3    = std::bit_cast< float >( glm::packHalf2x16( { radius, norm } ) ),
+        };
+    }
+}
+
+void RTGL1::EncodeLightBatch( const SpotLightBatch& batch, std::span< ShLightEncoded > dst )
+{
+    assert( dst.size() >= batch.GetCount() );
+
+    for( size_t i = 0; i < batch.GetCount(); i++ )
+    {
+        float radius;
+        float k =
+            CalcColorScale( batch.radius[ i ], batch.intensity[ i ], batch.mult[ i ], radius );
+
+        float    norm;
+        uint32_t colorE5 = EncodeE5( UnpackColor( batch.color[ i ] ) * k, norm );
+
+        uint32_t data0 = glm::packHalf2x16( { batch.posX[ i ], batch.posY[ i ] } );
+        uint32_t data1 = glm::packHalf2x16( { batch.posZ[ i ], norm } );
+        uint32_t data2 = glm::packHalf2x16( { batch.dirX[ i ], batch.dirY[ i ] } );
+        uint32_t data3 = ( glm::packHalf2x16( { 0, batch.dirZ[ i ] } ) & 0xFFFF0000 ) | //
+                         batch.cosAngles[ i ];
+
+        dst[ i ] = ShLightEncoded{
+            .lightType = LIGHT_TYPE_SPOT,
+            .colorE5   = colorE5,
+            .ldata0    = std::bit_cast< float >( data0 ),
+            .ldata1    = std::bit_cast< float >( data1 ),
+            .ldata2    = std::bit_cast< float >( data2 ),
+            .ldata3    = std::bit_cast< float >( data3 ),
+        };
+    }
+}
+
+void RTGL1::PatchLightColors( const LightColorBatch&      batch,
+                              size_t                      begin,
+                              size_t                      end,
+                              float                       mult,
+                              std::span< ShLightEncoded > dst )
+{
+    assert( begin <= end && end <= batch.GetCount() );
+    assert( dst.size() >= end - begin );
+
+    for( size_t i = begin; i < end; i++ )
+    {
+        float    norm;
+        uint32_t colorE5 = EncodeE5( UnpackColor( batch.color[ i ] ) * ( batch.scale[ i ] * mult ),
+                                     norm );
+
+        PatchColor( dst[ i - begin ], colorE5, glm::packHalf1x16( norm ) );
+    }
+}
+
+#endif // RG_LIGHT_ENCODE_SSE2
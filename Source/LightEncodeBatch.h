@@ -0,0 +1,110 @@
+/*
+
+Copyright (c) 2024 V.Shirokii
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#pragma once
+
+#include "FrameArena.h"
+
+#include <RTGL1/RTGL1.h>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace RTGL1
+{
+
+struct ShLightEncoded;
+
+// Sphere lights in the structure-of-arrays layout, to be encoded with SIMD
+struct SphereLightBatch
+{
+    explicit SphereLightBatch( FrameArena& arena );
+
+    void   Reserve( size_t count );
+    void   Push( const RgLightSphericalEXT& info, float mult );
+    size_t GetCount() const { return color.size(); }
+
+    FrameVector< float >             posX, posY, posZ;
+    FrameVector< float >             radius;
+    FrameVector< RgColor4DPacked32 > color;
+    FrameVector< float >             intensity;
+    FrameVector< float >             mult;
+};
+
+// Spot lights in the structure-of-arrays layout, to be encoded with SIMD
+struct SpotLightBatch
+{
+    explicit SpotLightBatch( FrameArena& arena );
+
+    void   Reserve( size_t count );
+    void   Push( const RgLightSpotEXT& info, float mult );
+    size_t GetCount() const { return color.size(); }
+
+    FrameVector< float >             posX, posY, posZ;
+    // Normalized
+    FrameVector< float >             dirX, dirY, dirZ;
+    FrameVector< float >             radius;
+    FrameVector< RgColor4DPacked32 > color;
+    FrameVector< float >             intensity;
+    FrameVector< float >             mult;
+    // (cosAngleInner << 8) | cosAngleOuter, both as 8-bit unorm
+    FrameVector< uint32_t >          cosAngles;
+};
+
+// Colors of encoded sphere and spot lights without their lightstyle multiplier,
+// in the structure-of-arrays layout: if only a lightstyle value has changed,
+// the colors can be encoded again with SIMD, keeping the other fields
+struct LightColorBatch
+{
+    void   Clear();
+    void   Push( const RgLightSphericalEXT& info );
+    void   Push( const RgLightSpotEXT& info );
+    size_t GetCount() const { return color.size(); }
+
+    std::vector< RgColor4DPacked32 > color;
+    // Multiplier of an unpacked color: intensity / area
+    std::vector< float >             scale;
+    // Luminance of the color multiplied by intensity, as the power of a light tree item
+    std::vector< float >             power;
+};
+
+// 8-bit unorm cosines of the cone angles, as (inner << 8) | outer
+uint32_t EncodeSpotLightCosAngles( float angleInner, float angleOuter );
+
+// Write GetCount() encoded lights to 'dst', which is expected to be write-combined memory,
+// so each light is written once and sequentially
+void EncodeLightBatch( const SphereLightBatch& batch, std::span< ShLightEncoded > dst );
+void EncodeLightBatch( const SpotLightBatch& batch, std::span< ShLightEncoded > dst );
+
+// Encode the colors of the lights [begin, end) of 'batch' multiplied by 'mult'
+// into the lights of 'dst', which are the same lights, encoded before
+void PatchLightColors( const LightColorBatch&      batch,
+                       size_t                      begin,
+                       size_t                      end,
+                       float                       mult,
+                       std::span< ShLightEncoded > dst );
+
+}
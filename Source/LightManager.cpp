@@ -22,9 +22,13 @@
 
 #include <cmath>
 #include <array>
+#include <algorithm>
+#include <utility>
 
 #include "Generated/ShaderCommonC.h"
 #include "CmdLabel.h"
+#include "LibraryConfig.h"
+#include "LightEncodeBatch.h"
 #include "RgException.h"
 #include "Utils.h"
 
@@ -32,10 +36,15 @@ namespace
 {
 constexpr double RG_PI = 3.1415926535897932384626433;
 
-constexpr float MIN_COLOR_SUM     = 0.0001f;
-constexpr float MIN_SPHERE_RADIUS = 0.005f;
+constexpr float MIN_COLOR_SUM = 0.0001f;
 
-constexpr uint32_t LIGHT_ARRAY_MAX_SIZE = 4096;
+constexpr uint32_t LIGHT_ARRAY_INITIAL_CAPACITY = 256;
+
+constexpr VkBufferUsageFlags LIGHTS_BUFFER_USAGE =
+    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+constexpr VkBufferUsageFlags LIGHTS_BUFFER_PREV_USAGE =
+    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+constexpr VkBufferUsageFlags LIGHTS_INDEX_BUFFER_USAGE = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
 
 static_assert( LIGHT_GRID_ENABLED_ == LIGHT_GRID_ENABLED, "Change LIGHT_GRID_ENABLED_" );
 #if LIGHT_GRID_ENABLED
@@ -49,27 +58,38 @@ static uint32_t encodeE5( const RgFloat3D& c, float* normalization );
 static uint32_t packHalf2x16( const float& x, const float& y );
 
 RTGL1::LightManager::LightManager( VkDevice                            _device,
-                                   std::shared_ptr< MemoryAllocator >& _allocator )
+                                   std::shared_ptr< MemoryAllocator >& _allocator,
+                                   std::shared_ptr< JobSystem >        _jobSystem )
     : device( _device )
+    , allocator( _allocator )
+    , jobs( std::move( _jobSystem ) )
+    , lightCapacity( LIGHT_ARRAY_INITIAL_CAPACITY )
+    , staticTreeUpdate( TreeUpdate::None )
+    , dynamicTreeTopology( 0 )
+    , dynamicTreeTopology_Built( 0 )
     , regLightCount( 0 )
     , regLightCount_Prev( 0 )
     , dirLightCount( 0 )
     , dirLightCount_Prev( 0 )
+    , staticRebuilt( false )
+    , staticMappingDirty( false )
+    , frameId( 0 )
+    , dynamicSpatialCount( 0 )
     , descSetLayout( VK_NULL_HANDLE )
     , descPool( VK_NULL_HANDLE )
     , descSets{}
     , needDescSetUpdate{}
 {
     lightsBuffer = std::make_shared< AutoBuffer >( _allocator );
-    lightsBuffer->Create( sizeof( ShLightEncoded ) * LIGHT_ARRAY_MAX_SIZE,
-                          VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                          "Lights buffer" );
+    lightsBuffer->Create(
+        sizeof( ShLightEncoded ) * lightCapacity, LIGHTS_BUFFER_USAGE, "Lights buffer" );
 
-    lightsBuffer_Prev.Init( *_allocator,
-                            sizeof( ShLightEncoded ) * LIGHT_ARRAY_MAX_SIZE,
-                            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-                            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-                            "Lights buffer - prev" );
+    lightsBuffer_Prev = std::make_unique< Buffer >();
+    lightsBuffer_Prev->Init( *_allocator,
+                             sizeof( ShLightEncoded ) * lightCapacity,
+                             LIGHTS_BUFFER_PREV_USAGE,
+                             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                             "Lights buffer - prev" );
 
 #if LIGHT_GRID_ENABLED
     for( auto& buf : initialLightsGrid )
@@ -83,20 +103,28 @@ RTGL1::LightManager::LightManager( VkDevice                            _device,
 #endif
 
     prevToCurIndex = std::make_shared< AutoBuffer >( _allocator );
-    prevToCurIndex->Create( sizeof( uint32_t ) * LIGHT_ARRAY_MAX_SIZE,
-                            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+    prevToCurIndex->Create( sizeof( uint32_t ) * lightCapacity,
+                            LIGHTS_INDEX_BUFFER_USAGE,
                             "Lights buffer - prev to cur" );
 
     curToPrevIndex = std::make_shared< AutoBuffer >( _allocator );
-    curToPrevIndex->Create( sizeof( uint32_t ) * LIGHT_ARRAY_MAX_SIZE,
-                            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+    curToPrevIndex->Create( sizeof( uint32_t ) * lightCapacity,
+                            LIGHTS_INDEX_BUFFER_USAGE,
                             "Lights buffer - cur to prev" );
 
+    lightTreeBuffer = std::make_shared< AutoBuffer >( _allocator );
+    lightTreeBuffer->Create( sizeof( ShLightTreeNode ) * LightTree::CalcNodeCount( lightCapacity ),
+                             LIGHTS_INDEX_BUFFER_USAGE,
+                             "Lights buffer - tree" );
+
     CreateDescriptors();
 }
 
 RTGL1::LightManager::~LightManager()
 {
+    // the job writes to the tree buffer
+    WaitLightTree();
+
     vkDestroyDescriptorSetLayout( device, descSetLayout, nullptr );
     vkDestroyDescriptorPool( device, descPool, nullptr );
 }
@@ -147,7 +175,7 @@ RTGL1::ShLightEncoded EncodeAsSphereLight( const RgLightSphericalEXT& info,
 {
     RgFloat3D pos = RTGL1::ApplyTransformToPosition( transform, info.position );
 
-    float radius = std::max( MIN_SPHERE_RADIUS, info.radius );
+    float radius = std::max( RTGL1::MIN_SPHERE_LIGHT_RADIUS, info.radius );
     // disk is visible from the point
     float area = float( RG_PI ) * radius * radius;
 
@@ -239,23 +267,10 @@ RTGL1::ShLightEncoded EncodeAsSpotLight( const RgLightSpotEXT& info,
         RTGL1::ApplyTransformToDirection( transform, RTGL1::Utils::Normalize( info.direction ) );
     assert( std::abs( RTGL1::Utils::Length( direction.data ) - 1.0f ) < 0.001f );
 
-    float radius = std::max( MIN_SPHERE_RADIUS, info.radius );
+    float radius = std::max( RTGL1::MIN_SPHERE_LIGHT_RADIUS, info.radius );
     float area   = float( RG_PI ) * radius * radius;
 
-    constexpr auto clampForCos = []( float a ) {
-        return std::clamp( a, 0.0f, RTGL1::Utils::DegToRad( 89 ) );
-    };
-
-    constexpr auto float01to8bit = []( float a ){
-        assert( a >= 0 && a <= 1 );
-        return uint8_t( std::clamp( int( a * 255 ), 0, 255 ) );
-    };
-
-    float angleInner = std::min( info.angleInner, info.angleOuter - RTGL1::Utils::DegToRad( 1 ) );
-    float angleOuter = info.angleOuter;
-
-    uint8_t cosAngleInner = float01to8bit( std::cos( clampForCos( angleInner ) ) );
-    uint8_t cosAngleOuter = float01to8bit( std::cos( clampForCos( angleOuter ) ) );
+    uint32_t cosAngles = RTGL1::EncodeSpotLightCosAngles( info.angleInner, info.angleOuter );
 
     auto fcolor = RTGL1::Utils::UnpackColor4DPacked32< RgFloat3D >( info.color );
     {
@@ -287,54 +302,247 @@ RTGL1::ShLightEncoded EncodeAsSpotLight( const RgLightSpotEXT& info,
         *data0_w = packHalf2x16( 0, direction.data[ 2 ] );
 
         assert( ( ( *data0_w ) & 0x0000FFFF ) == 0 );
-        *data0_w = ( *data0_w & 0xFFFF0000 ) | //
-                   ( cosAngleInner << 8 ) |    //
-                   ( cosAngleOuter );
+        *data0_w = ( *data0_w & 0xFFFF0000 ) | cosAngles;
     }
 
     return lt;
 }
 
+auto MakeTreeItem( const RgFloat3D& pos, float radius, RgColor4DPacked32 color, float power )
+    -> RTGL1::LightTree::Item
+{
+    auto fcolor = RTGL1::Utils::UnpackColor4DPacked32< RgFloat3D >( color );
+
+    return RTGL1::LightTree::Item{
+        .boundsMin  = { pos.data[ 0 ] - radius, pos.data[ 1 ] - radius, pos.data[ 2 ] - radius },
+        .boundsMax  = { pos.data[ 0 ] + radius, pos.data[ 1 ] + radius, pos.data[ 2 ] + radius },
+        .axis       = { 0, 0, 1 },
+        .cosThetaO  = -1.0f,
+        .cosThetaE  = 0.0f,
+        .power      = RTGL1::Utils::Luminance( fcolor.data ) * power,
+        .lightIndex = 0,
+    };
+}
+
+auto MakeSphereTreeItem( const RgLightSphericalEXT& info,
+                         float                      mult,
+                         const RgTransform*         transform ) -> RTGL1::LightTree::Item
+{
+    return MakeTreeItem( RTGL1::ApplyTransformToPosition( transform, info.position ),
+                         std::max( RTGL1::MIN_SPHERE_LIGHT_RADIUS, info.radius ),
+                         info.color,
+                         info.intensity * mult );
+}
+
+auto MakeSpotTreeItem( const RgLightSpotEXT& info, float mult, const RgTransform* transform )
+    -> RTGL1::LightTree::Item
+{
+    auto item = MakeTreeItem( RTGL1::ApplyTransformToPosition( transform, info.position ),
+                              std::max( RTGL1::MIN_SPHERE_LIGHT_RADIUS, info.radius ),
+                              info.color,
+                              info.intensity * mult );
+
+    RgFloat3D direction =
+        RTGL1::ApplyTransformToDirection( transform, RTGL1::Utils::Normalize( info.direction ) );
+
+    item.axis[ 0 ] = direction.data[ 0 ];
+    item.axis[ 1 ] = direction.data[ 1 ];
+    item.axis[ 2 ] = direction.data[ 2 ];
+    // all emission is within the outer cone
+    item.cosThetaO = 1.0f;
+    item.cosThetaE = std::cos( std::clamp( info.angleOuter, 0.0f, float( RG_PI ) * 0.5f ) );
+
+    return item;
+}
+
+#if TRIANGLE_LIGHTS
+auto MakeTriangleTreeItem( const RgLightPolygonalEXT& info,
+                           const RgFloat3D&           unnormalizedNormal,
+                           float                      mult ) -> RTGL1::LightTree::Item
+{
+    auto fcolor = RTGL1::Utils::UnpackColor4DPacked32< RgFloat3D >( info.color );
+    auto n      = RTGL1::Utils::Normalize( unnormalizedNormal );
+
+    auto item = RTGL1::LightTree::Item{
+        .axis       = { n.data[ 0 ], n.data[ 1 ], n.data[ 2 ] },
+        .cosThetaO  = 1.0f,
+        .cosThetaE  = 0.0f,
+        .power      = RTGL1::Utils::Luminance( fcolor.data ) * info.intensity * mult,
+        .lightIndex = 0,
+    };
+
+    for( int k = 0; k < 3; k++ )
+    {
+        item.boundsMin[ k ] = std::min( { info.positions[ 0 ].data[ k ],
+                                          info.positions[ 1 ].data[ k ],
+                                          info.positions[ 2 ].data[ k ] } );
+        item.boundsMax[ k ] = std::max( { info.positions[ 0 ].data[ k ],
+                                          info.positions[ 1 ].data[ k ],
+                                          info.positions[ 2 ].data[ k ] } );
+    }
+
+    return item;
+}
+#endif
+
 uint32_t GetLightArrayEnd( uint32_t regCount, uint32_t dirCount )
 {
     // assuming that reg lights are always after directional ones
     return LIGHT_ARRAY_REGULAR_LIGHTS_OFFSET + regCount;
 }
 
+void AddToSpatial( RTGL1::LightSpatialIndex&     index,
+                   const RTGL1::LightTree::Item& item,
+                   uint32_t                      lightIndex )
+{
+    // bounding sphere of the bounds
+    RgFloat3D center   = {};
+    float     radiusSq = 0;
+    for( int a = 0; a < 3; a++ )
+    {
+        const float half = 0.5f * ( item.boundsMax[ a ] - item.boundsMin[ a ] );
+
+        center.data[ a ] = item.boundsMin[ a ] + half;
+        radiusSq += half * half;
+    }
+
+    index.Add( center, std::sqrt( radiusSq ), lightIndex );
+}
+
+uint64_t HashCombine( uint64_t seed, uint64_t v )
+{
+    return seed ^ ( v + 0x9e3779b97f4a7c15 + ( seed << 6 ) + ( seed >> 2 ) );
+}
+
+// Ranges of elements to copy, adjacent ones are merged
+struct CopyRegions
+{
+    VkDeviceSize                  stride;
+    std::array< VkBufferCopy, 4 > infos{};
+    uint32_t                      count{ 0 };
+
+    // must be added in ascending order
+    void Add( uint32_t begin, uint32_t end )
+    {
+        if( begin >= end )
+        {
+            return;
+        }
+
+        if( count > 0 )
+        {
+            VkBufferCopy& last = infos[ count - 1 ];
+            assert( last.dstOffset <= begin * stride );
+
+            if( last.dstOffset + last.size >= begin * stride )
+            {
+                last.size = std::max( last.dstOffset + last.size, end * stride ) - last.dstOffset;
+                return;
+            }
+        }
+
+        assert( count < infos.size() );
+        infos[ count++ ] = VkBufferCopy{
+            .srcOffset = begin * stride,
+            .dstOffset = begin * stride,
+            .size      = ( end - begin ) * stride,
+        };
+    }
+};
+
 }
 
 void RTGL1::LightManager::PrepareForFrame( VkCommandBuffer cmd, uint32_t frameIndex )
 {
+    // if SubmitLightTree wasn't called in the previous frame
+    WaitLightTree();
+
+    // frame slot is reused, so the buffers that were retired in it are not in use anymore
+    ReleaseRetired( frameIndex );
+
+    // prev buffer is a copy of the lights buffer, so it must keep up with its capacity
+    bool prevRecreated = false;
+    if( lightsBuffer_Prev->GetSize() < lightsBuffer->GetSize() )
+    {
+        retiredBuffers[ frameIndex ].push_back( std::move( lightsBuffer_Prev ) );
+
+        lightsBuffer_Prev = std::make_unique< Buffer >();
+        lightsBuffer_Prev->Init( *allocator,
+                                 lightsBuffer->GetSize(),
+                                 LIGHTS_BUFFER_PREV_USAGE,
+                                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                 "Lights buffer - prev" );
+
+        std::ranges::fill( needDescSetUpdate, true );
+        prevRecreated = true;
+    }
+
     regLightCount_Prev = regLightCount;
     dirLightCount_Prev = dirLightCount;
 
-    regLightCount = 0;
+    const uint32_t prevEnd   = GetLightArrayEnd( regLightCount_Prev, dirLightCount_Prev );
+    const uint32_t staticEnd = LIGHT_ARRAY_REGULAR_LIGHTS_OFFSET + uint32_t( staticEncoded.size() );
+    assert( staticEnd <= prevEnd );
+
+    // static lights persist, so their slots are already filled
+    regLightCount = uint32_t( staticEncoded.size() );
     dirLightCount = 0;
 
-    // TODO: similar system to just swap desc sets, instead of actual copying
-    if( GetLightArrayEnd( regLightCount_Prev, dirLightCount_Prev ) > 0 )
+    dynamicTreeItems.clear();
+    dynamicTreeTopology = 0;
+
+    // static lights in the lights buffer are the same as in the prev one,
+    // unless they were changed in the previous frame
     {
-        VkBufferCopy info = {
-            .srcOffset = 0,
-            .dstOffset = 0,
-            .size      = GetLightArrayEnd( regLightCount_Prev, dirLightCount_Prev ) *
-                    sizeof( ShLightEncoded ),
-        };
+        auto regions = CopyRegions{ .stride = sizeof( ShLightEncoded ) };
+        if( prevRecreated )
+        {
+            regions.Add( 0, prevEnd );
+        }
+        else
+        {
+            regions.Add( 0, LIGHT_ARRAY_REGULAR_LIGHTS_OFFSET );
+            regions.Add( LIGHT_ARRAY_REGULAR_LIGHTS_OFFSET + staticCopied_Prev.begin,
+                         LIGHT_ARRAY_REGULAR_LIGHTS_OFFSET + staticCopied_Prev.end );
+            regions.Add( staticEnd, prevEnd );
+        }
 
-        vkCmdCopyBuffer(
-            cmd, lightsBuffer->GetDeviceLocal(), lightsBuffer_Prev.GetBuffer(), 1, &info );
+        if( regions.count > 0 )
+        {
+            vkCmdCopyBuffer( cmd,
+                             lightsBuffer->GetDeviceLocal(),
+                             lightsBuffer_Prev->GetBuffer(),
+                             regions.count,
+                             regions.infos.data() );
+        }
     }
 
-    memset( prevToCurIndex->GetMapped( frameIndex ),
-            0xFF,
-            sizeof( uint32_t ) * GetLightArrayEnd( regLightCount_Prev, dirLightCount_Prev ) );
+    // static lights are matched by their slots, and that mapping is already uploaded
+    {
+        auto* prev2cur = prevToCurIndex->GetMappedAs< uint32_t* >( frameIndex );
+        memset( prev2cur, 0xFF, sizeof( uint32_t ) * LIGHT_ARRAY_REGULAR_LIGHTS_OFFSET );
+        memset( prev2cur + staticEnd, 0xFF, sizeof( uint32_t ) * ( prevEnd - staticEnd ) );
+    }
     // no need to clear curToPrevIndex, as it'll be filled in the cur frame
 
-    uniqueIDToArrayIndex[ frameIndex ].clear();
+    frameId++;
+    staticIDToIndex_Prev.clear();
+    dynamicSpatial.Clear();
+    dynamicSpatialCount = 0;
+    budgetPending.clear();
+
+    // lights that weren't added in the previous frame can't be matched anymore
+    if( dynamicSlots.size() > 2 * size_t( prevEnd ) + 256 )
+    {
+        erase_if( dynamicSlots,
+                  [ this ]( const auto& kv ) { return kv.second.frameId + 1 < frameId; } );
+    }
 }
 
 void RTGL1::LightManager::Reset()
 {
+    WaitLightTree();
+
     for( uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++ )
     {
         memset( prevToCurIndex->GetMapped( i ),
@@ -347,12 +555,42 @@ void RTGL1::LightManager::Reset()
                 sizeof( uint32_t ) *
                     std::max( GetLightArrayEnd( regLightCount, dirLightCount ),
                               GetLightArrayEnd( regLightCount_Prev, dirLightCount_Prev ) ) );
-
-        uniqueIDToArrayIndex[ i ].clear();
     }
 
     regLightCount_Prev = regLightCount = 0;
     dirLightCount_Prev = dirLightCount = 0;
+
+    staticGeneration.reset();
+    staticEncoded.clear();
+    staticTreeItems.clear();
+    staticSources.clear();
+    staticStyleOffsets.clear();
+    staticStyledColors.Clear();
+    staticLightstyles.clear();
+    staticIDToIndex.clear();
+    staticIDToIndex_Prev.clear();
+    staticDirty        = {};
+    staticCopied_Prev  = {};
+    staticRebuilt      = false;
+    staticMappingDirty = false;
+    staticSpatial.Clear();
+    staticVolumetricSpatial.Clear();
+    staticVolumetricSuns.clear();
+    staticAnyVolumetric.reset();
+    staticAnySun.reset();
+
+    dynamicSlots.clear();
+    dynamicSpatial.Clear();
+    dynamicSpatialCount = 0;
+    budgetPending.clear();
+
+    staticTree.Clear();
+    staticTreeUpdate = TreeUpdate::None;
+    staticTreeUploadedAt.reset();
+    dynamicTree.Clear();
+    dynamicTreeItems.clear();
+    dynamicTreeTopology       = 0;
+    dynamicTreeTopology_Built = 0;
 }
 
 RTGL1::LightArrayIndex RTGL1::LightManager::GetIndex( const ShLightEncoded& encodedLight ) const
@@ -381,14 +619,14 @@ void RTGL1::LightManager::IncrementCount( const ShLightEncoded& encodedLight )
     }
 }
 
-void RTGL1::LightManager::AddInternal( uint32_t              frameIndex,
-                                       uint64_t              uniqueId,
-                                       const ShLightEncoded& encodedLight )
+void RTGL1::LightManager::AddInternal( uint32_t                                frameIndex,
+                                       uint64_t                                uniqueId,
+                                       const ShLightEncoded&                   encodedLight,
+                                       const std::optional< LightTree::Item >& treeItem )
 {
-    if( GetLightArrayEnd( regLightCount, dirLightCount ) >= LIGHT_ARRAY_MAX_SIZE )
+    if( GetLightArrayEnd( regLightCount, dirLightCount ) >= lightCapacity )
     {
-        assert( 0 );
-        return;
+        GrowLightBuffers( frameIndex, GetLightArrayEnd( regLightCount, dirLightCount ) + 1 );
     }
 
     const LightArrayIndex index = GetIndex( encodedLight );
@@ -397,13 +635,166 @@ void RTGL1::LightManager::AddInternal( uint32_t              frameIndex,
     auto* dst = lightsBuffer->GetMappedAs< ShLightEncoded* >( frameIndex );
     memcpy( &dst[ index.GetArrayIndex() ], &encodedLight, sizeof( ShLightEncoded ) );
 
+    TrackAdded( frameIndex, uniqueId, index, treeItem );
+}
+
+void RTGL1::LightManager::TrackAdded( uint32_t                                frameIndex,
+                                      uint64_t                                uniqueId,
+                                      LightArrayIndex                         index,
+                                      const std::optional< LightTree::Item >& treeItem )
+{
+    if( treeItem )
+    {
+        // regular lights are in the array order, so the trees cover all of them
+        assert( index.GetArrayIndex() == LIGHT_ARRAY_REGULAR_LIGHTS_OFFSET +
+                                             staticTreeItems.size() + dynamicTreeItems.size() );
+
+        dynamicTreeItems.push_back( *treeItem );
+        dynamicTreeItems.back().lightIndex = index.GetArrayIndex();
+
+        dynamicTreeTopology = HashCombine( dynamicTreeTopology, uniqueId );
+    }
+
+    auto [ slot, isNew ] = dynamicSlots.try_emplace( uniqueId, DynamicSlot{ index, frameId } );
+
+    auto prevIndex = std::optional< LightArrayIndex >{};
+    if( !isNew )
+    {
+        // must be unique
+        assert( slot->second.frameId != frameId );
+
+        if( slot->second.frameId + 1 == frameId )
+        {
+            prevIndex = slot->second.index;
+        }
+        slot->second = DynamicSlot{ index, frameId };
+    }
+    else if( !staticIDToIndex_Prev.empty() )
+    {
+        // static scene was changed, the light might have been static
+        auto found = staticIDToIndex_Prev.find( uniqueId );
+        if( found != staticIDToIndex_Prev.end() )
+        {
+            prevIndex = found->second;
+        }
+    }
+
+    WriteMatch( frameIndex, index, prevIndex );
+}
+
+namespace
+{
+
+// Create a bigger buffer, preserving the data that was already written for the current frame
+auto RecreateWithCapacity( const std::shared_ptr< RTGL1::MemoryAllocator >& allocator,
+                           RTGL1::AutoBuffer&                               old,
+                           uint32_t                                         frameIndex,
+                           VkDeviceSize                                     newSize,
+                           VkDeviceSize                                     preserveSize,
+                           VkBufferUsageFlags                               usage,
+                           const char*                                      debugName,
+                           bool                                             fillWithNone )
+    -> std::shared_ptr< RTGL1::AutoBuffer >
+{
+    assert( preserveSize <= old.GetSize() && old.GetSize() <= newSize );
+
+    auto buf = std::make_shared< RTGL1::AutoBuffer >( allocator );
+    buf->Create( newSize, usage, debugName );
+
+    if( fillWithNone )
+    {
+        // unmatched indices must be UINT32_MAX
+        for( uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++ )
+        {
+            memset( buf->GetMapped( i ), 0xFF, newSize );
+        }
+    }
+
+    if( preserveSize > 0 )
+    {
+        memcpy( buf->GetMapped( frameIndex ), old.GetMapped( frameIndex ), preserveSize );
+    }
+
+    return buf;
+}
+
+}
+
+void RTGL1::LightManager::GrowLightBuffers( uint32_t frameIndex, uint32_t requiredCount )
+{
+    uint32_t newCapacity = lightCapacity;
+    while( newCapacity < requiredCount )
+    {
+        newCapacity *= 2;
+    }
+
+    if( newCapacity == lightCapacity )
+    {
+        return;
+    }
+
+    debug::Verbose( "Growing light buffers: {} -> {} lights", lightCapacity, newCapacity );
+
+    const uint32_t curEnd  = GetLightArrayEnd( regLightCount, dirLightCount );
+    const uint32_t prevEnd = GetLightArrayEnd( regLightCount_Prev, dirLightCount_Prev );
+
+    auto newLights    = RecreateWithCapacity( allocator,
+                                            *lightsBuffer,
+                                            frameIndex,
+                                            sizeof( ShLightEncoded ) * newCapacity,
+                                            sizeof( ShLightEncoded ) * curEnd,
+                                            LIGHTS_BUFFER_USAGE,
+                                            "Lights buffer",
+                                            false );
+    auto newPrevToCur = RecreateWithCapacity( allocator,
+                                              *prevToCurIndex,
+                                              frameIndex,
+                                              sizeof( uint32_t ) * newCapacity,
+                                              sizeof( uint32_t ) * prevEnd,
+                                              LIGHTS_INDEX_BUFFER_USAGE,
+                                              "Lights buffer - prev to cur",
+                                              true );
+    auto newCurToPrev = RecreateWithCapacity( allocator,
+                                              *curToPrevIndex,
+                                              frameIndex,
+                                              sizeof( uint32_t ) * newCapacity,
+                                              sizeof( uint32_t ) * curEnd,
+                                              LIGHTS_INDEX_BUFFER_USAGE,
+                                              "Lights buffer - cur to prev",
+                                              true );
+    // tree is written in SubmitForFrame, only the static subtree must be uploaded again
+    auto newTree      = RecreateWithCapacity( allocator,
+                                              *lightTreeBuffer,
+                                              frameIndex,
+                                              sizeof( ShLightTreeNode ) *
+                                                  LightTree::CalcNodeCount( newCapacity ),
+                                              0,
+                                              LIGHTS_INDEX_BUFFER_USAGE,
+                                              "Lights buffer - tree",
+                                              false );
+
+    // old ones might be still in use: by the previous frame, and by the copy to
+    // lightsBuffer_Prev that was already recorded for this frame
+    retiredAutoBuffers[ frameIndex ].push_back( std::exchange( lightsBuffer, newLights ) );
+    retiredAutoBuffers[ frameIndex ].push_back( std::exchange( prevToCurIndex, newPrevToCur ) );
+    retiredAutoBuffers[ frameIndex ].push_back( std::exchange( curToPrevIndex, newCurToPrev ) );
+    retiredAutoBuffers[ frameIndex ].push_back( std::exchange( lightTreeBuffer, newTree ) );
+
+    // new device-local buffers don't have the persistent static lights
+    staticDirty        = ElementRange{ 0, uint32_t( staticEncoded.size() ) };
+    staticMappingDirty = true;
+    staticTreeUploadedAt.reset();
+
+    // lightsBuffer_Prev will be recreated in the next PrepareForFrame,
+    // as its current contents are needed for this frame
+    lightCapacity = newCapacity;
+    std::ranges::fill( needDescSetUpdate, true );
+}
 
-    FillMatchPrev( frameIndex, index, uniqueId );
-    // must be unique
-    assert( uniqueIDToArrayIndex[ frameIndex ].find( uniqueId ) ==
-            uniqueIDToArrayIndex[ frameIndex ].end() );
-    // save index for the next frame
-    uniqueIDToArrayIndex[ frameIndex ][ uniqueId ] = index;
+void RTGL1::LightManager::ReleaseRetired( uint32_t frameIndex )
+{
+    retiredAutoBuffers[ frameIndex ].clear();
+    retiredBuffers[ frameIndex ].clear();
 }
 
 namespace
@@ -442,99 +833,622 @@ float CalculateLightStyle( const std::optional< RgLightAdditionalEXT >& extra,
     return 1.0f;
 }
 
+bool IsBudgetEnabled()
+{
+    return RTGL1::LibConfig().lightBudget > 0 || RTGL1::LibConfig().lightCullThreshold > 0;
 }
 
-void RTGL1::LightManager::Add( uint32_t           frameIndex,
-                               const LightCopy&   light,
-                               const RgTransform* transform )
+bool IsVolumetric( const RTGL1::LightCopy& l )
 {
-    std::visit(
-        ext::overloaded{
-            [ & ]( const RgLightDirectionalEXT& lext ) {
-                if( IsLightColorTooDim( lext ) )
-                {
-                    return;
-                }
+    return l.additional && ( l.additional->flags & RG_LIGHT_ADDITIONAL_VOLUMETRIC );
+}
 
-                if( dirLightCount > 0 )
-                {
-                    debug::Error( "Only one directional light is allowed" );
-                    return;
-                }
+}
+
+namespace
+{
+
+struct EncodedRegularLight
+{
+    RTGL1::ShLightEncoded  light;
+    RTGL1::LightTree::Item treeItem;
+};
+
+auto EncodeRegularLight( const RTGL1::LightCopy&    light,
+                         std::span< const uint8_t > lightstyles,
+                         const RgTransform*         transform )
+    -> std::optional< EncodedRegularLight >
+{
+    using namespace RTGL1;
 
-                AddInternal(
-                    frameIndex,
-                    light.base.uniqueID,
-                    EncodeAsDirectionalLight(
-                        lext, CalculateLightStyle( light.additional, lightstyles ), transform ) );
+    return std::visit(
+        ext::overloaded{
+            []( const RgLightDirectionalEXT& lext ) -> std::optional< EncodedRegularLight > {
+                assert( 0 );
+                return std::nullopt;
             },
-            [ & ]( const RgLightSphericalEXT& lext ) {
+            [ & ]( const RgLightSphericalEXT& lext ) -> std::optional< EncodedRegularLight > {
                 if( IsLightColorTooDim( lext ) )
                 {
-                    return;
+                    return std::nullopt;
                 }
 
-                AddInternal(
-                    frameIndex,
-                    light.base.uniqueID,
-                    EncodeAsSphereLight(
-                        lext, CalculateLightStyle( light.additional, lightstyles ), transform ) );
+                float mult = CalculateLightStyle( light.additional, lightstyles );
+
+                return EncodedRegularLight{
+                    .light    = EncodeAsSphereLight( lext, mult, transform ),
+                    .treeItem = MakeSphereTreeItem( lext, mult, transform ),
+                };
             },
-            [ & ]( const RgLightSpotEXT& lext ) {
+            [ & ]( const RgLightSpotEXT& lext ) -> std::optional< EncodedRegularLight > {
                 if( IsLightColorTooDim( lext ) )
                 {
-                    return;
+                    return std::nullopt;
                 }
 
-                AddInternal(
-                    frameIndex,
-                    light.base.uniqueID,
-                    EncodeAsSpotLight(
-                        lext, CalculateLightStyle( light.additional, lightstyles ), transform ) );
+                float mult = CalculateLightStyle( light.additional, lightstyles );
+
+                return EncodedRegularLight{
+                    .light    = EncodeAsSpotLight( lext, mult, transform ),
+                    .treeItem = MakeSpotTreeItem( lext, mult, transform ),
+                };
             },
-            [ & ]( const RgLightPolygonalEXT& lext ) {
+            [ & ]( const RgLightPolygonalEXT& lext ) -> std::optional< EncodedRegularLight > {
 #if TRIANGLE_LIGHTS
                 if( IsLightColorTooDim( lext ) )
                 {
-                    return;
+                    return std::nullopt;
                 }
 
                 RgFloat3D unnormalizedNormal = Utils::GetUnnormalizedNormal( lext.positions );
                 if( Utils::Dot( unnormalizedNormal.data, unnormalizedNormal.data ) <= 0.0f )
                 {
-                    return;
+                    return std::nullopt;
                 }
 
-                AddInternal(
-                    frameIndex,
-                    light.base.uniqueID,
-                    EncodeAsTriangleLight( lext,
-                                           unnormalizedNormal,
-                                           CalculateLightStyle( light.additional, lightstyles ),
-                                           transform ) );
+                float mult = CalculateLightStyle( light.additional, lightstyles );
+
+                return EncodedRegularLight{
+                    .light = EncodeAsTriangleLight( lext, unnormalizedNormal, mult, transform ),
+                    .treeItem = MakeTriangleTreeItem( lext, unnormalizedNormal, mult ),
+                };
 #else
                 debug::Error( "Polygonal / triangle lights are not supported" );
+                return std::nullopt;
 #endif
             },
         },
         light.extension );
 }
 
+// Lightstyle index of a static light, or -1 if the light doesn't depend on lightstyles
+int32_t GetStaticLightStyle( const RTGL1::LightCopy& l )
+{
+    if( !l.additional || !( l.additional->flags & RG_LIGHT_ADDITIONAL_LIGHTSTYLE ) ||
+        l.additional->lightstyle < 0 )
+    {
+        return -1;
+    }
+
+    // only their color is patched on a lightstyle change
+    if( !std::holds_alternative< RgLightSphericalEXT >( l.extension ) &&
+        !std::holds_alternative< RgLightSpotEXT >( l.extension ) )
+    {
+        assert( 0 );
+        return -1;
+    }
+
+    return l.additional->lightstyle;
+}
+
+struct PendingStatic
+{
+    EncodedRegularLight encoded;
+    // Index in the array that was passed to SubmitStatic
+    uint32_t            source;
+    int32_t             style;
+};
+
+}
+
+void RTGL1::LightManager::Add( uint32_t           frameIndex,
+                               const LightCopy&   light,
+                               const RgTransform* transform )
+{
+    if( auto lext = std::get_if< RgLightDirectionalEXT >( &light.extension ) )
+    {
+        if( IsLightColorTooDim( *lext ) )
+        {
+            return;
+        }
+
+        if( dirLightCount > 0 )
+        {
+            debug::Error( "Only one directional light is allowed" );
+            return;
+        }
+
+        AddInternal( frameIndex,
+                     light.base.uniqueID,
+                     EncodeAsDirectionalLight(
+                         *lext, CalculateLightStyle( light.additional, lightstyles ), transform ) );
+        return;
+    }
+
+    if( auto encoded = EncodeRegularLight( light, lightstyles, transform ) )
+    {
+        if( IsBudgetEnabled() )
+        {
+            budgetPending.push_back( BudgetPending{
+                .uniqueId = light.base.uniqueID,
+                .light    = encoded->light,
+                .treeItem = encoded->treeItem,
+            } );
+            return;
+        }
+
+        AddInternal( frameIndex, light.base.uniqueID, encoded->light, encoded->treeItem );
+    }
+}
+
+void RTGL1::LightManager::ApplyBudget( uint32_t frameIndex, const Camera& camera )
+{
+    if( !IsBudgetEnabled() )
+    {
+        assert( budgetPending.empty() );
+        return;
+    }
+
+    budget.SetView( camera );
+
+    budgetCandidates.clear();
+    for( const BudgetPending& p : budgetPending )
+    {
+        // slots are updated only for the lights that were uploaded
+        auto slot = dynamicSlots.find( p.uniqueId );
+
+        budgetCandidates.push_back( LightBudget::Candidate{
+            .importance = budget.EstimateImportance( p.treeItem ),
+            .wasKept    = slot != dynamicSlots.end() && slot->second.frameId + 1 == frameId,
+        } );
+    }
+
+    budget.Select( budgetCandidates,
+                   LibConfig().lightBudget,
+                   LibConfig().lightCullThreshold,
+                   LibConfig().lightCullHysteresis,
+                   budgetKept );
+
+    const uint32_t requiredCount =
+        GetLightArrayEnd( regLightCount, dirLightCount ) + uint32_t( budgetKept.size() );
+    if( requiredCount > lightCapacity )
+    {
+        GrowLightBuffers( frameIndex, requiredCount );
+    }
+
+    // in the order of addition
+    for( uint32_t i : budgetKept )
+    {
+        const BudgetPending& p = budgetPending[ i ];
+        AddInternal( frameIndex, p.uniqueId, p.light, p.treeItem );
+    }
+
+    budgetPending.clear();
+}
+
+auto RTGL1::LightManager::GetBudgetStats() const -> const LightBudget::Stats&
+{
+    return budget.GetStats();
+}
+
+void RTGL1::LightManager::SubmitStatic( uint32_t                     frameIndex,
+                                        std::span< const LightCopy > lights,
+                                        uint64_t                     generation )
+{
+    if( staticGeneration != generation )
+    {
+        RebuildStatic( frameIndex, lights );
+        staticGeneration = generation;
+    }
+    else
+    {
+        UpdateStaticLightstyles();
+    }
+}
+
+void RTGL1::LightManager::RebuildStatic( uint32_t frameIndex, std::span< const LightCopy > lights )
+{
+    // static lights must be the first regular ones
+    assert( regLightCount == staticEncoded.size() );
+    assert( dynamicTreeItems.empty() );
+
+    const auto staticCount_Prev = uint32_t( staticEncoded.size() );
+
+    staticIDToIndex_Prev = std::exchange( staticIDToIndex, {} );
+    staticEncoded.clear();
+    staticTreeItems.clear();
+    staticSources.clear();
+    staticStyleOffsets.clear();
+    staticStyledColors.Clear();
+    staticSpatial.Clear();
+    staticVolumetricSpatial.Clear();
+    staticVolumetricSuns.clear();
+    staticAnyVolumetric.reset();
+    staticAnySun.reset();
+
+    auto pending = std::vector< PendingStatic >{};
+
+    for( uint32_t i = 0; i < lights.size(); i++ )
+    {
+        const LightCopy& l = lights[ i ];
+
+        if( IsVolumetric( l ) && !staticAnyVolumetric )
+        {
+            staticAnyVolumetric = l.base.uniqueID;
+        }
+
+        // directional lights are added by the caller every frame
+        if( std::holds_alternative< RgLightDirectionalEXT >( l.extension ) )
+        {
+            if( !staticAnySun )
+            {
+                staticAnySun = l.base.uniqueID;
+            }
+            if( IsVolumetric( l ) )
+            {
+                staticVolumetricSuns.push_back( i );
+            }
+            continue;
+        }
+
+        auto encoded = EncodeRegularLight( l, lightstyles, nullptr );
+        if( !encoded )
+        {
+            continue;
+        }
+
+        pending.push_back( PendingStatic{
+            .encoded = *encoded,
+            .source  = i,
+            .style   = GetStaticLightStyle( l ),
+        } );
+    }
+
+    // lights of the same lightstyle must be contiguous, so a change of a lightstyle value
+    // would touch only one range of slots
+    std::ranges::stable_sort( pending, std::less{}, &PendingStatic::style );
+
+    for( auto& [ encoded, source, style ] : pending )
+    {
+        const LightCopy& l = lights[ source ];
+
+        const auto index = LightArrayIndex{ LIGHT_ARRAY_REGULAR_LIGHTS_OFFSET +
+                                            uint32_t( staticEncoded.size() ) };
+        encoded.treeItem.lightIndex = index.GetArrayIndex();
+
+        staticEncoded.push_back( encoded.light );
+        staticTreeItems.push_back( encoded.treeItem );
+        staticSources.push_back( source );
+
+        if( style >= 0 )
+        {
+            std::visit( ext::overloaded{
+                            [ & ]( const RgLightSphericalEXT& lext ) {
+                                staticStyledColors.Push( lext );
+                            },
+                            [ & ]( const RgLightSpotEXT& lext ) {
+                                staticStyledColors.Push( lext );
+                            },
+                            []( const auto& ) { assert( 0 ); },
+                        },
+                        l.extension );
+        }
+
+        [[maybe_unused]] bool isNew = staticIDToIndex.emplace( l.base.uniqueID, index ).second;
+        assert( isNew );
+
+        AddToSpatial( staticSpatial, encoded.treeItem, index.GetArrayIndex() );
+        if( IsVolumetric( l ) && !std::holds_alternative< RgLightPolygonalEXT >( l.extension ) )
+        {
+            AddToSpatial( staticVolumetricSpatial, encoded.treeItem, index.GetArrayIndex() );
+        }
+    }
+    staticLightstyles = lightstyles;
+
+    if( !pending.empty() )
+    {
+        // sorted, so the last one has the greatest lightstyle index
+        staticStyleOffsets.resize( size_t( pending.back().style + 2 ), 0 );
+        for( const auto& p : pending )
+        {
+            staticStyleOffsets[ size_t( p.style + 1 ) ]++;
+        }
+        // from counts to the range ends
+        for( size_t s = 1; s < staticStyleOffsets.size(); s++ )
+        {
+            staticStyleOffsets[ s ] += staticStyleOffsets[ s - 1 ];
+        }
+        assert( staticStyleOffsets.back() == staticEncoded.size() );
+        assert( staticStyledColors.GetCount() == staticEncoded.size() - staticStyleOffsets[ 0 ] );
+    }
+
+    staticSpatial.Build();
+    staticVolumetricSpatial.Build();
+
+    const auto staticCount = uint32_t( staticEncoded.size() );
+
+    if( GetLightArrayEnd( staticCount, dirLightCount ) > lightCapacity )
+    {
+        GrowLightBuffers( frameIndex, GetLightArrayEnd( staticCount, dirLightCount ) );
+    }
+
+    regLightCount = staticCount;
+
+    staticTreeUpdate = TreeUpdate::Build;
+    staticTreeUploadedAt.reset();
+
+    // slots of the previous static lights are not valid anymore
+    memset( prevToCurIndex->GetMappedAs< uint32_t* >( frameIndex ) +
+                LIGHT_ARRAY_REGULAR_LIGHTS_OFFSET,
+            0xFF,
+            sizeof( uint32_t ) * staticCount_Prev );
+
+    for( const auto& [ uniqueId, index ] : staticIDToIndex )
+    {
+        WriteMatch( frameIndex, index, FindPrevIndex( uniqueId ) );
+    }
+
+    staticDirty   = ElementRange{ 0, staticCount };
+    staticRebuilt = true;
+}
+
+void RTGL1::LightManager::UpdateStaticLightstyles()
+{
+    if( std::ranges::equal( lightstyles, staticLightstyles ) )
+    {
+        return;
+    }
+
+    auto l_value = []( std::span< const uint8_t > values, size_t style ) -> int32_t {
+        return style < values.size() ? values[ style ] : -1;
+    };
+
+    const uint32_t styledBegin = staticStyleOffsets.empty() ? 0 : staticStyleOffsets[ 0 ];
+
+    for( size_t style = 0; style + 1 < staticStyleOffsets.size(); style++ )
+    {
+        const uint32_t begin = staticStyleOffsets[ style ];
+        const uint32_t end   = staticStyleOffsets[ style + 1 ];
+
+        if( begin == end || l_value( lightstyles, style ) == l_value( staticLightstyles, style ) )
+        {
+            continue;
+        }
+
+        // out of range is treated as no lightstyle, same as in CalculateLightStyle
+        const float mult =
+            style < lightstyles.size() ? float( lightstyles[ style ] ) / 255.0f : 1.0f;
+
+        // only the color depends on lightstyle, other fields are kept
+        PatchLightColors( staticStyledColors,
+                          begin - styledBegin,
+                          end - styledBegin,
+                          mult,
+                          std::span( staticEncoded ).subspan( begin, end - begin ) );
+
+        for( uint32_t i = begin; i < end; i++ )
+        {
+            const float power = staticStyledColors.power[ i - styledBegin ] * mult;
+
+            staticTreeItems[ i ].power = power;
+        }
+
+        // same lights, so the bounds can be just refitted with the new power
+        staticTreeUpdate = std::max( staticTreeUpdate, TreeUpdate::Refit );
+        staticTreeUploadedAt.reset();
+
+        staticDirty.Include( begin, end );
+    }
+
+    staticLightstyles = lightstyles;
+}
+
+void RTGL1::LightManager::AddBatch( uint32_t                     frameIndex,
+                                    std::span< const LightCopy > lights,
+                                    FrameArena&                  arena )
+{
+    auto spheres      = SphereLightBatch{ arena };
+    auto spots        = SpotLightBatch{ arena };
+    auto sphereLights = FrameVector< const LightCopy* >{ &arena };
+    auto spotLights   = FrameVector< const LightCopy* >{ &arena };
+    {
+        size_t sphereCount = 0;
+        size_t spotCount   = 0;
+        for( const LightCopy& l : lights )
+        {
+            sphereCount += std::holds_alternative< RgLightSphericalEXT >( l.extension ) ? 1 : 0;
+            spotCount += std::holds_alternative< RgLightSpotEXT >( l.extension ) ? 1 : 0;
+        }
+
+        spheres.Reserve( sphereCount );
+        spots.Reserve( spotCount );
+        sphereLights.reserve( sphereCount );
+        spotLights.reserve( spotCount );
+    }
+
+    for( const LightCopy& l : lights )
+    {
+        if( auto sphere = std::get_if< RgLightSphericalEXT >( &l.extension ) )
+        {
+            if( !IsLightColorTooDim( *sphere ) )
+            {
+                spheres.Push( *sphere, CalculateLightStyle( l.additional, lightstyles ) );
+                sphereLights.push_back( &l );
+            }
+        }
+        else if( auto spot = std::get_if< RgLightSpotEXT >( &l.extension ) )
+        {
+            if( !IsLightColorTooDim( *spot ) )
+            {
+                spots.Push( *spot, CalculateLightStyle( l.additional, lightstyles ) );
+                spotLights.push_back( &l );
+            }
+        }
+        else
+        {
+            // only one directional light is allowed, and triangle lights are rare
+            Add( frameIndex, l );
+        }
+    }
+
+    auto l_addBatch = [ this, frameIndex ]( const auto&                        batch,
+                                            std::span< const LightCopy* const > sources,
+                                            auto&&                             makeTreeItem ) {
+        const auto count = uint32_t( batch.GetCount() );
+        if( count == 0 )
+        {
+            return;
+        }
+
+        if( IsBudgetEnabled() )
+        {
+            // encoded in a batch too, but uploaded by ApplyBudget, when all lights are known
+            auto encoded = FrameVector< ShLightEncoded >( count, batch.color.get_allocator() );
+            EncodeLightBatch( batch, encoded );
+
+            budgetPending.reserve( budgetPending.size() + count );
+            for( uint32_t i = 0; i < count; i++ )
+            {
+                budgetPending.push_back( BudgetPending{
+                    .uniqueId = sources[ i ]->base.uniqueID,
+                    .light    = encoded[ i ],
+                    .treeItem = makeTreeItem( *sources[ i ], batch.mult[ i ] ),
+                } );
+            }
+            return;
+        }
+
+        const uint32_t first = GetLightArrayEnd( regLightCount, dirLightCount );
+        if( first + count > lightCapacity )
+        {
+            GrowLightBuffers( frameIndex, first + count );
+        }
+
+        // the batch is a contiguous range at the end of the regular lights
+        auto* dst = lightsBuffer->GetMappedAs< ShLightEncoded* >( frameIndex );
+        EncodeLightBatch( batch, std::span{ dst + first, count } );
+        regLightCount += count;
+
+        for( uint32_t i = 0; i < count; i++ )
+        {
+            TrackAdded( frameIndex,
+                        sources[ i ]->base.uniqueID,
+                        LightArrayIndex{ first + i },
+                        makeTreeItem( *sources[ i ], batch.mult[ i ] ) );
+        }
+    };
+
+    l_addBatch( spheres, sphereLights, []( const LightCopy& l, float mult ) {
+        return MakeSphereTreeItem( std::get< RgLightSphericalEXT >( l.extension ), mult, nullptr );
+    } );
+    l_addBatch( spots, spotLights, []( const LightCopy& l, float mult ) {
+        return MakeSpotTreeItem( std::get< RgLightSpotEXT >( l.extension ), mult, nullptr );
+    } );
+}
+
 void RTGL1::LightManager::SubmitForFrame( VkCommandBuffer cmd, uint32_t frameIndex )
 {
     CmdLabel label( cmd, "Copying lights" );
 
-    lightsBuffer->CopyFromStaging( cmd,
-                                   frameIndex,
-                                   sizeof( ShLightEncoded ) *
-                                       GetLightArrayEnd( regLightCount, dirLightCount ) );
+    // ApplyBudget must have been called
+    assert( budgetPending.empty() );
+
+    const uint32_t curEnd    = GetLightArrayEnd( regLightCount, dirLightCount );
+    const uint32_t prevEnd   = GetLightArrayEnd( regLightCount_Prev, dirLightCount_Prev );
+    const uint32_t staticEnd = LIGHT_ARRAY_REGULAR_LIGHTS_OFFSET + uint32_t( staticEncoded.size() );
+
+    // static lights are in the device-local buffer already, except the changed ones
+    {
+        auto regions = CopyRegions{ .stride = sizeof( ShLightEncoded ) };
+        regions.Add( 0, LIGHT_ARRAY_REGULAR_LIGHTS_OFFSET );
+
+        if( !staticDirty.Empty() )
+        {
+            auto* dst = lightsBuffer->GetMappedAs< ShLightEncoded* >( frameIndex );
+            memcpy( &dst[ LIGHT_ARRAY_REGULAR_LIGHTS_OFFSET + staticDirty.begin ],
+                    &staticEncoded[ staticDirty.begin ],
+                    sizeof( ShLightEncoded ) * ( staticDirty.end - staticDirty.begin ) );
+
+            regions.Add( LIGHT_ARRAY_REGULAR_LIGHTS_OFFSET + staticDirty.begin,
+                         LIGHT_ARRAY_REGULAR_LIGHTS_OFFSET + staticDirty.end );
+        }
+
+        regions.Add( staticEnd, curEnd );
+
+        lightsBuffer->CopyFromStaging( cmd, frameIndex, regions.infos.data(), regions.count );
+
+        staticCopied_Prev = std::exchange( staticDirty, {} );
+    }
+
+    {
+        auto prev2cur = CopyRegions{ .stride = sizeof( uint32_t ) };
+        auto cur2prev = CopyRegions{ .stride = sizeof( uint32_t ) };
 
-    prevToCurIndex->CopyFromStaging(
-        cmd,
-        frameIndex,
-        sizeof( uint32_t ) * GetLightArrayEnd( regLightCount_Prev, dirLightCount_Prev ) );
-    curToPrevIndex->CopyFromStaging(
-        cmd, frameIndex, sizeof( uint32_t ) * GetLightArrayEnd( regLightCount, dirLightCount ) );
+        if( staticRebuilt )
+        {
+            // all were written in this frame
+            prev2cur.Add( 0, prevEnd );
+            cur2prev.Add( 0, curEnd );
+
+            // in the next frame, static lights will match by their slots
+            staticMappingDirty = true;
+            staticRebuilt      = false;
+        }
+        else
+        {
+            prev2cur.Add( 0, LIGHT_ARRAY_REGULAR_LIGHTS_OFFSET );
+            cur2prev.Add( 0, LIGHT_ARRAY_REGULAR_LIGHTS_OFFSET );
+
+            if( staticMappingDirty )
+            {
+                assert( staticEnd <= prevEnd );
+
+                auto* p2c = prevToCurIndex->GetMappedAs< uint32_t* >( frameIndex );
+                auto* c2p = curToPrevIndex->GetMappedAs< uint32_t* >( frameIndex );
+                for( uint32_t i = LIGHT_ARRAY_REGULAR_LIGHTS_OFFSET; i < staticEnd; i++ )
+                {
+                    p2c[ i ] = i;
+                    c2p[ i ] = i;
+                }
+
+                prev2cur.Add( LIGHT_ARRAY_REGULAR_LIGHTS_OFFSET, staticEnd );
+                cur2prev.Add( LIGHT_ARRAY_REGULAR_LIGHTS_OFFSET, staticEnd );
+
+                staticMappingDirty = false;
+            }
+
+            prev2cur.Add( staticEnd, prevEnd );
+            cur2prev.Add( staticEnd, curEnd );
+        }
+
+        prevToCurIndex->CopyFromStaging( cmd, frameIndex, prev2cur.infos.data(), prev2cur.count );
+        curToPrevIndex->CopyFromStaging( cmd, frameIndex, cur2prev.infos.data(), cur2prev.count );
+    }
+
+    {
+        assert( !lightTreeJob );
+        lightTreeLayout = CalcLightTreeLayout();
+
+        if( lightTreeLayout.nodeCount > 0 )
+        {
+            auto* dst = lightTreeBuffer->GetMappedAs< ShLightTreeNode* >( frameIndex );
+
+            // the layout isn't changed until the job is awaited; captures are kept small,
+            // so the job is stored without a heap allocation
+            lightTreeJob =
+                jobs->Submit( [ this, dst ]() { BuildLightTree( lightTreeLayout, dst ); } );
+        }
+    }
 
     // should be used when buffers changed
     if( needDescSetUpdate[ frameIndex ] )
@@ -544,6 +1458,106 @@ void RTGL1::LightManager::SubmitForFrame( VkCommandBuffer cmd, uint32_t frameInd
     }
 }
 
+auto RTGL1::LightManager::CalcLightTreeLayout() const -> LightTreeLayout
+{
+    const uint32_t staticCount  = LightTree::CalcNodeCount( staticTreeItems.size() );
+    const uint32_t dynamicCount = LightTree::CalcNodeCount( dynamicTreeItems.size() );
+    const uint32_t rootCount    = staticCount > 0 && dynamicCount > 0 ? 1 : 0;
+
+    auto layout = LightTreeLayout{
+        .staticOffset  = rootCount,
+        .dynamicOffset = rootCount + staticCount,
+        .nodeCount     = rootCount + staticCount + dynamicCount,
+        .writeStatic   = staticCount > 0 && staticTreeUploadedAt != rootCount,
+    };
+    assert( layout.nodeCount == GetLightTreeNodeCount() );
+
+    return layout;
+}
+
+void RTGL1::LightManager::BuildLightTree( const LightTreeLayout& layout, ShLightTreeNode* dst )
+{
+    switch( staticTreeUpdate )
+    {
+        case TreeUpdate::Refit:
+            if( staticTree.Refit( staticTreeItems ) )
+            {
+                break;
+            }
+            [[fallthrough]];
+        case TreeUpdate::Build: staticTree.Build( staticTreeItems ); break;
+        case TreeUpdate::None: break;
+    }
+    staticTreeUpdate = TreeUpdate::None;
+
+    // same lights in the same order: only the bounds and the power might have changed
+    bool refitted = dynamicTreeTopology == dynamicTreeTopology_Built &&
+                    dynamicTree.Refit( dynamicTreeItems );
+    if( !refitted )
+    {
+        dynamicTree.Build( dynamicTreeItems );
+        dynamicTreeTopology_Built = dynamicTreeTopology;
+    }
+
+    const uint32_t staticCount  = staticTree.GetNodeCount();
+    const uint32_t dynamicCount = dynamicTree.GetNodeCount();
+    assert( layout.dynamicOffset + dynamicCount == layout.nodeCount );
+
+    if( staticCount > 0 && dynamicCount > 0 )
+    {
+        LightTree::WriteJoinedRoot( staticTree, dynamicTree, layout.dynamicOffset, dst[ 0 ] );
+    }
+    if( layout.writeStatic )
+    {
+        staticTree.WriteNodes( std::span( dst + layout.staticOffset, staticCount ),
+                               layout.staticOffset );
+    }
+    if( dynamicCount > 0 )
+    {
+        dynamicTree.WriteNodes( std::span( dst + layout.dynamicOffset, dynamicCount ),
+                                layout.dynamicOffset );
+    }
+}
+
+void RTGL1::LightManager::WaitLightTree()
+{
+    if( lightTreeJob )
+    {
+        jobs->Wait( lightTreeJob );
+        lightTreeJob.reset();
+    }
+}
+
+void RTGL1::LightManager::SubmitLightTree( VkCommandBuffer cmd, uint32_t frameIndex )
+{
+    if( !lightTreeJob )
+    {
+        return;
+    }
+
+    CmdLabel label( cmd, "Copying light tree" );
+
+    WaitLightTree();
+
+    const LightTreeLayout& layout = lightTreeLayout;
+
+    // the static subtree is kept in the device-local buffer, while it's the same
+    auto regions = CopyRegions{ .stride = sizeof( ShLightTreeNode ) };
+    regions.Add( 0, layout.staticOffset );
+    if( layout.writeStatic )
+    {
+        regions.Add( layout.staticOffset, layout.dynamicOffset );
+    }
+    regions.Add( layout.dynamicOffset, layout.nodeCount );
+
+    lightTreeBuffer->CopyFromStaging( cmd, frameIndex, regions.infos.data(), regions.count );
+
+    if( layout.writeStatic )
+    {
+        staticTreeUploadedAt = layout.staticOffset;
+    }
+}
+
 void RTGL1::LightManager::BarrierLightGrid( VkCommandBuffer cmd, uint32_t frameIndex )
 {
 #if LIGHT_GRID_ENABLED
@@ -582,27 +1596,36 @@ VkDescriptorSet RTGL1::LightManager::GetDescSet( uint32_t frameIndex ) const
     return descSets[ frameIndex ];
 }
 
-void RTGL1::LightManager::FillMatchPrev( uint32_t        curFrameIndex,
-                                         LightArrayIndex lightIndexInCurFrame,
-                                         UniqueLightID   uniqueID )
+auto RTGL1::LightManager::FindPrevIndex( UniqueLightID uniqueID ) const
+    -> std::optional< LightArrayIndex >
 {
-    uint32_t prevFrame = ( curFrameIndex + 1 ) % MAX_FRAMES_IN_FLIGHT;
-    const rgl::unordered_map< UniqueLightID, LightArrayIndex >& uniqueToPrevIndex =
-        uniqueIDToArrayIndex[ prevFrame ];
-
-    auto found = uniqueToPrevIndex.find( uniqueID );
-    if( found == uniqueToPrevIndex.end() )
+    auto foundStatic = staticIDToIndex_Prev.find( uniqueID );
+    if( foundStatic != staticIDToIndex_Prev.end() )
     {
-        return;
+        return foundStatic->second;
     }
 
-    LightArrayIndex lightIndexInPrevFrame = found->second;
+    auto foundDynamic = dynamicSlots.find( uniqueID );
+    if( foundDynamic != dynamicSlots.end() && foundDynamic->second.frameId + 1 == frameId )
+    {
+        return foundDynamic->second.index;
+    }
 
-    auto* prev2cur = prevToCurIndex->GetMappedAs< uint32_t* >( curFrameIndex );
-    prev2cur[ lightIndexInPrevFrame.GetArrayIndex() ] = lightIndexInCurFrame.GetArrayIndex();
+    return std::nullopt;
+}
 
+void RTGL1::LightManager::WriteMatch( uint32_t                                curFrameIndex,
+                                      LightArrayIndex                         curIndex,
+                                      const std::optional< LightArrayIndex >& prevIndex )
+{
     auto* cur2prev = curToPrevIndex->GetMappedAs< uint32_t* >( curFrameIndex );
-    cur2prev[ lightIndexInCurFrame.GetArrayIndex() ] = lightIndexInPrevFrame.GetArrayIndex();
+    cur2prev[ curIndex.GetArrayIndex() ] = prevIndex ? prevIndex->GetArrayIndex() : UINT32_MAX;
+
+    if( prevIndex )
+    {
+        auto* prev2cur = prevToCurIndex->GetMappedAs< uint32_t* >( curFrameIndex );
+        prev2cur[ prevIndex->GetArrayIndex() ] = curIndex.GetArrayIndex();
+    }
 }
 
 constexpr uint32_t BINDINGS[] = {
@@ -610,6 +1633,7 @@ constexpr uint32_t BINDINGS[] = {
     BINDING_LIGHT_SOURCES_PREV,
     BINDING_LIGHT_SOURCES_INDEX_PREV_TO_CUR,
     BINDING_LIGHT_SOURCES_INDEX_CUR_TO_PREV,
+    BINDING_LIGHT_TREE,
 #if LIGHT_GRID_ENABLED
     BINDING_INITIAL_LIGHTS_GRID,
     BINDING_INITIAL_LIGHTS_GRID_PREV,
@@ -694,9 +1718,10 @@ void RTGL1::LightManager::UpdateDescriptors( uint32_t frameIndex )
 {
     const VkBuffer buffers[] = {
         lightsBuffer->GetDeviceLocal(),
-        lightsBuffer_Prev.GetBuffer(),
+        lightsBuffer_Prev->GetBuffer(),
         prevToCurIndex->GetDeviceLocal(),
         curToPrevIndex->GetDeviceLocal(),
+        lightTreeBuffer->GetDeviceLocal(),
 #if LIGHT_GRID_ENABLED
         initialLightsGrid[ frameIndex ].GetBuffer(),
         initialLightsGrid[ Utils::GetPreviousByModulo( frameIndex, MAX_FRAMES_IN_FLIGHT ) ]
@@ -745,14 +1770,25 @@ uint32_t RTGL1::LightManager::GetLightCountPrev() const
     return regLightCount_Prev;
 }
 
+uint32_t RTGL1::LightManager::GetLightCapacity() const
+{
+    return lightCapacity;
+}
+
+uint32_t RTGL1::LightManager::GetLightTreeNodeCount() const
+{
+    // tree is built in SubmitForFrame, but its size is known already;
+    // a joined root has the same count as one tree over all lights
+    return LightTree::CalcNodeCount( staticTreeItems.size() + dynamicTreeItems.size() );
+}
+
 
 uint32_t RTGL1::LightManager::DoesDirectionalLightExist() const
 {
     return dirLightCount > 0 ? 1 : 0;
 }
 
-uint32_t RTGL1::LightManager::GetLightIndexForShaders( uint32_t        frameIndex,
-                                                       const uint64_t* pLightUniqueId ) const
+uint32_t RTGL1::LightManager::GetLightIndexForShaders( const uint64_t* pLightUniqueId ) const
 {
     if( pLightUniqueId == nullptr )
     {
@@ -760,107 +1796,134 @@ uint32_t RTGL1::LightManager::GetLightIndexForShaders( uint32_t        frameInde
     }
     UniqueLightID uniqueId = { *pLightUniqueId };
 
-    const auto f = uniqueIDToArrayIndex[ frameIndex ].find( uniqueId );
-    if( f == uniqueIDToArrayIndex[ frameIndex ].end() )
+    const auto s = staticIDToIndex.find( uniqueId );
+    if( s != staticIDToIndex.end() )
     {
-        return LIGHT_INDEX_NONE;
+        return s->second.GetArrayIndex();
     }
 
-    return f->second.GetArrayIndex();
+    // only if it was added in the current frame
+    const auto d = dynamicSlots.find( uniqueId );
+    if( d != dynamicSlots.end() && d->second.frameId == frameId )
+    {
+        return d->second.index.GetArrayIndex();
+    }
+
+    return LIGHT_INDEX_NONE;
 }
 
 auto RTGL1::LightManager::TryGetVolumetricLight( const RgFloat3D&                 cameraPos,
-                                                 const std::vector< LightCopy >&  from,
+                                                 std::span< const LightCopy >     staticLights,
                                                  const std::optional< uint64_t >& fallback ) const
     -> std::optional< uint64_t >
 {
-    static auto l_isVolumetric = []( const LightCopy& l ) {
-        return l.additional && ( l.additional->flags & RG_LIGHT_ADDITIONAL_VOLUMETRIC );
-    };
+    // indices were made by SubmitStatic from the same array
+    assert( staticSources.empty() || staticSources.back() < staticLights.size() );
+    assert( staticVolumetricSuns.empty() || staticVolumetricSuns.back() < staticLights.size() );
 
     auto l_approxVolumetricIntensity = [ this ]( const LightCopy& l ) {
-        assert( l_isVolumetric( l ) );
+        assert( IsVolumetric( l ) );
 
         float intensity =
             std::visit( []( const auto& lext ) { return lext.intensity; }, l.extension );
 
         return intensity * CalculateLightStyle( l.additional, lightstyles );
     };
-    auto l_approxDistanceSq = []( const LightCopy& l, const RgFloat3D& from ) -> float {
-        // clang-format off
-        return std::visit( ext::overloaded{
-            [ & ]( const RgLightDirectionalEXT& lext ) { return 0.f; },
-            [ & ]( const RgLightSphericalEXT&   lext ) { return Utils::SqrDistanceR( lext.position, from ); },
-            [ & ]( const RgLightSpotEXT&        lext ) { return Utils::SqrDistanceR( lext.position, from ); },
-            [ & ]( const RgLightPolygonalEXT&   lext ) { assert( 0 ); return -1.f; },
-        }, l.extension );
-        // clang-format on
-    };
-
-    struct Candidate
-    {
-        uint64_t id;
-        float    distanceSq;
-    };
-    auto best = std::optional< Candidate >{};
-    auto any  = std::optional< Candidate >{};
 
-    for( const auto& l : from )
+    // directional lights are at zero distance, so they are the closest
+    for( uint32_t i : staticVolumetricSuns )
     {
-        if( !l_isVolumetric( l ) )
+        if( l_approxVolumetricIntensity( staticLights[ i ] ) > 0.0f )
         {
-            continue;
-        }
-        
-        if( l_approxVolumetricIntensity( l ) > 0.0f )
-        {
-            float distSq = l_approxDistanceSq( l, cameraPos );
-            if( distSq >= 0 )
-            {
-                // choose closest
-                if( !best || distSq < best->distanceSq )
-                {
-                    best = Candidate{
-                        .id         = l.base.uniqueID,
-                        .distanceSq = distSq,
-                    };
-                }
-            }
-        }
-
-        if( !any )
-        {
-            any = Candidate{
-                .id         = l.base.uniqueID,
-                .distanceSq = 0,
-            };
+            return staticLights[ i ].base.uniqueID;
         }
     }
 
-    if( best )
+    auto l_toStatic = [ & ]( uint32_t lightIndex ) -> const LightCopy& {
+        return staticLights[ staticSources[ lightIndex - LIGHT_ARRAY_REGULAR_LIGHTS_OFFSET ] ];
+    };
+
+    auto closest = std::vector< LightSpatialIndex::Hit >{};
+    staticVolumetricSpatial.FindNearest(
+        cameraPos,
+        1,
+        [ & ]( uint32_t lightIndex ) {
+            return l_approxVolumetricIntensity( l_toStatic( lightIndex ) ) > 0.0f;
+        },
+        closest );
+
+    if( !closest.empty() )
     {
-        return best->id;
+        return l_toStatic( closest[ 0 ].value ).base.uniqueID;
     }
 
     // SHIPPING_HACK: don't fallback to sun, if at least
     // one light is marked as isVolumetric, but has 0 intensity
-    if( any )
+    if( staticAnyVolumetric )
     {
-        return any->id;
+        return staticAnyVolumetric;
     }
 
     // if nothing, just try find the sun in the provided list
-    for( const auto& l : from )
+    if( staticAnySun )
     {
-        if( auto sun = std::get_if< RgLightDirectionalEXT >( &l.extension ) )
-        {
-            return l.base.uniqueID;
-        }
+        return staticAnySun;
     }
 
     return fallback;
 }
 
+void RTGL1::LightManager::UpdateDynamicSpatial()
+{
+    // only the lights that were added since the last query of this frame
+    for( size_t i = dynamicSpatialCount; i < dynamicTreeItems.size(); i++ )
+    {
+        AddToSpatial( dynamicSpatial, dynamicTreeItems[ i ], dynamicTreeItems[ i ].lightIndex );
+    }
+    dynamicSpatialCount = dynamicTreeItems.size();
+
+    if( dynamicSpatial.NeedsBuild() )
+    {
+        dynamicSpatial.Build();
+    }
+}
+
+void RTGL1::LightManager::FindLightsInRadius( const RgFloat3D&         center,
+                                              float                    radius,
+                                              std::vector< uint32_t >& out )
+{
+    UpdateDynamicSpatial();
+
+    out.clear();
+
+    auto l_add = [ &out ]( uint32_t lightIndex ) { out.push_back( lightIndex ); };
+    staticSpatial.ForEachInRadius( center, radius, l_add );
+    dynamicSpatial.ForEachInRadius( center, radius, l_add );
+}
+
+void RTGL1::LightManager::FindNearestLights( const RgFloat3D&         point,
+                                             uint32_t                 k,
+                                             std::vector< uint32_t >& out )
+{
+    UpdateDynamicSpatial();
+
+    out.clear();
+
+    auto l_any = []( uint32_t ) { return true; };
+
+    // k closest from each, and then the k closest of them
+    staticSpatial.FindNearest( point, k, l_any, spatialHits );
+    dynamicSpatial.FindNearest( point, k, l_any, spatialHitsDynamic );
+
+    spatialHits.insert( spatialHits.end(), spatialHitsDynamic.begin(), spatialHitsDynamic.end() );
+    std::ranges::sort( spatialHits, std::less{}, &LightSpatialIndex::Hit::distanceSq );
+
+    for( size_t i = 0; i < std::min( size_t( k ), spatialHits.size() ); i++ )
+    {
+        out.push_back( spatialHits[ i ].value );
+    }
+}
+
 void RTGL1::LightManager::SetLightstyles( const RgStartFrameInfo& params )
 {
     if( !params.pLightstyleValues8 || params.lightstyleValuesCount == 0 )
@@ -24,8 +24,14 @@
 #include "Common.h"
 #include "Containers.h"
 #include "AutoBuffer.h"
+#include "JobSystem.h"
+#include "LightBudget.h"
 #include "LightDefs.h"
+#include "LightEncodeBatch.h"
+#include "LightSpatialIndex.h"
+#include "LightTree.h"
 
+#include <algorithm>
 #include <optional>
 #include <span>
 
@@ -34,12 +40,16 @@
 namespace RTGL1
 {
 
+struct Camera;
 struct ShLightEncoded;
+class FrameArena;
 
 class LightManager
 {
 public:
-    LightManager( VkDevice device, std::shared_ptr< MemoryAllocator >& allocator );
+    LightManager( VkDevice                            device,
+                  std::shared_ptr< MemoryAllocator >& allocator,
+                  std::shared_ptr< JobSystem >        jobSystem );
     ~LightManager();
 
     LightManager( const LightManager& other )                = delete;
@@ -52,13 +62,35 @@ public:
 
     uint32_t GetLightCount() const;
     uint32_t GetLightCountPrev() const;
+    uint32_t GetLightCapacity() const;
+    uint32_t GetLightTreeNodeCount() const;
     uint32_t DoesDirectionalLightExist() const;
 
-    uint32_t GetLightIndexForShaders( uint32_t frameIndex, const uint64_t* pLightUniqueId ) const;
+    uint32_t GetLightIndexForShaders( const uint64_t* pLightUniqueId ) const;
+
+    // Regular static lights are kept in a persistent region at the beginning of the light array,
+    // and encoded again only if 'generation' has changed, or if their lightstyle values have.
+    // Must be called before other lights are added for the frame. Directional lights are ignored
+    void SubmitStatic( uint32_t                     frameIndex,
+                       std::span< const LightCopy > lights,
+                       uint64_t                     generation );
 
     void Add( uint32_t frameIndex, const LightCopy& light, const RgTransform* transform = nullptr );
+    // Same as Add for each light without a transform, but sphere and spot lights
+    // are encoded in batches: directly into the staging buffer, or into the lights
+    // that wait for ApplyBudget, if the budget is enabled
+    void AddBatch( uint32_t frameIndex, std::span< const LightCopy > lights, FrameArena& arena );
+
+    // If the light budget is enabled in the library config, Add and AddBatch only collect
+    // the dynamic regular lights, and this uploads the most important of them for the camera.
+    // Must be called after all lights of the frame are added, before the light counts are used
+    void ApplyBudget( uint32_t frameIndex, const Camera& camera );
+    auto GetBudgetStats() const -> const LightBudget::Stats&;
 
+    // Starts building the light tree on a job, it overlaps the recording until SubmitLightTree
     void SubmitForFrame( VkCommandBuffer cmd, uint32_t frameIndex );
+    // Waits for the light tree and records its upload, must be called before it's used
+    void SubmitLightTree( VkCommandBuffer cmd, uint32_t frameIndex );
     void BarrierLightGrid( VkCommandBuffer cmd, uint32_t frameIndex );
 
     VkDescriptorSetLayout GetDescSetLayout() const;
@@ -66,29 +98,107 @@ public:
 
     void SetLightstyles( const RgStartFrameInfo& params );
 
+    // 'staticLights' must be the same as the last ones passed to SubmitStatic
     auto TryGetVolumetricLight( const RgFloat3D&                 cameraPos,
-                                const std::vector< LightCopy >&  from,
+                                std::span< const LightCopy >     staticLights,
                                 const std::optional< uint64_t >& fallback ) const
         -> std::optional< uint64_t >;
 
+    // Regular lights of the current frame, which bounding spheres intersect the given sphere.
+    // Results are indices in the light array
+    void FindLightsInRadius( const RgFloat3D& center, float radius, std::vector< uint32_t >& out );
+    // Up to 'k' regular lights of the current frame that are the closest to the point,
+    // sorted by distance. Results are indices in the light array
+    void FindNearestLights( const RgFloat3D& point, uint32_t k, std::vector< uint32_t >& out );
+
+private:
+    struct ElementRange
+    {
+        uint32_t begin{ 0 };
+        uint32_t end{ 0 };
+
+        bool Empty() const { return begin >= end; }
+        void Include( uint32_t b, uint32_t e )
+        {
+            begin = Empty() ? b : std::min( begin, b );
+            end   = Empty() ? e : std::max( end, e );
+        }
+    };
+
+    struct DynamicSlot
+    {
+        LightArrayIndex index;
+        uint64_t        frameId;
+    };
+
+    struct BudgetPending
+    {
+        uint64_t        uniqueId;
+        ShLightEncoded  light;
+        LightTree::Item treeItem;
+    };
+
+    enum class TreeUpdate
+    {
+        None,
+        Refit,
+        Build,
+    };
+
+    // Node offsets in the tree buffer: if there are both static and dynamic lights,
+    // their subtrees are joined under one root, as [root][static nodes][dynamic nodes]
+    struct LightTreeLayout
+    {
+        uint32_t staticOffset{ 0 };
+        uint32_t dynamicOffset{ 0 };
+        uint32_t nodeCount{ 0 };
+        // If the static subtree must be uploaded in this frame
+        bool     writeStatic{ false };
+    };
+
 private:
     LightArrayIndex GetIndex( const ShLightEncoded& encodedLight ) const;
     void            IncrementCount( const ShLightEncoded& encodedLight );
 
-    void AddInternal( uint32_t frameIndex, uint64_t uniqueId, const ShLightEncoded& encodedLight );
+    void AddInternal( uint32_t                                frameIndex,
+                      uint64_t                                uniqueId,
+                      const ShLightEncoded&                   encodedLight,
+                      const std::optional< LightTree::Item >& treeItem = std::nullopt );
+    // Bookkeeping of a light that was already written to the lights buffer
+    void TrackAdded( uint32_t                                frameIndex,
+                     uint64_t                                uniqueId,
+                     LightArrayIndex                         index,
+                     const std::optional< LightTree::Item >& treeItem );
+    void GrowLightBuffers( uint32_t frameIndex, uint32_t requiredCount );
+    void ReleaseRetired( uint32_t frameIndex );
 
-    void FillMatchPrev( uint32_t        curFrameIndex,
-                        LightArrayIndex lightIndexInCurFrame,
-                        UniqueLightID   uniqueID );
+    auto CalcLightTreeLayout() const -> LightTreeLayout;
+    // Runs on a job, writes the nodes to the staging buffer
+    void BuildLightTree( const LightTreeLayout& layout, ShLightTreeNode* dst );
+    void WaitLightTree();
+
+    void RebuildStatic( uint32_t frameIndex, std::span< const LightCopy > lights );
+    // Add the dynamic lights of this frame to the index, if they're not there yet
+    void UpdateDynamicSpatial();
+    void UpdateStaticLightstyles();
+    auto FindPrevIndex( UniqueLightID uniqueID ) const -> std::optional< LightArrayIndex >;
+    void WriteMatch( uint32_t                                curFrameIndex,
+                     LightArrayIndex                         curIndex,
+                     const std::optional< LightArrayIndex >& prevIndex );
 
     void CreateDescriptors();
     void UpdateDescriptors( uint32_t frameIndex );
 
 private:
-    VkDevice device;
+    VkDevice                           device;
+    std::shared_ptr< MemoryAllocator > allocator;
+    std::shared_ptr< JobSystem >       jobs;
+
+    // Capacity (in lights) of all light buffers, grows geometrically on demand
+    uint32_t                           lightCapacity;
 
     std::shared_ptr< AutoBuffer > lightsBuffer;
-    Buffer                        lightsBuffer_Prev;
+    std::unique_ptr< Buffer >     lightsBuffer_Prev;
 #if LIGHT_GRID_ENABLED_
     Buffer                        initialLightsGrid[ MAX_FRAMES_IN_FLIGHT ];
 #endif
@@ -97,8 +207,78 @@ private:
     std::shared_ptr< AutoBuffer > prevToCurIndex;
     std::shared_ptr< AutoBuffer > curToPrevIndex;
 
-    rgl::unordered_map< UniqueLightID, LightArrayIndex >
-        uniqueIDToArrayIndex[ MAX_FRAMES_IN_FLIGHT ];
+    // BVH over the regular lights, to importance sample them in the initial reservoirs.
+    // Static lights have their own subtree, which is updated only when they change,
+    // the one of the dynamic lights is refitted or rebuilt each frame
+    LightTree                      staticTree;
+    TreeUpdate                     staticTreeUpdate;
+    // Offset of the static subtree in the device-local tree buffer, if it's there
+    std::optional< uint32_t >      staticTreeUploadedAt;
+    LightTree                      dynamicTree;
+    std::vector< LightTree::Item > dynamicTreeItems;
+    // Hash of the dynamic lights' unique IDs in the array order: if it's the same as
+    // the one that dynamicTree was built with, then the tree can be just refitted
+    uint64_t                       dynamicTreeTopology;
+    uint64_t                       dynamicTreeTopology_Built;
+    std::shared_ptr< AutoBuffer >  lightTreeBuffer;
+    LightTreeLayout                lightTreeLayout;
+    JobSystem::Handle              lightTreeJob;
+
+    // Buffers replaced by a growth, can be referenced by frames in flight,
+    // so destroyed only when the frame slot is reused
+    std::vector< std::shared_ptr< AutoBuffer > > retiredAutoBuffers[ MAX_FRAMES_IN_FLIGHT ];
+    std::vector< std::unique_ptr< Buffer > >     retiredBuffers[ MAX_FRAMES_IN_FLIGHT ];
+
+    // Static lights, encoded once: they occupy the same slots while the static scene is the same,
+    // so their indices match between frames without any lookup
+    std::optional< uint64_t >                            staticGeneration;
+    std::vector< ShLightEncoded >                        staticEncoded;
+    std::vector< LightTree::Item >                       staticTreeItems;
+    // Index in the array that was passed to SubmitStatic
+    std::vector< uint32_t >                              staticSources;
+    // Static lights are sorted by lightstyle: [0, offsets[0]) don't depend on lightstyles,
+    // and the ones with lightstyle 's' are in [offsets[s], offsets[s+1])
+    std::vector< uint32_t >                              staticStyleOffsets;
+    // Colors of the lights that depend on lightstyles, starting from the slot offsets[0]
+    LightColorBatch                                      staticStyledColors;
+    // Lightstyle values that the static lights are encoded with
+    std::vector< uint8_t >                               staticLightstyles;
+    rgl::unordered_map< UniqueLightID, LightArrayIndex > staticIDToIndex;
+    // Not empty only in a frame when the static lights were changed
+    rgl::unordered_map< UniqueLightID, LightArrayIndex > staticIDToIndex_Prev;
+    // Relative to the static region: what must be copied to the GPU in this frame,
+    // and what was copied in the previous one, so lightsBuffer_Prev must receive it too
+    ElementRange                                         staticDirty;
+    ElementRange                                         staticCopied_Prev;
+    bool                                                 staticRebuilt;
+    // If the identity mapping of the static lights must be uploaded to the index buffers
+    bool                                                 staticMappingDirty;
+    // Values are indices in the light array
+    LightSpatialIndex                                    staticSpatial;
+    // Volumetric sphere and spot lights, only the closest center is looked up
+    LightSpatialIndex                                    staticVolumetricSpatial;
+    // Indices in the static lights array
+    std::vector< uint32_t >                              staticVolumetricSuns;
+    std::optional< uint64_t >                            staticAnyVolumetric;
+    std::optional< uint64_t >                            staticAnySun;
+
+    // Persistent, so the previous index of a dynamic light is found by the same lookup
+    // that registers the current one; entries of the lights that are gone are purged lazily
+    rgl::unordered_map< UniqueLightID, DynamicSlot > dynamicSlots;
+    uint64_t                                         frameId;
+    // Filled from dynamicTreeItems and built only on a query, so frames without queries
+    // don't pay for it; dynamicSpatialCount is how many of the items are already in it
+    LightSpatialIndex                                dynamicSpatial;
+    size_t                                           dynamicSpatialCount;
+    // Reused by the queries
+    std::vector< LightSpatialIndex::Hit >            spatialHits;
+    std::vector< LightSpatialIndex::Hit >            spatialHitsDynamic;
+
+    // Dynamic regular lights that wait for ApplyBudget
+    LightBudget                           budget;
+    std::vector< BudgetPending >          budgetPending;
+    std::vector< LightBudget::Candidate > budgetCandidates;
+    std::vector< uint32_t >               budgetKept;
 
     uint32_t regLightCount;
     uint32_t regLightCount_Prev;
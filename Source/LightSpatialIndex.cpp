@@ -0,0 +1,168 @@
+/*
+
+Copyright (c) 2024 V.Shirokii
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "LightSpatialIndex.h"
+
+#include <cmath>
+
+namespace
+{
+
+// Grid is not bigger than this many cells per item
+constexpr size_t  MAX_CELLS_PER_ITEM = 2;
+constexpr int32_t MAX_DIM            = 1024;
+constexpr float   MIN_EXTENT         = 0.001f;
+
+}
+
+void RTGL1::LightSpatialIndex::Clear()
+{
+    items.clear();
+    sorted.clear();
+    cellStart.clear();
+    dims[ 0 ] = dims[ 1 ] = dims[ 2 ] = 0;
+    maxRadius = 0.0f;
+    dirty     = false;
+}
+
+void RTGL1::LightSpatialIndex::Add( const RgFloat3D& center, float radius, uint32_t value )
+{
+    items.push_back( Item{
+        .center = { center.data[ 0 ], center.data[ 1 ], center.data[ 2 ] },
+        .radius = std::max( radius, 0.0f ),
+        .value  = value,
+    } );
+    dirty = true;
+}
+
+auto RTGL1::LightSpatialIndex::CellOf( const float ( &p )[ 3 ] ) const -> Cell
+{
+    // far away points are clamped, to not overflow
+    constexpr float limit = float( 1 << 20 );
+
+    Cell cell;
+    for( int a = 0; a < 3; a++ )
+    {
+        float c     = std::floor( ( p[ a ] - boundsMin[ a ] ) * invCellSize );
+        cell.c[ a ] = int32_t( std::clamp( c, -limit, limit ) );
+    }
+    return cell;
+}
+
+void RTGL1::LightSpatialIndex::Build()
+{
+    dirty = false;
+    sorted.clear();
+    cellStart.clear();
+
+    if( items.empty() )
+    {
+        dims[ 0 ] = dims[ 1 ] = dims[ 2 ] = 0;
+        return;
+    }
+
+    float boundsMax[ 3 ];
+    for( int a = 0; a < 3; a++ )
+    {
+        boundsMin[ a ] = items[ 0 ].center[ a ];
+        boundsMax[ a ] = items[ 0 ].center[ a ];
+    }
+    maxRadius = 0.0f;
+
+    for( const Item& item : items )
+    {
+        for( int a = 0; a < 3; a++ )
+        {
+            boundsMin[ a ] = std::min( boundsMin[ a ], item.center[ a ] );
+            boundsMax[ a ] = std::max( boundsMax[ a ], item.center[ a ] );
+        }
+        maxRadius = std::max( maxRadius, item.radius );
+    }
+
+    float extent[ 3 ];
+    float maxExtent = MIN_EXTENT;
+    float volume    = 1.0f;
+    for( int a = 0; a < 3; a++ )
+    {
+        extent[ a ] = std::max( boundsMax[ a ] - boundsMin[ a ], MIN_EXTENT );
+        maxExtent   = std::max( maxExtent, extent[ a ] );
+        volume *= extent[ a ];
+    }
+
+    // around one item per cell, if they are uniformly distributed;
+    // but flat or thin sets would produce too many cells on the long axes
+    cellSize = std::max( std::cbrt( volume / float( items.size() ) ),
+                         maxExtent / float( MAX_DIM ) );
+
+    const size_t maxCells = MAX_CELLS_PER_ITEM * items.size() + 64;
+    while( true )
+    {
+        size_t cellCount = 1;
+        for( int a = 0; a < 3; a++ )
+        {
+            dims[ a ] = std::min( int32_t( extent[ a ] / cellSize ) + 1, MAX_DIM );
+            cellCount *= size_t( dims[ a ] );
+        }
+
+        if( cellCount <= maxCells )
+        {
+            break;
+        }
+        cellSize *= 1.25f;
+    }
+    invCellSize = 1.0f / cellSize;
+
+    const uint32_t cellCount = CellIndex( dims[ 0 ] - 1, dims[ 1 ] - 1, dims[ 2 ] - 1 ) + 1;
+
+    // counting sort by cell
+    cellStart.assign( cellCount + 1, 0 );
+
+    auto l_cellOfItem = [ this ]( const Item& item ) {
+        const Cell c = CellOf( item.center );
+        return CellIndex( std::clamp( c.c[ 0 ], 0, dims[ 0 ] - 1 ),
+                          std::clamp( c.c[ 1 ], 0, dims[ 1 ] - 1 ),
+                          std::clamp( c.c[ 2 ], 0, dims[ 2 ] - 1 ) );
+    };
+
+    for( const Item& item : items )
+    {
+        cellStart[ l_cellOfItem( item ) + 1 ]++;
+    }
+    for( uint32_t i = 0; i < cellCount; i++ )
+    {
+        cellStart[ i + 1 ] += cellStart[ i ];
+    }
+
+    // cellStart is advanced while placing, and then restored by shifting
+    sorted.resize( items.size() );
+    for( const Item& item : items )
+    {
+        sorted[ cellStart[ l_cellOfItem( item ) ]++ ] = item;
+    }
+    for( uint32_t i = cellCount; i > 0; i-- )
+    {
+        cellStart[ i ] = cellStart[ i - 1 ];
+    }
+    cellStart[ 0 ] = 0;
+}
@@ -0,0 +1,304 @@
+/*
+
+Copyright (c) 2024 V.Shirokii
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "RTGL1/RTGL1.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
+namespace RTGL1
+{
+
+// Uniform grid over the bounding spheres of lights, to find the ones that are close
+// to a point without iterating over all of them. Items are accumulated with Add,
+// and the grid is constructed by Build, which is O(n): so it's cheap to reconstruct
+// it on the first query of a frame for dynamic lights, or only when the set is changed
+// for static ones.
+class LightSpatialIndex
+{
+public:
+    struct Hit
+    {
+        uint32_t value;
+        float    distanceSq;
+    };
+
+public:
+    LightSpatialIndex()  = default;
+    ~LightSpatialIndex() = default;
+
+    LightSpatialIndex( const LightSpatialIndex& other )                = delete;
+    LightSpatialIndex( LightSpatialIndex&& other ) noexcept            = delete;
+    LightSpatialIndex& operator=( const LightSpatialIndex& other )     = delete;
+    LightSpatialIndex& operator=( LightSpatialIndex&& other ) noexcept = delete;
+
+    void Clear();
+    // 'value' is an arbitrary user index, returned by the queries
+    void Add( const RgFloat3D& center, float radius, uint32_t value );
+    void Build();
+
+    bool NeedsBuild() const { return dirty; }
+    bool Empty() const { return items.empty(); }
+
+    // Call 'func( value )' for each item, which sphere intersects the given one
+    template< typename Func >
+    void ForEachInRadius( const RgFloat3D& center, float radius, Func&& func ) const;
+
+    // Up to 'k' items, for which 'filter( value )' is true, that are the closest
+    // to 'point' by their centers. Sorted by distance
+    template< typename Filter >
+    void FindNearest( const RgFloat3D&    point,
+                      uint32_t            k,
+                      Filter&&            filter,
+                      std::vector< Hit >& out ) const;
+
+private:
+    struct Item
+    {
+        float    center[ 3 ];
+        float    radius;
+        uint32_t value;
+    };
+
+    struct Cell
+    {
+        int32_t c[ 3 ];
+    };
+
+    Cell     CellOf( const float ( &p )[ 3 ] ) const;
+    uint32_t CellIndex( int32_t x, int32_t y, int32_t z ) const
+    {
+        return uint32_t( x + dims[ 0 ] * ( y + dims[ 1 ] * z ) );
+    }
+
+    template< typename Func >
+    void ForEachInCell( int32_t x, int32_t y, int32_t z, Func&& func ) const
+    {
+        const uint32_t cell = CellIndex( x, y, z );
+        for( uint32_t i = cellStart[ cell ]; i < cellStart[ cell + 1 ]; i++ )
+        {
+            func( sorted[ i ] );
+        }
+    }
+
+private:
+    std::vector< Item >     items;
+    // Items, grouped by cells
+    std::vector< Item >     sorted;
+    // For each cell, the first item in 'sorted'; plus the end
+    std::vector< uint32_t > cellStart;
+
+    float   boundsMin[ 3 ]{};
+    float   cellSize{ 1.0f };
+    float   invCellSize{ 1.0f };
+    int32_t dims[ 3 ]{};
+    float   maxRadius{ 0.0f };
+    bool    dirty{ false };
+};
+
+template< typename Func >
+void LightSpatialIndex::ForEachInRadius( const RgFloat3D& center, float radius, Func&& func ) const
+{
+    assert( !dirty );
+    if( sorted.empty() )
+    {
+        return;
+    }
+
+    const float r = radius + maxRadius;
+
+    const Cell lo = CellOf( { center.data[ 0 ] - r, center.data[ 1 ] - r, center.data[ 2 ] - r } );
+    const Cell hi = CellOf( { center.data[ 0 ] + r, center.data[ 1 ] + r, center.data[ 2 ] + r } );
+
+    int32_t from[ 3 ], to[ 3 ];
+    for( int a = 0; a < 3; a++ )
+    {
+        from[ a ] = std::max( lo.c[ a ], 0 );
+        to[ a ]   = std::min( hi.c[ a ], dims[ a ] - 1 );
+
+        if( from[ a ] > to[ a ] )
+        {
+            return;
+        }
+    }
+
+    for( int32_t z = from[ 2 ]; z <= to[ 2 ]; z++ )
+    {
+        for( int32_t y = from[ 1 ]; y <= to[ 1 ]; y++ )
+        {
+            for( int32_t x = from[ 0 ]; x <= to[ 0 ]; x++ )
+            {
+                ForEachInCell( x, y, z, [ & ]( const Item& item ) {
+                    const float dx = item.center[ 0 ] - center.data[ 0 ];
+                    const float dy = item.center[ 1 ] - center.data[ 1 ];
+                    const float dz = item.center[ 2 ] - center.data[ 2 ];
+                    const float rr = radius + item.radius;
+
+                    if( dx * dx + dy * dy + dz * dz <= rr * rr )
+                    {
+                        func( item.value );
+                    }
+                } );
+            }
+        }
+    }
+}
+
+template< typename Filter >
+void LightSpatialIndex::FindNearest( const RgFloat3D&    point,
+                                     uint32_t            k,
+                                     Filter&&            filter,
+                                     std::vector< Hit >& out ) const
+{
+    assert( !dirty );
+    out.clear();
+
+    if( k == 0 || sorted.empty() )
+    {
+        return;
+    }
+
+    // rings of cells around the closest cell to the point; moving towards it can only
+    // decrease the distance along each axis, so each next ring is not closer than the previous
+    Cell    center   = CellOf( { point.data[ 0 ], point.data[ 1 ], point.data[ 2 ] } );
+    int32_t ringLast = 0;
+    for( int a = 0; a < 3; a++ )
+    {
+        center.c[ a ] = std::clamp( center.c[ a ], 0, dims[ a ] - 1 );
+        ringLast      = std::max( { ringLast, center.c[ a ], dims[ a ] - 1 - center.c[ a ] } );
+    }
+
+    auto l_visit = [ & ]( const Item& item ) {
+        if( !filter( item.value ) )
+        {
+            return;
+        }
+
+        const float dx = item.center[ 0 ] - point.data[ 0 ];
+        const float dy = item.center[ 1 ] - point.data[ 1 ];
+        const float dz = item.center[ 2 ] - point.data[ 2 ];
+        const auto  hit = Hit{ .value = item.value, .distanceSq = dx * dx + dy * dy + dz * dz };
+
+        if( out.size() == k && hit.distanceSq >= out.back().distanceSq )
+        {
+            return;
+        }
+        if( out.size() == k )
+        {
+            out.pop_back();
+        }
+
+        auto at = std::ranges::upper_bound(
+            out, hit.distanceSq, std::less{}, []( const Hit& h ) { return h.distanceSq; } );
+        out.insert( at, hit );
+    };
+
+    // distance from the point to the cells [cellFrom, cellTo] along the axis
+    auto l_gap = [ & ]( int a, int32_t cellFrom, int32_t cellTo ) {
+        const float from = boundsMin[ a ] + float( cellFrom ) * cellSize;
+        const float to   = boundsMin[ a ] + float( cellTo + 1 ) * cellSize;
+        return std::max( { from - point.data[ a ], point.data[ a ] - to, 0.0f } );
+    };
+
+    for( int32_t r = 0; r <= ringLast; r++ )
+    {
+        // exact distance to the closest cell of the ring: one of the axes must be on its border
+        {
+            float rangeSq[ 3 ], borderSq[ 3 ];
+            for( int a = 0; a < 3; a++ )
+            {
+                const int32_t from = std::max( center.c[ a ] - r, 0 );
+                const int32_t to   = std::min( center.c[ a ] + r, dims[ a ] - 1 );
+                const float   g    = l_gap( a, from, to );
+
+                float b = std::numeric_limits< float >::max();
+                for( int32_t border : { center.c[ a ] - r, center.c[ a ] + r } )
+                {
+                    if( border >= 0 && border < dims[ a ] )
+                    {
+                        b = std::min( b, l_gap( a, border, border ) );
+                    }
+                }
+
+                rangeSq[ a ]  = g * g;
+                borderSq[ a ] = b < std::numeric_limits< float >::max() ? b * b : b;
+            }
+
+            const float ringDistanceSq =
+                std::min( { borderSq[ 0 ] + rangeSq[ 1 ] + rangeSq[ 2 ],
+                            rangeSq[ 0 ] + borderSq[ 1 ] + rangeSq[ 2 ],
+                            rangeSq[ 0 ] + rangeSq[ 1 ] + borderSq[ 2 ] } );
+
+            // rings further away can't be closer
+            if( out.size() == k && out.back().distanceSq <= ringDistanceSq )
+            {
+                break;
+            }
+        }
+
+        const int32_t zFrom = std::max( center.c[ 2 ] - r, 0 );
+        const int32_t zTo   = std::min( center.c[ 2 ] + r, dims[ 2 ] - 1 );
+        const int32_t yFrom = std::max( center.c[ 1 ] - r, 0 );
+        const int32_t yTo   = std::min( center.c[ 1 ] + r, dims[ 1 ] - 1 );
+
+        for( int32_t z = zFrom; z <= zTo; z++ )
+        {
+            for( int32_t y = yFrom; y <= yTo; y++ )
+            {
+                const bool onShell = std::abs( z - center.c[ 2 ] ) == r || //
+                                     std::abs( y - center.c[ 1 ] ) == r;
+
+                if( onShell )
+                {
+                    const int32_t xFrom = std::max( center.c[ 0 ] - r, 0 );
+                    const int32_t xTo   = std::min( center.c[ 0 ] + r, dims[ 0 ] - 1 );
+
+                    for( int32_t x = xFrom; x <= xTo; x++ )
+                    {
+                        ForEachInCell( x, y, z, l_visit );
+                    }
+                }
+                else
+                {
+                    // only the two side cells of a row that is inside the ring
+                    for( int32_t x : { center.c[ 0 ] - r, center.c[ 0 ] + r } )
+                    {
+                        if( x >= 0 && x < dims[ 0 ] )
+                        {
+                            ForEachInCell( x, y, z, l_visit );
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+}
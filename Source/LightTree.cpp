@@ -0,0 +1,658 @@
+/*
+
+Copyright (c) 2024 V.Shirokii
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#include "LightTree.h"
+
+#include "Utils.h"
+
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+
+constexpr uint32_t BIN_COUNT = 12;
+
+// Median splits below this depth, so any light count that fits into LIGHT_INDEX_NONE
+// doesn't exceed LIGHT_TREE_MAX_DEPTH, even under a joined root
+constexpr uint32_t SAH_MAX_DEPTH = LIGHT_TREE_MAX_DEPTH - 26;
+
+// If the sum of node areas grew more than that after a refit, rebuild
+constexpr float REFIT_MAX_AREA_GROWTH = 2.0f;
+
+// Cones are widened by this angle for the shader, to cover the float error of the fit;
+// cos and sin of 0.001 radians
+constexpr float COS_MARGIN = 0.9999995f;
+constexpr float SIN_MARGIN = 0.001f;
+
+constexpr uint32_t NO_PARENT = std::numeric_limits< uint32_t >::max();
+
+float HalfArea( const float ( &mn )[ 3 ], const float ( &mx )[ 3 ] )
+{
+    const float d[] = {
+        std::max( 0.0f, mx[ 0 ] - mn[ 0 ] ),
+        std::max( 0.0f, mx[ 1 ] - mn[ 1 ] ),
+        std::max( 0.0f, mx[ 2 ] - mn[ 2 ] ),
+    };
+    return d[ 0 ] * d[ 1 ] + d[ 1 ] * d[ 2 ] + d[ 2 ] * d[ 0 ];
+}
+
+struct Bin
+{
+    float    centroidMin[ 3 ];
+    float    centroidMax[ 3 ];
+    float    radius;
+    float    axisSum[ 3 ];
+    float    power;
+    uint32_t count;
+    uint32_t omniCount;
+
+    void Init()
+    {
+        std::ranges::fill( centroidMin, +std::numeric_limits< float >::max() );
+        std::ranges::fill( centroidMax, -std::numeric_limits< float >::max() );
+        std::ranges::fill( axisSum, 0.0f );
+        radius    = 0;
+        power     = 0;
+        count     = 0;
+        omniCount = 0;
+    }
+
+    void Add( const float ( &c )[ 3 ], float r, const float ( &axis )[ 3 ], float p )
+    {
+        for( int i = 0; i < 3; i++ )
+        {
+            centroidMin[ i ] = std::min( centroidMin[ i ], c[ i ] );
+            centroidMax[ i ] = std::max( centroidMax[ i ], c[ i ] );
+            axisSum[ i ] += axis[ i ];
+        }
+        radius = std::max( radius, r );
+        power += p;
+        count++;
+        omniCount += ( axis[ 0 ] == 0 && axis[ 1 ] == 0 && axis[ 2 ] == 0 ) ? 1 : 0;
+    }
+
+    void Merge( const Bin& other )
+    {
+        for( int i = 0; i < 3; i++ )
+        {
+            centroidMin[ i ] = std::min( centroidMin[ i ], other.centroidMin[ i ] );
+            centroidMax[ i ] = std::max( centroidMax[ i ], other.centroidMax[ i ] );
+            axisSum[ i ] += other.axisSum[ i ];
+        }
+        radius = std::max( radius, other.radius );
+        power += other.power;
+        count += other.count;
+        omniCount += other.omniCount;
+    }
+
+    // Approximation of the orientation measure M_Omega of [Conty, Kulla 2018]:
+    // instead of building the bounding cone (trigonometry per light per bin),
+    // estimate its spread by the length of the mean axis. The values span the same range:
+    // from a hemisphere of coherent emitters to the whole sphere
+    float OrientationMeasure() const
+    {
+        if( count == 0 )
+        {
+            return 0.0f;
+        }
+        if( omniCount > 0 )
+        {
+            return 4.0f;
+        }
+        float coherence = RTGL1::Utils::Length( axisSum ) / float( count );
+        return 1.0f + 3.0f * ( 1.0f - std::min( coherence, 1.0f ) );
+    }
+
+    float Cost() const
+    {
+        const float mn[] = {
+            centroidMin[ 0 ] - radius,
+            centroidMin[ 1 ] - radius,
+            centroidMin[ 2 ] - radius,
+        };
+        const float mx[] = {
+            centroidMax[ 0 ] + radius,
+            centroidMax[ 1 ] + radius,
+            centroidMax[ 2 ] + radius,
+        };
+        return power * HalfArea( mn, mx ) * OrientationMeasure();
+    }
+};
+
+}
+
+void RTGL1::LightTree::Build( std::span< const Item > items )
+{
+    nodes.clear();
+    builtArea = 0;
+
+    if( items.empty() )
+    {
+        refs.clear();
+        leafNodes.clear();
+        return;
+    }
+
+    assert( items.size() < LIGHT_INDEX_NONE );
+
+    auto rootRange = RangeBounds{};
+    std::ranges::fill( rootRange.centroidMin, +std::numeric_limits< float >::max() );
+    std::ranges::fill( rootRange.centroidMax, -std::numeric_limits< float >::max() );
+
+    refs.resize( items.size() );
+    for( uint32_t i = 0; i < items.size(); i++ )
+    {
+        const Item& src = items[ i ];
+        BuildRef&   dst = refs[ i ];
+
+        const bool omni = src.cosThetaO <= -0.9999f;
+
+        dst.radius = 0;
+        for( int k = 0; k < 3; k++ )
+        {
+            dst.centroid[ k ] = ( src.boundsMin[ k ] + src.boundsMax[ k ] ) * 0.5f;
+            dst.radius        = std::max( dst.radius, src.boundsMax[ k ] - dst.centroid[ k ] );
+            dst.axis[ k ]     = omni ? 0.0f : src.axis[ k ];
+
+            rootRange.centroidMin[ k ] = std::min( rootRange.centroidMin[ k ], dst.centroid[ k ] );
+            rootRange.centroidMax[ k ] = std::max( rootRange.centroidMax[ k ], dst.centroid[ k ] );
+        }
+        dst.power = src.power;
+        dst.item  = i;
+
+        rootRange.radius = std::max( rootRange.radius, dst.radius );
+    }
+
+    struct Task
+    {
+        uint32_t    begin;
+        uint32_t    end;
+        uint32_t    depth;
+        uint32_t    parent;
+        RangeBounds range;
+    };
+
+    nodes.reserve( CalcNodeCount( items.size() ) );
+    leafNodes.resize( items.size() );
+
+    auto stack = std::vector< Task >{};
+    stack.push_back( Task{ 0, uint32_t( refs.size() ), 0, NO_PARENT, rootRange } );
+
+    while( !stack.empty() )
+    {
+        const Task t = stack.back();
+        stack.pop_back();
+
+        const auto index = uint32_t( nodes.size() );
+        nodes.push_back( Node{} );
+
+        if( t.parent != NO_PARENT )
+        {
+            nodes[ t.parent ].secondChild = index;
+        }
+
+        if( t.end - t.begin == 1 )
+        {
+            leafNodes[ refs[ t.begin ].item ] = index;
+            continue;
+        }
+
+        RangeBounds    left, right;
+        const uint32_t mid = FindSplit( t.begin, t.end, t.depth, t.range, left, right );
+        assert( t.begin < mid && mid < t.end );
+
+        // the first child must be processed right after its parent
+        stack.push_back( Task{ mid, t.end, t.depth + 1, index, right } );
+        stack.push_back( Task{ t.begin, mid, t.depth + 1, NO_PARENT, left } );
+    }
+    assert( nodes.size() == CalcNodeCount( items.size() ) );
+
+    Fit( items );
+    builtArea = CalcTotalArea();
+}
+
+bool RTGL1::LightTree::Refit( std::span< const Item > items )
+{
+    if( nodes.empty() || items.size() != leafNodes.size() )
+    {
+        return false;
+    }
+
+    Fit( items );
+    return CalcTotalArea() <= builtArea * REFIT_MAX_AREA_GROWTH;
+}
+
+void RTGL1::LightTree::Clear()
+{
+    nodes.clear();
+    leafNodes.clear();
+    refs.clear();
+    builtArea = 0;
+}
+
+uint32_t RTGL1::LightTree::FindSplit( uint32_t           begin,
+                                      uint32_t           end,
+                                      uint32_t           depth,
+                                      const RangeBounds& range,
+                                      RangeBounds&       outLeft,
+                                      RangeBounds&       outRight )
+{
+    auto l_rangeOf = [ this ]( uint32_t from, uint32_t to, RangeBounds& dst ) {
+        Bin b;
+        b.Init();
+        for( uint32_t i = from; i < to; i++ )
+        {
+            b.Add( refs[ i ].centroid, refs[ i ].radius, refs[ i ].axis, refs[ i ].power );
+        }
+        std::ranges::copy( b.centroidMin, dst.centroidMin );
+        std::ranges::copy( b.centroidMax, dst.centroidMax );
+        dst.radius = b.radius;
+    };
+
+    float centroidExtent[ 3 ];
+    for( int k = 0; k < 3; k++ )
+    {
+        centroidExtent[ k ] = range.centroidMax[ k ] - range.centroidMin[ k ];
+    }
+    const int widestAxis =
+        int( std::ranges::max_element( centroidExtent ) - std::ranges::begin( centroidExtent ) );
+
+    auto l_medianSplit = [ & ]() {
+        const uint32_t mid = begin + ( end - begin ) / 2;
+        std::nth_element( refs.begin() + begin,
+                          refs.begin() + mid,
+                          refs.begin() + end,
+                          [ widestAxis ]( const BuildRef& a, const BuildRef& b ) {
+                              return a.centroid[ widestAxis ] < b.centroid[ widestAxis ];
+                          } );
+        l_rangeOf( begin, mid, outLeft );
+        l_rangeOf( mid, end, outRight );
+        return mid;
+    };
+
+    if( end - begin == 2 || centroidExtent[ widestAxis ] <= 0.0f || depth >= SAH_MAX_DEPTH )
+    {
+        return l_medianSplit();
+    }
+
+    // small nodes don't need many bins, and most of the nodes are small
+    const uint32_t binCount = std::min( BIN_COUNT, end - begin );
+
+    float scale[ 3 ];
+    for( int k = 0; k < 3; k++ )
+    {
+        scale[ k ] = centroidExtent[ k ] > 0.0f ? float( binCount ) / centroidExtent[ k ] : 0.0f;
+    }
+
+    auto l_binIndex = [ & ]( const BuildRef& r, int axis ) {
+        auto b = uint32_t( ( r.centroid[ axis ] - range.centroidMin[ axis ] ) * scale[ axis ] );
+        return std::min( b, binCount - 1 );
+    };
+
+    Bin bins[ 3 ][ BIN_COUNT ];
+    for( auto& axisBins : bins )
+    {
+        for( uint32_t b = 0; b < binCount; b++ )
+        {
+            axisBins[ b ].Init();
+        }
+    }
+
+    for( uint32_t i = begin; i < end; i++ )
+    {
+        const BuildRef& r = refs[ i ];
+        for( int k = 0; k < 3; k++ )
+        {
+            if( scale[ k ] > 0.0f )
+            {
+                bins[ k ][ l_binIndex( r, k ) ].Add( r.centroid, r.radius, r.axis, r.power );
+            }
+        }
+    }
+
+    float    bestCost  = std::numeric_limits< float >::max();
+    int      bestAxis  = -1;
+    uint32_t bestSplit = 0;
+    Bin      bestLeft, bestRight;
+
+    for( int k = 0; k < 3; k++ )
+    {
+        if( scale[ k ] <= 0.0f )
+        {
+            continue;
+        }
+
+        // penalize splits along thin axes
+        const float kr = ( centroidExtent[ widestAxis ] + range.radius * 2 ) /
+                         ( centroidExtent[ k ] + range.radius * 2 );
+
+        Bin right[ BIN_COUNT ];
+        right[ binCount - 1 ] = bins[ k ][ binCount - 1 ];
+        for( uint32_t b = binCount - 1; b-- > 1; )
+        {
+            right[ b ] = right[ b + 1 ];
+            right[ b ].Merge( bins[ k ][ b ] );
+        }
+
+        Bin left;
+        left.Init();
+        for( uint32_t b = 0; b < binCount - 1; b++ )
+        {
+            left.Merge( bins[ k ][ b ] );
+
+            if( left.count == 0 || right[ b + 1 ].count == 0 )
+            {
+                continue;
+            }
+
+            const float cost = kr * ( left.Cost() + right[ b + 1 ].Cost() );
+            if( cost < bestCost )
+            {
+                bestCost  = cost;
+                bestAxis  = k;
+                bestSplit = b;
+                bestLeft  = left;
+                bestRight = right[ b + 1 ];
+            }
+        }
+    }
+
+    if( bestAxis < 0 )
+    {
+        return l_medianSplit();
+    }
+
+    const auto midIter =
+        std::partition( refs.begin() + begin, refs.begin() + end, [ & ]( const BuildRef& r ) {
+            return l_binIndex( r, bestAxis ) <= bestSplit;
+        } );
+    const auto mid = uint32_t( midIter - refs.begin() );
+    assert( mid - begin == bestLeft.count );
+
+    auto l_toRange = []( const Bin& src, RangeBounds& dst ) {
+        std::ranges::copy( src.centroidMin, dst.centroidMin );
+        std::ranges::copy( src.centroidMax, dst.centroidMax );
+        dst.radius = src.radius;
+    };
+    l_toRange( bestLeft, outLeft );
+    l_toRange( bestRight, outRight );
+    return mid;
+}
+
+namespace
+{
+
+// Bounding cone of two cones [Conty, Kulla 2018].
+// Angles are kept as their cosines and sines, and are added with the angle sum identities,
+// so there's no trigonometry per node
+template< typename Node >
+void UnionCone( Node& dst, const Node& a0, const Node& b0 )
+{
+    // a is the wider one
+    const Node* a = &a0;
+    const Node* b = &b0;
+    if( b->cosThetaO < a->cosThetaO )
+    {
+        std::swap( a, b );
+    }
+
+    dst.cosThetaE = std::min( a0.cosThetaE, b0.cosThetaE );
+
+    auto l_set = [ & ]( const float ( &axis )[ 3 ], float cosThetaO, float sinThetaO ) {
+        dst.axis[ 0 ] = axis[ 0 ];
+        dst.axis[ 1 ] = axis[ 1 ];
+        dst.axis[ 2 ] = axis[ 2 ];
+        dst.cosThetaO = cosThetaO;
+        dst.sinThetaO = sinThetaO;
+    };
+
+    l_set( a->axis, a->cosThetaO, a->sinThetaO );
+
+    if( a->cosThetaO <= -1.0f )
+    {
+        return;
+    }
+
+    const float cosD = std::clamp( RTGL1::Utils::Dot( a->axis, b->axis ), -1.0f, 1.0f );
+    const float sinD = std::sqrt( std::max( 0.0f, 1.0f - cosD * cosD ) );
+
+    // s = thetaD + thetaB, in [0, 2pi]
+    const float cosS = cosD * b->cosThetaO - sinD * b->sinThetaO;
+    const float sinS = sinD * b->cosThetaO + cosD * b->sinThetaO;
+
+    const bool sAtLeastPi = sinS < 0.0f || ( sinS == 0.0f && cosS < 0.0f );
+
+    // b is inside a: s <= thetaA
+    if( !sAtLeastPi && cosS >= a->cosThetaO )
+    {
+        return;
+    }
+
+    // (thetaA + s) / 2 >= pi, i.e. s >= 2pi - thetaA
+    if( sAtLeastPi && cosS >= a->cosThetaO )
+    {
+        constexpr float anyAxis[] = { 0.0f, 0.0f, 1.0f };
+        l_set( anyAxis, -1.0f, 0.0f );
+        return;
+    }
+
+    // rotate a's axis towards b's by r = (s - thetaA) / 2, r is in (0, pi)
+    const float cosY = cosS * a->cosThetaO + sinS * a->sinThetaO;
+    const float sinY = sinS * a->cosThetaO - cosS * a->sinThetaO;
+    const float sinR = std::sqrt( std::max( 0.0f, ( 1.0f - cosY ) * 0.5f ) );
+    const float cosR =
+        std::copysign( std::sqrt( std::max( 0.0f, ( 1.0f + cosY ) * 0.5f ) ), sinY );
+
+    float ortho[] = {
+        b->axis[ 0 ] - a->axis[ 0 ] * cosD,
+        b->axis[ 1 ] - a->axis[ 1 ] * cosD,
+        b->axis[ 2 ] - a->axis[ 2 ] * cosD,
+    };
+    float orthoLength = RTGL1::Utils::Length( ortho );
+    if( orthoLength < 0.00001f )
+    {
+        // opposite: any perpendicular
+        constexpr float x[] = { 1.0f, 0.0f, 0.0f };
+        constexpr float y[] = { 0.0f, 1.0f, 0.0f };
+        RTGL1::Utils::Cross( a->axis, std::abs( a->axis[ 0 ] ) < 0.9f ? x : y, ortho );
+        orthoLength = RTGL1::Utils::Length( ortho );
+    }
+
+    const float k = sinR / orthoLength;
+
+    const float axis[] = {
+        a->axis[ 0 ] * cosR + ortho[ 0 ] * k,
+        a->axis[ 1 ] * cosR + ortho[ 1 ] * k,
+        a->axis[ 2 ] * cosR + ortho[ 2 ] * k,
+    };
+
+    // thetaO = thetaA + r
+    l_set( axis,
+           std::clamp( a->cosThetaO * cosR - a->sinThetaO * sinR, -1.0f, 1.0f ),
+           std::max( 0.0f, a->sinThetaO * cosR + a->cosThetaO * sinR ) );
+}
+
+}
+
+void RTGL1::LightTree::Fit( std::span< const Item > items )
+{
+    // in the items order, to read them sequentially
+    for( uint32_t i = 0; i < items.size(); i++ )
+    {
+        const Item& src = items[ i ];
+        Node&       n   = nodes[ leafNodes[ i ] ];
+
+        for( int k = 0; k < 3; k++ )
+        {
+            n.boundsMin[ k ] = src.boundsMin[ k ];
+            n.boundsMax[ k ] = src.boundsMax[ k ];
+            n.axis[ k ]      = src.axis[ k ];
+        }
+        n.cosThetaO  = std::clamp( src.cosThetaO, -1.0f, 1.0f );
+        n.sinThetaO  = std::sqrt( 1.0f - n.cosThetaO * n.cosThetaO );
+        n.cosThetaE  = std::clamp( src.cosThetaE, 0.0f, 1.0f );
+        n.power      = src.power;
+        n.lightIndex = src.lightIndex;
+    }
+
+    // children are always after their parent
+    for( size_t i = nodes.size(); i-- > 0; )
+    {
+        Node& n = nodes[ i ];
+
+        if( n.secondChild != 0 )
+        {
+            const Node& l = nodes[ i + 1 ];
+            const Node& r = nodes[ n.secondChild ];
+
+            for( int k = 0; k < 3; k++ )
+            {
+                n.boundsMin[ k ] = std::min( l.boundsMin[ k ], r.boundsMin[ k ] );
+                n.boundsMax[ k ] = std::max( l.boundsMax[ k ], r.boundsMax[ k ] );
+            }
+            UnionCone( n, l, r );
+            n.power = l.power + r.power;
+        }
+    }
+}
+
+namespace
+{
+
+// Widen the cone by a fixed angle, not by a fixed cosine: a constant cosine step is a much
+// wider angle near 1, which would make narrow children wider than their parents
+float WidenCos( float cosTheta, float sinTheta )
+{
+    if( cosTheta <= -1.0f )
+    {
+        return -1.0f;
+    }
+    return std::max( cosTheta * COS_MARGIN - sinTheta * SIN_MARGIN, -1.0f );
+}
+
+// Round towards -inf, so the stored cone is never tighter; as rounding is monotonic,
+// a parent's cone still contains its children's ones after the packing
+uint16_t PackHalfDown( float value )
+{
+    auto h = static_cast< uint16_t >( glm::packHalf1x16( value ) );
+    if( glm::unpackHalf1x16( h ) > value )
+    {
+        if( h == 0 )
+        {
+            h = 0x8001;
+        }
+        else if( h & 0x8000 )
+        {
+            h++;
+        }
+        else
+        {
+            h--;
+        }
+    }
+    return h;
+}
+
+template< typename Node >
+void ToShader( const Node& n, uint32_t childOrLightIndex, RTGL1::ShLightTreeNode& dst )
+{
+    for( int k = 0; k < 3; k++ )
+    {
+        dst.boundsMin[ k ] = n.boundsMin[ k ];
+        dst.boundsMax[ k ] = n.boundsMax[ k ];
+        dst.coneAxis[ k ]  = n.axis[ k ];
+    }
+
+    const float    sinThetaE = std::sqrt( std::max( 0.0f, 1.0f - n.cosThetaE * n.cosThetaE ) );
+    const uint32_t cosO      = PackHalfDown( WidenCos( n.cosThetaO, n.sinThetaO ) );
+    const uint32_t cosE      = PackHalfDown( WidenCos( n.cosThetaE, sinThetaE ) );
+
+    dst.power             = n.power;
+    dst.childOrLightIndex = childOrLightIndex;
+    dst.cosThetaOE        = cosO | ( cosE << 16 );
+}
+
+}
+
+void RTGL1::LightTree::WriteNodes( std::span< ShLightTreeNode > dst, uint32_t nodeOffset ) const
+{
+    assert( dst.size() == nodes.size() );
+
+    for( size_t i = 0; i < nodes.size(); i++ )
+    {
+        const Node& n = nodes[ i ];
+
+        if( n.secondChild == 0 )
+        {
+            assert( n.lightIndex < LIGHT_TREE_LEAF_FLAG );
+            ToShader( n, n.lightIndex | LIGHT_TREE_LEAF_FLAG, dst[ i ] );
+        }
+        else
+        {
+            ToShader( n, n.secondChild + nodeOffset, dst[ i ] );
+        }
+    }
+}
+
+void RTGL1::LightTree::WriteJoinedRoot( const LightTree& first,
+                                        const LightTree& second,
+                                        uint32_t         secondOffset,
+                                        ShLightTreeNode& dst )
+{
+    assert( !first.nodes.empty() && !second.nodes.empty() );
+    assert( secondOffset >= 1 + first.nodes.size() );
+
+    const Node& l = first.nodes[ 0 ];
+    const Node& r = second.nodes[ 0 ];
+
+    Node root;
+    for( int k = 0; k < 3; k++ )
+    {
+        root.boundsMin[ k ] = std::min( l.boundsMin[ k ], r.boundsMin[ k ] );
+        root.boundsMax[ k ] = std::max( l.boundsMax[ k ], r.boundsMax[ k ] );
+    }
+    UnionCone( root, l, r );
+    root.power = l.power + r.power;
+
+    ToShader( root, secondOffset, dst );
+}
+
+float RTGL1::LightTree::CalcTotalArea() const
+{
+    float area = 0;
+    for( const Node& n : nodes )
+    {
+        if( n.secondChild != 0 )
+        {
+            area += HalfArea( n.boundsMin, n.boundsMax );
+        }
+    }
+    return area;
+}
@@ -0,0 +1,147 @@
+/*
+
+Copyright (c) 2024 V.Shirokii
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "Generated/ShaderCommonC.h"
+
+namespace RTGL1
+{
+
+// Bounding volume hierarchy over the regular lights, to importance sample them in shaders.
+// Each node has the bounds, the total power and the cone of emission directions of its
+// lights, so a shader can descend the tree choosing a child by its estimated contribution.
+// Nodes are in depth-first order: the first child follows its parent, and the second one
+// is referenced by an index. Each leaf holds exactly one light.
+// Several trees can be placed in one node array, and joined by a root, see WriteJoinedRoot.
+class LightTree
+{
+public:
+    struct Item
+    {
+        float    boundsMin[ 3 ];
+        float    boundsMax[ 3 ];
+        // Normals are within the angle thetaO around 'axis', and the light
+        // is emitted within thetaE around the normals. Cosines, so fitting the cones
+        // of the nodes doesn't need any trigonometry
+        float    axis[ 3 ];
+        float    cosThetaO;
+        float    cosThetaE;
+        float    power;
+        // Index in the global light array
+        uint32_t lightIndex;
+    };
+
+public:
+    LightTree() = default;
+    ~LightTree() = default;
+
+    LightTree( const LightTree& other )                = delete;
+    LightTree( LightTree&& other ) noexcept            = delete;
+    LightTree& operator=( const LightTree& other )     = delete;
+    LightTree& operator=( LightTree&& other ) noexcept = delete;
+
+    // Binned SAH build, with an orientation term
+    void Build( std::span< const Item > items );
+    // Update the nodes for the same items (in the same order) as in the last Build.
+    // Returns false if the items don't match, or if the tree degraded too much,
+    // and it should be rebuilt
+    bool Refit( std::span< const Item > items );
+    void Clear();
+
+    uint32_t GetNodeCount() const { return uint32_t( nodes.size() ); }
+    // Write GetNodeCount() nodes in the shader layout. The tree starts at 'nodeOffset'
+    // in the whole node array, so the child indices are shifted by it
+    void WriteNodes( std::span< ShLightTreeNode > dst, uint32_t nodeOffset ) const;
+    // Write a root node of two non-empty trees: 'first' must be placed right after the root,
+    // and 'second' at 'secondOffset'
+    static void WriteJoinedRoot( const LightTree& first,
+                                 const LightTree& second,
+                                 uint32_t         secondOffset,
+                                 ShLightTreeNode& dst );
+
+    // For the given item count, regardless of the topology.
+    // Also for several joined trees, as each root that joins two trees is one more node
+    static constexpr uint32_t CalcNodeCount( size_t itemCount )
+    {
+        return itemCount > 0 ? uint32_t( itemCount * 2 - 1 ) : 0;
+    }
+
+private:
+    struct Node
+    {
+        float    boundsMin[ 3 ];
+        float    boundsMax[ 3 ];
+        float    axis[ 3 ];
+        float    cosThetaO;
+        float    sinThetaO;
+        float    cosThetaE;
+        float    power;
+        // Zero, if leaf
+        uint32_t secondChild;
+        // If leaf
+        uint32_t lightIndex;
+    };
+
+    struct BuildRef
+    {
+        float    centroid[ 3 ];
+        float    radius;
+        // Zero, if omnidirectional
+        float    axis[ 3 ];
+        float    power;
+        uint32_t item;
+    };
+
+    struct RangeBounds
+    {
+        float centroidMin[ 3 ];
+        float centroidMax[ 3 ];
+        float radius;
+    };
+
+    uint32_t FindSplit( uint32_t           begin,
+                        uint32_t           end,
+                        uint32_t           depth,
+                        const RangeBounds& range,
+                        RangeBounds&       outLeft,
+                        RangeBounds&       outRight );
+    void     Fit( std::span< const Item > items );
+    float    CalcTotalArea() const;
+
+private:
+    std::vector< Node >     nodes;
+    std::vector< BuildRef > refs;
+    // Item index to its leaf node index
+    std::vector< uint32_t > leafNodes;
+    // Sum of the node surface areas at the last build, to detect degradation on refit
+    float                   builtArea{ 0 };
+};
+
+}
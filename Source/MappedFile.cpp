@@ -0,0 +1,143 @@
+/*
+
+Copyright (c) 2024 V.Shirokii
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#include "MappedFile.h"
+
+#include "DebugPrint.h"
+
+#ifdef _WIN32
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <Windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+RTGL1::MappedFile::MappedFile( const std::filesystem::path& path )
+{
+    HANDLE file = CreateFileW( path.c_str(),
+                               GENERIC_READ,
+                               FILE_SHARE_READ,
+                               nullptr,
+                               OPEN_EXISTING,
+                               FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS,
+                               nullptr );
+    if( file == INVALID_HANDLE_VALUE )
+    {
+        return;
+    }
+
+    LARGE_INTEGER fileSize = {};
+    if( !GetFileSizeEx( file, &fileSize ) || fileSize.QuadPart <= 0 )
+    {
+        CloseHandle( file );
+        return;
+    }
+
+    HANDLE mapping = CreateFileMappingW( file, nullptr, PAGE_READONLY, 0, 0, nullptr );
+    if( !mapping )
+    {
+        debug::Warning( "CreateFileMapping failed on {}", path.string() );
+        CloseHandle( file );
+        return;
+    }
+
+    void* view = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+    if( !view )
+    {
+        debug::Warning( "MapViewOfFile failed on {}", path.string() );
+        CloseHandle( mapping );
+        CloseHandle( file );
+        return;
+    }
+
+    fileHandle    = file;
+    mappingHandle = mapping;
+    data          = static_cast< const uint8_t* >( view );
+    size          = static_cast< size_t >( fileSize.QuadPart );
+}
+
+RTGL1::MappedFile::~MappedFile()
+{
+    if( data )
+    {
+        UnmapViewOfFile( data );
+    }
+    if( mappingHandle )
+    {
+        CloseHandle( mappingHandle );
+    }
+    if( fileHandle )
+    {
+        CloseHandle( fileHandle );
+    }
+}
+
+#else
+
+RTGL1::MappedFile::MappedFile( const std::filesystem::path& path )
+{
+    int fd = open( path.c_str(), O_RDONLY );
+    if( fd < 0 )
+    {
+        return;
+    }
+
+    struct stat st = {};
+    if( fstat( fd, &st ) != 0 || st.st_size <= 0 )
+    {
+        close( fd );
+        return;
+    }
+
+    void* view = mmap( nullptr, size_t( st.st_size ), PROT_READ, MAP_PRIVATE, fd, 0 );
+    // the mapping keeps its own reference to the file
+    close( fd );
+
+    if( view == MAP_FAILED )
+    {
+        debug::Warning( "mmap failed on {}", path.string() );
+        return;
+    }
+
+    data = static_cast< const uint8_t* >( view );
+    size = size_t( st.st_size );
+}
+
+RTGL1::MappedFile::~MappedFile()
+{
+    if( data )
+    {
+        munmap( const_cast< uint8_t* >( data ), size );
+    }
+}
+
+#endif
@@ -38,6 +38,8 @@ struct Texture
     SamplerManager::Handle              samplerHandle = SamplerManager::Handle();
     std::optional< RgTextureSwizzling > swizzling     = std::nullopt;
     std::filesystem::path               filepath      = {};
+    // slot is taken by a texture that is still being loaded
+    bool                                reserved      = false;
 };
 
 
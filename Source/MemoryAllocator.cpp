@@ -21,7 +21,9 @@
 #include "MemoryAllocator.h"
 
 #include "Const.h"
+#include "LibraryConfig.h"
 #include "RgException.h"
+#include "UploadRing.h"
 #include "Utils.h"
 
 RTGL1::MemoryAllocator::MemoryAllocator( VkInstance                        _instance,
@@ -34,10 +36,11 @@ RTGL1::MemoryAllocator::MemoryAllocator( VkInstance                        _inst
     , texturesFinalPool( VK_NULL_HANDLE )
 {
     VmaAllocatorCreateInfo allocatorInfo = {
-        .flags = VMA_ALLOCATOR_CREATE_EXTERNALLY_SYNCHRONIZED_BIT | // currently, the library uses
-                                                                    // only one thread,
-                 VMA_ALLOCATOR_CREATE_KHR_DEDICATED_ALLOCATION_BIT, // if buffer/image requires a
-                                                                    // dedicated allocation
+        .flags = VMA_ALLOCATOR_CREATE_EXTERNALLY_SYNCHRONIZED_BIT |  // currently, the library uses
+                                                                     // only one thread,
+                 VMA_ALLOCATOR_CREATE_KHR_DEDICATED_ALLOCATION_BIT | // if buffer/image requires a
+                                                                     // dedicated allocation,
+                 VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT,     // for RTGL1::Buffer
         .physicalDevice   = physDevice->Get(),
         .device           = device,
         .instance         = _instance,
@@ -49,10 +52,15 @@ RTGL1::MemoryAllocator::MemoryAllocator( VkInstance                        _inst
 
     CreateTexturesStagingPool();
     CreateTexturesFinalPool();
+
+    uploadRing = std::make_unique< UploadRing >(
+        *this, VkDeviceSize{ std::max( LibConfig().uploadRingSizeMB, 1u ) } * 1024 * 1024 );
 }
 
 RTGL1::MemoryAllocator::~MemoryAllocator()
 {
+    uploadRing.reset();
+
     assert( bufAllocs.empty() );
 
     vmaDestroyPool( allocator, texturesStagingPool );
@@ -243,6 +251,67 @@ void RTGL1::MemoryAllocator::CreateTexturesFinalPool()
     VK_CHECKERROR( r );
 }
 
+VkBuffer RTGL1::MemoryAllocator::CreateBuffer( const VkBufferCreateInfo& info,
+                                               VkMemoryPropertyFlags     properties,
+                                               VkDeviceSize              minAlignment,
+                                               const char*               pDebugName,
+                                               VmaAllocation*            outAllocation )
+{
+    VmaAllocationCreateInfo allocInfo = {
+        .flags         = VMA_ALLOCATION_CREATE_USER_DATA_COPY_STRING_BIT,
+        .requiredFlags = properties,
+        .pUserData     = const_cast< char* >( pDebugName ),
+    };
+
+    VkBuffer          buffer;
+    VmaAllocation     resultAlloc;
+    VmaAllocationInfo resultAllocInfo = {};
+
+    VkResult r = vmaCreateBufferWithAlignment(
+        allocator, &info, &allocInfo, minAlignment, &buffer, &resultAlloc, &resultAllocInfo );
+
+    if( r != VK_SUCCESS || buffer == VK_NULL_HANDLE )
+    {
+        VK_CHECKERROR( r );
+        throw RgException{ RG_RESULT_GRAPHICS_API_ERROR, "vmaCreateBufferWithAlignment failure" };
+    }
+
+    {
+        if( Utils::IsCstrEmpty( pDebugName ) )
+        {
+            debug::Verbose( "Videomem buffer: {:.2f} MB", float( info.size ) / 1024.f / 1024.f );
+        }
+        else
+        {
+            debug::Verbose( "Videomem buffer: {:.2f} MB ({})",
+                            float( info.size ) / 1024.f / 1024.f,
+                            pDebugName );
+        }
+    }
+
+    *outAllocation = resultAlloc;
+    return buffer;
+}
+
+void RTGL1::MemoryAllocator::DestroyBuffer( VkBuffer buffer, VmaAllocation allocation )
+{
+    vmaDestroyBuffer( allocator, buffer, allocation );
+}
+
+void* RTGL1::MemoryAllocator::MapBuffer( VmaAllocation allocation )
+{
+    void*    mapped = nullptr;
+    VkResult r      = vmaMapMemory( allocator, allocation, &mapped );
+    VK_CHECKERROR( r );
+
+    return mapped;
+}
+
+void RTGL1::MemoryAllocator::UnmapBuffer( VmaAllocation allocation )
+{
+    vmaUnmapMemory( allocator, allocation );
+}
+
 VkDevice RTGL1::MemoryAllocator::GetDevice()
 {
     return device;
@@ -314,3 +383,9 @@ void RTGL1::MemoryAllocator::FreeDedicated( VkDevice device, VkDeviceMemory memo
 {
     vkFreeMemory( device, memory, nullptr );
 }
+
+RTGL1::UploadRing& RTGL1::MemoryAllocator::GetUploadRing()
+{
+    assert( uploadRing );
+    return *uploadRing;
+}
@@ -28,6 +28,8 @@
 namespace RTGL1
 {
 
+class UploadRing;
+
 // Device memory allocator.
 class MemoryAllocator
 {
@@ -76,10 +78,25 @@ public:
     void             DestroyStagingSrcTextureBuffer( VkBuffer buffer );
     void             DestroyTextureImage( VkImage image );
 
+
+    // Create a buffer in a memory block of VMA, shared with other buffers
+    // of the same memory type. Large buffers still get a dedicated allocation
+    VkBuffer         CreateBuffer( const VkBufferCreateInfo& info,
+                                   VkMemoryPropertyFlags     properties,
+                                   VkDeviceSize              minAlignment,
+                                   const char*               pDebugName,
+                                   VmaAllocation*            outAllocation );
+    void             DestroyBuffer( VkBuffer buffer, VmaAllocation allocation );
+    void*            MapBuffer( VmaAllocation allocation );
+    void             UnmapBuffer( VmaAllocation allocation );
+
     
     auto GetMemoryTypeIndex( uint32_t memoryTypeBits, VkMemoryPropertyFlags requirementsMask ) const
         -> std::optional< uint32_t >;
 
+    // Shared staging memory for the buffers that are uploaded every frame
+    UploadRing&      GetUploadRing();
+
 private:
     void CreateTexturesStagingPool();
     void CreateTexturesFinalPool();
@@ -99,6 +116,8 @@ private:
     // maps for freeing corresponding allocations
     rgl::unordered_map< VkBuffer, VmaAllocation > bufAllocs;
     rgl::unordered_map< VkImage, VmaAllocation >  imgAllocs;
+
+    std::unique_ptr< UploadRing >                 uploadRing;
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,582 @@
+/*
+
+Copyright (c) 2024 V.Shirokii
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#include "MipmapGenerator.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <optional>
+
+#if defined( _M_X64 ) || defined( _M_IX86 ) || defined( __SSE2__ )
+    #define RG_MIPMAP_SSE2 1
+    #include <emmintrin.h>
+#else
+    #define RG_MIPMAP_SSE2 0
+#endif
+
+namespace
+{
+
+// same as ALPHA_THRESHOLD in shaders
+constexpr float AlphaThreshold = 0.5f;
+
+// if there are less texels with intermediate alpha, the image is considered alpha-tested
+constexpr float AlphaTestedMaxPartial = 0.05f;
+
+// linear to sRGB table is indexed by sqrt(linear) to have enough precision in darks
+constexpr uint32_t SqrtTableSize = 4096;
+
+enum class Layout
+{
+    RGBA8,
+    R8,
+    RGBA16F,
+};
+
+struct FormatInfo
+{
+    Layout   layout;
+    bool     srgb;
+    uint32_t bytesPerPixel;
+};
+
+auto GetFormatInfo( VkFormat format ) -> std::optional< FormatInfo >
+{
+    switch( format )
+    {
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_B8G8R8A8_UNORM: return FormatInfo{ Layout::RGBA8, false, 4 };
+        case VK_FORMAT_R8G8B8A8_SRGB:
+        case VK_FORMAT_B8G8R8A8_SRGB: return FormatInfo{ Layout::RGBA8, true, 4 };
+        case VK_FORMAT_R8_UNORM: return FormatInfo{ Layout::R8, false, 1 };
+        case VK_FORMAT_R8_SRGB: return FormatInfo{ Layout::R8, true, 1 };
+        case VK_FORMAT_R16G16B16A16_SFLOAT: return FormatInfo{ Layout::RGBA16F, false, 8 };
+        default: return std::nullopt;
+    }
+}
+
+struct alignas( 16 ) Pixel
+{
+    float v[ 4 ];
+};
+
+struct SrgbTables
+{
+    float   toLinear[ 256 ];
+    uint8_t fromSqrtLinear[ SqrtTableSize ];
+};
+
+const SrgbTables& GetSrgbTables()
+{
+    static const SrgbTables tables = []() {
+        auto t = SrgbTables{};
+        for( uint32_t i = 0; i < 256; i++ )
+        {
+            float c = float( i ) / 255.0f;
+
+            t.toLinear[ i ] = c <= 0.04045f ? c / 12.92f //
+                                            : std::pow( ( c + 0.055f ) / 1.055f, 2.4f );
+        }
+        for( uint32_t i = 0; i < SqrtTableSize; i++ )
+        {
+            float s = float( i ) / float( SqrtTableSize - 1 );
+            float l = s * s;
+            float c = l <= 0.0031308f ? l * 12.92f //
+                                      : 1.055f * std::pow( l, 1.0f / 2.4f ) - 0.055f;
+
+            t.fromSqrtLinear[ i ] = uint8_t( std::clamp( c * 255.0f + 0.5f, 0.0f, 255.0f ) );
+        }
+        return t;
+    }();
+    return tables;
+}
+
+float HalfToFloat( uint16_t h )
+{
+    const uint32_t sign = uint32_t( h & 0x8000 ) << 16;
+    const uint32_t exp  = ( h >> 10 ) & 0x1F;
+    const uint32_t mant = h & 0x3FF;
+
+    if( exp == 0 )
+    {
+        // zero or subnormal
+        float f = float( mant ) / 16777216.0f;
+        return sign ? -f : f;
+    }
+    if( exp == 31 )
+    {
+        return std::bit_cast< float >( sign | 0x7F800000 | ( mant << 13 ) );
+    }
+    return std::bit_cast< float >( sign | ( ( exp + 112 ) << 23 ) | ( mant << 13 ) );
+}
+
+uint16_t FloatToHalf( float f )
+{
+    const uint32_t bits = std::bit_cast< uint32_t >( f );
+    const auto     sign = uint16_t( ( bits >> 16 ) & 0x8000 );
+    const uint32_t absb = bits & 0x7FFFFFFF;
+
+    if( absb > 0x7F800000 )
+    {
+        // nan
+        return sign | 0x7E00;
+    }
+    if( absb >= 0x477FF000 )
+    {
+        // overflow or inf
+        return sign | 0x7C00;
+    }
+    if( absb < 0x38800000 )
+    {
+        // subnormal
+        auto m = std::lrint( std::bit_cast< float >( absb ) * 16777216.0f );
+        return sign | uint16_t( m );
+    }
+    // round to nearest even
+    const uint32_t rounded = absb + 0xFFF + ( ( absb >> 13 ) & 1 );
+    return sign | uint16_t( ( rounded - 0x38000000 ) >> 13 );
+}
+
+void DecodeRow( const uint8_t* src, uint32_t width, const FormatInfo& fi, Pixel* dst )
+{
+    const SrgbTables& t = GetSrgbTables();
+
+    switch( fi.layout )
+    {
+        case Layout::RGBA8:
+            for( uint32_t x = 0; x < width; x++ )
+            {
+                const uint8_t* s = &src[ x * 4 ];
+                if( fi.srgb )
+                {
+                    dst[ x ] = { {
+                        t.toLinear[ s[ 0 ] ],
+                        t.toLinear[ s[ 1 ] ],
+                        t.toLinear[ s[ 2 ] ],
+                        float( s[ 3 ] ) / 255.0f,
+                    } };
+                }
+                else
+                {
+                    dst[ x ] = { {
+                        float( s[ 0 ] ) / 255.0f,
+                        float( s[ 1 ] ) / 255.0f,
+                        float( s[ 2 ] ) / 255.0f,
+                        float( s[ 3 ] ) / 255.0f,
+                    } };
+                }
+            }
+            break;
+
+        case Layout::R8:
+            for( uint32_t x = 0; x < width; x++ )
+            {
+                float r  = fi.srgb ? t.toLinear[ src[ x ] ] : float( src[ x ] ) / 255.0f;
+                dst[ x ] = { { r, 0, 0, 1 } };
+            }
+            break;
+
+        case Layout::RGBA16F:
+            for( uint32_t x = 0; x < width; x++ )
+            {
+                uint16_t s[ 4 ];
+                memcpy( s, &src[ x * 8 ], sizeof( s ) );
+                dst[ x ] = { {
+                    HalfToFloat( s[ 0 ] ),
+                    HalfToFloat( s[ 1 ] ),
+                    HalfToFloat( s[ 2 ] ),
+                    HalfToFloat( s[ 3 ] ),
+                } };
+            }
+            break;
+
+        default: assert( 0 ); break;
+    }
+}
+
+// Clamp to [0,1], and convert to sqrt-linear table indices / unorm8 values
+void Quantize8( const Pixel& p, float alphaScale, bool srgb, uint8_t* dst, uint32_t count )
+{
+    const SrgbTables& t = GetSrgbTables();
+
+#if RG_MIPMAP_SSE2
+    __m128 v = _mm_load_ps( p.v );
+    v        = _mm_mul_ps( v, _mm_set_ps( alphaScale, 1.0f, 1.0f, 1.0f ) );
+    v        = _mm_min_ps( _mm_max_ps( v, _mm_setzero_ps() ), _mm_set1_ps( 1.0f ) );
+
+    __m128 asUnorm = _mm_mul_ps( v, _mm_set1_ps( 255.0f ) );
+    __m128 asSqrt  = _mm_mul_ps( _mm_sqrt_ps( v ), _mm_set1_ps( float( SqrtTableSize - 1 ) ) );
+
+    alignas( 16 ) int32_t u[ 4 ];
+    alignas( 16 ) int32_t s[ 4 ];
+    // cvtps rounds to nearest
+    _mm_store_si128( reinterpret_cast< __m128i* >( u ), _mm_cvtps_epi32( asUnorm ) );
+    _mm_store_si128( reinterpret_cast< __m128i* >( s ), _mm_cvtps_epi32( asSqrt ) );
+#else
+    int32_t u[ 4 ];
+    int32_t s[ 4 ];
+    for( int i = 0; i < 4; i++ )
+    {
+        float c = std::clamp( i == 3 ? p.v[ i ] * alphaScale : p.v[ i ], 0.0f, 1.0f );
+        u[ i ]  = int32_t( std::lrint( c * 255.0f ) );
+        s[ i ]  = int32_t( std::lrint( std::sqrt( c ) * float( SqrtTableSize - 1 ) ) );
+    }
+#endif
+
+    for( uint32_t i = 0; i < count; i++ )
+    {
+        // alpha is always linear
+        dst[ i ] = srgb && i < 3 ? t.fromSqrtLinear[ s[ i ] ] : uint8_t( u[ i ] );
+    }
+}
+
+void EncodeRow(
+    const Pixel* src, uint32_t width, const FormatInfo& fi, float alphaScale, uint8_t* dst )
+{
+    switch( fi.layout )
+    {
+        case Layout::RGBA8:
+            for( uint32_t x = 0; x < width; x++ )
+            {
+                Quantize8( src[ x ], alphaScale, fi.srgb, &dst[ x * 4 ], 4 );
+            }
+            break;
+
+        case Layout::R8:
+            for( uint32_t x = 0; x < width; x++ )
+            {
+                Quantize8( src[ x ], 1.0f, fi.srgb, &dst[ x ], 1 );
+            }
+            break;
+
+        case Layout::RGBA16F:
+            for( uint32_t x = 0; x < width; x++ )
+            {
+                uint16_t h[ 4 ] = {
+                    FloatToHalf( src[ x ].v[ 0 ] ),
+                    FloatToHalf( src[ x ].v[ 1 ] ),
+                    FloatToHalf( src[ x ].v[ 2 ] ),
+                    FloatToHalf( std::clamp( src[ x ].v[ 3 ] * alphaScale, 0.0f, 1.0f ) ),
+                };
+                memcpy( &dst[ x * 8 ], h, sizeof( h ) );
+            }
+            break;
+
+        default: assert( 0 ); break;
+    }
+}
+
+// Filter taps of a destination texel along one axis.
+// For even source size, it's a 2x box; for odd size n=2m+1, three source texels
+// are covered partially, so the footprint of each destination texel is exact.
+struct Taps
+{
+    uint32_t first;
+    uint32_t count;
+    float    weights[ 3 ];
+};
+
+Taps MakeTaps( uint32_t srcSize, uint32_t dst )
+{
+    if( srcSize == 1 )
+    {
+        return Taps{ 0, 1, { 1.0f, 0, 0 } };
+    }
+    if( srcSize % 2 == 0 )
+    {
+        return Taps{ dst * 2, 2, { 0.5f, 0.5f, 0 } };
+    }
+
+    const auto m = float( srcSize / 2 );
+    const auto n = float( srcSize );
+    const auto i = float( dst );
+
+    return Taps{ dst * 2, 3, { ( m - i ) / n, m / n, ( i + 1 ) / n } };
+}
+
+void Accumulate( Pixel* dst, const Pixel* src, float weight, uint32_t count )
+{
+#if RG_MIPMAP_SSE2
+    const __m128 w = _mm_set1_ps( weight );
+    for( uint32_t x = 0; x < count; x++ )
+    {
+        __m128 d = _mm_load_ps( dst[ x ].v );
+        __m128 s = _mm_load_ps( src[ x ].v );
+        _mm_store_ps( dst[ x ].v, _mm_add_ps( d, _mm_mul_ps( s, w ) ) );
+    }
+#else
+    for( uint32_t x = 0; x < count; x++ )
+    {
+        for( int c = 0; c < 4; c++ )
+        {
+            dst[ x ].v[ c ] += src[ x ].v[ c ] * weight;
+        }
+    }
+#endif
+}
+
+// Horizontal pass of one source row into a destination-width row
+void DownsampleRow( const Pixel* src, uint32_t srcWidth, Pixel* dst, uint32_t dstWidth )
+{
+    for( uint32_t x = 0; x < dstWidth; x++ )
+    {
+        Taps t = MakeTaps( srcWidth, x );
+
+        dst[ x ] = {};
+        for( uint32_t k = 0; k < t.count; k++ )
+        {
+            Accumulate( &dst[ x ], &src[ t.first + k ], t.weights[ k ], 1 );
+        }
+    }
+}
+
+// Source rows are provided by a callback, so the base level can be decoded lazily
+template< typename GetSrcRow >
+void Downsample( GetSrcRow&&          getSrcRow,
+                 uint32_t             srcWidth,
+                 uint32_t             srcHeight,
+                 std::vector< Pixel >& rowTmp,
+                 Pixel*               dst,
+                 uint32_t             dstWidth,
+                 uint32_t             dstHeight )
+{
+    rowTmp.resize( dstWidth );
+
+    for( uint32_t y = 0; y < dstHeight; y++ )
+    {
+        Taps   t      = MakeTaps( srcHeight, y );
+        Pixel* dstRow = &dst[ size_t( y ) * dstWidth ];
+
+        std::fill_n( dstRow, dstWidth, Pixel{} );
+        for( uint32_t k = 0; k < t.count; k++ )
+        {
+            DownsampleRow( getSrcRow( t.first + k ), srcWidth, rowTmp.data(), dstWidth );
+            Accumulate( dstRow, rowTmp.data(), t.weights[ k ], dstWidth );
+        }
+    }
+}
+
+float AlphaCoverage( const Pixel* pixels, size_t count, float alphaScale )
+{
+    size_t passed = 0;
+    for( size_t i = 0; i < count; i++ )
+    {
+        if( pixels[ i ].v[ 3 ] * alphaScale >= AlphaThreshold )
+        {
+            passed++;
+        }
+    }
+    return float( passed ) / float( std::max< size_t >( count, 1 ) );
+}
+
+// Find alpha scale of a level, so its coverage is the same as in the base level
+float FindAlphaScale( const Pixel* pixels, size_t count, float targetCoverage )
+{
+    float lo = 0.0f;
+    float hi = 4.0f;
+
+    for( int iter = 0; iter < 10; iter++ )
+    {
+        float mid = ( lo + hi ) * 0.5f;
+        if( AlphaCoverage( pixels, count, mid ) < targetCoverage )
+        {
+            lo = mid;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    // coverage is discrete, so pick the closest of both bounds
+    float errLo = std::abs( AlphaCoverage( pixels, count, lo ) - targetCoverage );
+    float errHi = std::abs( AlphaCoverage( pixels, count, hi ) - targetCoverage );
+    return errLo < errHi ? lo : hi;
+}
+
+uint32_t CalcLevelCount( RgExtent2D size )
+{
+    uint32_t minSide = std::min( size.width, size.height );
+    uint32_t count   = minSide > 0 ? std::bit_width( minSide ) : 0;
+
+    return std::min( count, RTGL1::MAX_PREGENERATED_MIPMAP_LEVELS );
+}
+
+}
+
+bool RTGL1::MipmapGenerator::IsSupported( VkFormat format )
+{
+    return GetFormatInfo( format ).has_value();
+}
+
+bool RTGL1::MipmapGenerator::Generate( ImageLoader::ResultInfo& image )
+{
+    if( image.isPregenerated || image.levelCount != 1 || !image.pData )
+    {
+        return false;
+    }
+
+    const auto fi = GetFormatInfo( image.format );
+    if( !fi )
+    {
+        return false;
+    }
+
+    const uint32_t levelCount = CalcLevelCount( image.baseSize );
+    if( levelCount <= 1 )
+    {
+        return false;
+    }
+
+    const uint32_t baseWidth  = image.baseSize.width;
+    const uint32_t baseHeight = image.baseSize.height;
+    const size_t   baseRowPitch = size_t( baseWidth ) * fi->bytesPerPixel;
+
+    if( image.levelSizes[ 0 ] < baseRowPitch * baseHeight )
+    {
+        return false;
+    }
+
+    // level 0 goes first, as offsets are explicit
+    size_t offsets[ MAX_PREGENERATED_MIPMAP_LEVELS ] = {};
+    size_t sizes[ MAX_PREGENERATED_MIPMAP_LEVELS ]   = {};
+    size_t total                                     = 0;
+    for( uint32_t i = 0; i < levelCount; i++ )
+    {
+        uint32_t w = std::max( baseWidth >> i, 1u );
+        uint32_t h = std::max( baseHeight >> i, 1u );
+
+        offsets[ i ] = total;
+        sizes[ i ]   = size_t( w ) * h * fi->bytesPerPixel;
+        total += sizes[ i ];
+    }
+
+    auto dst = std::make_unique< uint8_t[] >( total );
+    memcpy( &dst[ 0 ], image.pData + image.levelOffsets[ 0 ], sizes[ 0 ] );
+
+    // decode base rows lazily into a small ring, as at most 3 rows are needed at once
+    auto                 baseRows = std::vector< Pixel >( size_t( baseWidth ) * 3 );
+    uint32_t             baseRowIds[ 3 ] = { UINT32_MAX, UINT32_MAX, UINT32_MAX };
+    std::vector< Pixel > rowTmp;
+
+    auto getBaseRow = [ & ]( uint32_t y ) -> const Pixel* {
+        Pixel* row = &baseRows[ size_t( y % 3 ) * baseWidth ];
+        if( baseRowIds[ y % 3 ] != y )
+        {
+            DecodeRow( image.pData + image.levelOffsets[ 0 ] + baseRowPitch * y,
+                       baseWidth,
+                       *fi,
+                       row );
+            baseRowIds[ y % 3 ] = y;
+        }
+        return row;
+    };
+
+    // alpha-tested detection and target coverage of the base level
+    bool  preserveCoverage = false;
+    float baseCoverage     = 0.0f;
+    if( fi->layout != Layout::R8 )
+    {
+        size_t partial = 0, passed = 0, belowThreshold = 0;
+        for( uint32_t y = 0; y < baseHeight; y++ )
+        {
+            const Pixel* row = getBaseRow( y );
+            for( uint32_t x = 0; x < baseWidth; x++ )
+            {
+                float a = row[ x ].v[ 3 ];
+                partial += ( a > 0.1f && a < 0.9f ) ? 1 : 0;
+                passed += a >= AlphaThreshold ? 1 : 0;
+                belowThreshold += a < AlphaThreshold ? 1 : 0;
+            }
+        }
+
+        const size_t count = size_t( baseWidth ) * baseHeight;
+
+        preserveCoverage = belowThreshold > 0 &&
+                           float( partial ) <= AlphaTestedMaxPartial * float( count );
+        baseCoverage     = float( passed ) / float( count );
+    }
+
+    std::vector< Pixel > levelA, levelB;
+    uint32_t             srcWidth  = baseWidth;
+    uint32_t             srcHeight = baseHeight;
+
+    for( uint32_t i = 1; i < levelCount; i++ )
+    {
+        uint32_t w = std::max( baseWidth >> i, 1u );
+        uint32_t h = std::max( baseHeight >> i, 1u );
+
+        levelB.resize( size_t( w ) * h );
+        if( i == 1 )
+        {
+            Downsample( getBaseRow, srcWidth, srcHeight, rowTmp, levelB.data(), w, h );
+        }
+        else
+        {
+            const Pixel* src       = levelA.data();
+            auto         getRow    = [ & ]( uint32_t y ) { return &src[ size_t( y ) * srcWidth ]; };
+            Downsample( getRow, srcWidth, srcHeight, rowTmp, levelB.data(), w, h );
+        }
+
+        // scale is applied only to the encoded level,
+        // so the next levels are filtered from unmodified values
+        float alphaScale = preserveCoverage
+                               ? FindAlphaScale( levelB.data(), levelB.size(), baseCoverage )
+                               : 1.0f;
+
+        for( uint32_t y = 0; y < h; y++ )
+        {
+            EncodeRow( &levelB[ size_t( y ) * w ],
+                       w,
+                       *fi,
+                       alphaScale,
+                       &dst[ offsets[ i ] + size_t( y ) * w * fi->bytesPerPixel ] );
+        }
+
+        std::swap( levelA, levelB );
+        srcWidth  = w;
+        srcHeight = h;
+    }
+
+    for( uint32_t i = 0; i < levelCount; i++ )
+    {
+        image.levelOffsets[ i ] = offsets[ i ];
+        image.levelSizes[ i ]   = sizes[ i ];
+    }
+    image.levelCount     = levelCount;
+    image.isPregenerated = true;
+    image.pData          = dst.get();
+    image.dataSize       = total;
+
+    generated.push_back( std::move( dst ) );
+    return true;
+}
+
+void RTGL1::MipmapGenerator::FreeGenerated()
+{
+    generated.clear();
+}
@@ -0,0 +1,66 @@
+/*
+
+Copyright (c) 2024 V.Shirokii
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#pragma once
+
+#include "ImageLoader.h"
+
+#include <memory>
+#include <vector>
+
+namespace RTGL1
+{
+
+// Builds a mip chain of an uncompressed image on CPU, so all levels are uploaded
+// with one copy, instead of blitting each level from the previous one on GPU.
+// Levels are averaged in linear space, i.e. sRGB formats are decoded before filtering.
+// If an RGBA image looks alpha-tested (its alpha is mostly 0 or 1), alpha of each level
+// is scaled to keep the same coverage for ALPHA_THRESHOLD as in the base level,
+// so cutouts don't dissolve in the distance.
+class MipmapGenerator final
+{
+public:
+    MipmapGenerator() = default;
+    ~MipmapGenerator() = default;
+
+    MipmapGenerator( const MipmapGenerator& other )                = delete;
+    MipmapGenerator( MipmapGenerator&& other ) noexcept            = delete;
+    MipmapGenerator& operator=( const MipmapGenerator& other )     = delete;
+    MipmapGenerator& operator=( MipmapGenerator&& other ) noexcept = delete;
+
+    // R8, RGBA8 / BGRA8 (UNORM or SRGB), RGBA16 SFLOAT
+    static bool IsSupported( VkFormat format );
+
+    // If the image has only one level and its format is supported, replace it
+    // with a full mip chain, which is owned by the generator until FreeGenerated.
+    // Returns false, if the image was not changed.
+    bool Generate( ImageLoader::ResultInfo& image );
+    void FreeGenerated();
+
+private:
+    std::vector< std::unique_ptr< uint8_t[] > > generated;
+};
+
+}
@@ -0,0 +1,445 @@
+/*
+
+Copyright (c) 2024 V.Shirokii
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#include "PrimitiveLightCache.h"
+
+#include "DebugPrint.h"
+#include "JobSystem.h"
+#include "Utils.h"
+
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <string_view>
+
+namespace
+{
+
+// Primitives with more triangles are processed on the job system
+constexpr uint32_t PARALLEL_TRIANGLE_COUNT = 4096;
+constexpr size_t   PARALLEL_GRAIN          = 1024;
+
+// Neighbor triangles are coplanar, if the angle between their normals is less than ~2.5 degrees
+constexpr float COPLANAR_COS = 0.999f;
+
+// Vertices of the neighbor triangles are matched on a grid with this many cells per unit
+constexpr float EDGE_QUANTIZATION = 1000.0f;
+
+// Entries of the primitives that were not uploaded for longer are removed
+constexpr uint64_t MAX_UNUSED_FRAMES = 120;
+
+uint64_t HashBytes( const void* data, size_t size )
+{
+    return ankerl::unordered_dense::hash< std::string_view >{}(
+        std::string_view( static_cast< const char* >( data ), size ) );
+}
+
+uint64_t Combine( uint64_t seed, uint64_t value )
+{
+    return seed ^ ( ankerl::unordered_dense::hash< uint64_t >{}( value ) + 0x9e3779b97f4a7c15ULL +
+                    ( seed << 6 ) + ( seed >> 2 ) );
+}
+
+uint32_t GetTriangleCount( const RgMeshPrimitiveInfo& prim )
+{
+    return ( prim.pIndices && prim.indexCount > 0 ? prim.indexCount : prim.vertexCount ) / 3;
+}
+
+RgFloat3D GetTriangleVertex( const RgMeshPrimitiveInfo& prim, uint32_t triangle, uint32_t k )
+{
+    const uint32_t v = prim.pIndices && prim.indexCount > 0 ? prim.pIndices[ triangle * 3 + k ]
+                                                            : triangle * 3 + k;
+    return RgFloat3D{ RG_ACCESS_VEC3( prim.pVertices[ v ].position ) };
+}
+
+struct Triangle
+{
+    RgFloat3D v[ 3 ];
+    RgFloat3D normal;
+    // Zero, if degenerate
+    float     area;
+    // Hashes of the edges
+    uint64_t  edges[ 3 ];
+};
+
+// Hash of the quantized endpoints, regardless of their order.
+// Used as a key directly: a collision requires the triangles to be also coplanar
+uint64_t HashEdge( const RgFloat3D& a, const RgFloat3D& b )
+{
+    auto qa = std::array< int64_t, 3 >{};
+    auto qb = std::array< int64_t, 3 >{};
+    for( int k = 0; k < 3; k++ )
+    {
+        qa[ k ] = std::llround( a.data[ k ] * EDGE_QUANTIZATION );
+        qb[ k ] = std::llround( b.data[ k ] * EDGE_QUANTIZATION );
+    }
+    if( qb < qa )
+    {
+        std::swap( qa, qb );
+    }
+    const int64_t e[] = { qa[ 0 ], qa[ 1 ], qa[ 2 ], qb[ 0 ], qb[ 1 ], qb[ 2 ] };
+    return HashBytes( e, sizeof( e ) );
+}
+
+struct IdentityHash
+{
+    using is_avalanching = void;
+
+    uint64_t operator()( uint64_t v ) const noexcept { return v; }
+};
+
+uint32_t FindRoot( std::vector< uint32_t >& parent, uint32_t i )
+{
+    while( parent[ i ] != i )
+    {
+        // path halving
+        parent[ i ] = parent[ parent[ i ] ];
+        i           = parent[ i ];
+    }
+    return i;
+}
+
+}
+
+void RTGL1::ExtractPrimitiveLights( const RgMeshPrimitiveInfo&     prim,
+                                    JobSystem*                     jobSystem,
+                                    std::vector< PositionNormal >& out )
+{
+    out.clear();
+
+    const uint32_t triangleCount = GetTriangleCount( prim );
+    if( triangleCount == 0 || !prim.pVertices )
+    {
+        return;
+    }
+
+    auto triangles = std::vector< Triangle >( triangleCount );
+    {
+        auto l_compute = [ &prim, &triangles ]( size_t begin, size_t end ) {
+            for( size_t i = begin; i < end; i++ )
+            {
+                Triangle& t = triangles[ i ];
+                for( uint32_t k = 0; k < 3; k++ )
+                {
+                    t.v[ k ] = GetTriangleVertex( prim, uint32_t( i ), k );
+                }
+
+                if( !Utils::GetNormalAndArea( t.v, t.normal, t.area ) )
+                {
+                    t.area = 0;
+                    continue;
+                }
+
+                t.edges[ 0 ] = HashEdge( t.v[ 0 ], t.v[ 1 ] );
+                t.edges[ 1 ] = HashEdge( t.v[ 1 ], t.v[ 2 ] );
+                t.edges[ 2 ] = HashEdge( t.v[ 2 ], t.v[ 0 ] );
+            }
+        };
+
+        if( jobSystem && triangleCount >= PARALLEL_TRIANGLE_COUNT )
+        {
+            jobSystem->ParallelFor( triangleCount, PARALLEL_GRAIN, l_compute );
+        }
+        else
+        {
+            l_compute( 0, triangleCount );
+        }
+    }
+
+    // join the coplanar triangles that share an edge
+    auto parent = std::vector< uint32_t >( triangleCount );
+    std::iota( parent.begin(), parent.end(), 0 );
+    {
+        auto edgeOwners = ankerl::unordered_dense::map< uint64_t, uint32_t, IdentityHash >{};
+        edgeOwners.reserve( size_t( triangleCount ) * 3 / 2 );
+
+        for( uint32_t t = 0; t < triangleCount; t++ )
+        {
+            const Triangle& cur = triangles[ t ];
+            if( cur.area <= 0 )
+            {
+                continue;
+            }
+
+            for( uint64_t edge : cur.edges )
+            {
+                auto [ owner, isNew ] = edgeOwners.try_emplace( edge, t );
+                if( isNew )
+                {
+                    continue;
+                }
+
+                const uint32_t rootA = FindRoot( parent, owner->second );
+                const uint32_t rootB = FindRoot( parent, t );
+                if( rootA == rootB )
+                {
+                    continue;
+                }
+
+                // compare with the roots too, so a finely tessellated curved surface
+                // doesn't become one plane, as each step between neighbors is small
+                if( Utils::Dot( triangles[ owner->second ].normal, cur.normal ) >= COPLANAR_COS &&
+                    Utils::Dot( triangles[ rootA ].normal, triangles[ rootB ].normal ) >=
+                        COPLANAR_COS )
+                {
+                    parent[ std::max( rootA, rootB ) ] = std::min( rootA, rootB );
+                }
+            }
+        }
+    }
+
+    // in the order of the first triangle of each surface, so the order is stable
+    struct Accum
+    {
+        float    center[ 3 ];
+        float    normal[ 3 ];
+        float    area;
+        uint32_t first;
+    };
+    auto accums  = std::vector< Accum >{};
+    auto surface = std::vector< uint32_t >( triangleCount, UINT32_MAX );
+
+    for( uint32_t t = 0; t < triangleCount; t++ )
+    {
+        const Triangle& tri = triangles[ t ];
+        if( tri.area <= 0 )
+        {
+            continue;
+        }
+
+        uint32_t& s = surface[ FindRoot( parent, t ) ];
+        if( s == UINT32_MAX )
+        {
+            s = uint32_t( accums.size() );
+            accums.push_back( Accum{ .first = t } );
+        }
+
+        Accum& dst = accums[ s ];
+        for( int k = 0; k < 3; k++ )
+        {
+            const float c = ( tri.v[ 0 ].data[ k ] + tri.v[ 1 ].data[ k ] + tri.v[ 2 ].data[ k ] ) /
+                            3.0f;
+
+            dst.center[ k ] += c * tri.area;
+            dst.normal[ k ] += tri.normal.data[ k ] * tri.area;
+        }
+        dst.area += tri.area;
+    }
+
+    out.reserve( accums.size() );
+    for( const Accum& a : accums )
+    {
+        out.push_back( PositionNormal{
+            .position = { a.center[ 0 ] / a.area, a.center[ 1 ] / a.area, a.center[ 2 ] / a.area },
+            .normal   = Utils::SafeNormalize( RgFloat3D{ RG_ACCESS_VEC3( a.normal ) },
+                                            triangles[ a.first ].normal ),
+        } );
+    }
+}
+
+RTGL1::PositionNormal RTGL1::TransformPositionNormal( const RgTransform&    transform,
+                                                      const PositionNormal& local )
+{
+    const auto& m = transform.matrix;
+
+    // normals are transformed by the cofactor matrix, so non-uniform scale
+    // and mirroring are handled the same way as if the triangles were transformed
+    const float c0[] = { m[ 0 ][ 0 ], m[ 1 ][ 0 ], m[ 2 ][ 0 ] };
+    const float c1[] = { m[ 0 ][ 1 ], m[ 1 ][ 1 ], m[ 2 ][ 1 ] };
+    const float c2[] = { m[ 0 ][ 2 ], m[ 1 ][ 2 ], m[ 2 ][ 2 ] };
+
+    auto l_cross = []( const float* a, const float* b ) {
+        return RgFloat3D{
+            a[ 1 ] * b[ 2 ] - a[ 2 ] * b[ 1 ],
+            a[ 2 ] * b[ 0 ] - a[ 0 ] * b[ 2 ],
+            a[ 0 ] * b[ 1 ] - a[ 1 ] * b[ 0 ],
+        };
+    };
+    const RgFloat3D x = l_cross( c1, c2 );
+    const RgFloat3D y = l_cross( c2, c0 );
+    const RgFloat3D z = l_cross( c0, c1 );
+
+    const float* n = local.normal.data;
+
+    const auto normal = RgFloat3D{
+        x.data[ 0 ] * n[ 0 ] + y.data[ 0 ] * n[ 1 ] + z.data[ 0 ] * n[ 2 ],
+        x.data[ 1 ] * n[ 0 ] + y.data[ 1 ] * n[ 1 ] + z.data[ 1 ] * n[ 2 ],
+        x.data[ 2 ] * n[ 0 ] + y.data[ 2 ] * n[ 1 ] + z.data[ 2 ] * n[ 2 ],
+    };
+
+    return PositionNormal{
+        .position = Utils::ApplyTransform( transform, local.position ),
+        .normal   = Utils::SafeNormalize( normal, local.normal ),
+    };
+}
+
+RgLightSpotEXT RTGL1::MakeAttachedSpotLight( const RgMeshPrimitiveAttachedLightEXT& info,
+                                             const PositionNormal&                  surface,
+                                             float oneGameUnitInMeters )
+{
+    const float offset = 0.1f / oneGameUnitInMeters;
+
+    return RgLightSpotEXT{
+        .sType      = RG_STRUCTURE_TYPE_LIGHT_SPOT_EXT,
+        .pNext      = nullptr,
+        .color      = info.color,
+        .intensity  = info.intensity,
+        .position   = { surface.position.data[ 0 ] + surface.normal.data[ 0 ] * offset,
+                        surface.position.data[ 1 ] + surface.normal.data[ 1 ] * offset,
+                        surface.position.data[ 2 ] + surface.normal.data[ 2 ] * offset },
+        .direction  = surface.normal,
+        .radius     = 0.1f, /* ignored */
+        .angleOuter = Utils::DegToRad( 89 ),
+        .angleInner = Utils::DegToRad( 75 ),
+    };
+}
+
+RTGL1::PrimitiveLightCache::PrimitiveLightCache( std::shared_ptr< JobSystem > _jobSystem )
+    : jobSystem{ std::move( _jobSystem ) }
+{
+}
+
+uint64_t RTGL1::PrimitiveLightCache::KeyHash::operator()( const Key& k ) const noexcept
+{
+    return Combine( ankerl::unordered_dense::hash< uint64_t >{}( k.uniqueObjectID ),
+                    k.primitiveIndexInMesh );
+}
+
+void RTGL1::PrimitiveLightCache::PrepareForFrame()
+{
+    frameId++;
+
+    erase_if( entries, [ this ]( const auto& kv ) {
+        return kv.second.lastFrame + MAX_UNUSED_FRAMES < frameId;
+    } );
+}
+
+bool RTGL1::PrimitiveLightCache::IsQuad( const RgMeshPrimitiveInfo& prim )
+{
+    return ( prim.indexCount == 6 && prim.vertexCount == 4 ) ||
+           ( prim.indexCount == 0 && prim.vertexCount == 6 );
+}
+
+auto RTGL1::PrimitiveLightCache::Get( const RgMeshInfo&                      mesh,
+                                      const RgMeshPrimitiveInfo&             prim,
+                                      const RgMeshPrimitiveAttachedLightEXT& info,
+                                      float oneGameUnitInMeters ) -> std::span< const AnyLightEXT >
+{
+    // only positions define the surfaces
+    uint64_t vertexHash = 0;
+    for( uint32_t v = 0; v < prim.vertexCount; v++ )
+    {
+        vertexHash =
+            Combine( vertexHash, HashBytes( prim.pVertices[ v ].position, sizeof( float ) * 3 ) );
+    }
+    if( prim.pIndices && prim.indexCount > 0 )
+    {
+        vertexHash =
+            Combine( vertexHash, HashBytes( prim.pIndices, sizeof( uint32_t ) * prim.indexCount ) );
+    }
+
+    const bool quad = IsQuad( prim );
+
+    auto [ iter, isNew ] = entries.try_emplace(
+        Key{ .uniqueObjectID = mesh.uniqueObjectID,
+             .primitiveIndexInMesh = prim.primitiveIndexInMesh } );
+    Entry& e = iter->second;
+
+    e.lastFrame = frameId;
+
+    bool remake = isNew || e.vertexHash != vertexHash || e.quad != quad;
+    if( remake )
+    {
+        e.vertexHash = vertexHash;
+        e.quad       = quad;
+
+        if( quad )
+        {
+            auto center = RgFloat3D{ 0, 0, 0 };
+            for( uint32_t v = 0; v < prim.vertexCount; v++ )
+            {
+                center.data[ 0 ] += prim.pVertices[ v ].position[ 0 ];
+                center.data[ 1 ] += prim.pVertices[ v ].position[ 1 ];
+                center.data[ 2 ] += prim.pVertices[ v ].position[ 2 ];
+            }
+            center.data[ 0 ] /= float( prim.vertexCount );
+            center.data[ 1 ] /= float( prim.vertexCount );
+            center.data[ 2 ] /= float( prim.vertexCount );
+
+            e.surfaces.assign( { PositionNormal{ .position = center, .normal = { 0, 0, 0 } } } );
+        }
+        else
+        {
+            if( GetTriangleCount( prim ) > 1024 )
+            {
+                debug::Warning( "The amount of triangles ({}) on a primitive (ID {}-{}, "
+                                "material name: {}) with attached light is too high",
+                                GetTriangleCount( prim ),
+                                mesh.uniqueObjectID,
+                                prim.primitiveIndexInMesh,
+                                Utils::SafeCstr( prim.pTextureName ) );
+            }
+
+            ExtractPrimitiveLights( prim, jobSystem.get(), e.surfaces );
+        }
+    }
+
+    remake = remake || memcmp( &e.transform, &mesh.transform, sizeof( RgTransform ) ) != 0 ||
+             e.color != info.color || e.intensity != info.intensity ||
+             e.oneGameUnitInMeters != oneGameUnitInMeters;
+    if( remake )
+    {
+        e.transform           = mesh.transform;
+        e.color               = info.color;
+        e.intensity           = info.intensity;
+        e.oneGameUnitInMeters = oneGameUnitInMeters;
+
+        e.lights.clear();
+        for( const PositionNormal& s : e.surfaces )
+        {
+            if( quad )
+            {
+                e.lights.emplace_back( RgLightSphericalEXT{
+                    .sType     = RG_STRUCTURE_TYPE_LIGHT_SPHERICAL_EXT,
+                    .pNext     = nullptr,
+                    .color     = info.color,
+                    .intensity = info.intensity,
+                    .position  = { s.position.data[ 0 ] + mesh.transform.matrix[ 0 ][ 3 ],
+                                   s.position.data[ 1 ] + mesh.transform.matrix[ 1 ][ 3 ],
+                                   s.position.data[ 2 ] + mesh.transform.matrix[ 2 ][ 3 ] },
+                    .radius    = 0.1f,
+                } );
+            }
+            else
+            {
+                e.lights.emplace_back( MakeAttachedSpotLight(
+                    info, TransformPositionNormal( mesh.transform, s ), oneGameUnitInMeters ) );
+            }
+        }
+    }
+
+    return e.lights;
+}
@@ -0,0 +1,127 @@
+/*
+
+Copyright (c) 2024 V.Shirokii
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#pragma once
+
+#include "Common.h"
+
+#include "ankerl/unordered_dense.h"
+
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace RTGL1
+{
+
+class JobSystem;
+
+struct PositionNormal
+{
+    RgFloat3D position;
+    RgFloat3D normal;
+};
+
+// Emissive surfaces of a primitive in its local space: adjacent coplanar triangles are merged,
+// and each surface is positioned at the area-weighted centroid of its triangles.
+// If 'jobSystem' is not null, triangles of large primitives are processed on its workers
+void ExtractPrimitiveLights( const RgMeshPrimitiveInfo&     prim,
+                             JobSystem*                     jobSystem,
+                             std::vector< PositionNormal >& out );
+
+PositionNormal TransformPositionNormal( const RgTransform& transform, const PositionNormal& local );
+
+// Light that is placed slightly in front of an emissive surface
+RgLightSpotEXT MakeAttachedSpotLight( const RgMeshPrimitiveAttachedLightEXT& info,
+                                      const PositionNormal&                  surface,
+                                      float                                  oneGameUnitInMeters );
+
+// Lights of the primitives with RgMeshPrimitiveAttachedLightEXT. Surfaces are extracted again
+// only if the vertex data of a primitive has changed, and lights are made again only
+// if its transform or the light parameters have. Entries of the primitives that
+// were not uploaded for some frames are removed
+class PrimitiveLightCache
+{
+public:
+    explicit PrimitiveLightCache( std::shared_ptr< JobSystem > jobSystem );
+    ~PrimitiveLightCache() = default;
+
+    PrimitiveLightCache( const PrimitiveLightCache& other )                = delete;
+    PrimitiveLightCache( PrimitiveLightCache&& other ) noexcept            = delete;
+    PrimitiveLightCache& operator=( const PrimitiveLightCache& other )     = delete;
+    PrimitiveLightCache& operator=( PrimitiveLightCache&& other ) noexcept = delete;
+
+    void PrepareForFrame();
+
+    // Quads get one sphere light in their center
+    static bool IsQuad( const RgMeshPrimitiveInfo& prim );
+
+    // The result is valid until the next call
+    auto Get( const RgMeshInfo&                      mesh,
+              const RgMeshPrimitiveInfo&             prim,
+              const RgMeshPrimitiveAttachedLightEXT& info,
+              float                                  oneGameUnitInMeters )
+        -> std::span< const AnyLightEXT >;
+
+private:
+    struct Key
+    {
+        uint64_t uniqueObjectID;
+        uint32_t primitiveIndexInMesh;
+
+        bool operator==( const Key& other ) const = default;
+    };
+
+    struct KeyHash
+    {
+        using is_avalanching = void;
+
+        uint64_t operator()( const Key& k ) const noexcept;
+    };
+
+    struct Entry
+    {
+        uint64_t                      vertexHash;
+        bool                          quad;
+        std::vector< PositionNormal > surfaces;
+
+        // What 'lights' were made for
+        RgTransform       transform;
+        RgColor4DPacked32 color;
+        float             intensity;
+        float             oneGameUnitInMeters;
+
+        std::vector< AnyLightEXT > lights;
+        uint64_t                   lastFrame;
+    };
+
+private:
+    std::shared_ptr< JobSystem > jobSystem;
+
+    ankerl::unordered_dense::map< Key, Entry, KeyHash > entries;
+    uint64_t                                            frameId{ 0 };
+};
+
+}
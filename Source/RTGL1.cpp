@@ -141,6 +141,11 @@ RgResult RGAPI_CALL rgUploadLight( const RgLightInfo* pInfo )
     return Call( [ & ]( Device& d ) { d.UploadLight( pInfo ); } );
 }
 
+RgResult RGAPI_CALL rgUploadLights( const RgLightInfo* pInfos, uint32_t count )
+{
+    return Call( [ & ]( Device& d ) { d.UploadLights( pInfos, count ); } );
+}
+
 RgResult RGAPI_CALL rgProvideOriginalTexture( const RgOriginalTextureInfo* pInfo )
 {
     return Call( [ & ]( Device& d ) { d.ProvideOriginalTexture( pInfo ); } );
@@ -362,6 +367,7 @@ RGAPI RgResult RGCONV RGAPI_CALL rgCreateInstance( const RgInstanceCreateInfo* p
             .rgUtilExportAsTGA                 = rgUtilExportAsTGA,
             .rgUtilGetSupportedFeatures        = rgUtilGetSupportedFeatures,
             .rgSpawnFluid                      = rgSpawnFluid,
+            .rgUploadLights                    = rgUploadLights,
         };
 
         // error if DLL has less functionality, otherwise, warning
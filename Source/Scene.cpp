@@ -33,7 +33,6 @@
 
 #include <glm/gtc/quaternion.hpp>
 
-#include <future>
 #include <ranges>
 
 namespace
@@ -198,6 +197,8 @@ RTGL1::Scene::Scene( VkDevice                                _device,
                      const PhysicalDevice&                   _physDevice,
                      std::shared_ptr< MemoryAllocator >&     _allocator,
                      std::shared_ptr< CommandBufferManager > _cmdManager,
+                     std::shared_ptr< JobSystem >            _jobSystem,
+                     std::shared_ptr< FrameArenas >          _frameArenas,
                      const GlobalUniform&                    _uniform,
                      const ShaderManager&                    _shaderManager,
                      uint64_t                                _maxReplacementsVerts,
@@ -205,6 +206,7 @@ RTGL1::Scene::Scene( VkDevice                                _device,
                      bool                                    _enableTexCoordLayer1,
                      bool                                    _enableTexCoordLayer2,
                      bool                                    _enableTexCoordLayer3 )
+    : jobs{ std::move( _jobSystem ) }
 {
     geomInfoMgr = std::make_shared< GeomInfoManager >( _device, _allocator );
 
@@ -213,6 +215,8 @@ RTGL1::Scene::Scene( VkDevice                                _device,
                                                _allocator,
                                                std::move( _cmdManager ),
                                                geomInfoMgr,
+                                               jobs,
+                                               std::move( _frameArenas ),
                                                _maxReplacementsVerts,
                                                _maxDynamicVerts,
                                                _enableTexCoordLayer1,
@@ -433,6 +437,25 @@ namespace
 
         return r;
     }
+
+    auto ToImportedMaterials( const std::vector< WholeModelFile::RawMaterialData >& materials )
+        -> std::vector< TextureManager::ImportedMaterial >
+    {
+        auto imported = std::vector< TextureManager::ImportedMaterial >{};
+        imported.reserve( materials.size() );
+
+        for( const auto& mat : materials )
+        {
+            imported.push_back( TextureManager::ImportedMaterial{
+                .materialName       = mat.pTextureName,
+                .fullPaths          = mat.fullPaths,
+                .samplers           = mat.samplers,
+                .customPbrSwizzling = mat.pbrSwizzling,
+                .isReplacement      = mat.isReplacement,
+            } );
+        }
+        return imported;
+    }
 }
 }
 
@@ -536,10 +559,10 @@ void RTGL1::Scene::SubmitForFrame( VkCommandBuffer                         cmd,
     asManager->SubmitDynamicGeometry( makingDynamic, cmd, frameIndex );
 
     // geom infos must be ready before vertex preprocessing
-    auto tlas     = asManager->MakeUniqueIDToTlasID( disableRTGeometry );
-    auto tlasSize = static_cast< uint32_t >( tlas.size() );
+    asManager->MakeUniqueIDToTlasID( disableRTGeometry, tlasMapping );
+    auto tlasSize = static_cast< uint32_t >( tlasMapping.size() );
 
-    geomInfoMgr->CopyFromStaging( cmd, frameIndex, std::move( tlas ) );
+    geomInfoMgr->CopyFromStaging( cmd, frameIndex, tlasMapping );
 
     vertPreproc->Preprocess(
         cmd, frameIndex, VERT_PREPROC_MODE_ONLY_DYNAMIC, *uniform, *asManager, tlasSize );
@@ -688,6 +711,44 @@ RTGL1::UploadResult RTGL1::Scene::UploadLight( uint32_t           frameIndex,
 {
     assert( !isStatic || ( isStatic && !transform ) );
 
+    UploadResult r = RegisterLight( light, isStatic );
+
+    // adding static to light manager is done separately in SubmitStaticLights
+    if( r == UploadResult::Dynamic || r == UploadResult::ExportableDynamic )
+    {
+        lightManager.Add( frameIndex, light, transform );
+    }
+
+    return r;
+}
+
+void RTGL1::Scene::UploadLights( uint32_t                     frameIndex,
+                                 std::span< const LightCopy > lights,
+                                 LightManager&                lightManager,
+                                 FrameArena&                  arena,
+                                 std::span< UploadResult >    outResults )
+{
+    assert( lights.size() == outResults.size() );
+
+    auto toAdd = FrameVector< LightCopy >{ &arena };
+    toAdd.reserve( lights.size() );
+
+    for( size_t i = 0; i < lights.size(); i++ )
+    {
+        outResults[ i ] = RegisterLight( lights[ i ], false );
+
+        if( outResults[ i ] == UploadResult::Dynamic ||
+            outResults[ i ] == UploadResult::ExportableDynamic )
+        {
+            toAdd.push_back( lights[ i ] );
+        }
+    }
+
+    lightManager.AddBatch( frameIndex, toAdd, arena );
+}
+
+RTGL1::UploadResult RTGL1::Scene::RegisterLight( const LightCopy& light, bool isStatic )
+{
     bool isExportable = light.base.isExportable;
 
     if( !isStatic )
@@ -706,11 +767,8 @@ RTGL1::UploadResult RTGL1::Scene::UploadLight( uint32_t           frameIndex,
         return UploadResult::Fail;
     }
 
-    // adding static to light manager is done separately in SubmitStaticLights
     if( !isStatic )
     {
-        lightManager.Add( frameIndex, light, transform );
-
         if( std::holds_alternative< RgLightDirectionalEXT >( light.extension ) )
         {
             lastDynamicSun_uniqueId = light.base.uniqueID;
@@ -726,8 +784,13 @@ void RTGL1::Scene::SubmitStaticLights( uint32_t          frameIndex,
                                        bool              isUnderwater,
                                        RgColor4DPacked32 underwaterColor ) const
 {
-    for( const LightCopy& l : staticLights )
+    // regular ones are encoded only if changed
+    lightManager.SubmitStatic( frameIndex, staticLights, staticLightsGeneration );
+
+    for( size_t i : staticSunIndices )
     {
+        const LightCopy& l = staticLights[ i ];
+
         // SHIPPING_HACK begin - tint sun if underwater
         if( isUnderwater )
         {
@@ -813,6 +876,12 @@ bool RTGL1::Scene::InsertLightInfo( bool isStatic, const LightCopy& light )
 
         // add to the list
         staticLights.push_back( light );
+        staticLightsGeneration++;
+
+        if( std::holds_alternative< RgLightDirectionalEXT >( light.extension ) )
+        {
+            staticSunIndices.push_back( staticLights.size() - 1 );
+        }
         return true;
     }
     else
@@ -835,6 +904,8 @@ void RTGL1::Scene::NewScene( VkCommandBuffer              cmd,
     staticUniqueIDs.clear();
     staticMeshNames.clear();
     staticLights.clear();
+    staticSunIndices.clear();
+    staticLightsGeneration++;
     cameraInfo_Imported = {};
     m_cameraInfo_ImportedAnim = {};
     m_obj_ImportedAnim        = {};
@@ -853,31 +924,41 @@ void RTGL1::Scene::NewScene( VkCommandBuffer              cmd,
         debug::Verbose( "Reading replacements..." );
         const auto gltfs = GetGltfFilesSortedAlphabetically( *replacementsFolder );
 
-        auto allImported = std::vector< std::future< std::unique_ptr< WholeModelFile > > >{};
+        // reverse alphabetical -- last ones have more priority
+        auto allImported = std::vector< std::unique_ptr< WholeModelFile > >( gltfs.size() );
+        auto importJobs  = std::vector< JobSystem::Handle >{};
         {
-            // reverse alphabetical -- last ones have more priority
+            importJobs.reserve( gltfs.size() );
+
+            size_t index = 0;
             for( const auto& p : std::ranges::reverse_view{ gltfs } )
             {
-                allImported.push_back( std::async(
-                    std::launch::async,
-                    [ & ](
-                        const std::filesystem::path& path ) -> std::unique_ptr< WholeModelFile > //
+                importJobs.push_back( jobs->Submit( [ &, index, path = p ] {
+                    if( auto i = GltfImporter{ path, params, textureMeta, true } )
                     {
-                        if( auto i = GltfImporter{ path, params, textureMeta, true } )
-                        {
-                            return std::make_unique< WholeModelFile >( i.Move() );
-                        }
-                        return {};
-                    },
-                    p ) );
+                        allImported[ index ] = std::make_unique< WholeModelFile >( i.Move() );
+                    }
+                } ) );
+                index++;
             }
         }
 
-        for( auto &ff : allImported )
+        // jobs write to 'allImported', so they must be finished before it's destroyed,
+        // even if the processing below throws
+        struct WaitOnExit
+        {
+            ~WaitOnExit() { jobSystem.Wait( handles ); }
+
+            JobSystem&                           jobSystem;
+            std::span< const JobSystem::Handle > handles;
+        } waitOnExit{ *jobs, importJobs };
+
+        for( size_t index = 0; index < allImported.size(); index++ )
         {
-            auto wholeGltf = ff.valid() //
-                                 ? ff.get()
-                                 : std::unique_ptr< WholeModelFile >{};
+            // process in order, while the rest are still being imported
+            jobs->Wait( importJobs[ index ] );
+
+            auto wholeGltf = std::move( allImported[ index ] );
 
             if( !wholeGltf )
             {
@@ -890,16 +971,8 @@ void RTGL1::Scene::NewScene( VkCommandBuffer              cmd,
                 debug::Warning( "Ignoring non-attached lights from \'{}\'", path.string() );
             }
 
-            for( const auto& mat : wholeGltf->materials )
-            {
-                textureManager.TryCreateImportedMaterial( cmd,
-                                                          frameIndex,
-                                                          mat.pTextureName,
-                                                          mat.fullPaths,
-                                                          mat.samplers,
-                                                          mat.pbrSwizzling,
-                                                          mat.isReplacement );
-            }
+            textureManager.CreateImportedMaterials(
+                cmd, frameIndex, ToImportedMaterials( wholeGltf->materials ) );
 
             for( auto& [ meshName, meshSrc ] : wholeGltf->models )
             {
@@ -990,16 +1063,11 @@ void RTGL1::Scene::NewScene( VkCommandBuffer              cmd,
             }
         }
 
+        textureManager.CreateImportedMaterials(
+            cmd, frameIndex, ToImportedMaterials( sceneFile.materials ) );
+
         for( const auto& mat : sceneFile.materials )
         {
-            textureManager.TryCreateImportedMaterial( cmd,
-                                                      frameIndex,
-                                                      mat.pTextureName,
-                                                      mat.fullPaths,
-                                                      mat.samplers,
-                                                      mat.pbrSwizzling,
-                                                      mat.isReplacement );
-
             // SHIPPING_HACK begin
             if( mat.trackOriginalTexture && !mat.pTextureName.empty() )
             {
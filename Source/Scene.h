@@ -24,6 +24,7 @@
 #include "Camera.h"
 #include "GltfExporter.h"
 #include "GltfImporter.h"
+#include "JobSystem.h"
 #include "LightManager.h"
 #include "VertexPreprocessing.h"
 #include "TextureMeta.h"
@@ -57,6 +58,8 @@ public:
                     const PhysicalDevice&                   physDevice,
                     std::shared_ptr< MemoryAllocator >&     allocator,
                     std::shared_ptr< CommandBufferManager > cmdManager,
+                    std::shared_ptr< JobSystem >            jobSystem,
+                    std::shared_ptr< FrameArenas >          frameArenas,
                     const GlobalUniform&                    uniform,
                     const ShaderManager&                    shaderManager,
                     uint64_t                                maxReplacementsVerts,
@@ -93,6 +96,12 @@ public:
                               LightManager&      lightManager,
                               bool               isStatic,
                               const RgTransform* transform = nullptr );
+    // Dynamic lights only
+    void UploadLights( uint32_t                     frameIndex,
+                       std::span< const LightCopy > lights,
+                       LightManager&                lightManager,
+                       FrameArena&                  arena,
+                       std::span< UploadResult >    outResults );
 
     void SubmitStaticLights( uint32_t          frameIndex,
                              LightManager&     lightManager,
@@ -130,13 +139,19 @@ private:
                               const RgMeshInfo&          mesh,
                               const RgMeshPrimitiveInfo& primitive );
 
-    bool InsertLightInfo( bool isStatic, const LightCopy& light );
+    bool         InsertLightInfo( bool isStatic, const LightCopy& light );
+    // Check and remember the light, but don't add it to the light manager
+    UploadResult RegisterLight( const LightCopy& light, bool isStatic );
 
 private:
+    std::shared_ptr< JobSystem >           jobs;
     std::shared_ptr< ASManager >           asManager;
     std::shared_ptr< GeomInfoManager >     geomInfoMgr;
     std::shared_ptr< VertexPreprocessing > vertPreproc;
 
+    // to reuse the allocated memory
+    UniqueIDToTlasID tlasMapping;
+
     // Dynamic indices are cleared every frame
     rgl::unordered_set< PrimitiveUniqueID > dynamicUniqueIDs;
     rgl::unordered_set< uint64_t >          alreadyReplacedUniqueObjectIDs;
@@ -144,6 +159,9 @@ private:
     rgl::unordered_set< PrimitiveUniqueID > staticUniqueIDs;
     rgl::string_set                         staticMeshNames;
     std::vector< LightCopy >                staticLights;
+    std::vector< size_t >                   staticSunIndices;
+    // Changed on any modification of staticLights
+    uint64_t                                staticLightsGeneration{ 0 };
     std::optional< uint64_t >               lastDynamicSun_uniqueId{};
 
     std::optional< Camera >       curFrameCamera{};
@@ -25,88 +25,205 @@
 #include "RgException.h"
 #include "Utils.h"
 
-RTGL1::ChunkedStackAllocator::ChunkedStackAllocator( std::shared_ptr< MemoryAllocator >& _allocator,
-                                                     VkBufferUsageFlags                  _usage,
-                                                     VkDeviceSize     _initialChunkSize,
-                                                     VkDeviceSize     _alignment,
-                                                     std::string_view _debugName )
+RTGL1::DeviceSuballocator::DeviceSuballocator( std::shared_ptr< MemoryAllocator >& _allocator,
+                                               VkBufferUsageFlags                  _usage,
+                                               VkDeviceSize     _initialChunkSize,
+                                               VkDeviceSize     _alignment,
+                                               Strategy         _strategy,
+                                               std::string_view _debugName )
     : allocator{ _allocator }
+    , generation{ 0 }
     , usage{ _usage }
     , chunkAllocSize{ Utils::Align( _initialChunkSize, _alignment ) }
     , alignment{ _alignment }
+    , strategy{ _strategy }
     , debugName{ _debugName }
 {
 }
 
-auto RTGL1::ChunkedStackAllocator::Push( VkDeviceSize size ) -> PushResult
+RTGL1::DeviceSuballocator::~DeviceSuballocator()
 {
-    const VkDeviceSize alignedSize = Utils::Align( size, alignment );
+    for( auto& c : chunks )
+    {
+        assert( c->allocationCount == 0 );
+
+        vmaClearVirtualBlock( c->block );
+        vmaDestroyVirtualBlock( c->block );
+    }
+}
 
+auto RTGL1::DeviceSuballocator::Allocate( VkDeviceSize size ) -> Allocation
+{
     // find fitting chunk
     for( auto& c : chunks )
     {
-        if( c.currentOffset + alignedSize < c.buffer.GetSize() )
+        auto result = TryAllocate( *c, size );
+        if( result.IsValid() )
         {
-            const auto result = PushResult{
-                .address        = c.buffer.GetAddress() + c.currentOffset,
-                .buffer         = c.buffer.GetBuffer(),
-                .offsetInBuffer = c.currentOffset,
-            };
-
-            assert( result.offsetInBuffer % alignment == 0 );
-            assert( result.address % alignment == 0 );
-
-            c.currentOffset += alignedSize;
-
             return result;
         }
     }
 
     // couldn't find chunk, create new one
-    return AllocateChunk( alignedSize );
+    if( Chunk* c = AllocateChunk( size ) )
+    {
+        auto result = TryAllocate( *c, size );
+        assert( result.IsValid() );
+
+        return result;
+    }
+
+    assert( 0 );
+    return {};
+}
+
+auto RTGL1::DeviceSuballocator::TryAllocate( Chunk& chunk, VkDeviceSize size ) -> Allocation
+{
+    auto info = VmaVirtualAllocationCreateInfo{
+        .size      = size,
+        .alignment = alignment,
+    };
+
+    VmaVirtualAllocation handle = VK_NULL_HANDLE;
+    VkDeviceSize         offset = 0;
+
+    if( vmaVirtualAllocate( chunk.block, &info, &handle, &offset ) != VK_SUCCESS )
+    {
+        return {};
+    }
+
+    chunk.allocationCount++;
+
+    const auto result = Allocation{
+        .address        = chunk.buffer.GetAddress() + offset,
+        .buffer         = chunk.buffer.GetBuffer(),
+        .offsetInBuffer = offset,
+        .size           = size,
+        .chunk          = &chunk,
+        .handle         = handle,
+        .generation     = generation,
+    };
+
+    assert( result.offsetInBuffer % alignment == 0 );
+    assert( result.address % alignment == 0 );
+
+    return result;
+}
+
+void RTGL1::DeviceSuballocator::Free( Allocation& a )
+{
+    if( a.IsValid() && a.generation == generation )
+    {
+        assert( a.chunk && a.chunk->allocationCount > 0 );
+
+        vmaVirtualFree( a.chunk->block, a.handle );
+        a.chunk->allocationCount--;
+    }
+
+    a = {};
 }
 
-void RTGL1::ChunkedStackAllocator::Reset()
+void RTGL1::DeviceSuballocator::Reset()
 {
     for( auto& c : chunks )
     {
-        c.currentOffset = 0;
+        vmaClearVirtualBlock( c->block );
+        c->allocationCount = 0;
+    }
+
+    generation++;
+}
+
+void RTGL1::DeviceSuballocator::ReleaseEmptyChunks()
+{
+    if( chunks.size() <= 1 )
+    {
+        return;
     }
+
+    for( auto c = chunks.begin() + 1; c != chunks.end(); ++c )
+    {
+        if( ( *c )->allocationCount == 0 )
+        {
+            vmaDestroyVirtualBlock( ( *c )->block );
+            c->reset();
+        }
+    }
+
+    std::erase( chunks, nullptr );
 }
 
-auto RTGL1::ChunkedStackAllocator::AllocateChunk( VkDeviceSize size ) -> PushResult
+auto RTGL1::DeviceSuballocator::AllocateChunk( VkDeviceSize size ) -> Chunk*
 {
     const auto chunkSize = std::max( chunkAllocSize, Utils::Align( size, alignment ) );
 
     if( const auto alloc = allocator.lock() )
     {
-        auto& c = chunks.emplace_back();
-        c.buffer.Init( *alloc,
-                       chunkSize,
-                       VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | usage,
-                       VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-                       debugName.c_str() );
-
-        if( c.buffer.GetAddress() % alignment != 0 )
+        auto c = std::make_unique< Chunk >();
+        c->buffer.Init( *alloc,
+                        chunkSize,
+                        VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | usage,
+                        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                        debugName.c_str(),
+                        alignment );
+
+        if( c->buffer.GetAddress() % alignment != 0 )
         {
             throw RgException( RG_RESULT_ERROR_MEMORY_ALIGNMENT,
                                "Allocated VkBuffer's address was not aligned" );
         }
 
-        const auto result = PushResult{
-            .address        = c.buffer.GetAddress(),
-            .buffer         = c.buffer.GetBuffer(),
-            .offsetInBuffer = 0,
+        auto info = VmaVirtualBlockCreateInfo{
+            .size  = chunkSize,
+            .flags = strategy == Strategy::Linear ? VMA_VIRTUAL_BLOCK_CREATE_LINEAR_ALGORITHM_BIT
+                                                  : VmaVirtualBlockCreateFlags{ 0 },
         };
-        assert( result.address % alignment == 0 );
 
-        // initial offset
-        c.currentOffset = 0;
-        c.currentOffset += Utils::Align( size, alignment );
+        VkResult r = vmaCreateVirtualBlock( &info, &c->block );
+        VK_CHECKERROR( r );
 
-        return result;
+        debug::Verbose( "{}: new chunk of {} MB, total chunks: {}",
+                        debugName,
+                        chunkSize / 1024 / 1024,
+                        chunks.size() + 1 );
+
+        return chunks.emplace_back( std::move( c ) ).get();
     }
 
     assert( 0 );
-    return {};
+    return nullptr;
+}
+
+auto RTGL1::DeviceSuballocator::GetStatistics() const -> Statistics
+{
+    auto result = Statistics{};
+
+    for( const auto& c : chunks )
+    {
+        VmaDetailedStatistics s = {};
+        vmaCalculateVirtualBlockStatistics( c->block, &s );
+
+        result.capacity += s.statistics.blockBytes;
+        result.used += s.statistics.allocationBytes;
+        result.allocationCount += s.statistics.allocationCount;
+        result.freeRangeCount += s.unusedRangeCount;
+        if( s.unusedRangeCount > 0 )
+        {
+            result.largestFreeRange = std::max( result.largestFreeRange, s.unusedRangeSizeMax );
+        }
+        result.chunkCount++;
+    }
+
+    return result;
+}
+
+float RTGL1::DeviceSuballocator::Statistics::Fragmentation() const
+{
+    const VkDeviceSize free = capacity - used;
+    if( free == 0 )
+    {
+        return 0.0f;
+    }
+
+    return 1.0f - float( largestFreeRange ) / float( free );
 }
@@ -20,60 +20,106 @@
 
 #pragma once
 
-#include <list>
+#include <vector>
 
 #include "Buffer.h"
 
 namespace RTGL1
 {
 
-// Each chunk is a buffer that acts like a stack.
-// This class is a list of such chunks.
-// All returned addresses are guaranteed to be valid until reset.
-class ChunkedStackAllocator
+// Device-local memory, sub-allocated with VMA virtual blocks.
+// Each chunk is a buffer with its own virtual block; a new chunk is created,
+// if none of the existing has a free range that fits.
+// Allocations can be freed individually, or all at once with Reset.
+class DeviceSuballocator
 {
 public:
-    explicit ChunkedStackAllocator( std::shared_ptr< MemoryAllocator >& allocator,
-                                    VkBufferUsageFlags                  usage,
-                                    VkDeviceSize                        initialChunkSize,
-                                    VkDeviceSize                        alignment,
-                                    std::string_view                    debugName );
-    ~ChunkedStackAllocator() = default;
-
-    ChunkedStackAllocator( const ChunkedStackAllocator& other )                = delete;
-    ChunkedStackAllocator( ChunkedStackAllocator&& other ) noexcept            = delete;
-    ChunkedStackAllocator& operator=( const ChunkedStackAllocator& other )     = delete;
-    ChunkedStackAllocator& operator=( ChunkedStackAllocator&& other ) noexcept = delete;
-
-    struct PushResult
+    enum class Strategy
     {
-        VkDeviceAddress address;
-        VkBuffer        buffer;
-        VkDeviceSize    offsetInBuffer;
+        // for long-living allocations with arbitrary lifetimes
+        General,
+        // for per-frame allocations that are mostly reset as a whole
+        Linear,
     };
 
-    auto Push( VkDeviceSize size ) -> PushResult;
+private:
+    struct Chunk;
+
+public:
+    explicit DeviceSuballocator( std::shared_ptr< MemoryAllocator >& allocator,
+                                 VkBufferUsageFlags                  usage,
+                                 VkDeviceSize                        initialChunkSize,
+                                 VkDeviceSize                        alignment,
+                                 Strategy                            strategy,
+                                 std::string_view                    debugName );
+    ~DeviceSuballocator();
+
+    DeviceSuballocator( const DeviceSuballocator& other )                = delete;
+    DeviceSuballocator( DeviceSuballocator&& other ) noexcept            = delete;
+    DeviceSuballocator& operator=( const DeviceSuballocator& other )     = delete;
+    DeviceSuballocator& operator=( DeviceSuballocator&& other ) noexcept = delete;
+
+    struct Allocation
+    {
+        VkDeviceAddress      address{ 0 };
+        VkBuffer             buffer{ VK_NULL_HANDLE };
+        VkDeviceSize         offsetInBuffer{ 0 };
+        VkDeviceSize         size{ 0 };
+
+        Chunk*               chunk{ nullptr };
+        VmaVirtualAllocation handle{ VK_NULL_HANDLE };
+        uint64_t             generation{ 0 };
+
+        bool                 IsValid() const { return handle != VK_NULL_HANDLE; }
+    };
+
+    struct Statistics
+    {
+        VkDeviceSize capacity{ 0 };
+        VkDeviceSize used{ 0 };
+        VkDeviceSize largestFreeRange{ 0 };
+        uint32_t     chunkCount{ 0 };
+        uint32_t     allocationCount{ 0 };
+        uint32_t     freeRangeCount{ 0 };
+
+        // 0 - all free space is one range, 1 - free space is scattered
+        float        Fragmentation() const;
+    };
+
+    auto Allocate( VkDeviceSize size ) -> Allocation;
+    // No-op, if allocation was already released by Reset
+    void Free( Allocation& allocation );
+    // Release all allocations, but keep chunks
     void Reset();
+    // Destroy chunks without allocations, except the first one
+    void ReleaseEmptyChunks();
+
+    auto GetStatistics() const -> Statistics;
 
 private:
-    auto AllocateChunk( VkDeviceSize size ) -> PushResult;
+    auto AllocateChunk( VkDeviceSize size ) -> Chunk*;
+    auto TryAllocate( Chunk& chunk, VkDeviceSize size ) -> Allocation;
 
 private:
-    struct ChunkBuffer
+    struct Chunk
     {
-        Buffer       buffer{};
-        VkDeviceSize currentOffset{ 0 };
+        Buffer          buffer{};
+        VmaVirtualBlock block{ VK_NULL_HANDLE };
+        uint32_t        allocationCount{ 0 };
     };
 
-    std::weak_ptr< MemoryAllocator > allocator;
-    std::list< ChunkBuffer >         chunks;
+    std::weak_ptr< MemoryAllocator >        allocator;
+    std::vector< std::unique_ptr< Chunk > > chunks;
+    // to ignore allocations that were made before Reset
+    uint64_t                                generation;
 
     VkBufferUsageFlags usage;
 
     const VkDeviceSize chunkAllocSize;
     const VkDeviceSize alignment;
+    const Strategy     strategy;
 
     std::string debugName;
 };
 
-}
\ No newline at end of file
+}
@@ -70,6 +70,11 @@ def getDependentFoldersProcArg():
     return [a for p in DEPENDENCY_FOLDERS if p != "" for a in ("-I", p)]
 
 
+def getStageDefinesProcArg(filename):
+    # GLSL has no predefined macro for a shader stage
+    return ["-DSHADER_STAGE_FRAGMENT"] if filename.endswith(".frag") else []
+
+
 def abspath(filename):
     return os.path.abspath(filename).replace('\\','/')
 
@@ -243,7 +248,7 @@ def main():
 
             r = subprocess.run([
                 "glslc", "--target-env=vulkan1.2"
-                ] + getDependentFoldersProcArg() + [
+                ] + getDependentFoldersProcArg() + getStageDefinesProcArg(filename) + [
                 filename, 
                 "-o", targetSpvFile], 
                 stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
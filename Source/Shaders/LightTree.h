@@ -0,0 +1,137 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef LIGHT_TREE_H_
+#define LIGHT_TREE_H_
+
+// Light BVH traversal, as in [Conty, Kulla 2018] and pbrt-v4's BVHLightSampler.
+// Tree is built on CPU, see LightTree.cpp
+
+// cos(max(0, a - b))
+float cosSubClamped(float sinA, float cosA, float sinB, float cosB)
+{
+    if (cosA > cosB)
+    {
+        return 1.0;
+    }
+    return cosA * cosB + sinA * sinB;
+}
+
+// sin(max(0, a - b))
+float sinSubClamped(float sinA, float cosA, float sinB, float cosB)
+{
+    if (cosA > cosB)
+    {
+        return 0.0;
+    }
+    return sinA * cosB - cosA * sinB;
+}
+
+float getLightTreeNodeImportance(const ShLightTreeNode node, const vec3 p, const vec3 n)
+{
+    const vec3 center = (node.boundsMin + node.boundsMax) * 0.5;
+    const float radiusSq = dot(node.boundsMax - center, node.boundsMax - center);
+
+    // don't let the importance blow up, if the point is close to the lights
+    const float distSq = max(dot(p - center, p - center), sqrt(radiusSq));
+
+    const vec2 cosThetaOE = unpackHalf2x16(node.cosThetaOE);
+    const float cosTheta_o = cosThetaOE.x;
+    const float cosTheta_e = cosThetaOE.y;
+    const float sinTheta_o = sqrt(max(0.0, 1.0 - cosTheta_o * cosTheta_o));
+
+    const vec3 wi = normalize(p - center);
+
+    const float cosTheta_w = dot(node.coneAxis, wi);
+    const float sinTheta_w = sqrt(max(0.0, 1.0 - cosTheta_w * cosTheta_w));
+
+    // angle subtended by the bounding sphere
+    const float cosTheta_b = distSq > radiusSq ? sqrt(max(0.0, 1.0 - radiusSq / distSq)) : -1.0;
+    const float sinTheta_b = sqrt(max(0.0, 1.0 - cosTheta_b * cosTheta_b));
+
+    // the minimal angle between the emitter normals and the direction to the point
+    const float cosTheta_x = cosSubClamped(sinTheta_w, cosTheta_w, sinTheta_o, cosTheta_o);
+    const float sinTheta_x = sinSubClamped(sinTheta_w, cosTheta_w, sinTheta_o, cosTheta_o);
+    const float cosThetap  = cosSubClamped(sinTheta_x, cosTheta_x, sinTheta_b, cosTheta_b);
+
+    if (cosThetap <= cosTheta_e)
+    {
+        return 0.0;
+    }
+
+    float importance = node.power * cosThetap / distSq;
+
+    // the minimal angle between the surface normal and the direction to the lights
+    const float cosTheta_i = abs(dot(wi, n));
+    const float sinTheta_i = sqrt(max(0.0, 1.0 - cosTheta_i * cosTheta_i));
+    importance *= cosSubClamped(sinTheta_i, cosTheta_i, sinTheta_b, cosTheta_b);
+
+    return max(importance, 0.0);
+}
+
+// Returns LIGHT_INDEX_NONE, if no light contributes to the point
+uint sampleLightTree(const vec3 p, const vec3 n, float rnd, out float pdf)
+{
+    pdf = 1.0;
+    uint nodeIndex = 0;
+
+    for (int depth = 0; depth < LIGHT_TREE_MAX_DEPTH; depth++)
+    {
+        const uint childOrLight = lightTree[nodeIndex].childOrLightIndex;
+
+        if ((childOrLight & LIGHT_TREE_LEAF_FLAG) != 0)
+        {
+            return childOrLight & (LIGHT_TREE_LEAF_FLAG - 1);
+        }
+
+        // first child is right after its parent
+        const uint childA = nodeIndex + 1;
+        const uint childB = childOrLight;
+
+        const float importanceA = getLightTreeNodeImportance(lightTree[childA], p, n);
+        const float importanceB = getLightTreeNodeImportance(lightTree[childB], p, n);
+
+        if (importanceA + importanceB <= 0.0)
+        {
+            break;
+        }
+
+        const float probA = importanceA / (importanceA + importanceB);
+
+        // reuse the random number on each level
+        if (rnd < probA)
+        {
+            nodeIndex = childA;
+            pdf *= probA;
+            rnd = min(rnd / probA, 0.99999994);
+        }
+        else
+        {
+            nodeIndex = childB;
+            pdf *= 1.0 - probA;
+            rnd = min((rnd - probA) / (1.0 - probA), 0.99999994);
+        }
+    }
+
+    pdf = 0.0;
+    return LIGHT_INDEX_NONE;
+}
+
+#endif // LIGHT_TREE_H_
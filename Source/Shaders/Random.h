@@ -258,6 +258,14 @@ float rnd16(uint seed, uint salt)
         float((rnd & 0x0000FFFF)      ) / float(UINT16_MAX + 1);
 }
 
+// Random in [0..1) with 1/16777216 precision, i.e. exact in float
+float rnd24(uint seed, uint salt)
+{
+    uint rnd = wellonsLowBias32(seed + salt);
+    return 
+        float(rnd >> 8) / float(1 << 24);
+}
+
 vec2 rnd16_2(uint seed, uint salt)
 {
     uint rnd = wellonsLowBias32(seed + salt);
@@ -120,6 +120,10 @@ DerivativeSet getTriangleUVDerivativesFromRayCone(
 
 vec4 getTextureSampleDerivU(uint textureIndex, const vec2 texCoord, const float uDeriv)
 {
+    if (isTextureFeedbackEnabled())
+    {
+        writeTextureFeedback(textureIndex, getTextureLodFromGrad(textureIndex, vec2(uDeriv, 0), vec2(0, uDeriv)));
+    }
     return textureGrad(globalTextures[nonuniformEXT(textureIndex)], texCoord, vec2(uDeriv, 0), vec2(0, uDeriv));
 }
 
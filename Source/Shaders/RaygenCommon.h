@@ -54,6 +54,7 @@
 #include "Surface.inl"
 #include "Light.h"
 #include "LightGrid.h"
+#include "LightTree.h"
 #include "Media.h"
 #include "RayCone.h"
 
@@ -432,6 +433,31 @@ Reservoir calcInitialReservoir(uint seed, uint salt, const Surface surf, const v
     }
     else
 #endif // LIGHT_GRID_ENABLED
+    if (globalUniform.lightTreeNodeCount > 0)
+    {
+        for (int i = 0; i < INITIAL_SAMPLES; i++)
+        {
+            // importance sampling by the light tree
+            float treePdf;
+            uint xi = sampleLightTree(surf.position, surf.normal, rnd24(seed, salt++), treePdf);
+            float rndRis = rnd16(seed, salt++);
+
+            if (xi == LIGHT_INDEX_NONE)
+            {
+                // no light contributes, but the sample still must be counted
+                updateReservoir(regularReservoir, LIGHT_INDEX_NONE, 0.0, 0.0, rndRis);
+                continue;
+            }
+
+            float oneOverSourcePdf_xi = safePositiveRcp(treePdf);
+
+            LightSample lightSample = sampleLight(lightSources[xi], surf.position, pointRnd);
+            float targetPdf_xi = targetPdfForLightSample(lightSample, surf);
+
+            updateReservoir(regularReservoir, xi, targetPdf_xi, oneOverSourcePdf_xi, rndRis);
+        }
+    }
+    else
     {      
         for (int i = 0; i < INITIAL_SAMPLES; i++)
         {
@@ -118,14 +118,14 @@ uvec2 packReservoir(const Reservoir r)
     if (!isinf(r.weightSum) && !isnan(r.weightSum))
     {        
         return uvec2(
-            (min(r.M, 65535u) << 16u) | min(r.selected, 65535u),
+            (min(r.M, 255u) << 24u) | min(r.selected, LIGHT_INDEX_NONE),
             packHalf2x16(vec2(r.selected_targetPdf, r.weightSum))
         );
     }
     else
     {
         return uvec2(
-            min(LIGHT_INDEX_NONE, 65535u),
+            LIGHT_INDEX_NONE,
             packHalf2x16(vec2(0, 0))
         );
     }
@@ -134,8 +134,8 @@ uvec2 packReservoir(const Reservoir r)
 Reservoir unpackReservoir(const uvec2 p)
 {
     Reservoir r;
-    r.selected              = (p[0]       ) & 65535u;
-    r.M                     = (p[0] >> 16u) & 65535u;
+    r.selected              = (p[0]       ) & LIGHT_INDEX_NONE;
+    r.M                     = (p[0] >> 24u) & 255u;
     vec2 stws               = unpackHalf2x16( p[ 1 ] );
     {
         r.selected_targetPdf = stws.x;
@@ -68,23 +68,78 @@ layout(
     binding = BINDING_TEXTURES)
     uniform sampler2D globalTextures[];
 
+// Min mip level that was requested for each texture during the frame.
+// Lod is relative to the currently resident image, and biased by
+// TEXTURE_FEEDBACK_LOD_BIAS, to store the levels finer than resident.
+layout(
+    set = DESC_SET_TEXTURES,
+    binding = BINDING_TEXTURE_FEEDBACK)
+    buffer TextureFeedback_BT
+{
+    uint textureFeedback[];
+};
+
 ivec2 getTextureSize(uint textureIndex)
 {
     return textureSize(globalTextures[nonuniformEXT(textureIndex)], 0);
 }
 
+// Feedback is read only if mip streaming is enabled, otherwise don't pay for the lod and atomics
+bool isTextureFeedbackEnabled()
+{
+#ifdef DESC_SET_GLOBAL_UNIFORM
+    return globalUniform.textureFeedbackEnabled != 0;
+#else
+    return false;
+#endif
+}
+
+void writeTextureFeedback(uint textureIndex, float lod)
+{
+    if (!isTextureFeedbackEnabled())
+    {
+        return;
+    }
+
+    uint v = uint(clamp(floor(lod) + TEXTURE_FEEDBACK_LOD_BIAS, 0, 2 * TEXTURE_FEEDBACK_LOD_BIAS));
+
+    // avoid atomics, if a finer level was already requested
+    if (v < textureFeedback[textureIndex])
+    {
+        atomicMin(textureFeedback[textureIndex], v);
+    }
+}
+
+float getTextureLodFromGrad(uint textureIndex, const vec2 dPdx, const vec2 dPdy)
+{
+    const vec2 size = vec2(getTextureSize(textureIndex));
+    return log2(max(max(length(dPdx * size), length(dPdy * size)), 0.000001));
+}
+
 vec4 getTextureSample(uint textureIndex, const vec2 texCoord)
 {
+#ifdef SHADER_STAGE_FRAGMENT
+    // implicit derivatives are only available in fragment shaders
+    if (isTextureFeedbackEnabled())
+    {
+        writeTextureFeedback(textureIndex, textureQueryLod(globalTextures[nonuniformEXT(textureIndex)], texCoord).y);
+    }
+#endif
     return texture(globalTextures[nonuniformEXT(textureIndex)], texCoord);
 }
 
 vec4 getTextureSampleLod(uint textureIndex, const vec2 texCoord, float lod)
 {
+    writeTextureFeedback(textureIndex, lod);
     return textureLod(globalTextures[nonuniformEXT(textureIndex)], texCoord, lod);
 }
 
 vec4 getTextureSampleGrad(uint textureIndex, const vec2 texCoord, const vec2 dPdx, const vec2 dPdy)
 {
+    if (isTextureFeedbackEnabled())
+    {
+        writeTextureFeedback(textureIndex, getTextureLodFromGrad(textureIndex, dPdx, dPdy));
+    }
     return textureGrad(globalTextures[nonuniformEXT(textureIndex)], texCoord, dPdx, dPdy);
 }
 #endif // DESC_SET_TEXTURES
@@ -189,6 +244,11 @@ layout(set = DESC_SET_LIGHT_SOURCES, binding = BINDING_LIGHT_SOURCES_INDEX_CUR_T
     uint lightSources_Index_CurToPrev[];
 };
 
+layout(set = DESC_SET_LIGHT_SOURCES, binding = BINDING_LIGHT_TREE) readonly buffer LightTree_BT
+{
+    ShLightTreeNode lightTree[];
+};
+
 #if LIGHT_GRID_ENABLED
 layout(set = DESC_SET_LIGHT_SOURCES, binding = BINDING_INITIAL_LIGHTS_GRID) 
 #ifndef LIGHT_GRID_WRITE
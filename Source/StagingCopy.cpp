@@ -0,0 +1,201 @@
+/*
+
+Copyright (c) 2024 V.Shirokii
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "StagingCopy.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#if defined( _M_X64 ) || defined( _M_IX86 ) || defined( __SSE2__ )
+    #define RG_STAGING_COPY_SSE2 1
+    #include <emmintrin.h>
+#else
+    #define RG_STAGING_COPY_SSE2 0
+#endif
+
+namespace
+{
+
+constexpr size_t CACHE_LINE_SIZE = 64;
+// to not wake up all workers for copies that are just above the threshold
+constexpr size_t MIN_CHUNK_SIZE = 64 * 1024;
+
+uint8_t* AlignUpPtr( uint8_t* p, size_t alignment )
+{
+    auto v = reinterpret_cast< uintptr_t >( p );
+    return reinterpret_cast< uint8_t* >( ( v + alignment - 1 ) & ~uintptr_t( alignment - 1 ) );
+}
+
+}
+
+void RTGL1::StreamingMemcpy( void* dst, const void* src, size_t size )
+{
+#if RG_STAGING_COPY_SSE2
+    auto d = static_cast< uint8_t* >( dst );
+    auto s = static_cast< const uint8_t* >( src );
+
+    // stream stores require 16-byte aligned destination
+    {
+        size_t head = std::min( size_t( AlignUpPtr( d, 16 ) - d ), size );
+        if( head > 0 )
+        {
+            memcpy( d, s, head );
+            d += head;
+            s += head;
+            size -= head;
+        }
+    }
+
+    // whole cache lines, so write-combining buffers are flushed full
+    while( size >= CACHE_LINE_SIZE )
+    {
+        __m128i a = _mm_loadu_si128( reinterpret_cast< const __m128i* >( s + 0 ) );
+        __m128i b = _mm_loadu_si128( reinterpret_cast< const __m128i* >( s + 16 ) );
+        __m128i c = _mm_loadu_si128( reinterpret_cast< const __m128i* >( s + 32 ) );
+        __m128i e = _mm_loadu_si128( reinterpret_cast< const __m128i* >( s + 48 ) );
+        _mm_stream_si128( reinterpret_cast< __m128i* >( d + 0 ), a );
+        _mm_stream_si128( reinterpret_cast< __m128i* >( d + 16 ), b );
+        _mm_stream_si128( reinterpret_cast< __m128i* >( d + 32 ), c );
+        _mm_stream_si128( reinterpret_cast< __m128i* >( d + 48 ), e );
+        d += CACHE_LINE_SIZE;
+        s += CACHE_LINE_SIZE;
+        size -= CACHE_LINE_SIZE;
+    }
+
+    while( size >= 16 )
+    {
+        _mm_stream_si128( reinterpret_cast< __m128i* >( d ),
+                          _mm_loadu_si128( reinterpret_cast< const __m128i* >( s ) ) );
+        d += 16;
+        s += 16;
+        size -= 16;
+    }
+
+    if( size > 0 )
+    {
+        memcpy( d, s, size );
+    }
+#else
+    memcpy( dst, src, size );
+#endif
+}
+
+void RTGL1::StreamingFence()
+{
+#if RG_STAGING_COPY_SSE2
+    _mm_sfence();
+#else
+    std::atomic_thread_fence( std::memory_order_release );
+#endif
+}
+
+RTGL1::StagingCopier::StagingCopier( std::shared_ptr< JobSystem > _jobSystem,
+                                     uint32_t                     _maxWorkers,
+                                     size_t                       _threshold )
+    : jobs{ std::move( _jobSystem ) }
+    , workerCount{ std::min( _maxWorkers, jobs->GetConcurrency() - 1 ) }
+    , threshold{ std::max< size_t >( _threshold, MIN_CHUNK_SIZE ) }
+{
+}
+
+void RTGL1::StagingCopier::Copy( void* dst, const void* src, size_t size )
+{
+    const Region r = { .dst = dst, .src = src, .size = size };
+    Copy( std::span{ &r, 1 } );
+}
+
+void RTGL1::StagingCopier::Copy( std::span< const Region > regions )
+{
+    const size_t threadCount = size_t{ workerCount } + 1;
+
+    chunks.clear();
+
+    for( const Region& r : regions )
+    {
+        if( r.size == 0 )
+        {
+            continue;
+        }
+
+        if( r.size < threshold )
+        {
+            memcpy( r.dst, r.src, r.size );
+            continue;
+        }
+
+        // split evenly between threads, but chunk boundaries are cache-line aligned
+        // in the destination, so one line is never written by two threads
+        const size_t chunkSize = std::max( MIN_CHUNK_SIZE, r.size / threadCount );
+
+        auto       d    = static_cast< uint8_t* >( r.dst );
+        auto       s    = static_cast< const uint8_t* >( r.src );
+        const auto dEnd = d + r.size;
+
+        while( d < dEnd )
+        {
+            uint8_t* next = AlignUpPtr( d + chunkSize, CACHE_LINE_SIZE );
+            if( next >= dEnd || size_t( dEnd - next ) < CACHE_LINE_SIZE )
+            {
+                next = dEnd;
+            }
+
+            chunks.push_back( Chunk{
+                .dst  = d,
+                .src  = s,
+                .size = size_t( next - d ),
+            } );
+
+            s += next - d;
+            d = next;
+        }
+    }
+
+    if( chunks.empty() )
+    {
+        return;
+    }
+
+    // calling thread also participates
+    const size_t grain = ( chunks.size() + threadCount - 1 ) / threadCount;
+
+    jobs->ParallelFor( chunks.size(), grain, [ this ]( size_t begin, size_t end ) {
+        for( size_t i = begin; i < end; i++ )
+        {
+            StreamingMemcpy( chunks[ i ].dst, chunks[ i ].src, chunks[ i ].size );
+        }
+        // sfence is per-core: must be done by the thread that issued the stores
+        StreamingFence();
+    } );
+}
+
+uint32_t RTGL1::StagingCopier::GetWorkerCount() const
+{
+    return workerCount;
+}
+
+size_t RTGL1::StagingCopier::GetThreshold() const
+{
+    return threshold;
+}
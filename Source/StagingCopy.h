@@ -0,0 +1,92 @@
+/*
+
+Copyright (c) 2024 V.Shirokii
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "JobSystem.h"
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace RTGL1
+{
+
+// Copy that bypasses CPU caches, intended for write-combined HOST_VISIBLE memory
+// that is only written by CPU. Before the data is consumed, the same thread
+// must call StreamingFence to make the non-temporal stores globally visible.
+void StreamingMemcpy( void* dst, const void* src, size_t size );
+void StreamingFence();
+
+
+// Splits large copies into staging memory across the job system's workers.
+// Copies are not required to be thread-safe: only one thread may call Copy at a time.
+class StagingCopier
+{
+public:
+    struct Region
+    {
+        void*       dst;
+        const void* src;
+        size_t      size;
+    };
+
+    // At most 'maxWorkers' threads of the job system help the calling one.
+    // If 0, large regions are still copied with streaming stores, but only on the calling
+    // thread. Regions smaller than 'threshold' bytes are copied with a plain memcpy.
+    explicit StagingCopier( std::shared_ptr< JobSystem > jobSystem,
+                            uint32_t                     maxWorkers,
+                            size_t                       threshold );
+    ~StagingCopier() = default;
+
+    StagingCopier( const StagingCopier& other )                = delete;
+    StagingCopier( StagingCopier&& other ) noexcept            = delete;
+    StagingCopier& operator=( const StagingCopier& other )     = delete;
+    StagingCopier& operator=( StagingCopier&& other ) noexcept = delete;
+
+    // Returns when all the regions were copied and fenced
+    void Copy( std::span< const Region > regions );
+    void Copy( void* dst, const void* src, size_t size );
+
+    [[nodiscard]] uint32_t GetWorkerCount() const;
+    [[nodiscard]] size_t   GetThreshold() const;
+
+private:
+    struct Chunk
+    {
+        uint8_t*       dst;
+        const uint8_t* src;
+        size_t         size;
+    };
+
+private:
+    std::shared_ptr< JobSystem > jobs;
+    uint32_t                     workerCount;
+    size_t                       threshold;
+
+    std::vector< Chunk > chunks;
+};
+
+}
@@ -0,0 +1,172 @@
+/*
+
+Copyright (c) 2024 V.Shirokii
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#include "TextureBatchLoader.h"
+
+#include "TextureDeduplicator.h"
+
+#include <cassert>
+
+namespace
+{
+// a limit, if the files are small, so the other jobs still get the workers
+constexpr size_t MaxItemsPerWorker = 4;
+}
+
+RTGL1::TextureBatchLoader::TextureBatchLoader( std::shared_ptr< JobSystem > _jobSystem,
+                                               LoadFunc                     _loadFunc,
+                                               uint64_t                     _maxBytesInFlight,
+                                               bool                         _preferRaw )
+    : jobs{ std::move( _jobSystem ) }
+    , loadFunc{ std::move( _loadFunc ) }
+    , maxBytesInFlight{ _maxBytesInFlight }
+    , preferRaw{ _preferRaw }
+{
+    assert( jobs );
+}
+
+RTGL1::TextureBatchLoader::~TextureBatchLoader()
+{
+    for( size_t i = taken; i < submitted; i++ )
+    {
+        jobs->Wait( items[ i ]->job );
+    }
+    for( auto& item : items )
+    {
+        if( item )
+        {
+            Free( *item );
+        }
+    }
+}
+
+void RTGL1::TextureBatchLoader::Add( std::span< const std::filesystem::path > fullPaths )
+{
+    assert( fullPaths.size() == TEXTURES_PER_MATERIAL_COUNT );
+    assert( submitted == 0 );
+
+    auto item = std::make_unique< Item >( *jobs );
+    std::ranges::copy( fullPaths, item->paths.begin() );
+
+    items.push_back( std::move( item ) );
+}
+
+auto RTGL1::TextureBatchLoader::Take( size_t index ) -> Textures&
+{
+    assert( index < items.size() );
+    assert( index >= taken );
+
+    // free the previously taken, so the memory can be used by the next loads
+    if( taken > 0 && items[ taken - 1 ] )
+    {
+        Free( *items[ taken - 1 ] );
+        items[ taken - 1 ].reset();
+    }
+    // skipped ones are not needed anymore too, but they must be loaded to be freed
+    for( ; taken < index; taken++ )
+    {
+        if( taken < submitted )
+        {
+            jobs->Wait( items[ taken ]->job );
+        }
+        Free( *items[ taken ] );
+        items[ taken ].reset();
+    }
+
+    SubmitMore( index + 1 );
+
+    Item& item = *items[ index ];
+    jobs->Wait( item.job );
+    taken = index + 1;
+
+    // keep the workers busy while the caller uploads
+    SubmitMore( taken );
+
+    assert( item.textures );
+    return *item.textures;
+}
+
+void RTGL1::TextureBatchLoader::Load( Item& item ) const
+{
+    auto loader = preferRaw ? TextureOverrides::Loader{ std::tuple{ &item.loaderRaw,
+                                                                    &item.loaderKtx } }
+                            : TextureOverrides::Loader{ std::tuple{ &item.loaderKtx,
+                                                                    &item.loaderRaw } };
+
+    item.textures = loadFunc( item.paths, std::move( loader ) );
+
+    uint64_t bytes = 0;
+    for( TextureOverrides& t : *item.textures )
+    {
+        // on a worker, so raw images get their levels here, instead of GPU blits
+        t.GenerateMipmaps();
+
+        if( t.result )
+        {
+            // hash here too, so the frame thread doesn't scan the whole image
+            t.result->contentHash = TextureDeduplicator::HashContents( *t.result );
+            bytes += t.result->dataSize;
+        }
+    }
+    item.loadedBytes = bytes;
+}
+
+void RTGL1::TextureBatchLoader::Free( Item& item )
+{
+    // before the loaders
+    item.textures.reset();
+
+    assert( bytesInFlight >= item.loadedBytes );
+    bytesInFlight -= item.loadedBytes;
+    item.loadedBytes = 0;
+}
+
+void RTGL1::TextureBatchLoader::SubmitMore( size_t required )
+{
+    const size_t maxItemsInFlight = size_t{ jobs->GetConcurrency() } * MaxItemsPerWorker;
+
+    while( submitted < items.size() )
+    {
+        // always submit the required ones, even if over the limits
+        if( submitted >= required )
+        {
+            if( bytesInFlight >= maxBytesInFlight )
+            {
+                break;
+            }
+            if( submitted - taken >= maxItemsInFlight )
+            {
+                break;
+            }
+        }
+
+        Item* pItem = items[ submitted ].get();
+        pItem->job  = jobs->Submit( [ this, pItem ]() {
+            Load( *pItem );
+            bytesInFlight += pItem->loadedBytes;
+        } );
+        submitted++;
+    }
+}
@@ -0,0 +1,102 @@
+/*
+
+Copyright (c) 2024 V.Shirokii
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#pragma once
+
+#include "Const.h"
+#include "ImageLoader.h"
+#include "ImageLoaderDev.h"
+#include "JobSystem.h"
+#include "TextureOverrides.h"
+
+#include <array>
+#include <atomic>
+
+namespace RTGL1
+{
+
+// Loads and decodes the textures of many materials on the job system, e.g. on scene import.
+// Materials are taken in the order they were added, so their uploads are recorded in that order.
+// New loads are not started while more than maxBytesInFlight of loaded data is not taken yet.
+class TextureBatchLoader
+{
+public:
+    using Textures = std::array< TextureOverrides, TEXTURES_PER_MATERIAL_COUNT >;
+    // Called on a worker thread, loader refers to the loaders that are owned by the batch
+    using LoadFunc = std::function< std::unique_ptr< Textures >(
+        std::span< const std::filesystem::path > fullPaths, TextureOverrides::Loader loader ) >;
+
+public:
+    TextureBatchLoader( std::shared_ptr< JobSystem > jobSystem,
+                        LoadFunc                     loadFunc,
+                        uint64_t                     maxBytesInFlight,
+                        bool                         preferRaw );
+    ~TextureBatchLoader();
+
+    TextureBatchLoader( const TextureBatchLoader& other )                = delete;
+    TextureBatchLoader( TextureBatchLoader&& other ) noexcept            = delete;
+    TextureBatchLoader& operator=( const TextureBatchLoader& other )     = delete;
+    TextureBatchLoader& operator=( TextureBatchLoader&& other ) noexcept = delete;
+
+    // Paths are copied. Loading starts on the first Take
+    void   Add( std::span< const std::filesystem::path > fullPaths );
+    size_t GetCount() const { return items.size(); }
+
+    // Wait for the textures of the material, indices must be taken in increasing order.
+    // The textures are valid until the next call, the previous ones are freed
+    auto   Take( size_t index ) -> Textures&;
+
+private:
+    struct Item
+    {
+        explicit Item( JobSystem& jobs ) : loaderKtx{ false, &jobs } {}
+
+        std::array< std::filesystem::path, TEXTURES_PER_MATERIAL_COUNT > paths;
+        // must outlive the textures, as they free the loaded data on destruction;
+        // inflates on the workers, so the render thread only copies to staging
+        ImageLoader                 loaderKtx;
+        ImageLoaderDev              loaderRaw;
+        std::unique_ptr< Textures > textures;
+        uint64_t                    loadedBytes{ 0 };
+        JobSystem::Handle           job;
+    };
+
+    void Load( Item& item ) const;
+    void Free( Item& item );
+    void SubmitMore( size_t required );
+
+private:
+    std::shared_ptr< JobSystem >           jobs;
+    LoadFunc                               loadFunc;
+    uint64_t                               maxBytesInFlight;
+    bool                                   preferRaw;
+    std::vector< std::unique_ptr< Item > > items;
+    size_t                                 submitted{ 0 };
+    size_t                                 taken{ 0 };
+    // of the loaded items that were not freed yet
+    std::atomic< uint64_t >                bytesInFlight{ 0 };
+};
+
+}
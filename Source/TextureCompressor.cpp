@@ -0,0 +1,386 @@
+/*
+
+Copyright (c) 2024 V.Shirokii
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#include "TextureCompressor.h"
+
+#include "BlockCompression.h"
+#include "Const.h"
+#include "DebugPrint.h"
+#include "MipmapGenerator.h"
+#include "Utils.h"
+
+#include "ankerl/unordered_dense.h"
+#include <KHR/khr_df.h>
+
+#include <cassert>
+#include <format>
+#include <fstream>
+#include <optional>
+
+namespace
+{
+
+// change, if the output of the encoders is changed, so the old cache is not used
+constexpr uint64_t ENCODER_VERSION = 1;
+
+// smaller textures are not worth a file
+constexpr uint32_t MIN_SIDE_SIZE = 16;
+
+struct Target
+{
+    VkFormat           format;
+    RTGL1::BlockFormat blockFormat;
+    bool               swapRB;
+    bool               srgb;
+};
+
+auto GetTarget( VkFormat source ) -> std::optional< Target >
+{
+    using RTGL1::BlockFormat;
+
+    switch( source )
+    {
+        case VK_FORMAT_R8G8B8A8_UNORM:
+            return Target{ VK_FORMAT_BC7_UNORM_BLOCK, BlockFormat::BC7, false, false };
+        case VK_FORMAT_R8G8B8A8_SRGB:
+            return Target{ VK_FORMAT_BC7_SRGB_BLOCK, BlockFormat::BC7, false, true };
+        case VK_FORMAT_B8G8R8A8_UNORM:
+            return Target{ VK_FORMAT_BC7_UNORM_BLOCK, BlockFormat::BC7, true, false };
+        case VK_FORMAT_B8G8R8A8_SRGB:
+            return Target{ VK_FORMAT_BC7_SRGB_BLOCK, BlockFormat::BC7, true, true };
+        // there's no sRGB BC4
+        case VK_FORMAT_R8_UNORM:
+            return Target{ VK_FORMAT_BC4_UNORM_BLOCK, BlockFormat::BC4, false, false };
+        default: return std::nullopt;
+    }
+}
+
+uint32_t GetTexelSize( VkFormat source )
+{
+    return source == VK_FORMAT_R8_UNORM ? 1 : 4;
+}
+
+// Data format descriptor with one basic block and one sample that covers the whole block
+auto MakeDFD( const Target& target ) -> std::vector< uint32_t >
+{
+    const uint32_t blockBytes = target.blockFormat == RTGL1::BlockFormat::BC4 ? 8 : 16;
+    const uint32_t model =
+        target.blockFormat == RTGL1::BlockFormat::BC4 ? KHR_DF_MODEL_BC4 : KHR_DF_MODEL_BC7;
+    const uint32_t transfer = target.srgb ? KHR_DF_TRANSFER_SRGB : KHR_DF_TRANSFER_LINEAR;
+
+    constexpr uint32_t blockSize = 24 + 16;
+
+    return {
+        4 + blockSize,
+        KHR_DF_VENDORID_KHRONOS | ( KHR_DF_KHR_DESCRIPTORTYPE_BASICFORMAT << 17 ),
+        KHR_DF_VERSIONNUMBER_1_3 | ( blockSize << 16 ),
+        model | ( KHR_DF_PRIMARIES_BT709 << 8 ) | ( transfer << 16 ) |
+            ( KHR_DF_FLAG_ALPHA_STRAIGHT << 24 ),
+        // 4x4 texels
+        3 | ( 3 << 8 ),
+        blockBytes,
+        0,
+        // sample: bit offset, bit length - 1, channel
+        0 | ( ( blockBytes * 8 - 1 ) << 16 ) | ( 0 << 24 ),
+        0,
+        0,
+        UINT32_MAX,
+    };
+}
+
+struct Ktx2Header
+{
+    uint8_t  identifier[ 12 ];
+    uint32_t vkFormat;
+    uint32_t typeSize;
+    uint32_t pixelWidth;
+    uint32_t pixelHeight;
+    uint32_t pixelDepth;
+    uint32_t layerCount;
+    uint32_t faceCount;
+    uint32_t levelCount;
+    uint32_t supercompressionScheme;
+    uint32_t dfdByteOffset;
+    uint32_t dfdByteLength;
+    uint32_t kvdByteOffset;
+    uint32_t kvdByteLength;
+    uint64_t sgdByteOffset;
+    uint64_t sgdByteLength;
+};
+static_assert( sizeof( Ktx2Header ) == 80 );
+
+struct Ktx2LevelIndex
+{
+    uint64_t byteOffset;
+    uint64_t byteLength;
+    uint64_t uncompressedByteLength;
+};
+static_assert( sizeof( Ktx2LevelIndex ) == 24 );
+
+bool WriteKtx2( const std::filesystem::path&                  path,
+                const Target&                                 target,
+                RgExtent2D                                    baseSize,
+                const std::vector< std::vector< uint8_t > >& levels )
+{
+    const auto     dfd        = MakeDFD( target );
+    const uint32_t levelCount = uint32_t( levels.size() );
+    const size_t   alignment  = target.blockFormat == RTGL1::BlockFormat::BC4 ? 8 : 16;
+
+    auto header = Ktx2Header{
+        .identifier             = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32,
+                                    0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A },
+        .vkFormat               = uint32_t( target.format ),
+        .typeSize               = 1,
+        .pixelWidth             = baseSize.width,
+        .pixelHeight            = baseSize.height,
+        .pixelDepth             = 0,
+        .layerCount             = 0,
+        .faceCount              = 1,
+        .levelCount             = levelCount,
+        .supercompressionScheme = 0,
+        .dfdByteOffset          = uint32_t( sizeof( Ktx2Header ) +
+                                   sizeof( Ktx2LevelIndex ) * levelCount ),
+        .dfdByteLength          = uint32_t( dfd.size() * sizeof( uint32_t ) ),
+        .kvdByteOffset          = 0,
+        .kvdByteLength          = 0,
+        .sgdByteOffset          = 0,
+        .sgdByteLength          = 0,
+    };
+
+    // the smallest level goes first
+    auto   index  = std::vector< Ktx2LevelIndex >( levelCount );
+    size_t offset = header.dfdByteOffset + header.dfdByteLength;
+    for( uint32_t i = levelCount; i-- > 0; )
+    {
+        offset = RTGL1::Utils::Align( offset, alignment );
+
+        index[ i ] = Ktx2LevelIndex{
+            .byteOffset             = offset,
+            .byteLength             = levels[ i ].size(),
+            .uncompressedByteLength = levels[ i ].size(),
+        };
+        offset += levels[ i ].size();
+    }
+
+    auto file = std::ofstream{ path, std::ios::binary | std::ios::trunc };
+    if( !file )
+    {
+        return false;
+    }
+
+    file.write( reinterpret_cast< const char* >( &header ), sizeof( header ) );
+    file.write( reinterpret_cast< const char* >( index.data() ),
+                std::streamsize( index.size() * sizeof( Ktx2LevelIndex ) ) );
+    file.write( reinterpret_cast< const char* >( dfd.data() ), header.dfdByteLength );
+
+    size_t written = header.dfdByteOffset + header.dfdByteLength;
+    for( uint32_t i = levelCount; i-- > 0; )
+    {
+        constexpr char zeros[ 16 ] = {};
+        file.write( zeros, std::streamsize( index[ i ].byteOffset - written ) );
+        file.write( reinterpret_cast< const char* >( levels[ i ].data() ),
+                    std::streamsize( levels[ i ].size() ) );
+
+        written = index[ i ].byteOffset + index[ i ].byteLength;
+    }
+
+    return bool( file );
+}
+
+}
+
+RTGL1::TextureCompressor::TextureCompressor( std::shared_ptr< JobSystem > _jobSystem )
+    : jobs{ std::move( _jobSystem ) }
+{
+}
+
+RTGL1::TextureCompressor::~TextureCompressor()
+{
+    for( auto& item : items )
+    {
+        jobs->Wait( item->job );
+    }
+}
+
+bool RTGL1::TextureCompressor::CanCompress( VkFormat format, RgExtent2D size )
+{
+    return GetTarget( format ).has_value() && size.width >= MIN_SIDE_SIZE &&
+           size.height >= MIN_SIDE_SIZE;
+}
+
+auto RTGL1::TextureCompressor::GetCachePath( const std::filesystem::path& ovrdFolder,
+                                             const Source&                src )
+    -> std::filesystem::path
+{
+    const size_t dataSize =
+        size_t( src.size.width ) * src.size.height * GetTexelSize( src.format );
+
+    uint64_t hash = ankerl::unordered_dense::hash< std::string_view >{}(
+        std::string_view( static_cast< const char* >( src.pixels ), dataSize ) );
+
+    // same pixels, but in a different format must have a different file
+    hash ^= ankerl::unordered_dense::hash< uint64_t >{}( ( uint64_t( src.format ) << 32 ) |
+                                                         ENCODER_VERSION );
+
+    return ovrdFolder / TEXTURES_FOLDER_CACHE /
+           std::format( "{:016x}_{}x{}.ktx2", hash, src.size.width, src.size.height );
+}
+
+void RTGL1::TextureCompressor::Compress( Item& item )
+{
+    const auto target = GetTarget( item.format );
+    if( !target )
+    {
+        assert( 0 );
+        return;
+    }
+
+    auto image = ImageLoader::ResultInfo{
+        .levelOffsets   = { 0 },
+        .levelSizes     = { item.pixels.size() },
+        .levelCount     = 1,
+        .isPregenerated = false,
+        .pData          = item.pixels.data(),
+        .dataSize       = item.pixels.size(),
+        .baseSize       = item.size,
+        .format         = item.format,
+        .pZstdLevels    = nullptr,
+        .contentHash    = 0,
+    };
+
+    auto mipmaps = MipmapGenerator{};
+    mipmaps.Generate( image );
+
+    auto levels = std::vector< std::vector< uint8_t > >( image.levelCount );
+    for( uint32_t i = 0; i < image.levelCount; i++ )
+    {
+        const uint32_t w = std::max( item.size.width >> i, 1u );
+        const uint32_t h = std::max( item.size.height >> i, 1u );
+
+        levels[ i ].resize( GetBlockCompressedSize( target->blockFormat, w, h ) );
+        BlockCompress( target->blockFormat,
+                       image.pData + image.levelOffsets[ i ],
+                       w,
+                       h,
+                       target->swapRB,
+                       levels[ i ].data() );
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories( item.cachePath.parent_path(), ec );
+
+    // other items with the same pixels might write the same file, so write to a unique one
+    const auto tmpPath = std::filesystem::path( item.cachePath )
+                             .replace_extension( std::format( ".{}.tmp", item.slot ) );
+
+    if( !WriteKtx2( tmpPath, *target, item.size, levels ) )
+    {
+        debug::Warning( "Failed to write compressed texture: {}", tmpPath.string() );
+        std::filesystem::remove( tmpPath, ec );
+        return;
+    }
+
+    std::filesystem::rename( tmpPath, item.cachePath, ec );
+    if( ec )
+    {
+        debug::Warning( "Failed to rename {}: {}", tmpPath.string(), ec.message() );
+        std::filesystem::remove( tmpPath, ec );
+        return;
+    }
+
+    item.written = true;
+}
+
+void RTGL1::TextureCompressor::Enqueue( uint32_t              slot,
+                                        uint32_t              generation,
+                                        const Source&         src,
+                                        std::filesystem::path cachePath )
+{
+    const auto data = static_cast< const uint8_t* >( src.pixels );
+    const auto size = size_t( src.size.width ) * src.size.height * GetTexelSize( src.format );
+
+    auto item = std::make_unique< Item >( Item{
+        .slot       = slot,
+        .generation = generation,
+        .cachePath  = std::move( cachePath ),
+        .pixels     = std::vector< uint8_t >( data, data + size ),
+        .size       = src.size,
+        .format     = src.format,
+        .job        = {},
+        .written    = false,
+        .canceled   = false,
+    } );
+
+    // item's address is stable, as it's owned by unique_ptr
+    Item* pItem = item.get();
+    item->job   = jobs->Submit( [ pItem ]() { Compress( *pItem ); } );
+
+    items.push_back( std::move( item ) );
+}
+
+void RTGL1::TextureCompressor::Cancel( uint32_t slot )
+{
+    for( auto& item : items )
+    {
+        if( item->slot == slot && !item->canceled )
+        {
+            item->canceled = true;
+            return;
+        }
+    }
+}
+
+void RTGL1::TextureCompressor::ProcessReady( uint32_t maxCount, const OnReady& onReady )
+{
+    uint32_t count = 0;
+
+    for( auto& item : items )
+    {
+        if( count >= maxCount )
+        {
+            break;
+        }
+
+        if( !item->job->IsDone() )
+        {
+            continue;
+        }
+
+        if( !item->canceled && item->written )
+        {
+            onReady( item->slot, item->generation, item->cachePath );
+            count++;
+        }
+
+        item.reset();
+    }
+
+    std::erase( items, nullptr );
+}
+
+uint32_t RTGL1::TextureCompressor::GetPendingCount() const
+{
+    return static_cast< uint32_t >( items.size() );
+}
@@ -0,0 +1,106 @@
+/*
+
+Copyright (c) 2024 V.Shirokii
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#pragma once
+
+#include "JobSystem.h"
+#include "RTGL1/RTGL1.h"
+
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace RTGL1
+{
+
+// Block-compresses original textures on the job system: RGBA8 to BC7, R8 to BC4.
+// Each result is written as a KTX2 file with a full mip chain to a cache folder,
+// addressed by the hash of the pixel data, so the next launches load it directly.
+// Until compression is done, the uncompressed texture can be used as a placeholder.
+class TextureCompressor
+{
+public:
+    struct Source
+    {
+        const void* pixels;
+        RgExtent2D  size;
+        VkFormat    format;
+    };
+
+    using OnReady = std::function< void(
+        uint32_t slot, uint32_t generation, const std::filesystem::path& cachePath ) >;
+
+public:
+    explicit TextureCompressor( std::shared_ptr< JobSystem > jobSystem );
+    ~TextureCompressor();
+
+    TextureCompressor( const TextureCompressor& other )                = delete;
+    TextureCompressor( TextureCompressor&& other ) noexcept            = delete;
+    TextureCompressor& operator=( const TextureCompressor& other )     = delete;
+    TextureCompressor& operator=( TextureCompressor&& other ) noexcept = delete;
+
+    static bool CanCompress( VkFormat format, RgExtent2D size );
+    // Where the compressed pixels are cached, the file might not exist yet
+    static auto GetCachePath( const std::filesystem::path& ovrdFolder, const Source& src )
+        -> std::filesystem::path;
+
+    // Pixels are copied, so they can be freed right after the call;
+    // generation of the slot is returned to onReady as is, see TextureSlotAllocator
+    void     Enqueue( uint32_t              slot,
+                      uint32_t              generation,
+                      const Source&         src,
+                      std::filesystem::path cachePath );
+    // The slot can be reused immediately, but the file is still written
+    void     Cancel( uint32_t slot );
+
+    // Call onReady for at most maxCount slots, which files were written
+    void     ProcessReady( uint32_t maxCount, const OnReady& onReady );
+
+    uint32_t GetPendingCount() const;
+
+private:
+    struct Item
+    {
+        uint32_t               slot;
+        uint32_t               generation;
+        std::filesystem::path  cachePath;
+        std::vector< uint8_t > pixels;
+        RgExtent2D             size;
+        VkFormat               format;
+        JobSystem::Handle      job;
+        bool                   written;
+        bool                   canceled;
+    };
+
+    static void Compress( Item& item );
+
+private:
+    std::shared_ptr< JobSystem >          jobs;
+    std::deque< std::unique_ptr< Item > > items;
+};
+
+}
@@ -0,0 +1,234 @@
+/*
+
+Copyright (c) 2024 V.Shirokii
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#include "TextureDeduplicator.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <string_view>
+
+namespace
+{
+uint64_t HashBytes( const void* data, size_t size )
+{
+    return ankerl::unordered_dense::hash< std::string_view >{}(
+        std::string_view( static_cast< const char* >( data ), size ) );
+}
+
+uint64_t Combine( uint64_t seed, uint64_t value )
+{
+    return seed ^ ( ankerl::unordered_dense::hash< uint64_t >{}( value ) + 0x9e3779b97f4a7c15ULL +
+                    ( seed << 6 ) + ( seed >> 2 ) );
+}
+
+// Call func for each byte range that HashContents hashes, in the same order
+template< typename Func >
+void ForEachContentRange( const RTGL1::ImageLoader::ResultInfo& info, Func&& func )
+{
+    if( info.pZstdLevels )
+    {
+        for( uint32_t i = 0; i < info.levelCount; i++ )
+        {
+            func( info.pZstdLevels[ i ] );
+        }
+    }
+    else
+    {
+        assert( info.pData );
+        func( std::span< const uint8_t >( info.pData, info.dataSize ) );
+    }
+}
+
+auto CopyContents( const RTGL1::ImageLoader::ResultInfo& info ) -> std::vector< uint8_t >
+{
+    auto dst = std::vector< uint8_t >{};
+    ForEachContentRange( info, [ & ]( std::span< const uint8_t > range ) {
+        dst.insert( dst.end(), range.begin(), range.end() );
+    } );
+    return dst;
+}
+
+bool IsSameContents( std::span< const uint8_t >             contents,
+                     const RTGL1::ImageLoader::ResultInfo& info )
+{
+    size_t offset = 0;
+    bool   same   = true;
+
+    ForEachContentRange( info, [ & ]( std::span< const uint8_t > range ) {
+        if( !same || offset + range.size() > contents.size() ||
+            ( !range.empty() &&
+              std::memcmp( &contents[ offset ], range.data(), range.size() ) != 0 ) )
+        {
+            same = false;
+            return;
+        }
+        offset += range.size();
+    } );
+
+    return same && offset == contents.size();
+}
+}
+
+RTGL1::TextureDeduplicator::~TextureDeduplicator()
+{
+    // all images must be released by the owner
+    assert( imageToKey.empty() );
+}
+
+uint64_t RTGL1::TextureDeduplicator::HashContents( const ImageLoader::ResultInfo& info )
+{
+    // compressed levels of the same file are identical, no need to decompress
+    uint64_t hash = 0;
+    ForEachContentRange( info, [ & ]( std::span< const uint8_t > range ) {
+        hash = Combine( hash, HashBytes( range.data(), range.size() ) );
+    } );
+    return hash;
+}
+
+uint64_t RTGL1::TextureDeduplicator::MakeKey( const ImageLoader::ResultInfo&             info,
+                                              bool                                       useMipmaps,
+                                              const std::optional< RgTextureSwizzling >& swizzling )
+{
+    // if a level slice of an image is uploaded, contentHash is of the whole image,
+    // but the slice is still identified by the size and level count below
+    uint64_t hash = info.contentHash != 0 ? info.contentHash : HashContents( info );
+
+    hash = Combine( hash, ( uint64_t( info.baseSize.width ) << 32 ) | info.baseSize.height );
+    hash = Combine( hash, ( uint64_t( info.format ) << 32 ) | info.levelCount );
+    hash = Combine( hash,
+                    ( uint64_t( info.isPregenerated ) << 2 ) | ( uint64_t( useMipmaps ) << 1 ) |
+                        uint64_t( swizzling.has_value() ) );
+    hash = Combine( hash, swizzling ? uint64_t( *swizzling ) : 0 );
+
+    return hash;
+}
+
+auto RTGL1::TextureDeduplicator::Acquire( uint64_t key, const ImageLoader::ResultInfo& info )
+    -> std::optional< Shared >
+{
+    auto found = entries.find( key );
+    if( found == entries.end() )
+    {
+        return std::nullopt;
+    }
+
+    Entry& e = found->second;
+
+    if( e.format != info.format || e.size.width != info.baseSize.width ||
+        e.size.height != info.baseSize.height || e.dataSize != info.dataSize )
+    {
+        return std::nullopt;
+    }
+
+    // a 64-bit hash match is not enough to alias the images
+    if( !IsSameContents( e.contents, info ) )
+    {
+        return std::nullopt;
+    }
+
+    e.refCount++;
+    savedBytes += e.dataSize;
+
+    return e.shared;
+}
+
+void RTGL1::TextureDeduplicator::Add( uint64_t                       key,
+                                      const ImageLoader::ResultInfo& info,
+                                      VkImage                        image,
+                                      VkImageView                    view )
+{
+    assert( image != VK_NULL_HANDLE && view != VK_NULL_HANDLE );
+
+    // on a hash collision, keep the first image shared, the new one is unique
+    auto [ iter, isNew ] = entries.try_emplace( key,
+                                                Entry{
+                                                    .shared   = { image, view },
+                                                    .refCount = 1,
+                                                    .format   = info.format,
+                                                    .size     = info.baseSize,
+                                                    .dataSize = info.dataSize,
+                                                    .contents = {},
+                                                } );
+    if( isNew )
+    {
+        iter->second.contents = CopyContents( info );
+        imageToKey[ image ]   = key;
+    }
+}
+
+bool RTGL1::TextureDeduplicator::Release( VkImage image )
+{
+    auto found = imageToKey.find( image );
+    if( found == imageToKey.end() )
+    {
+        return true;
+    }
+
+    auto entry = entries.find( found->second );
+    assert( entry != entries.end() && entry->second.shared.image == image );
+
+    Entry& e = entry->second;
+    assert( e.refCount > 0 );
+
+    if( --e.refCount > 0 )
+    {
+        assert( savedBytes >= e.dataSize );
+        savedBytes -= e.dataSize;
+        return false;
+    }
+
+    entries.erase( entry );
+    imageToKey.erase( found );
+    return true;
+}
+
+void RTGL1::TextureDeduplicator::BindSlot( VkImage image, uint32_t slot )
+{
+    assert( image != VK_NULL_HANDLE );
+    imageSlots.emplace( image, slot );
+}
+
+void RTGL1::TextureDeduplicator::UnbindSlot( VkImage image, uint32_t slot )
+{
+    auto [ begin, end ] = imageSlots.equal_range( image );
+
+    auto found =
+        std::find_if( begin, end, [ slot ]( const auto& kv ) { return kv.second == slot; } );
+    if( found != end )
+    {
+        imageSlots.erase( found );
+    }
+}
+
+uint32_t RTGL1::TextureDeduplicator::GetSharedImageCount() const
+{
+    uint32_t count = 0;
+    for( const auto& [ key, e ] : entries )
+    {
+        count += e.refCount > 1 ? 1 : 0;
+    }
+    return count;
+}
@@ -0,0 +1,116 @@
+/*
+
+Copyright (c) 2024 V.Shirokii
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#pragma once
+
+#include "Common.h"
+#include "Containers.h"
+#include "ImageLoader.h"
+
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace RTGL1
+{
+
+// Shares one image among the textures with identical contents, e.g. the same pixels
+// that a game provides under different names. Images are found by a hash of the pixel
+// data (or of the compressed levels), and are destroyed when the last reference is released.
+// On a hash match, the contents are compared byte by byte, so a copy of them is kept
+// for each shared image.
+// Only an image and its view are shared, so each texture still has its own slot and sampler.
+class TextureDeduplicator
+{
+public:
+    struct Shared
+    {
+        VkImage     image;
+        VkImageView view;
+    };
+
+public:
+    TextureDeduplicator() = default;
+    ~TextureDeduplicator();
+
+    TextureDeduplicator( const TextureDeduplicator& other )                = delete;
+    TextureDeduplicator( TextureDeduplicator&& other ) noexcept            = delete;
+    TextureDeduplicator& operator=( const TextureDeduplicator& other )     = delete;
+    TextureDeduplicator& operator=( TextureDeduplicator&& other ) noexcept = delete;
+
+    // Hash of the pixel data, or of the compressed levels. Thread-safe,
+    // so loader threads store it in ResultInfo::contentHash to not hash on the frame thread
+    static uint64_t HashContents( const ImageLoader::ResultInfo& info );
+    // Swizzling is baked into the image view, so it's a part of the key.
+    // Uses info.contentHash, if it was computed
+    static uint64_t MakeKey( const ImageLoader::ResultInfo&             info,
+                             bool                                       useMipmaps,
+                             const std::optional< RgTextureSwizzling >& swizzling );
+
+    // If found, and the contents are the same, the image gets one more reference
+    auto Acquire( uint64_t key, const ImageLoader::ResultInfo& info ) -> std::optional< Shared >;
+    // Register a newly created image with one reference
+    void Add( uint64_t key, const ImageLoader::ResultInfo& info, VkImage image, VkImageView view );
+    // Returns true, if there are no references left, and the image must be destroyed.
+    // Images that were not added are not shared, so true is returned for them
+    bool Release( VkImage image );
+
+    // Slots that show an image, shared or not, to bind them when its upload is finished
+    void BindSlot( VkImage image, uint32_t slot );
+    void UnbindSlot( VkImage image, uint32_t slot );
+    template< typename Func >
+    void ForEachSlot( VkImage image, Func&& func ) const
+    {
+        auto [ begin, end ] = imageSlots.equal_range( image );
+        for( auto it = begin; it != end; ++it )
+        {
+            func( it->second );
+        }
+    }
+
+    // Bytes that would have been uploaded, if there was no sharing
+    uint64_t GetSavedBytes() const { return savedBytes; }
+    uint32_t GetSharedImageCount() const;
+
+private:
+    struct Entry
+    {
+        Shared                 shared;
+        uint32_t               refCount;
+        // to reject the hash collisions
+        VkFormat               format;
+        RgExtent2D             size;
+        size_t                 dataSize;
+        // the bytes that were hashed, to compare on a hash match
+        std::vector< uint8_t > contents;
+    };
+
+    rgl::unordered_map< uint64_t, Entry >        entries;
+    rgl::unordered_map< VkImage, uint64_t >      imageToKey;
+    std::unordered_multimap< VkImage, uint32_t > imageSlots;
+    uint64_t                                     savedBytes{ 0 };
+};
+
+}
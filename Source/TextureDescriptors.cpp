@@ -21,31 +21,40 @@
 #include "TextureDescriptors.h"
 #include "Const.h"
 
+#include <algorithm>
+#include <bit>
+
 using namespace RTGL1;
 
 TextureDescriptors::TextureDescriptors( VkDevice                          _device,
                                         std::shared_ptr< SamplerManager > _samplerManager,
                                         uint32_t                          _maxTextureCount,
-                                        uint32_t                          _bindingIndex )
+                                        uint32_t                          _bindingIndex,
+                                        VkBuffer                          _feedbackBuffer,
+                                        uint32_t                          _feedbackBindingIndex )
     : device( _device )
     , samplerManager( std::move( _samplerManager ) )
     , bindingIndex( _bindingIndex )
+    , feedbackBindingIndex( _feedbackBindingIndex )
     , descPool( VK_NULL_HANDLE )
     , descLayout( VK_NULL_HANDLE )
     , descSets{}
     , emptyTextureImageView( VK_NULL_HANDLE )
     , emptyTextureImageLayout( VK_IMAGE_LAYOUT_UNDEFINED )
-    , currentWriteCount( 0 )
 {
     writeImageInfos.resize( _maxTextureCount );
     writeInfos.resize( _maxTextureCount );
 
-    for( uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++ )
+    entries.resize( _maxTextureCount, Entry{ VK_NULL_HANDLE, SamplerManager::Handle() } );
+    for( auto& d : dirty )
     {
-        writeCache[ i ].resize( _maxTextureCount );
+        d.resize( ( _maxTextureCount + 63 ) / 64, 0 );
     }
 
-    CreateDescriptors( _maxTextureCount );
+    CreateDescriptors( _maxTextureCount, _feedbackBuffer );
+
+    // all elements must be written before the first use
+    MarkAllDirty();
 }
 
 TextureDescriptors::~TextureDescriptors()
@@ -70,20 +79,30 @@ void TextureDescriptors::SetEmptyTextureInfo( VkImageView view )
     emptyTextureImageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 }
 
-void TextureDescriptors::CreateDescriptors( uint32_t maxTextureCount )
+void TextureDescriptors::CreateDescriptors( uint32_t maxTextureCount, VkBuffer feedbackBuffer )
 {
+    const bool withFeedback = feedbackBuffer != VK_NULL_HANDLE;
+
     {
-        VkDescriptorSetLayoutBinding binding = {
-            .binding         = bindingIndex,
-            .descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-            .descriptorCount = maxTextureCount,
-            .stageFlags      = VK_SHADER_STAGE_ALL,
+        VkDescriptorSetLayoutBinding bindings[] = {
+            {
+                .binding         = bindingIndex,
+                .descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                .descriptorCount = maxTextureCount,
+                .stageFlags      = VK_SHADER_STAGE_ALL,
+            },
+            {
+                .binding         = feedbackBindingIndex,
+                .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .descriptorCount = 1,
+                .stageFlags      = VK_SHADER_STAGE_ALL,
+            },
         };
 
         VkDescriptorSetLayoutCreateInfo layoutInfo = {
             .sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
-            .bindingCount = 1,
-            .pBindings    = &binding,
+            .bindingCount = withFeedback ? 2u : 1u,
+            .pBindings    = bindings,
         };
 
         VkResult r = vkCreateDescriptorSetLayout( device, &layoutInfo, nullptr, &descLayout );
@@ -94,16 +113,22 @@ void TextureDescriptors::CreateDescriptors( uint32_t maxTextureCount )
     }
 
     {
-        VkDescriptorPoolSize poolSize = {
-            .type            = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-            .descriptorCount = maxTextureCount * MAX_FRAMES_IN_FLIGHT,
+        VkDescriptorPoolSize poolSizes[] = {
+            {
+                .type            = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                .descriptorCount = maxTextureCount * MAX_FRAMES_IN_FLIGHT,
+            },
+            {
+                .type            = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .descriptorCount = MAX_FRAMES_IN_FLIGHT,
+            },
         };
 
         VkDescriptorPoolCreateInfo poolInfo = {
             .sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
             .maxSets       = MAX_FRAMES_IN_FLIGHT,
-            .poolSizeCount = 1,
-            .pPoolSizes    = &poolSize,
+            .poolSizeCount = withFeedback ? 2u : 1u,
+            .pPoolSizes    = poolSizes,
         };
 
         VkResult r = vkCreateDescriptorPool( device, &poolInfo, nullptr, &descPool );
@@ -128,82 +153,92 @@ void TextureDescriptors::CreateDescriptors( uint32_t maxTextureCount )
                 device, descSets[ i ], VK_OBJECT_TYPE_DESCRIPTOR_SET, "Textures desc set" );
         }
     }
-}
 
-bool TextureDescriptors::IsCached( uint32_t               frameIndex,
-                                   uint32_t               textureIndex,
-                                   VkImageView            view,
-                                   SamplerManager::Handle samplerHandle )
-{
-    return writeCache[ frameIndex ][ textureIndex ].view == view &&
-           writeCache[ frameIndex ][ textureIndex ].samplerHandle == samplerHandle;
-}
+    // feedback buffer is the same for all frames, it's written only once
+    if( withFeedback )
+    {
+        VkDescriptorBufferInfo bufInfo = {
+            .buffer = feedbackBuffer,
+            .offset = 0,
+            .range  = VK_WHOLE_SIZE,
+        };
 
-void TextureDescriptors::AddToCache( uint32_t               frameIndex,
-                                     uint32_t               textureIndex,
-                                     VkImageView            view,
-                                     SamplerManager::Handle samplerHandle )
-{
-    writeCache[ frameIndex ][ textureIndex ].view          = view;
-    writeCache[ frameIndex ][ textureIndex ].samplerHandle = samplerHandle;
+        VkWriteDescriptorSet writes[ MAX_FRAMES_IN_FLIGHT ];
+        for( uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++ )
+        {
+            writes[ i ] = VkWriteDescriptorSet{
+                .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet          = descSets[ i ],
+                .dstBinding      = feedbackBindingIndex,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .pBufferInfo     = &bufInfo,
+            };
+        }
+        vkUpdateDescriptorSets( device, MAX_FRAMES_IN_FLIGHT, writes, 0, nullptr );
+    }
 }
 
-void TextureDescriptors::ResetCache( uint32_t frameIndex, uint32_t textureIndex )
+void TextureDescriptors::MarkDirty( uint32_t textureIndex )
 {
-    writeCache[ frameIndex ][ textureIndex ] = { VK_NULL_HANDLE, SamplerManager::Handle() };
+    for( auto& d : dirty )
+    {
+        d[ textureIndex / 64 ] |= uint64_t{ 1 } << ( textureIndex % 64 );
+    }
 }
 
-void RTGL1::TextureDescriptors::ResetAllCache( uint32_t frameIndex )
+void TextureDescriptors::MarkAllDirty()
 {
-    for( uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++ )
+    const auto count = static_cast< uint32_t >( entries.size() );
+
+    for( auto& d : dirty )
     {
-        for( auto& f : writeCache[ i ] )
+        std::ranges::fill( d, ~uint64_t{ 0 } );
+
+        // clear the bits after the last texture
+        if( count % 64 != 0 )
         {
-            f.view          = VK_NULL_HANDLE;
-            f.samplerHandle = SamplerManager::Handle();
+            d.back() = ( uint64_t{ 1 } << ( count % 64 ) ) - 1;
         }
     }
 }
 
-void TextureDescriptors::UpdateTextureDesc( uint32_t               frameIndex,
-                                            uint32_t               textureIndex,
-                                            VkImageView            view,
-                                            SamplerManager::Handle samplerHandle )
+void TextureDescriptors::SetTexture( uint32_t               textureIndex,
+                                     VkImageView            view,
+                                     SamplerManager::Handle samplerHandle )
 {
     assert( view != VK_NULL_HANDLE );
+    assert( textureIndex < entries.size() );
+
+    Entry& e = entries[ textureIndex ];
 
-    if( currentWriteCount >= writeInfos.size() )
+    // don't update if already is set to given parameters
+    if( e.view == view && e.samplerHandle == samplerHandle )
     {
-        assert( 0 );
         return;
     }
 
-    // don't update if already is set to given parameters
-    if( IsCached( frameIndex, textureIndex, view, samplerHandle ) )
+    e = Entry{ view, samplerHandle };
+    MarkDirty( textureIndex );
+}
+
+void TextureDescriptors::ResetTexture( uint32_t textureIndex )
+{
+    assert( textureIndex < entries.size() );
+
+    Entry& e = entries[ textureIndex ];
+
+    if( e.view == VK_NULL_HANDLE )
     {
         return;
     }
 
-    writeImageInfos[ currentWriteCount ] = VkDescriptorImageInfo{
-        .sampler     = samplerManager->GetSampler( samplerHandle ),
-        .imageView   = view,
-        .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-    };
-    writeInfos[ currentWriteCount ] = VkWriteDescriptorSet{
-        .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-        .dstSet          = descSets[ frameIndex ],
-        .dstBinding      = bindingIndex,
-        .dstArrayElement = textureIndex,
-        .descriptorCount = 1,
-        .descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-        .pImageInfo      = &writeImageInfos[ currentWriteCount ],
-    };
-    currentWriteCount++;
-
-    AddToCache( frameIndex, textureIndex, view, samplerHandle );
+    e = Entry{ VK_NULL_HANDLE, SamplerManager::Handle() };
+    MarkDirty( textureIndex );
 }
 
-void TextureDescriptors::ResetTextureDesc( uint32_t frameIndex, uint32_t textureIndex )
+void TextureDescriptors::FlushDescWrites( uint32_t frameIndex )
 {
     assert( emptyTextureImageView != VK_NULL_HANDLE &&
             emptyTextureImageLayout != VK_IMAGE_LAYOUT_UNDEFINED );
@@ -212,12 +247,62 @@ void TextureDescriptors::ResetTextureDesc( uint32_t frameIndex, uint32_t texture
                                                             RG_SAMPLER_ADDRESS_MODE_REPEAT,
                                                             RG_SAMPLER_ADDRESS_MODE_REPEAT };
 
-    // try to update with empty data
-    UpdateTextureDesc( frameIndex, textureIndex, emptyTextureImageView, nullSampler );
-}
+    uint32_t imageInfoCount = 0;
+    uint32_t writeCount     = 0;
 
-void TextureDescriptors::FlushDescWrites()
-{
-    vkUpdateDescriptorSets( device, currentWriteCount, writeInfos.data(), 0, nullptr );
-    currentWriteCount = 0;
+    auto& frameDirty = dirty[ frameIndex ];
+
+    for( uint32_t w = 0; w < frameDirty.size(); w++ )
+    {
+        uint64_t bits = frameDirty[ w ];
+        frameDirty[ w ] = 0;
+
+        while( bits != 0 )
+        {
+            const uint32_t textureIndex = w * 64 + std::countr_zero( bits );
+            bits &= bits - 1;
+
+            const Entry& e       = entries[ textureIndex ];
+            const bool   isEmpty = e.view == VK_NULL_HANDLE;
+
+            const SamplerManager::Handle& sampler = isEmpty ? nullSampler : e.samplerHandle;
+
+            writeImageInfos[ imageInfoCount ] = VkDescriptorImageInfo{
+                .sampler     = samplerManager->GetSampler( sampler ),
+                .imageView   = isEmpty ? emptyTextureImageView : e.view,
+                .imageLayout = isEmpty ? emptyTextureImageLayout
+                                       : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            };
+
+            // append to the previous write, if the array elements are contiguous
+            if( writeCount > 0 )
+            {
+                VkWriteDescriptorSet& prev = writeInfos[ writeCount - 1 ];
+
+                if( prev.dstArrayElement + prev.descriptorCount == textureIndex )
+                {
+                    prev.descriptorCount++;
+                    imageInfoCount++;
+                    continue;
+                }
+            }
+
+            writeInfos[ writeCount ] = VkWriteDescriptorSet{
+                .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet          = descSets[ frameIndex ],
+                .dstBinding      = bindingIndex,
+                .dstArrayElement = textureIndex,
+                .descriptorCount = 1,
+                .descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                .pImageInfo      = &writeImageInfos[ imageInfoCount ],
+            };
+            writeCount++;
+            imageInfoCount++;
+        }
+    }
+
+    if( writeCount > 0 )
+    {
+        vkUpdateDescriptorSets( device, writeCount, writeInfos.data(), 0, nullptr );
+    }
 }
@@ -34,7 +34,9 @@ public:
     explicit TextureDescriptors( VkDevice                          device,
                                  std::shared_ptr< SamplerManager > samplerManager,
                                  uint32_t                          maxTextureCount,
-                                 uint32_t                          bindingIndex );
+                                 uint32_t                          bindingIndex,
+                                 VkBuffer                          feedbackBuffer = VK_NULL_HANDLE,
+                                 uint32_t                          feedbackBindingIndex = 0 );
     ~TextureDescriptors();
 
     TextureDescriptors( const TextureDescriptors& other )     = delete;
@@ -42,39 +44,34 @@ public:
     TextureDescriptors&   operator=( const TextureDescriptors& other ) = delete;
     TextureDescriptors&   operator=( TextureDescriptors&& other ) noexcept = delete;
 
-    void                  UpdateTextureDesc( uint32_t               frameIndex,
-                                             uint32_t               textureIndex,
-                                             VkImageView            view,
-                                             SamplerManager::Handle samplerHandle );
-    void                  ResetTextureDesc( uint32_t frameIndex, uint32_t textureIndex );
-    void                  ResetAllCache( uint32_t frameIndex );
+    // If the texture is different from the current one at the index,
+    // it's written to the desc set of each frame on its next flush
+    void                  SetTexture( uint32_t               textureIndex,
+                                      VkImageView            view,
+                                      SamplerManager::Handle samplerHandle );
+    // Use the empty texture at the index
+    void                  ResetTexture( uint32_t textureIndex );
+    // Rewrite all textures, e.g. if samplers were changed
+    void                  MarkAllDirty();
 
-    // Must be called after a series of UpdateTextureDesc and
-    // ResetTextureDesc to make an actual desc write
-    void                  FlushDescWrites();
+    // Write the textures that were changed since the last flush of this frame's desc set,
+    // contiguous indices are merged into one write
+    void                  FlushDescWrites( uint32_t frameIndex );
 
     VkDescriptorSet       GetDescSet( uint32_t frameIndex ) const;
     VkDescriptorSetLayout GetDescSetLayout() const;
 
-    // Set texture info that should be used in ResetTextureDesc(..)
+    // Set texture info that should be used for ResetTexture(..)
     void                  SetEmptyTextureInfo( VkImageView view );
 
 private:
-    void CreateDescriptors( uint32_t maxTextureCount );
-
-    bool IsCached( uint32_t               frameIndex,
-                   uint32_t               textureIndex,
-                   VkImageView            view,
-                   SamplerManager::Handle samplerHandle );
-    void AddToCache( uint32_t               frameIndex,
-                     uint32_t               textureIndex,
-                     VkImageView            view,
-                     SamplerManager::Handle samplerHandle );
-    void ResetCache( uint32_t frameIndex, uint32_t textureIndex );
+    void CreateDescriptors( uint32_t maxTextureCount, VkBuffer feedbackBuffer );
+    void MarkDirty( uint32_t textureIndex );
 
 private:
-    struct UpdatedDescCache
+    struct Entry
     {
+        // null, if empty texture
         VkImageView            view;
         SamplerManager::Handle samplerHandle;
     };
@@ -84,6 +81,7 @@ private:
     std::shared_ptr< SamplerManager >    samplerManager;
 
     uint32_t                             bindingIndex;
+    uint32_t                             feedbackBindingIndex;
 
     VkDescriptorPool                     descPool;
     VkDescriptorSetLayout                descLayout;
@@ -92,11 +90,12 @@ private:
     VkImageView                          emptyTextureImageView;
     VkImageLayout                        emptyTextureImageLayout;
 
-    uint32_t                             currentWriteCount;
     std::vector< VkDescriptorImageInfo > writeImageInfos;
     std::vector< VkWriteDescriptorSet >  writeInfos;
 
-    std::vector< UpdatedDescCache >      writeCache[ MAX_FRAMES_IN_FLIGHT ];
+    std::vector< Entry >                 entries;
+    // a bit per texture, if it must be written to the desc set of the frame
+    std::vector< uint64_t >              dirty[ MAX_FRAMES_IN_FLIGHT ];
 };
 
 }
\ No newline at end of file
@@ -23,6 +23,7 @@
 
 #include "Stb/stb_image_write.h"
 
+#include <algorithm>
 #include <span>
 
 namespace
@@ -92,17 +93,53 @@ bool RTGL1::TextureExporter::WriteTGA( std::filesystem::path filepath,
     return true;
 }
 
-bool RTGL1::TextureExporter::ExportAsTGA( MemoryAllocator&             allocator,
-                                          CommandBufferManager&        cmdManager,
-                                          VkImage                      srcImage,
-                                          RgExtent2D                   srcImageSize,
-                                          VkFormat                     srcImageFormat,
-                                          const std::filesystem::path& filepath,
-                                          bool                         exportAsSRGB,
-                                          bool                         overwriteFiles )
+RTGL1::TextureExporter::TextureExporter( std::shared_ptr< MemoryAllocator > _allocator,
+                                         std::shared_ptr< JobSystem >       _jobSystem,
+                                         VkDeviceSize                       _readbackRingSize )
+    : allocator{ std::move( _allocator ) }, jobs{ std::move( _jobSystem ) }
 {
-    VkDevice device = allocator.GetDevice();
+    const VkDeviceSize ringSize = std::max< VkDeviceSize >( _readbackRingSize, DstBytesPerPixel );
+
+    ringBuffer.Init( *allocator,
+                     ringSize,
+                     VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                     VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                     "Export readback ring" );
+    ringMapped = static_cast< const uint8_t* >( ringBuffer.Map() );
+    ring.emplace( ringSize );
+}
+
+RTGL1::TextureExporter::~TextureExporter()
+{
+    if( !queued.empty() )
+    {
+        debug::Warning( "{} textures were not exported, as they were not recorded",
+                        queued.size() );
+    }
+
+    // device is idle, so all recorded readbacks are complete
+    for( Readback& r : recorded )
+    {
+        Resolve( r );
+    }
+    recorded.clear();
 
+    if( jobs )
+    {
+        jobs->Wait( writes );
+    }
+
+    ringBuffer.TryUnmap();
+    ringBuffer.Destroy();
+}
+
+bool RTGL1::TextureExporter::Enqueue( VkImage                      srcImage,
+                                      RgExtent2D                   srcImageSize,
+                                      VkFormat                     srcImageFormat,
+                                      const std::filesystem::path& filepath,
+                                      bool                         exportAsSRGB,
+                                      bool                         overwriteFiles )
+{
     const VkFormat dstImageFormat =
         exportAsSRGB ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
 
@@ -114,370 +151,344 @@ bool RTGL1::TextureExporter::ExportAsTGA( MemoryAllocator&             allocator
         default: return false;
     }
 
-    if( !CheckSupport( allocator.GetPhysicalDevice(), srcImageFormat, dstImageFormat ) )
+    if( !CheckSupport( allocator->GetPhysicalDevice(), srcImageFormat, dstImageFormat ) )
     {
         return false;
     }
 
-    vkDeviceWaitIdle( device );
-    VkCommandBuffer cmd = cmdManager.StartGraphicsCmd();
-
-    constexpr VkImageLayout srcImageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    queued.push_back( Request{
+        .srcImage  = srcImage,
+        .size      = srcImageSize,
+        .srcFormat = srcImageFormat,
+        .dstFormat = dstImageFormat,
+        .filepath  = filepath,
+    } );
+    return true;
+}
 
-    const VkImageSubresourceRange subresRange = {
-        .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
-        .baseMipLevel   = 0,
-        .levelCount     = 1,
-        .baseArrayLayer = 0,
-        .layerCount     = 1,
-    };
-    const VkImageSubresource subres = {
-        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-        .mipLevel   = 0,
-        .arrayLayer = 0,
+void RTGL1::TextureExporter::CreateRGBAImage( Readback& r, VkFormat format ) const
+{
+    VkDevice device = allocator->GetDevice();
+
+    VkImageCreateInfo info = {
+        .sType                 = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+        .pNext                 = nullptr,
+        .flags                 = 0,
+        .imageType             = VK_IMAGE_TYPE_2D,
+        .format                = format,
+        .extent                = { r.size.width, r.size.height, 1 },
+        .mipLevels             = 1,
+        .arrayLayers           = 1,
+        .samples               = VK_SAMPLE_COUNT_1_BIT,
+        .tiling                = VK_IMAGE_TILING_OPTIMAL,
+        .usage                 = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+        .sharingMode           = VK_SHARING_MODE_EXCLUSIVE,
+        .queueFamilyIndexCount = 0,
+        .pQueueFamilyIndices   = nullptr,
+        .initialLayout         = VK_IMAGE_LAYOUT_UNDEFINED,
     };
 
-    // Can't vkCmdBlit into a linear tiling directly
-    // Can't vkCmdCopy directly from a compressed format (diff block extents with rgba8)
-    // 1. Blit from compressed to optimal rgba8
-    // 2. Copy from optimal rgba8 to linear rgba8
+    VkResult res = vkCreateImage( device, &info, nullptr, &r.rgbaImage );
+    VK_CHECKERROR( res );
+    SET_DEBUG_NAME( device, r.rgbaImage, VK_OBJECT_TYPE_IMAGE, "Export dst image (optimal)" );
+
+    VkMemoryRequirements memReqs = {};
+    vkGetImageMemoryRequirements( device, r.rgbaImage, &memReqs );
+
+    r.rgbaMemory = allocator->AllocDedicated( memReqs,
+                                              VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                              MemoryAllocator::AllocType::DEFAULT,
+                                              "Export dst image (optimal)" );
 
-    VkImage dstImage_Optimal = VK_NULL_HANDLE;
-    VkImage dstImage_Linear  = VK_NULL_HANDLE;
+    res = vkBindImageMemory( device, r.rgbaImage, r.rgbaMemory, 0 );
+    VK_CHECKERROR( res );
+}
+
+void RTGL1::TextureExporter::Record( VkCommandBuffer cmd, uint32_t frameIndex )
+{
+    // the readbacks of this frame index are the oldest, and their fence was waited
+    while( !recorded.empty() && recorded.front().frameIndex == frameIndex )
     {
-        VkImageCreateInfo info = {
-            .sType       = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
-            .pNext       = nullptr,
-            .flags       = 0,
-            .imageType   = VK_IMAGE_TYPE_2D,
-            .format      = dstImageFormat,
-            .extent      = { srcImageSize.width, srcImageSize.height, 1 },
-            .mipLevels   = 1,
-            .arrayLayers = 1,
-            .samples     = VK_SAMPLE_COUNT_1_BIT,
-            .tiling      = VK_IMAGE_TILING_OPTIMAL, /* optimal */
-            .usage =
-                VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, /* dst + src */
-            .sharingMode           = VK_SHARING_MODE_EXCLUSIVE,
-            .queueFamilyIndexCount = 0,
-            .pQueueFamilyIndices   = nullptr,
-            .initialLayout         = VK_IMAGE_LAYOUT_UNDEFINED,
-        };
+        Resolve( recorded.front() );
+        recorded.pop_front();
+    }
+    ring->BeginFrame( frameIndex );
 
-        VkResult r = vkCreateImage( device, &info, nullptr, &dstImage_Optimal );
-        VK_CHECKERROR( r );
-        SET_DEBUG_NAME(
-            device, dstImage_Optimal, VK_OBJECT_TYPE_IMAGE, "Export dst image (optimal)" );
+    std::erase_if( writes, []( const JobSystem::Handle& h ) { return h->IsDone(); } );
+
+    if( queued.empty() )
+    {
+        return;
     }
 
+    struct ToRecord
     {
-        VkImageCreateInfo info = {
-            .sType                 = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
-            .pNext                 = nullptr,
-            .flags                 = 0,
-            .imageType             = VK_IMAGE_TYPE_2D,
-            .format                = dstImageFormat,
-            .extent                = { srcImageSize.width, srcImageSize.height, 1 },
-            .mipLevels             = 1,
-            .arrayLayers           = 1,
-            .samples               = VK_SAMPLE_COUNT_1_BIT,
-            .tiling                = VK_IMAGE_TILING_LINEAR,          /* linear */
-            .usage                 = VK_IMAGE_USAGE_TRANSFER_DST_BIT, /* dst */
-            .sharingMode           = VK_SHARING_MODE_EXCLUSIVE,
-            .queueFamilyIndexCount = 0,
-            .pQueueFamilyIndices   = nullptr,
-            .initialLayout         = VK_IMAGE_LAYOUT_UNDEFINED,
+        VkImage   srcImage;
+        Readback* dst;
+    };
+    auto batch         = std::vector< ToRecord >{};
+    bool usesDedicated = false;
+
+    while( !queued.empty() )
+    {
+        const Request& q = queued.front();
+
+        // an image can be shared by textures, its layout must be transitioned only once
+        if( std::ranges::any_of( batch,
+                                 [ & ]( const ToRecord& t ) { return t.srcImage == q.srcImage; } ) )
+        {
+            break;
+        }
+
+        auto r = Readback{
+            .filepath   = q.filepath,
+            .size       = q.size,
+            .frameIndex = frameIndex,
+            .rgbaImage  = VK_NULL_HANDLE,
+            .rgbaMemory = VK_NULL_HANDLE,
+            .dedicated  = nullptr,
+            .ringOffset = 0,
         };
 
-        VkResult r = vkCreateImage( device, &info, nullptr, &dstImage_Linear );
-        VK_CHECKERROR( r );
-        SET_DEBUG_NAME( device,
-                        dstImage_Linear,
-                        VK_OBJECT_TYPE_IMAGE,
-                        "Export dst image (linear, host-readable)" );
-    }
+        const VkDeviceSize bytes = DstBytesPerPixel * q.size.width * q.size.height;
 
-    VkDeviceMemory dstMemory_Optimal = VK_NULL_HANDLE;
-    VkDeviceMemory dstMemory_Linear  = VK_NULL_HANDLE;
-    {
-        VkMemoryRequirements memReqs = {};
-        vkGetImageMemoryRequirements( device, dstImage_Optimal, &memReqs );
+        if( bytes > ring->GetCapacity() )
+        {
+            // at most one per frame, as it's a new allocation
+            if( usesDedicated )
+            {
+                break;
+            }
+            r.dedicated = std::make_unique< Buffer >();
+            r.dedicated->Init( *allocator,
+                               bytes,
+                               VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                               VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                   VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                               "Export readback (dedicated)" );
+            usesDedicated = true;
+        }
+        else if( auto offset = ring->Allocate( bytes, DstBytesPerPixel ) )
+        {
+            r.ringOffset = *offset;
+        }
+        else
+        {
+            // wait for the ring to be released
+            break;
+        }
 
-        dstMemory_Optimal = allocator.AllocDedicated( memReqs,
-                                                      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-                                                      MemoryAllocator::AllocType::DEFAULT,
-                                                      "Export dst image (optimal)" );
+        CreateRGBAImage( r, q.dstFormat );
 
-        VkResult r = vkBindImageMemory( device, dstImage_Optimal, dstMemory_Optimal, 0 );
-        VK_CHECKERROR( r );
+        // deque doesn't invalidate references on push_back
+        batch.push_back( ToRecord{
+            .srcImage = q.srcImage,
+            .dst      = &recorded.emplace_back( std::move( r ) ),
+        } );
+        queued.pop_front();
     }
+
+    if( batch.empty() )
     {
-        VkMemoryRequirements memReqs = {};
-        vkGetImageMemoryRequirements( device, dstImage_Linear, &memReqs );
+        return;
+    }
 
-        dstMemory_Linear = allocator.AllocDedicated( memReqs,
-                                                     VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                                                         VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                                                     MemoryAllocator::AllocType::DEFAULT,
-                                                     "Export dst image (linear, host-readable)" );
+    constexpr VkImageLayout srcImageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
-        VkResult r = vkBindImageMemory( device, dstImage_Linear, dstMemory_Linear, 0 );
-        VK_CHECKERROR( r );
-    }
+    constexpr VkImageSubresourceRange subresRange = {
+        .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
+        .baseMipLevel   = 0,
+        .levelCount     = 1,
+        .baseArrayLayer = 0,
+        .layerCount     = 1,
+    };
+    constexpr VkImageSubresourceLayers subresLayers = {
+        .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
+        .mipLevel       = 0,
+        .baseArrayLayer = 0,
+        .layerCount     = 1,
+    };
 
-    // blit srcImage -> dstImage_Optimal
-    {
-        VkImageMemoryBarrier2 bs[] = {
-            // srcImage to transfer src
-            {
-                .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR,
-                .srcStageMask        = VK_PIPELINE_STAGE_2_ALL_GRAPHICS_BIT,
-                .srcAccessMask       = VK_ACCESS_2_SHADER_READ_BIT,
-                .dstStageMask        = VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
-                .dstAccessMask       = VK_ACCESS_2_TRANSFER_READ_BIT,
-                .oldLayout           = srcImageLayout,
-                .newLayout           = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                .image               = srcImage,
-                .subresourceRange    = subresRange,
-            },
-            // dstImage_Optimal to transfer dst
-            {
-                .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR,
-                .srcStageMask        = VK_PIPELINE_STAGE_2_ALL_GRAPHICS_BIT,
-                .srcAccessMask       = VK_ACCESS_2_NONE,
-                .dstStageMask        = VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
-                .dstAccessMask       = VK_ACCESS_2_TRANSFER_WRITE_BIT,
-                .oldLayout           = VK_IMAGE_LAYOUT_UNDEFINED,
-                .newLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                .image               = dstImage_Optimal,
-                .subresourceRange    = subresRange,
-            },
-        };
+    auto barriers = std::vector< VkImageMemoryBarrier2 >{};
+    barriers.reserve( batch.size() * 2 );
 
+    auto recordBarriers = [ & ]() {
         VkDependencyInfoKHR dependencyInfo = {
             .sType                   = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR,
-            .imageMemoryBarrierCount = std::size( bs ),
-            .pImageMemoryBarriers    = std::data( bs ),
+            .imageMemoryBarrierCount = uint32_t( barriers.size() ),
+            .pImageMemoryBarriers    = barriers.data(),
         };
-
         svkCmdPipelineBarrier2KHR( cmd, &dependencyInfo );
+        barriers.clear();
+    };
+
+    // src images to transfer src, rgba images to transfer dst
+    for( const ToRecord& t : batch )
+    {
+        barriers.push_back( {
+            .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR,
+            .srcStageMask        = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+            .srcAccessMask       = VK_ACCESS_2_SHADER_READ_BIT,
+            .dstStageMask        = VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+            .dstAccessMask       = VK_ACCESS_2_TRANSFER_READ_BIT,
+            .oldLayout           = srcImageLayout,
+            .newLayout           = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image               = t.srcImage,
+            .subresourceRange    = subresRange,
+        } );
+        barriers.push_back( {
+            .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR,
+            .srcStageMask        = VK_PIPELINE_STAGE_2_NONE,
+            .srcAccessMask       = VK_ACCESS_2_NONE,
+            .dstStageMask        = VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+            .dstAccessMask       = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+            .oldLayout           = VK_IMAGE_LAYOUT_UNDEFINED,
+            .newLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image               = t.dst->rgbaImage,
+            .subresourceRange    = subresRange,
+        } );
     }
+    recordBarriers();
+
+    // can't vkCmdCopy directly from a compressed format (diff block extents with rgba8)
+    for( const ToRecord& t : batch )
     {
+        const auto extent =
+            VkOffset3D{ int32_t( t.dst->size.width ), int32_t( t.dst->size.height ), 1 };
+
         VkImageBlit blit = {
-            .srcSubresource = { .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
-                                .mipLevel       = 0,
-                                .baseArrayLayer = 0,
-                                .layerCount     = 1 },
-            .srcOffsets     = { { 0, 0, 0 },
-                                { int32_t( srcImageSize.width ), int32_t( srcImageSize.height ), 1 } },
-            .dstSubresource = { .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
-                                .mipLevel       = 0,
-                                .baseArrayLayer = 0,
-                                .layerCount     = 1 },
-            .dstOffsets     = { { 0, 0, 0 },
-                                { int32_t( srcImageSize.width ), int32_t( srcImageSize.height ), 1 } },
+            .srcSubresource = subresLayers,
+            .srcOffsets     = { { 0, 0, 0 }, extent },
+            .dstSubresource = subresLayers,
+            .dstOffsets     = { { 0, 0, 0 }, extent },
         };
 
         vkCmdBlitImage( cmd,
-                        srcImage,
+                        t.srcImage,
                         VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                        dstImage_Optimal,
+                        t.dst->rgbaImage,
                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
                         1,
                         &blit,
                         VK_FILTER_NEAREST );
     }
 
-    // copy dstImage_Optimal -> dstImage_Linear
+    // src images back, rgba images to transfer src
+    for( const ToRecord& t : batch )
     {
-        VkImageMemoryBarrier2 bs[] = {
-            {
-                // dstImage_Optimal to transfer src
-                .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR,
-                .srcStageMask        = VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
-                .srcAccessMask       = VK_ACCESS_2_TRANSFER_WRITE_BIT,
-                .dstStageMask        = VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
-                .dstAccessMask       = VK_ACCESS_2_TRANSFER_READ_BIT,
-                .oldLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                .newLayout           = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                .image               = dstImage_Optimal,
-                .subresourceRange    = subresRange,
-            },
-            {
-                // dstImage_Linear to transfer dst
-                .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR,
-                .srcStageMask        = VK_PIPELINE_STAGE_2_ALL_GRAPHICS_BIT,
-                .srcAccessMask       = VK_ACCESS_2_NONE,
-                .dstStageMask        = VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
-                .dstAccessMask       = VK_ACCESS_2_TRANSFER_WRITE_BIT,
-                .oldLayout           = VK_IMAGE_LAYOUT_UNDEFINED,
-                .newLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                .image               = dstImage_Linear,
-                .subresourceRange    = subresRange,
-            },
-        };
-
-        VkDependencyInfoKHR dependencyInfo = {
-            .sType                   = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR,
-            .imageMemoryBarrierCount = std::size( bs ),
-            .pImageMemoryBarriers    = std::data( bs ),
-        };
-
-        svkCmdPipelineBarrier2KHR( cmd, &dependencyInfo );
+        barriers.push_back( {
+            .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR,
+            .srcStageMask        = VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+            .srcAccessMask       = VK_ACCESS_2_TRANSFER_READ_BIT,
+            .dstStageMask        = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+            .dstAccessMask       = VK_ACCESS_2_SHADER_READ_BIT,
+            .oldLayout           = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            .newLayout           = srcImageLayout,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image               = t.srcImage,
+            .subresourceRange    = subresRange,
+        } );
+        barriers.push_back( {
+            .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR,
+            .srcStageMask        = VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+            .srcAccessMask       = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+            .dstStageMask        = VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+            .dstAccessMask       = VK_ACCESS_2_TRANSFER_READ_BIT,
+            .oldLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            .newLayout           = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image               = t.dst->rgbaImage,
+            .subresourceRange    = subresRange,
+        } );
     }
+    recordBarriers();
+
+    // tightly packed rows, unlike a linear image
+    for( const ToRecord& t : batch )
     {
-        VkImageCopy region = {
-            .srcSubresource = { .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
-                                .mipLevel       = 0,
-                                .baseArrayLayer = 0,
-                                .layerCount     = 1 },
-            .srcOffset      = { 0, 0, 0 },
-            .dstSubresource = { .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
-                                .mipLevel       = 0,
-                                .baseArrayLayer = 0,
-                                .layerCount     = 1 },
-            .dstOffset      = { 0, 0, 0 },
-            .extent         = { srcImageSize.width, srcImageSize.height, 1 },
+        VkBufferImageCopy region = {
+            .bufferOffset      = t.dst->ringOffset,
+            .bufferRowLength   = 0,
+            .bufferImageHeight = 0,
+            .imageSubresource  = subresLayers,
+            .imageOffset       = { 0, 0, 0 },
+            .imageExtent       = { t.dst->size.width, t.dst->size.height, 1 },
         };
 
-        vkCmdCopyImage( cmd,
-                        dstImage_Optimal,
-                        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                        dstImage_Linear,
-                        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                        1,
-                        &region );
+        vkCmdCopyImageToBuffer(
+            cmd,
+            t.dst->rgbaImage,
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            t.dst->dedicated ? t.dst->dedicated->GetBuffer() : ringBuffer.GetBuffer(),
+            1,
+            &region );
     }
 
     {
-        VkImageMemoryBarrier2 bs[] = {
-            {
-                // srcImage to original layout
-                .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR,
-                .srcStageMask        = VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
-                .srcAccessMask       = VK_ACCESS_2_TRANSFER_READ_BIT,
-                .dstStageMask        = VK_PIPELINE_STAGE_2_ALL_GRAPHICS_BIT,
-                .dstAccessMask       = VK_ACCESS_2_SHADER_READ_BIT,
-                .oldLayout           = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                .newLayout           = srcImageLayout,
-                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                .image               = srcImage,
-                .subresourceRange    = subresRange,
-            },
-            {
-                // dstImage_Linear to host read
-                .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR,
-                .srcStageMask        = VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
-                .srcAccessMask       = VK_ACCESS_2_TRANSFER_WRITE_BIT,
-                .dstStageMask        = VK_PIPELINE_STAGE_2_HOST_BIT,
-                .dstAccessMask       = VK_ACCESS_2_HOST_READ_BIT,
-                .oldLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                .newLayout           = VK_IMAGE_LAYOUT_GENERAL,
-                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                .image               = dstImage_Linear,
-                .subresourceRange    = subresRange,
-            },
+        auto b = VkMemoryBarrier2{
+            .sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+            .srcStageMask  = VK_PIPELINE_STAGE_2_COPY_BIT,
+            .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+            .dstStageMask  = VK_PIPELINE_STAGE_2_HOST_BIT,
+            .dstAccessMask = VK_ACCESS_2_HOST_READ_BIT,
         };
-
-        VkDependencyInfoKHR dependencyInfo = {
-            .sType                   = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR,
-            .imageMemoryBarrierCount = std::size( bs ),
-            .pImageMemoryBarriers    = std::data( bs ),
+        auto dep = VkDependencyInfo{
+            .sType              = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+            .memoryBarrierCount = 1,
+            .pMemoryBarriers    = &b,
         };
-
-        svkCmdPipelineBarrier2KHR( cmd, &dependencyInfo );
+        svkCmdPipelineBarrier2KHR( cmd, &dep );
     }
+}
 
-    cmdManager.Submit( cmd );
-    cmdManager.WaitGraphicsIdle();
+void RTGL1::TextureExporter::Resolve( Readback& r )
+{
+    const size_t bytes = DstBytesPerPixel * r.size.width * r.size.height;
 
-    bool success = false;
-    {
-        VkSubresourceLayout subresLayout = {};
-        vkGetImageSubresourceLayout( device, dstImage_Linear, &subres, &subresLayout );
+    const uint8_t* src = r.dedicated ? static_cast< const uint8_t* >( r.dedicated->Map() )
+                                     : &ringMapped[ r.ringOffset ];
 
-        if( subresLayout.rowPitch == DstBytesPerPixel * srcImageSize.width )
-        {
-            assert( subresLayout.size ==
-                    DstBytesPerPixel * srcImageSize.width * srcImageSize.height );
+    // copy out, as the ring is reused right after
+    auto pixels = std::vector< uint8_t >( src, src + bytes );
 
-            uint8_t* data{ nullptr };
-            VkResult r = vkMapMemory( device,
-                                      dstMemory_Linear,
-                                      0,
-                                      VK_WHOLE_SIZE,
-                                      0,
-                                      reinterpret_cast< void** >( &data ) );
-            VK_CHECKERROR( r );
+    if( r.dedicated )
+    {
+        r.dedicated->TryUnmap();
+        r.dedicated->Destroy();
+        r.dedicated.reset();
+    }
 
-            success = WriteTGA( filepath, &data[ subresLayout.offset ], srcImageSize );
+    MemoryAllocator::FreeDedicated( allocator->GetDevice(), r.rgbaMemory );
+    vkDestroyImage( allocator->GetDevice(), r.rgbaImage, nullptr );
+    r.rgbaMemory = VK_NULL_HANDLE;
+    r.rgbaImage  = VK_NULL_HANDLE;
 
-            vkUnmapMemory( device, dstMemory_Linear );
-        }
-        else
-        {
-            // manually, if small enough
-            if( srcImageSize.width <= 64 && srcImageSize.height <= 64 )
-            {
-                auto pixels = std::make_unique< uint8_t[] >( DstBytesPerPixel * srcImageSize.width *
-                                                             srcImageSize.height );
-                {
-                    uint8_t* rawData{ nullptr };
-                    VkResult r = vkMapMemory( device,
-                                              dstMemory_Linear,
-                                              0,
-                                              VK_WHOLE_SIZE,
-                                              0,
-                                              reinterpret_cast< void** >( &rawData ) );
-                    VK_CHECKERROR( r );
-
-                    uint8_t* beginData = &rawData[ subresLayout.offset ];
-                    uint8_t* endData   = &rawData[ subresLayout.offset + subresLayout.size ];
-
-                    uint8_t* dstPtr = pixels.get();
-
-                    for( uint8_t* ptr = beginData; ptr < endData; ptr += subresLayout.rowPitch )
-                    {
-                        memcpy( dstPtr, ptr, DstBytesPerPixel * srcImageSize.width );
-                        dstPtr += DstBytesPerPixel * srcImageSize.width;
-                    }
-
-                    vkUnmapMemory( device, dstMemory_Linear );
-                }
-                success = WriteTGA( filepath, pixels.get(), srcImageSize );
-            }
-            else
-            {
-                debug::Warning(
-                    "Can't export to image file, as mapped data is not tightly packed: {}. "
-                    "VkSubresourceLayout::rowPitch is {}; expected "
-                    "( {} bytes per pixel * {} pixels in a row )",
-                    filepath.string(),
-                    subresLayout.rowPitch,
-                    DstBytesPerPixel,
-                    srcImageSize.width );
-            }
-        }
+    auto write = [ pixels = std::move( pixels ), path = std::move( r.filepath ), size = r.size ]() {
+        WriteTGA( path, pixels.data(), size );
+    };
+
+    if( jobs )
+    {
+        writes.push_back( jobs->Submit( std::move( write ) ) );
     }
+    else
     {
-        MemoryAllocator::FreeDedicated( device, dstMemory_Linear );
-        MemoryAllocator::FreeDedicated( device, dstMemory_Optimal );
-
-        vkDestroyImage( device, dstImage_Linear, nullptr );
-        vkDestroyImage( device, dstImage_Optimal, nullptr );
+        write();
     }
+}
 
-    return success;
+uint32_t RTGL1::TextureExporter::GetPendingCount() const
+{
+    return uint32_t( queued.size() + recorded.size() +
+                     std::ranges::count_if( writes, []( const JobSystem::Handle& h ) {
+                         return !h->IsDone();
+                     } ) );
 }
 
 bool RTGL1::TextureExporter::CheckSupport( VkPhysicalDevice physDevice,
@@ -502,15 +513,16 @@ bool RTGL1::TextureExporter::CheckSupport( VkPhysicalDevice physDevice,
             debug::Warning( "BLIT_DST not supported for VkFormat {}", uint32_t( dstImageFormat ) );
             return false;
         }
-        if( !( formatProps.linearTilingFeatures & VK_FORMAT_FEATURE_TRANSFER_SRC_BIT ) )
+        // the blit destination is optimal-tiled too, it's copied to a buffer for readback
+        if( !( formatProps.optimalTilingFeatures & VK_FORMAT_FEATURE_TRANSFER_SRC_BIT ) )
         {
-            debug::Warning( "TRANSFER_SRC not supported for VkFormat {} (linear tiling)",
+            debug::Warning( "TRANSFER_SRC not supported for VkFormat {}",
                             uint32_t( dstImageFormat ) );
             return false;
         }
-        if( !( formatProps.linearTilingFeatures & VK_FORMAT_FEATURE_TRANSFER_DST_BIT ) )
+        if( !( formatProps.optimalTilingFeatures & VK_FORMAT_FEATURE_TRANSFER_DST_BIT ) )
         {
-            debug::Warning( "TRANSFER_DST not supported for VkFormat {} (linear tiling)",
+            debug::Warning( "TRANSFER_DST not supported for VkFormat {}",
                             uint32_t( dstImageFormat ) );
             return false;
         }
@@ -20,19 +20,30 @@
 
 #pragma once
 
+#include "Buffer.h"
 #include "CommandBufferManager.h"
+#include "FrameRingAllocator.h"
+#include "JobSystem.h"
 #include "MemoryAllocator.h"
 
+#include <deque>
 #include <filesystem>
 
 namespace RTGL1
 {
 
+// Exports textures to image files without stalling the frames. Queued textures are blitted
+// to RGBA8 and copied to a host-visible readback ring in the command buffer of a frame.
+// When the fence of the same frame index was waited, i.e. MAX_FRAMES_IN_FLIGHT frames later,
+// the pixels are taken from the ring, and the files are encoded and written on the job system.
 class TextureExporter
 {
 public:
-    TextureExporter() = default;
-    ~TextureExporter() = default;
+    TextureExporter( std::shared_ptr< MemoryAllocator > allocator,
+                     std::shared_ptr< JobSystem >       jobSystem,
+                     VkDeviceSize                       readbackRingSize );
+    // Device must be idle, so the recorded readbacks can be written
+    ~TextureExporter();
 
     TextureExporter( const TextureExporter& other )                = delete;
     TextureExporter( TextureExporter&& other ) noexcept            = delete;
@@ -43,20 +54,63 @@ public:
                           const void*           pixels,
                           const RgExtent2D&     size );
 
-    bool ExportAsTGA( MemoryAllocator&             allocator,
-                      CommandBufferManager&        cmdManager,
-                      VkImage                      srcImage,
-                      RgExtent2D                   srcImageSize,
-                      VkFormat                     srcImageFormat,
-                      const std::filesystem::path& filepath,
-                      bool                         exportAsSRGB,
-                      bool                         overwriteFiles = true );
+    // Returns false, if the file will not be written. The image must be in
+    // VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, and alive until the next Record
+    bool Enqueue( VkImage                      srcImage,
+                  RgExtent2D                   srcImageSize,
+                  VkFormat                     srcImageFormat,
+                  const std::filesystem::path& filepath,
+                  bool                         exportAsSRGB,
+                  bool                         overwriteFiles = true );
+
+    // Write the readbacks that were recorded with the same frame index,
+    // and record the queued ones, while they fit the readback ring
+    void Record( VkCommandBuffer cmd, uint32_t frameIndex );
+
+    // Queued, recorded, or being written
+    uint32_t GetPendingCount() const;
 
     bool CheckSupport( VkPhysicalDevice physDevice,
                        VkFormat         srcImageFormat,
                        VkFormat         dstImageFormat );
 
 private:
+    struct Request
+    {
+        VkImage               srcImage;
+        RgExtent2D            size;
+        VkFormat              srcFormat;
+        VkFormat              dstFormat;
+        std::filesystem::path filepath;
+    };
+
+    struct Readback
+    {
+        std::filesystem::path     filepath;
+        RgExtent2D                size;
+        uint32_t                  frameIndex;
+        // can't copy a compressed image to RGBA8 directly, so it's blitted to this one first
+        VkImage                   rgbaImage;
+        VkDeviceMemory            rgbaMemory;
+        // if the pixels don't fit the ring
+        std::unique_ptr< Buffer > dedicated;
+        VkDeviceSize              ringOffset;
+    };
+
+    void CreateRGBAImage( Readback& r, VkFormat format ) const;
+    void Resolve( Readback& r );
+
+private:
+    std::shared_ptr< MemoryAllocator > allocator;
+    std::shared_ptr< JobSystem >       jobs;
+
+    Buffer                              ringBuffer;
+    const uint8_t*                      ringMapped{ nullptr };
+    std::optional< FrameRingAllocator > ring;
+
+    std::deque< Request >            queued;
+    std::deque< Readback >           recorded;
+    std::vector< JobSystem::Handle > writes;
 };
 
 }
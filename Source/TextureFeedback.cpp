@@ -0,0 +1,180 @@
+/*
+
+Copyright (c) 2024 V.Shirokii
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#include "TextureFeedback.h"
+
+#include "CmdLabel.h"
+
+RTGL1::TextureFeedback::TextureFeedback( MemoryAllocator& allocator, uint32_t maxTextureCount )
+    : count{ maxTextureCount }
+{
+    gpuBuffer.Init( allocator,
+                    sizeof( uint32_t ) * count,
+                    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+                        VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                    "Texture feedback" );
+
+    for( uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++ )
+    {
+        readback[ i ].Init( allocator,
+                            sizeof( uint32_t ) * count,
+                            VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                            "Texture feedback readback" );
+        mapped[ i ] = static_cast< const uint32_t* >( readback[ i ].Map() );
+    }
+}
+
+RTGL1::TextureFeedback::~TextureFeedback()
+{
+    for( auto& b : readback )
+    {
+        b.TryUnmap();
+        b.Destroy();
+    }
+    gpuBuffer.Destroy();
+}
+
+void RTGL1::TextureFeedback::Reset( VkCommandBuffer cmd )
+{
+    auto label = CmdLabel{ cmd, "Texture feedback reset" };
+
+    // previous frame's copy must finish reading
+    {
+        auto b = VkBufferMemoryBarrier2{
+            .sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+            .srcStageMask        = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+            .srcAccessMask       = VK_ACCESS_2_SHADER_WRITE_BIT | VK_ACCESS_2_TRANSFER_READ_BIT,
+            .dstStageMask        = VK_PIPELINE_STAGE_2_CLEAR_BIT,
+            .dstAccessMask       = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .buffer              = gpuBuffer.GetBuffer(),
+            .offset              = 0,
+            .size                = VK_WHOLE_SIZE,
+        };
+        auto dep = VkDependencyInfo{
+            .sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+            .bufferMemoryBarrierCount = 1,
+            .pBufferMemoryBarriers    = &b,
+        };
+        svkCmdPipelineBarrier2KHR( cmd, &dep );
+    }
+
+    vkCmdFillBuffer( cmd, gpuBuffer.GetBuffer(), 0, VK_WHOLE_SIZE, NotRequested );
+
+    {
+        auto b = VkBufferMemoryBarrier2{
+            .sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+            .srcStageMask        = VK_PIPELINE_STAGE_2_CLEAR_BIT,
+            .srcAccessMask       = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+            .dstStageMask        = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+            .dstAccessMask       = VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .buffer              = gpuBuffer.GetBuffer(),
+            .offset              = 0,
+            .size                = VK_WHOLE_SIZE,
+        };
+        auto dep = VkDependencyInfo{
+            .sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+            .bufferMemoryBarrierCount = 1,
+            .pBufferMemoryBarriers    = &b,
+        };
+        svkCmdPipelineBarrier2KHR( cmd, &dep );
+    }
+}
+
+void RTGL1::TextureFeedback::CopyToReadback( VkCommandBuffer cmd, uint32_t frameIndex )
+{
+    auto label = CmdLabel{ cmd, "Texture feedback copy" };
+
+    {
+        auto b = VkBufferMemoryBarrier2{
+            .sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+            .srcStageMask        = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+            .srcAccessMask       = VK_ACCESS_2_SHADER_WRITE_BIT,
+            .dstStageMask        = VK_PIPELINE_STAGE_2_COPY_BIT,
+            .dstAccessMask       = VK_ACCESS_2_TRANSFER_READ_BIT,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .buffer              = gpuBuffer.GetBuffer(),
+            .offset              = 0,
+            .size                = VK_WHOLE_SIZE,
+        };
+        auto dep = VkDependencyInfo{
+            .sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+            .bufferMemoryBarrierCount = 1,
+            .pBufferMemoryBarriers    = &b,
+        };
+        svkCmdPipelineBarrier2KHR( cmd, &dep );
+    }
+
+    auto region = VkBufferCopy{
+        .srcOffset = 0,
+        .dstOffset = 0,
+        .size      = sizeof( uint32_t ) * count,
+    };
+    vkCmdCopyBuffer( cmd, gpuBuffer.GetBuffer(), readback[ frameIndex ].GetBuffer(), 1, &region );
+
+    {
+        auto b = VkBufferMemoryBarrier2{
+            .sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+            .srcStageMask        = VK_PIPELINE_STAGE_2_COPY_BIT,
+            .srcAccessMask       = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+            .dstStageMask        = VK_PIPELINE_STAGE_2_HOST_BIT,
+            .dstAccessMask       = VK_ACCESS_2_HOST_READ_BIT,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .buffer              = readback[ frameIndex ].GetBuffer(),
+            .offset              = 0,
+            .size                = VK_WHOLE_SIZE,
+        };
+        auto dep = VkDependencyInfo{
+            .sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+            .bufferMemoryBarrierCount = 1,
+            .pBufferMemoryBarriers    = &b,
+        };
+        svkCmdPipelineBarrier2KHR( cmd, &dep );
+    }
+
+    hasData[ frameIndex ] = true;
+}
+
+auto RTGL1::TextureFeedback::Read( uint32_t frameIndex ) const -> std::span< const uint32_t >
+{
+    if( !hasData[ frameIndex ] )
+    {
+        return {};
+    }
+    return { mapped[ frameIndex ], count };
+}
+
+VkBuffer RTGL1::TextureFeedback::GetBuffer() const
+{
+    return gpuBuffer.GetBuffer();
+}
@@ -0,0 +1,71 @@
+/*
+
+Copyright (c) 2024 V.Shirokii
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#pragma once
+
+#include "Buffer.h"
+
+#include <span>
+
+namespace RTGL1
+{
+
+// Shaders write a min mip level that was requested for each texture index
+// (see writeTextureFeedback in ShaderCommonGLSLFunc.h). At the end of a frame,
+// the buffer is copied to a host-visible one, which is read after the frame fence
+// of the same frame index was waited, i.e. MAX_FRAMES_IN_FLIGHT frames later.
+class TextureFeedback
+{
+public:
+    constexpr static uint32_t NotRequested = 0xFFFFFFFF;
+
+public:
+    TextureFeedback( MemoryAllocator& allocator, uint32_t maxTextureCount );
+    ~TextureFeedback();
+
+    TextureFeedback( const TextureFeedback& other )                = delete;
+    TextureFeedback( TextureFeedback&& other ) noexcept            = delete;
+    TextureFeedback& operator=( const TextureFeedback& other )     = delete;
+    TextureFeedback& operator=( TextureFeedback&& other ) noexcept = delete;
+
+    // Must be recorded before any shader that samples the textures
+    void Reset( VkCommandBuffer cmd );
+    // Must be recorded after all shaders that sample the textures
+    void CopyToReadback( VkCommandBuffer cmd, uint32_t frameIndex );
+
+    // Empty, if nothing was copied for this frame index yet
+    auto Read( uint32_t frameIndex ) const -> std::span< const uint32_t >;
+
+    VkBuffer GetBuffer() const;
+
+private:
+    Buffer          gpuBuffer;
+    Buffer          readback[ MAX_FRAMES_IN_FLIGHT ];
+    const uint32_t* mapped[ MAX_FRAMES_IN_FLIGHT ]{};
+    bool            hasData[ MAX_FRAMES_IN_FLIGHT ]{};
+    uint32_t        count;
+};
+
+}
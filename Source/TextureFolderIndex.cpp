@@ -0,0 +1,166 @@
+/*
+
+Copyright (c) 2024 V.Shirokii
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#include "TextureFolderIndex.h"
+
+#include "Const.h"
+#include "TextureOverrides.h"
+#include "Utils.h"
+
+#include <algorithm>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+bool IsImageFile( RTGL1::FileType type )
+{
+    using RTGL1::FileType;
+    return type == FileType::KTX2 || type == FileType::PNG || type == FileType::TGA ||
+           type == FileType::JPG;
+}
+
+std::string ToLower( std::string s )
+{
+    std::ranges::transform( s, s.begin(), []( unsigned char c ) { return std::tolower( c ); } );
+    return s;
+}
+}
+
+RTGL1::TextureFolderIndex::TextureFolderIndex( fs::path _ovrdFolder )
+    : ovrdFolder{ std::move( _ovrdFolder ) }
+{
+    InsertAllFolderFiles( ovrdFolder / TEXTURES_FOLDER );
+    InsertAllFolderFiles( ovrdFolder / TEXTURES_FOLDER_DEV );
+
+    debug::Verbose( "Texture folder index: {} files", fileCount );
+
+    if( auto p = std::make_unique< TexturePack >( ovrdFolder / TEXTURES_PACK ); p->IsValid() )
+    {
+        pack = std::move( p );
+    }
+}
+
+void RTGL1::TextureFolderIndex::InsertAllFolderFiles( const fs::path& folder )
+{
+    auto ec = std::error_code{};
+    if( !fs::is_directory( folder, ec ) )
+    {
+        return;
+    }
+
+    for( auto iter = fs::recursive_directory_iterator(
+             folder, fs::directory_options::skip_permission_denied, ec );
+         !ec && iter != fs::recursive_directory_iterator{};
+         iter.increment( ec ) )
+    {
+        if( iter->is_regular_file( ec ) && IsImageFile( MakeFileType( iter->path() ) ) )
+        {
+            Insert( iter->path() );
+        }
+    }
+
+    if( ec )
+    {
+        debug::Warning( "Failed to index texture folder {}: {}", folder.string(), ec.message() );
+    }
+}
+
+void RTGL1::TextureFolderIndex::Insert( const fs::path& filepath )
+{
+    auto relative = filepath.lexically_relative( ovrdFolder );
+    if( relative.empty() || *relative.begin() == ".." )
+    {
+        return;
+    }
+
+    auto& sameName = files[ MakeKey( relative.replace_extension() ) ];
+
+    if( std::ranges::find( sameName, filepath ) == sameName.end() )
+    {
+        sameName.push_back( filepath );
+        fileCount++;
+    }
+}
+
+std::string RTGL1::TextureFolderIndex::MakeKey( const fs::path& relativePathWithoutExtension )
+{
+    auto key = relativePathWithoutExtension.lexically_normal().generic_string();
+#ifdef _WIN32
+    // to match the case-insensitive lookup of the file system
+    key = ToLower( std::move( key ) );
+#endif
+    return key;
+}
+
+fs::path RTGL1::TextureFolderIndex::Find( std::string_view               subfolder,
+                                          std::span< const char* const > extensions,
+                                          std::string_view               name,
+                                          std::string_view               postfix ) const
+{
+    auto found =
+        files.find( MakeKey( TextureOverrides::GetTexturePath( subfolder, name, postfix, "" ) ) );
+    if( found == files.end() )
+    {
+        return {};
+    }
+
+    for( const char* ext : extensions )
+    {
+        for( const fs::path& f : found->second )
+        {
+            if( ToLower( f.extension().string() ) == ext )
+            {
+                return f;
+            }
+        }
+    }
+
+    return {};
+}
+
+std::span< const uint8_t > RTGL1::TextureFolderIndex::FindPacked( std::string_view name,
+                                                                  std::string_view postfix ) const
+{
+    if( !pack )
+    {
+        return {};
+    }
+
+    const auto* entry =
+        pack->Find( TextureOverrides::GetTexturePath( "", name, postfix, "" ).generic_string() );
+
+    return entry ? pack->GetData( *entry ) : std::span< const uint8_t >{};
+}
+
+void RTGL1::TextureFolderIndex::OnFileChanged( FileType type, const fs::path& filepath )
+{
+    // removed files are not tracked by the observer, so the entries are only added;
+    // loading a stale entry fails the same way as a missing file
+    if( IsImageFile( type ) )
+    {
+        Insert( filepath );
+    }
+}
@@ -0,0 +1,91 @@
+/*
+
+Copyright (c) 2024 V.Shirokii
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#pragma once
+
+#include "Containers.h"
+#include "IFileDependency.h"
+#include "TexturePack.h"
+
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace RTGL1
+{
+
+// Index of the image files in the texture folders of the override folder,
+// so material creation doesn't need to probe the filesystem for each
+// (name, postfix, extension) combination. Also owns the texture pack,
+// which is consulted only if there's no loose file.
+class TextureFolderIndex final : public IFileDependency
+{
+public:
+    explicit TextureFolderIndex( std::filesystem::path ovrdFolder );
+    ~TextureFolderIndex() override = default;
+
+    TextureFolderIndex( const TextureFolderIndex& other )                = delete;
+    TextureFolderIndex( TextureFolderIndex&& other ) noexcept            = delete;
+    TextureFolderIndex& operator=( const TextureFolderIndex& other )     = delete;
+    TextureFolderIndex& operator=( TextureFolderIndex&& other ) noexcept = delete;
+
+    // Returns the file in the subfolder, that has the name with postfix, and the extension
+    // that is earliest in the list. Empty path, if there's no such file.
+    std::filesystem::path Find( std::string_view              subfolder,
+                                std::span< const char* const > extensions,
+                                std::string_view              name,
+                                std::string_view              postfix ) const;
+
+    // Returns a KTX2 file from the texture pack, that has the name with postfix.
+    // Empty span, if there's no such texture. Valid while the index is alive.
+    std::span< const uint8_t > FindPacked( std::string_view name, std::string_view postfix ) const;
+
+    const std::filesystem::path& GetFolder() const { return ovrdFolder; }
+    size_t                       GetFileCount() const { return fileCount; }
+    uint32_t                     GetPackedCount() const { return pack ? pack->GetEntryCount() : 0; }
+
+    // Add new files to the index
+    void OnFileChanged( FileType type, const std::filesystem::path& filepath ) override;
+
+private:
+    void InsertAllFolderFiles( const std::filesystem::path& folder );
+    void Insert( const std::filesystem::path& filepath );
+
+    static std::string MakeKey( const std::filesystem::path& relativePathWithoutExtension );
+
+private:
+    std::filesystem::path ovrdFolder;
+
+    // key is a path relative to the override folder without an extension,
+    // value is the list of existing files with such path
+    rgl::string_map< std::vector< std::filesystem::path > > files;
+    size_t                                                  fileCount{ 0 };
+
+    std::unique_ptr< TexturePack > pack;
+};
+
+}
@@ -68,13 +68,6 @@ bool ContainsTextures( const MaterialTextures& m )
     return false;
 }
 
-auto FindEmptySlot( std::vector< Texture >& textures )
-{
-    return std::ranges::find_if( textures, []( const Texture& t ) {
-        return t.image == VK_NULL_HANDLE && t.view == VK_NULL_HANDLE;
-    } );
-}
-
 VkFormat toVkFormat( RgFormat f )
 {
     switch( f )
@@ -99,6 +92,63 @@ VkFormat getVkFormat( const RgOriginalTextureDetailsEXT* details, VkFormat fallb
     return fallback;
 }
 
+constexpr uint32_t MaxResidencyChangesPerFrame  = 8;
+constexpr uint32_t MaxCompressedUploadsPerFrame = 8;
+
+bool CanStreamLevels( const ImageLoader::ResultInfo& info )
+{
+    return info.isPregenerated && info.levelCount > 1;
+}
+
+// The first level which is not larger than maxSize
+uint32_t InitialLevel( const ImageLoader::ResultInfo& info, uint32_t maxSize )
+{
+    uint32_t level = 0;
+    while( level + 1 < info.levelCount &&
+           std::max( info.baseSize.width >> level, info.baseSize.height >> level ) > maxSize )
+    {
+        level++;
+    }
+    return level;
+}
+
+// Only the levels starting from firstLevel, pixel data is not copied
+auto SliceLevels( const ImageLoader::ResultInfo& info, uint32_t firstLevel )
+    -> ImageLoader::ResultInfo
+{
+    assert( CanStreamLevels( info ) && firstLevel < info.levelCount );
+
+    // levels are not necessarily in the order of their offsets, e.g. in KTX2 the smallest is first
+    size_t minOffset = SIZE_MAX;
+    size_t maxEnd    = 0;
+    for( uint32_t i = firstLevel; i < info.levelCount; i++ )
+    {
+        minOffset = std::min( minOffset, info.levelOffsets[ i ] );
+        maxEnd    = std::max( maxEnd, info.levelOffsets[ i ] + info.levelSizes[ i ] );
+    }
+
+    auto r = ImageLoader::ResultInfo{
+        .levelOffsets   = {},
+        .levelSizes     = {},
+        .levelCount     = info.levelCount - firstLevel,
+        .isPregenerated = true,
+        .pData          = info.pData ? info.pData + minOffset : nullptr,
+        .dataSize       = maxEnd - minOffset,
+        .baseSize       = { std::max( info.baseSize.width >> firstLevel, 1u ),
+                            std::max( info.baseSize.height >> firstLevel, 1u ) },
+        .format         = info.format,
+        .pZstdLevels    = info.pZstdLevels ? info.pZstdLevels + firstLevel : nullptr,
+        .contentHash    = info.contentHash,
+    };
+
+    for( uint32_t i = 0; i < r.levelCount; i++ )
+    {
+        r.levelOffsets[ i ] = info.levelOffsets[ firstLevel + i ] - minOffset;
+        r.levelSizes[ i ]   = info.levelSizes[ firstLevel + i ];
+    }
+    return r;
+}
+
 }
 
 
@@ -106,6 +156,7 @@ TextureManager::TextureManager( VkDevice                                _device,
                                 std::shared_ptr< MemoryAllocator >      _memAllocator,
                                 std::shared_ptr< SamplerManager >       _samplerMgr,
                                 std::shared_ptr< CommandBufferManager > _cmdManager,
+                                std::shared_ptr< JobSystem >            _jobSystem,
                                 const std::filesystem::path&            _waterNormalTexturePath,
                                 const std::filesystem::path&            _dirtMaskTexturePath,
                                 const std::filesystem::path&            _sceneBuildingTexturePath,
@@ -113,15 +164,18 @@ TextureManager::TextureManager( VkDevice                                _device,
                                 bool                                    _forceNormalMapFilterLinear )
     : device{ _device }
     , pbrSwizzling{ _pbrSwizzling }
-    , imageLoaderKtx{ std::make_shared< ImageLoader >() }
+    // synchronous loads are on the render thread anyway, so inflate straight into staging
+    , imageLoaderKtx{ std::make_shared< ImageLoader >( true ) }
     , imageLoaderRaw{ std::make_shared< ImageLoaderDev >() }
     , isdevmode{ LibConfig().developerMode }
     , memAllocator{ std::move( _memAllocator ) }
     , cmdManager{ std::move( _cmdManager ) }
+    , jobs{ _jobSystem }
     , samplerMgr{ std::move( _samplerMgr ) }
     , waterNormalTextureIndex{ EMPTY_TEXTURE_INDEX }
     , dirtMaskTextureIndex{ EMPTY_TEXTURE_INDEX }
     , sceneBuildingTextureIndex{ EMPTY_TEXTURE_INDEX }
+    , frameId{ 0 }
     , currentDynamicSamplerFilter{ RG_SAMPLER_FILTER_LINEAR }
     , postfixes
         {
@@ -133,9 +187,41 @@ TextureManager::TextureManager( VkDevice                                _device,
         }
     , forceNormalMapFilterLinear{ _forceNormalMapFilterLinear }
 {
-    textureDesc = std::make_shared< TextureDescriptors >(
-        device, samplerMgr, TEXTURE_COUNT_MAX, BINDING_TEXTURES );
-    textureUploader = std::make_shared< TextureUploader >( device, memAllocator );
+    // bound always, but shaders write the feedback only if IsFeedbackEnabled
+    textureFeedback = std::make_unique< TextureFeedback >( *memAllocator, TEXTURE_COUNT_MAX );
+    textureDesc     = std::make_shared< TextureDescriptors >( device,
+                                                          samplerMgr,
+                                                          TEXTURE_COUNT_MAX,
+                                                          BINDING_TEXTURES,
+                                                          textureFeedback->GetBuffer(),
+                                                          BINDING_TEXTURE_FEEDBACK );
+    textureUploader = std::make_shared< TextureUploader >(
+        device,
+        memAllocator,
+        VkDeviceSize{ LibConfig().textureStagingRingSizeMB } * 1024 * 1024,
+        _jobSystem );
+    textureExporter = std::make_unique< TextureExporter >(
+        memAllocator,
+        _jobSystem,
+        VkDeviceSize{ LibConfig().exportReadbackRingSizeMB } * 1024 * 1024 );
+
+    if( LibConfig().textureCompression )
+    {
+        textureCompressor = std::make_unique< TextureCompressor >( _jobSystem );
+    }
+
+    if( LibConfig().textureStreaming )
+    {
+        textureStreamer = std::make_unique< TextureStreamer >(
+            std::move( _jobSystem ), LibConfig().textureStreamingBudgetKB );
+
+        if( LibConfig().mipStreaming )
+        {
+            textureResidency = std::make_unique< TextureResidency >(
+                TEXTURE_COUNT_MAX, uint64_t{ LibConfig().mipStreamingBudgetMB } * 1024 * 1024 );
+            streamSources.resize( TEXTURE_COUNT_MAX );
+        }
+    }
 
     textures.resize( TEXTURE_COUNT_MAX );
 
@@ -143,6 +229,7 @@ TextureManager::TextureManager( VkDevice                                _device,
     {
         VkCommandBuffer cmd = cmdManager->StartGraphicsCmd();
         {
+            textureFeedback->Reset( cmd );
             CreateEmptyTexture( cmd, 0 );
 
             waterNormalTextureIndex = CreateWaterNormalTexture( cmd, 0, _waterNormalTexturePath );
@@ -171,6 +258,8 @@ void TextureManager::CreateEmptyTexture( VkCommandBuffer cmd, uint32_t frameInde
         .dataSize       = sizeof( data ),
         .baseSize       = size,
         .format         = VK_FORMAT_R8G8B8A8_UNORM,
+        .pZstdLevels    = nullptr,
+        .contentHash    = 0,
     };
 
     uint32_t textureIndex =
@@ -185,7 +274,7 @@ void TextureManager::CreateEmptyTexture( VkCommandBuffer cmd, uint32_t frameInde
                         false,
                         std::nullopt,
                         {},
-                        FindEmptySlot( textures ) );
+                        AllocateSlot() );
 
     // must have specific index
     assert( textureIndex == EMPTY_TEXTURE_INDEX );
@@ -223,6 +312,8 @@ uint32_t TextureManager::CreateWaterNormalTexture( VkCommandBuffer
             .dataSize       = sizeof( defaultData ),
             .baseSize       = defaultSize,
             .format         = VK_FORMAT_R8G8B8A8_UNORM,
+            .pZstdLevels    = nullptr,
+            .contentHash    = 0,
         };
         ovrd.path = filepath;
         Utils::SafeCstrCopy( ovrd.debugname, "Water normal" );
@@ -239,7 +330,7 @@ uint32_t TextureManager::CreateWaterNormalTexture( VkCommandBuffer
                            false,
                            std::nullopt,
                            std::move( ovrd.path ),
-                           FindEmptySlot( textures ) );
+                           AllocateSlot() );
 }
 
 uint32_t TextureManager::CreateDirtMaskTexture( VkCommandBuffer              cmd,
@@ -265,6 +356,8 @@ uint32_t TextureManager::CreateDirtMaskTexture( VkCommandBuffer              cmd
             .dataSize       = sizeof( defaultData ),
             .baseSize       = defaultSize,
             .format         = VK_FORMAT_R8G8B8A8_SRGB,
+            .pZstdLevels    = nullptr,
+            .contentHash    = 0,
         };
         ovrd.path = filepath;
         Utils::SafeCstrCopy( ovrd.debugname, "Dirt mask" );
@@ -281,7 +374,7 @@ uint32_t TextureManager::CreateDirtMaskTexture( VkCommandBuffer              cmd
                            false,
                            std::nullopt,
                            std::move( ovrd.path ),
-                           FindEmptySlot( textures ) );
+                           AllocateSlot() );
 }
 
 uint32_t TextureManager::CreateSceneBuildingTexture( VkCommandBuffer              cmd,
@@ -307,6 +400,8 @@ uint32_t TextureManager::CreateSceneBuildingTexture( VkCommandBuffer
             .dataSize       = sizeof( defaultData ),
             .baseSize       = defaultSize,
             .format         = VK_FORMAT_R8G8B8A8_SRGB,
+            .pZstdLevels    = nullptr,
+            .contentHash    = 0,
         };
         ovrd.path = filepath;
         Utils::SafeCstrCopy( ovrd.debugname, "Scene build warning" );
@@ -323,7 +418,7 @@ uint32_t TextureManager::CreateSceneBuildingTexture( VkCommandBuffer
                                false,
                                std::nullopt,
                                std::move( ovrd.path ),
-                               FindEmptySlot( textures ) );
+                               AllocateSlot() );
 
     InsertMaterial( frameIndex,
                     MATERIAL_NAME_SCENEBUILDINGWARNING,
@@ -368,6 +463,14 @@ void TextureManager::PrepareForFrame( uint32_t frameIndex )
 
     // clear staging buffer that are not in use
     textureUploader->ClearStaging( frameIndex );
+
+    frameId++;
+
+    // the frame fence was waited, so the feedback of MAX_FRAMES_IN_FLIGHT frames ago is ready
+    if( textureResidency )
+    {
+        textureResidency->ApplyFeedback( textureFeedback->Read( frameIndex ), frameId );
+    }
 }
 
 void TextureManager::TryHotReload( VkCommandBuffer cmd, uint32_t frameIndex )
@@ -400,6 +503,21 @@ void TextureManager::TryHotReload( VkCommandBuffer cmd, uint32_t frameIndex )
                     const auto prevSampler   = slot->samplerHandle;
                     const auto prevSwizzling = slot->swizzling;
 
+                    // all levels of the new file are uploaded, stop streaming the old ones
+                    if( textureResidency )
+                    {
+                        const auto slotIndex = uint32_t( std::distance( textures.begin(), slot ) );
+                        textureStreamer->Cancel( slotIndex );
+                        textureResidency->Untrack( slotIndex );
+                    }
+
+                    // the new file replaces the original pixels
+                    if( textureCompressor )
+                    {
+                        textureCompressor->Cancel(
+                            uint32_t( std::distance( textures.begin(), slot ) ) );
+                    }
+
                     AddToBeDestroyed( frameIndex, *slot );
 
                     auto tindex = PrepareTexture( cmd,
@@ -431,6 +549,216 @@ void TextureManager::TryHotReload( VkCommandBuffer cmd, uint32_t frameIndex )
     texturesToReload.clear();
 }
 
+void TextureManager::UploadPending( VkCommandBuffer cmd )
+{
+    auto finished = std::vector< VkImage >{};
+    textureUploader->UploadPending( cmd, finished );
+
+    if( finished.empty() )
+    {
+        return;
+    }
+
+    // the textures are complete, bind them; an image can be shared by several slots
+    for( VkImage image : finished )
+    {
+        textureDedup.ForEachSlot( image, [ this ]( uint32_t slot ) { UpdateDescriptor( slot ); } );
+    }
+}
+
+void TextureManager::UploadStreamed( VkCommandBuffer cmd, uint32_t frameIndex )
+{
+    if( !textureStreamer )
+    {
+        return;
+    }
+
+    textureStreamer->ProcessReady(
+        [ & ]( TextureStreamer::Request& request, const ImageLoader::ResultInfo* result ) {
+            // the slot was refilled after the request, e.g. by a compressed texture
+            if( !textureSlots.IsCurrent( request.slot, request.generation ) )
+            {
+                return;
+            }
+
+            auto slot = textures.begin() + request.slot;
+
+            // if the slot is already filled, the request was to change its resident levels
+            const bool isLevelChange = !slot->reserved;
+
+            if( isLevelChange )
+            {
+                assert( textureResidency && textureResidency->IsTracked( request.slot ) );
+                assert( slot->image != VK_NULL_HANDLE );
+
+                if( !result )
+                {
+                    // keep the current levels
+                    debug::Warning( "Failed to reload levels of a texture: {}",
+                                    request.path.string() );
+                    textureResidency->OnChangeFailed( request.slot );
+                    return;
+                }
+            }
+            else
+            {
+                assert( slot->reserved && slot->image == VK_NULL_HANDLE );
+
+                // release the reservation, so PrepareTexture can fill the slot
+                *slot = {};
+
+                if( !result )
+                {
+                    debug::Warning( "Failed to load streamed texture: {}", request.path.string() );
+                    FreeSlot( request.slot );
+                    return;
+                }
+            }
+
+            const bool withLevels = textureResidency && CanStreamLevels( *result );
+
+            uint32_t firstLevel = 0;
+            if( withLevels )
+            {
+                firstLevel =
+                    isLevelChange
+                        ? std::min( textureResidency->GetPendingLevel( request.slot ),
+                                    result->levelCount - 1 )
+                        : InitialLevel( *result, LibConfig().mipStreamingInitialSize );
+
+                if( !isLevelChange )
+                {
+                    streamSources[ request.slot ] = request;
+                }
+            }
+
+            if( isLevelChange )
+            {
+                AddToBeDestroyed( frameIndex, *slot );
+            }
+
+            // if failed, the slot is left empty, and the descriptor shows the empty texture
+            auto tindex = PrepareTexture( cmd,
+                                          frameIndex,
+                                          withLevels ? SliceLevels( *result, firstLevel ) : *result,
+                                          request.samplerHandle,
+                                          true,
+                                          request.debugname,
+                                          false,
+                                          request.swizzling,
+                                          std::move( request.path ),
+                                          slot );
+
+            if( withLevels && tindex != EMPTY_TEXTURE_INDEX )
+            {
+                textureResidency->Track( request.slot,
+                                         std::span( result->levelSizes, result->levelCount ),
+                                         firstLevel );
+            }
+            else if( textureResidency )
+            {
+                textureResidency->Untrack( request.slot );
+            }
+        } );
+
+    if( textureResidency )
+    {
+        auto changes = std::vector< TextureResidency::Change >{};
+        textureResidency->CollectChanges( MaxResidencyChangesPerFrame, changes );
+
+        for( const auto& c : changes )
+        {
+            const Texture& t = textures[ c.slot ];
+
+            // reload the same file, but keep the current sampler
+            auto request          = streamSources[ c.slot ];
+            request.generation    = textureSlots.GetGeneration( c.slot );
+            request.samplerHandle = t.samplerHandle;
+            request.swizzling     = t.swizzling;
+
+            textureStreamer->Enqueue( std::move( request ) );
+        }
+    }
+}
+
+void TextureManager::UploadCompressed( VkCommandBuffer cmd, uint32_t frameIndex )
+{
+    if( !textureCompressor )
+    {
+        return;
+    }
+
+    textureCompressor->ProcessReady(
+        MaxCompressedUploadsPerFrame,
+        [ & ]( uint32_t slotIndex, uint32_t generation, const std::filesystem::path& cachePath ) {
+            // the slot was refilled after the request, e.g. by a streamed level
+            if( !textureSlots.IsCurrent( slotIndex, generation ) )
+            {
+                return;
+            }
+
+            auto slot = textures.begin() + slotIndex;
+            assert( slot->image != VK_NULL_HANDLE );
+
+            auto compressed = TextureOverrides{
+                cachePath,
+                Utils::IsSRGB( slot->format ),
+                std::tuple< ImageLoader* >{ imageLoaderKtx.get() },
+            };
+            if( !compressed.result )
+            {
+                debug::Warning( "Failed to load compressed texture: {}", cachePath.string() );
+                return;
+            }
+
+            const auto prevSampler   = slot->samplerHandle;
+            const auto prevSwizzling = slot->swizzling;
+            auto       prevPath      = slot->filepath;
+
+            AddToBeDestroyed( frameIndex, *slot );
+
+            auto tindex = PrepareTexture( cmd,
+                                          frameIndex,
+                                          compressed.result,
+                                          prevSampler,
+                                          true,
+                                          compressed.debugname,
+                                          false,
+                                          prevSwizzling,
+                                          std::move( prevPath ),
+                                          slot );
+
+            // must match, so materials' indices are still correct
+            assert( tindex == slotIndex );
+        } );
+}
+
+void TextureManager::RecordExports( VkCommandBuffer cmd, uint32_t frameIndex )
+{
+    textureExporter->Record( cmd, frameIndex );
+}
+
+void TextureManager::ResetFeedback( VkCommandBuffer cmd )
+{
+    if( textureResidency )
+    {
+        textureFeedback->Reset( cmd );
+    }
+}
+
+void TextureManager::CopyFeedback( VkCommandBuffer cmd, uint32_t frameIndex )
+{
+    if( textureResidency )
+    {
+        textureFeedback->CopyToReadback( cmd, frameIndex );
+    }
+}
+
+bool TextureManager::IsFeedbackEnabled() const
+{
+    return textureResidency != nullptr;
+}
+
 void TextureManager::SubmitDescriptors( uint32_t                         frameIndex,
                                         const RgDrawFrameTexturesParams& texturesParams,
                                         bool                             forceUpdateAllDescriptors )
@@ -442,39 +770,65 @@ void TextureManager::SubmitDescriptors( uint32_t                         frameIn
     {
         currentDynamicSamplerFilter = newDynamicSamplerFilter;
         forceUpdateAllDescriptors   = true;
+
+        for( uint32_t i = 0; i < textures.size(); i++ )
+        {
+            if( textures[ i ].samplerHandle.SetIfHasDynamicSamplerFilter(
+                    newDynamicSamplerFilter ) )
+            {
+                UpdateDescriptor( i );
+            }
+        }
     }
 
 
     if( forceUpdateAllDescriptors )
     {
-        textureDesc->ResetAllCache( frameIndex );
+        textureDesc->MarkAllDirty();
     }
 
-    // update desc set with current values
-    for( uint32_t i = 0; i < textures.size(); i++ )
-    {
-        textures[ i ].samplerHandle.SetIfHasDynamicSamplerFilter( newDynamicSamplerFilter );
+    // only the slots that were changed since the last flush of this frame's desc set
+    textureDesc->FlushDescWrites( frameIndex );
+}
 
+auto TextureManager::AllocateSlot() -> std::vector< Texture >::iterator
+{
+    auto index = textureSlots.Allocate();
+    return index ? textures.begin() + *index : textures.end();
+}
 
-        if( textures[ i ].image != VK_NULL_HANDLE )
-        {
-            textureDesc->UpdateTextureDesc(
-                frameIndex, i, textures[ i ].view, textures[ i ].samplerHandle );
-        }
-        else
-        {
-            // reset descriptor to empty texture
-            textureDesc->ResetTextureDesc( frameIndex, i );
-        }
+void TextureManager::FreeSlot( uint32_t slotIndex )
+{
+    if( textures[ slotIndex ].image != VK_NULL_HANDLE )
+    {
+        textureDedup.UnbindSlot( textures[ slotIndex ].image, slotIndex );
     }
 
-    textureDesc->FlushDescWrites();
+    textures[ slotIndex ] = {};
+    textureSlots.Release( slotIndex );
+    UpdateDescriptor( slotIndex );
+}
+
+void TextureManager::UpdateDescriptor( uint32_t slotIndex )
+{
+    const Texture& t = textures[ slotIndex ];
+
+    // a texture that is still being copied in parts is not bound
+    if( t.image != VK_NULL_HANDLE && !textureUploader->IsPending( t.image ) )
+    {
+        textureDesc->SetTexture( slotIndex, t.view, t.samplerHandle );
+    }
+    else
+    {
+        // reset descriptor to empty texture
+        textureDesc->ResetTexture( slotIndex );
+    }
 }
 
 bool TextureManager::TryCreateMaterial( VkCommandBuffer              cmd,
                                         uint32_t                     frameIndex,
                                         const RgOriginalTextureInfo& info,
-                                        const std::filesystem::path& ovrdFolder )
+                                        const TextureFolderIndex&    ovrdIndex )
 {
     if( Utils::IsCstrEmpty( info.pTextureName ) )
     {
@@ -511,16 +865,14 @@ bool TextureManager::TryCreateMaterial( VkCommandBuffer              cmd,
     auto details = pnext::find< RgOriginalTextureDetailsEXT >( &info );
 
 
-    // clang-format off
-    TextureOverrides ovrd[] = {
-        TextureOverrides{ ovrdFolder, info.pTextureName, postfixes[ 0 ], info.pPixels, info.size, getVkFormat( details, VK_FORMAT_R8G8B8A8_SRGB ), OnlyKTX2LoaderIfNonDevMode() },
-        TextureOverrides{ ovrdFolder, info.pTextureName, postfixes[ 1 ], nullptr, {}, VK_FORMAT_R8G8B8A8_UNORM, OnlyKTX2LoaderIfNonDevMode() },
-        TextureOverrides{ ovrdFolder, info.pTextureName, postfixes[ 2 ], nullptr, {}, VK_FORMAT_R8G8B8A8_UNORM, OnlyKTX2LoaderIfNonDevMode() },
-        TextureOverrides{ ovrdFolder, info.pTextureName, postfixes[ 3 ], nullptr, {}, VK_FORMAT_R8G8B8A8_SRGB, OnlyKTX2LoaderIfNonDevMode() },
-        TextureOverrides{ ovrdFolder, info.pTextureName, postfixes[ 4 ], nullptr, {}, VK_FORMAT_R8_UNORM, OnlyKTX2LoaderIfNonDevMode() },
+    const VkFormat formats[] = {
+        getVkFormat( details, VK_FORMAT_R8G8B8A8_SRGB ),
+        VK_FORMAT_R8G8B8A8_UNORM,
+        VK_FORMAT_R8G8B8A8_UNORM,
+        VK_FORMAT_R8G8B8A8_SRGB,
+        VK_FORMAT_R8_UNORM,
     };
-    static_assert( std::size( ovrd ) == TEXTURES_PER_MATERIAL_COUNT );
-    // clang-format on
+    static_assert( std::size( formats ) == TEXTURES_PER_MATERIAL_COUNT );
 
 
     SamplerManager::Handle samplers[] = {
@@ -557,16 +909,190 @@ bool TextureManager::TryCreateMaterial( VkCommandBuffer              cmd,
     }
 
 
-    MakeMaterial( cmd, frameIndex, info.pTextureName, ovrd, samplers, swizzlings );
+    if( textureStreamer )
+    {
+        MakeMaterialStreamed( cmd, frameIndex, info, ovrdIndex, formats, samplers, swizzlings );
+        return true;
+    }
+
+
+    // clang-format off
+    TextureOverrides ovrd[] = {
+        TextureOverrides{ ovrdIndex, info.pTextureName, postfixes[ 0 ], info.pPixels, info.size, formats[ 0 ], OnlyKTX2LoaderIfNonDevMode() },
+        TextureOverrides{ ovrdIndex, info.pTextureName, postfixes[ 1 ], nullptr, {}, formats[ 1 ], OnlyKTX2LoaderIfNonDevMode() },
+        TextureOverrides{ ovrdIndex, info.pTextureName, postfixes[ 2 ], nullptr, {}, formats[ 2 ], OnlyKTX2LoaderIfNonDevMode() },
+        TextureOverrides{ ovrdIndex, info.pTextureName, postfixes[ 3 ], nullptr, {}, formats[ 3 ], OnlyKTX2LoaderIfNonDevMode() },
+        TextureOverrides{ ovrdIndex, info.pTextureName, postfixes[ 4 ], nullptr, {}, formats[ 4 ], OnlyKTX2LoaderIfNonDevMode() },
+    };
+    static_assert( std::size( ovrd ) == TEXTURES_PER_MATERIAL_COUNT );
+    // clang-format on
+
+    auto compressed = std::optional< TextureOverrides >{};
+    auto cachePath  = UseCompressedOriginal(
+        ovrdIndex, info, formats[ TEXTURE_ALBEDO_ALPHA_INDEX ], ovrd[ 0 ], compressed );
+
+    auto mtextures = MakeMaterial( cmd, frameIndex, info.pTextureName, ovrd, samplers, swizzlings );
+
+    if( !cachePath.empty() && mtextures.indices[ 0 ] != EMPTY_TEXTURE_INDEX )
+    {
+        textureCompressor->Enqueue( mtextures.indices[ 0 ],
+                                    textureSlots.GetGeneration( mtextures.indices[ 0 ] ),
+                                    { info.pPixels, info.size, formats[ 0 ] },
+                                    std::move( cachePath ) );
+    }
     return true;
 }
 
-void TextureManager::MakeMaterial( VkCommandBuffer                                  cmd,
+auto TextureManager::UseCompressedOriginal( const TextureFolderIndex&          ovrdIndex,
+                                            const RgOriginalTextureInfo&       info,
+                                            VkFormat                           format,
+                                            TextureOverrides&                  original,
+                                            std::optional< TextureOverrides >& cached )
+    -> std::filesystem::path
+{
+    // an override file was found, or there are no pixels
+    if( !textureCompressor || !original.result || original.result->pData != info.pPixels )
+    {
+        return {};
+    }
+
+    if( !TextureCompressor::CanCompress( format, info.size ) )
+    {
+        return {};
+    }
+
+    auto cachePath = TextureCompressor::GetCachePath(
+        ovrdIndex.GetFolder(), { info.pPixels, info.size, format } );
+
+    if( std::filesystem::exists( cachePath ) )
+    {
+        cached.emplace( cachePath,
+                        Utils::IsSRGB( format ),
+                        std::tuple< ImageLoader* >{ imageLoaderKtx.get() } );
+
+        if( cached->result )
+        {
+            // keep the path of the original, so a dev file can still hot-reload it
+            original.result = cached->result;
+            return {};
+        }
+
+        debug::Warning( "Failed to load a cached compressed texture, recompressing: {}",
+                        cachePath.string() );
+    }
+
+    return cachePath;
+}
+
+void TextureManager::MakeMaterialStreamed(
+    VkCommandBuffer                                  cmd,
+    uint32_t                                         frameIndex,
+    const RgOriginalTextureInfo&                     info,
+    const TextureFolderIndex&                        ovrdIndex,
+    std::span< const VkFormat >                      formats,
+    std::span< const SamplerManager::Handle >        samplers,
+    std::span< std::optional< RgTextureSwizzling > > swizzlings )
+{
+    assert( textureStreamer );
+    assert( formats.size() == TEXTURES_PER_MATERIAL_COUNT );
+    assert( samplers.size() == TEXTURES_PER_MATERIAL_COUNT );
+    assert( swizzlings.size() == TEXTURES_PER_MATERIAL_COUNT );
+
+    MaterialTextures mtextures = {};
+    static_assert( EMPTY_TEXTURE_INDEX == 0 );
+
+    for( uint32_t i = 0; i < TEXTURES_PER_MATERIAL_COUNT; i++ )
+    {
+        auto found = TextureOverrides::FindOverride(
+            ovrdIndex, info.pTextureName, postfixes[ i ], OnlyKTX2LoaderIfNonDevMode() );
+
+        if( found.path.empty() )
+        {
+            // original pixels are already in memory, nothing to wait for
+            if( i == TEXTURE_ALBEDO_ALPHA_INDEX )
+            {
+                // no override was found, so with no loaders, only the default pixels are used
+                auto original = TextureOverrides{ ovrdIndex,
+                                                  info.pTextureName,
+                                                  postfixes[ i ],
+                                                  info.pPixels,
+                                                  info.size,
+                                                  formats[ i ],
+                                                  std::tuple< ImageLoader* >{ nullptr } };
+
+                auto compressed = std::optional< TextureOverrides >{};
+                auto cachePath =
+                    UseCompressedOriginal( ovrdIndex, info, formats[ i ], original, compressed );
+
+                mtextures.indices[ i ] = PrepareTexture( cmd,
+                                                         frameIndex,
+                                                         original.result,
+                                                         samplers[ i ],
+                                                         true,
+                                                         original.debugname,
+                                                         false,
+                                                         swizzlings[ i ],
+                                                         std::move( original.path ),
+                                                         AllocateSlot() );
+
+                // the uncompressed texture is a placeholder until compression is done
+                if( !cachePath.empty() && mtextures.indices[ i ] != EMPTY_TEXTURE_INDEX )
+                {
+                    const uint32_t t = mtextures.indices[ i ];
+                    textureCompressor->Enqueue( t,
+                                                textureSlots.GetGeneration( t ),
+                                                { info.pPixels, info.size, formats[ i ] },
+                                                std::move( cachePath ) );
+                }
+            }
+            continue;
+        }
+
+        auto slot = AllocateSlot();
+        if( slot == textures.end() )
+        {
+            debug::Warning( "Reached texture limit: {}, couldn't stream {}",
+                            textures.size(),
+                            found.path.string() );
+            continue;
+        }
+
+        // reserve, so the material gets its final index right away
+        slot->reserved = true;
+
+        const auto slotIndex = uint32_t( std::distance( textures.begin(), slot ) );
+
+        auto request = TextureStreamer::Request{
+            .slot          = slotIndex,
+            .generation    = textureSlots.GetGeneration( slotIndex ),
+            .path          = std::move( found.path ),
+            .packed        = found.packed,
+            .isSRGB        = Utils::IsSRGB( formats[ i ] ),
+            .samplerHandle = samplers[ i ],
+            .swizzling     = swizzlings[ i ],
+            .debugname     = {},
+        };
+        Utils::SafeCstrCopy( request.debugname, info.pTextureName );
+
+        mtextures.indices[ i ] = request.slot;
+        textureStreamer->Enqueue( std::move( request ) );
+    }
+
+    InsertMaterial( frameIndex,
+                    info.pTextureName,
+                    Material{
+                        .textures     = mtextures,
+                        .isUpdateable = false,
+                    } );
+}
+
+auto TextureManager::MakeMaterial( VkCommandBuffer                                  cmd,
                                    uint32_t                                         frameIndex,
                                    std::string_view                                 materialName,
                                    std::span< TextureOverrides >                    ovrd,
                                    std::span< const SamplerManager::Handle >        samplers,
                                    std::span< std::optional< RgTextureSwizzling > > swizzlings )
+    -> MaterialTextures
 {
     assert( ovrd.size() == TEXTURES_PER_MATERIAL_COUNT );
     assert( samplers.size() == TEXTURES_PER_MATERIAL_COUNT );
@@ -586,7 +1112,7 @@ void TextureManager::MakeMaterial( VkCommandBuffer
                                                  isUpdateable,
                                                  swizzlings[ i ],
                                                  std::move( ovrd[ i ].path ),
-                                                 FindEmptySlot( textures ) );
+                                                 AllocateSlot() );
     }
 
     InsertMaterial( frameIndex,
@@ -595,6 +1121,7 @@ void TextureManager::MakeMaterial( VkCommandBuffer
                         .textures     = mtextures,
                         .isUpdateable = isUpdateable,
                     } );
+    return mtextures;
 }
 
 bool TextureManager::TryCreateImportedMaterial( VkCommandBuffer    cmd,
@@ -604,9 +1131,81 @@ bool TextureManager::TryCreateImportedMaterial( VkCommandBuffer    cmd,
                                                 std::span< const SamplerManager::Handle > samplers,
                                                 RgTextureSwizzling customPbrSwizzling,
                                                 bool               isReplacement )
+{
+    if( !ShouldCreateImportedMaterial( materialName, fullPaths, isReplacement ) )
+    {
+        // true, if already uploaded
+        return importedMaterials.contains( materialName );
+    }
+
+    auto loaded = LoadImportedTextures( fullPaths, AnyImageLoader() );
+
+    CreateImportedMaterial( cmd,
+                            frameIndex,
+                            materialName,
+                            *loaded,
+                            samplers,
+                            customPbrSwizzling,
+                            isReplacement );
+    return true;
+}
+
+void TextureManager::CreateImportedMaterials( VkCommandBuffer                     cmd,
+                                              uint32_t                            frameIndex,
+                                              std::span< const ImportedMaterial > imported )
+{
+    auto batch = TextureBatchLoader{
+        jobs,
+        &TextureManager::LoadImportedTextures,
+        uint64_t{ LibConfig().importTextureLoadBudgetMB } * 1024 * 1024,
+        isdevmode,
+    };
+
+    // check on this thread, so the skipped materials are not loaded at all
+    auto toCreate = std::vector< const ImportedMaterial* >{};
+    for( const ImportedMaterial& m : imported )
+    {
+        assert( m.samplers.size() == TEXTURES_PER_MATERIAL_COUNT );
+
+        if( ShouldCreateImportedMaterial( m.materialName, m.fullPaths, m.isReplacement ) )
+        {
+            toCreate.push_back( &m );
+            batch.Add( m.fullPaths );
+        }
+    }
+
+    for( size_t i = 0; i < toCreate.size(); i++ )
+    {
+        const ImportedMaterial& m      = *toCreate[ i ];
+        auto&                   loaded = batch.Take( i );
+
+        // the same name could be earlier in the list
+        auto found = importedMaterials.find( m.materialName );
+        if( found != importedMaterials.end() )
+        {
+            if( m.isReplacement )
+            {
+                found->second = ImportedType::ForReplacement;
+            }
+            continue;
+        }
+
+        CreateImportedMaterial( cmd,
+                                frameIndex,
+                                m.materialName,
+                                loaded,
+                                m.samplers,
+                                m.customPbrSwizzling,
+                                m.isReplacement );
+    }
+}
+
+bool TextureManager::ShouldCreateImportedMaterial(
+    std::string_view                         materialName,
+    std::span< const std::filesystem::path > fullPaths,
+    bool                                     isReplacement )
 {
     assert( fullPaths.size() == TEXTURES_PER_MATERIAL_COUNT );
-    assert( samplers.size() == TEXTURES_PER_MATERIAL_COUNT );
 
     if( materialName.empty() )
     {
@@ -623,7 +1222,7 @@ bool TextureManager::TryCreateImportedMaterial( VkCommandBuffer    cmd,
                 // promote to a stronger type
                 found->second = ImportedType::ForReplacement;
             }
-            return true;
+            return false;
         }
     }
 
@@ -657,17 +1256,36 @@ bool TextureManager::TryCreateImportedMaterial( VkCommandBuffer    cmd,
         return false;
     }
 
+    return true;
+}
+
+auto TextureManager::LoadImportedTextures( std::span< const std::filesystem::path > fullPaths,
+                                           TextureOverrides::Loader                 loader )
+    -> std::unique_ptr< TextureBatchLoader::Textures >
+{
+    assert( fullPaths.size() == TEXTURES_PER_MATERIAL_COUNT );
+
     // clang-format off
-    TextureOverrides ovrd[] = {
-        TextureOverrides{ fullPaths[ 0 ], true, AnyImageLoader() },
-        TextureOverrides{ fullPaths[ 1 ], false, AnyImageLoader() },
-        TextureOverrides{ fullPaths[ 2 ], false, AnyImageLoader() },
-        TextureOverrides{ fullPaths[ 3 ], true, AnyImageLoader() },
-        TextureOverrides{ fullPaths[ 4 ], true, AnyImageLoader() },
-    };
-    static_assert( std::size( ovrd ) == TEXTURES_PER_MATERIAL_COUNT );
+    return std::unique_ptr< TextureBatchLoader::Textures >( new TextureBatchLoader::Textures{ {
+        TextureOverrides{ fullPaths[ 0 ], true, loader },
+        TextureOverrides{ fullPaths[ 1 ], false, loader },
+        TextureOverrides{ fullPaths[ 2 ], false, loader },
+        TextureOverrides{ fullPaths[ 3 ], true, loader },
+        TextureOverrides{ fullPaths[ 4 ], true, loader },
+    } } );
     // clang-format on
+}
 
+void TextureManager::CreateImportedMaterial( VkCommandBuffer                           cmd,
+                                             uint32_t                                  frameIndex,
+                                             std::string_view                          materialName,
+                                             std::span< TextureOverrides >             loaded,
+                                             std::span< const SamplerManager::Handle > samplers,
+                                             RgTextureSwizzling customPbrSwizzling,
+                                             bool               isReplacement )
+{
+    assert( loaded.size() == TEXTURES_PER_MATERIAL_COUNT );
+    assert( samplers.size() == TEXTURES_PER_MATERIAL_COUNT );
 
     std::optional< RgTextureSwizzling > swizzlings[] = {
         std::nullopt,
@@ -684,8 +1302,7 @@ bool TextureManager::TryCreateImportedMaterial( VkCommandBuffer    cmd,
         materialName, isReplacement ? ImportedType::ForReplacement : ImportedType::ForStatic );
     assert( isNew );
 
-    MakeMaterial( cmd, frameIndex, materialName, ovrd, samplers, swizzlings );
-    return true;
+    MakeMaterial( cmd, frameIndex, materialName, loaded, samplers, swizzlings );
 }
 
 void TextureManager::FreeAllImportedMaterials( uint32_t frameIndex, bool freeReplacements )
@@ -725,6 +1342,10 @@ uint32_t TextureManager::PrepareTexture( VkCommandBuffer
 {
     if( !info )
     {
+        if( targetSlot != textures.end() )
+        {
+            FreeSlot( uint32_t( std::distance( textures.begin(), targetSlot ) ) );
+        }
         return EMPTY_TEXTURE_INDEX;
     }
 
@@ -741,12 +1362,16 @@ uint32_t TextureManager::PrepareTexture( VkCommandBuffer
         return EMPTY_TEXTURE_INDEX;
     }
 
+    const auto slotIndex = uint32_t( std::distance( textures.begin(), targetSlot ) );
+    assert( targetSlot->image == VK_NULL_HANDLE && !targetSlot->reserved );
+
     if( info->baseSize.width == 0 || info->baseSize.height == 0 )
     {
         debug::Warning( "Incorrect size ({},{}) of one of images in a texture {}",
                         info->baseSize.width,
                         info->baseSize.height,
                         Utils::SafeCstr( debugName ) );
+        FreeSlot( slotIndex );
         return EMPTY_TEXTURE_INDEX;
     }
 
@@ -763,45 +1388,73 @@ uint32_t TextureManager::PrepareTexture( VkCommandBuffer
     }
     // SHIPPING_HACK end
 
-    auto uploadInfo = TextureUploader::UploadInfo{
-        .cmd                    = cmd,
-        .frameIndex             = frameIndex,
-        .pData                  = info->pData,
-        .dataSize               = info->dataSize,
-        .cubemap                = {},
-        .baseSize               = info->baseSize,
-        .format                 = info->format,
-        .useMipmaps             = useMipmaps,
-        .pregeneratedLevelCount = info->isPregenerated ? info->levelCount : 0,
-        .pLevelDataOffsets      = info->levelOffsets,
-        .pLevelDataSizes        = info->levelSizes,
-        .isUpdateable           = isUpdateable,
-        .pDebugName             = debugName,
-        .isCubemap              = false,
-        .swizzling              = swizzling,
-    };
+    // identical contents share one image; updateable textures are modified in place
+    const auto contentKey = isUpdateable
+                                ? std::optional< uint64_t >{}
+                                : TextureDeduplicator::MakeKey( *info, useMipmaps, swizzling );
 
-    auto [ wasUploaded, image, view ] = textureUploader->UploadImage( uploadInfo );
+    auto shared = contentKey ? textureDedup.Acquire( *contentKey, *info ) : std::nullopt;
 
-    if( !wasUploaded )
+    if( !shared )
     {
-        debug::Warning(
-            "UploadImage fail on {}. Path: {}", Utils::SafeCstr( debugName ), filepath.string() );
+        auto uploadInfo = TextureUploader::UploadInfo{
+            .cmd                    = cmd,
+            .frameIndex             = frameIndex,
+            .pData                  = info->pData,
+            .dataSize               = info->dataSize,
+            .cubemap                = {},
+            .baseSize               = info->baseSize,
+            .format                 = info->format,
+            .useMipmaps             = useMipmaps,
+            .pregeneratedLevelCount = info->isPregenerated ? info->levelCount : 0,
+            .pLevelDataOffsets      = info->levelOffsets,
+            .pLevelDataSizes        = info->levelSizes,
+            .pZstdLevels            = info->pZstdLevels,
+            .isUpdateable           = isUpdateable,
+            .pDebugName             = debugName,
+            .isCubemap              = false,
+            .swizzling              = swizzling,
+        };
 
-        return EMPTY_TEXTURE_INDEX;
+        auto [ wasUploaded, image, view ] = textureUploader->UploadImage( uploadInfo );
+
+        if( !wasUploaded )
+        {
+            debug::Warning( "UploadImage fail on {}. Path: {}",
+                            Utils::SafeCstr( debugName ),
+                            filepath.string() );
+
+            FreeSlot( slotIndex );
+            return EMPTY_TEXTURE_INDEX;
+        }
+
+        if( contentKey )
+        {
+            textureDedup.Add( *contentKey, *info, image, view );
+        }
+
+        shared = TextureDeduplicator::Shared{ image, view };
     }
 
-    // insert
+    // new textures use the current filter
+    samplerHandle.SetIfHasDynamicSamplerFilter( currentDynamicSamplerFilter );
+
+    // insert, sampler and swizzling are per slot, even if the image is shared
     *targetSlot = Texture{
-        .image         = image,
-        .view          = view,
-        .size          = uploadInfo.baseSize,
-        .format        = uploadInfo.format,
+        .image         = shared->image,
+        .view          = shared->view,
+        .size          = info->baseSize,
+        .format        = info->format,
         .samplerHandle = samplerHandle,
-        .swizzling     = uploadInfo.swizzling,
+        .swizzling     = swizzling,
         .filepath      = std::move( filepath ),
     };
-    return uint32_t( std::distance( textures.begin(), targetSlot ) );
+
+    // the slot could be released right before, to be refilled
+    textureSlots.Claim( slotIndex );
+    textureDedup.BindSlot( shared->image, slotIndex );
+    UpdateDescriptor( slotIndex );
+    return slotIndex;
 }
 
 void TextureManager::InsertMaterial( uint32_t         frameIndex,
@@ -837,6 +1490,27 @@ void TextureManager::DestroyMaterialTextures( uint32_t frameIndex, const Materia
     {
         if( t != EMPTY_TEXTURE_INDEX )
         {
+            if( textures[ t ].reserved )
+            {
+                // still loading: discard the result, the slot can be reused right away
+                assert( textureStreamer );
+                textureStreamer->Cancel( t );
+                FreeSlot( t );
+                continue;
+            }
+
+            if( textureResidency && textureResidency->IsTracked( t ) )
+            {
+                // discard a reload of other levels, if any
+                textureStreamer->Cancel( t );
+                textureResidency->Untrack( t );
+            }
+
+            if( textureCompressor )
+            {
+                textureCompressor->Cancel( t );
+            }
+
             AddToBeDestroyed( frameIndex, textures[ t ] );
         }
     }
@@ -867,17 +1541,24 @@ void TextureManager::DestroyTexture( const Texture& texture )
 {
     assert( texture.image != VK_NULL_HANDLE && texture.view != VK_NULL_HANDLE );
 
-    textureUploader->DestroyImage( texture.image, texture.view );
+    // other slots might still use the same image
+    if( textureDedup.Release( texture.image ) )
+    {
+        textureUploader->DestroyImage( texture.image, texture.view );
+    }
 }
 
 void TextureManager::AddToBeDestroyed( uint32_t frameIndex, Texture& texture )
 {
     assert( texture.image != VK_NULL_HANDLE && texture.view != VK_NULL_HANDLE );
 
+    const auto slotIndex = uint32_t( &texture - textures.data() );
+    assert( slotIndex < textures.size() );
+
     texturesToDestroy[ frameIndex ].push_back( std::move( texture ) );
 
-    // nullify the slot
-    texture = {};
+    // nullify the slot, it can be refilled right away
+    FreeSlot( slotIndex );
 }
 
 MaterialTextures TextureManager::GetMaterialTextures( const char* materialName ) const
@@ -907,6 +1588,31 @@ VkDescriptorSetLayout TextureManager::GetDescSetLayout() const
     return textureDesc->GetDescSetLayout();
 }
 
+uint32_t TextureManager::GetStreamingPendingCount() const
+{
+    return textureStreamer ? textureStreamer->GetPendingCount() : 0;
+}
+
+auto TextureManager::GetUploadStatistics() const -> TextureUploader::Statistics
+{
+    return textureUploader->GetStatistics();
+}
+
+auto TextureManager::GetExportPendingCount() const -> uint32_t
+{
+    return textureExporter->GetPendingCount();
+}
+
+auto TextureManager::GetDeduplicator() const -> const TextureDeduplicator&
+{
+    return textureDedup;
+}
+
+const TextureResidency* TextureManager::GetResidency() const
+{
+    return textureResidency.get();
+}
+
 void TextureManager::OnFileChanged( FileType type, const std::filesystem::path& filepath )
 {
     if( type == FileType::PNG || type == FileType::TGA || type == FileType::KTX2 ||
@@ -1057,7 +1763,7 @@ auto TextureManager::ExportMaterialTextures( const char*                  materi
         const Texture& info = textures[ txds.indices[ i ] ];
 
         if( info.image == VK_NULL_HANDLE || info.size.width == 0 || info.size.height == 0 ||
-            info.format == VK_FORMAT_UNDEFINED )
+            info.format == VK_FORMAT_UNDEFINED || textureUploader->IsPending( info.image ) )
         {
             continue;
         }
@@ -1077,14 +1783,13 @@ auto TextureManager::ExportMaterialTextures( const char*                  materi
         }
         else
         {
-            exported = TextureExporter{}.ExportAsTGA( *memAllocator,
-                                                      *cmdManager,
-                                                      info.image,
-                                                      info.size,
-                                                      info.format,
-                                                      folder / relativeFilePath,
-                                                      asSrgb,
-                                                      overwriteExisting );
+            // the file is written a few frames later
+            exported = textureExporter->Enqueue( info.image,
+                                                 info.size,
+                                                 info.format,
+                                                 folder / relativeFilePath,
+                                                 asSrgb,
+                                                 overwriteExisting );
         }
 
         if( exported )
@@ -1130,8 +1835,9 @@ void TextureManager::ExportOriginalMaterialTextures( const std::filesystem::path
 
             const Texture& info = textures[ txds.indices[ i ] ];
 
-            if( info.image == VK_NULL_HANDLE || info.size.width == 0 || info.size.height == 0 ||
-                info.format == VK_FORMAT_UNDEFINED )
+            if( info.image == VK_NULL_HANDLE || info.size.width == 0 ||
+                info.size.height == 0 || info.format == VK_FORMAT_UNDEFINED ||
+                textureUploader->IsPending( info.image ) )
             {
                 continue;
             }
@@ -1142,14 +1848,12 @@ void TextureManager::ExportOriginalMaterialTextures( const std::filesystem::path
             bool asSrgb = ( i == TEXTURE_ALBEDO_ALPHA_INDEX ) || ( i == TEXTURE_EMISSIVE_INDEX );
             assert( asSrgb == Utils::IsSRGB( info.format ) );
 
-            TextureExporter().ExportAsTGA( *memAllocator,
-                                           *cmdManager,
-                                           info.image,
-                                           info.size,
-                                           info.format,
-                                           folder / relativeFilePath,
-                                           asSrgb,
-                                           overwriteExisting );
+            textureExporter->Enqueue( info.image,
+                                      info.size,
+                                      info.format,
+                                      folder / relativeFilePath,
+                                      asSrgb,
+                                      overwriteExisting );
         }
     }
 }
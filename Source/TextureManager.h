@@ -29,11 +29,21 @@
 #include "IFileDependency.h"
 #include "ImageLoader.h"
 #include "ImageLoaderDev.h"
+#include "JobSystem.h"
 #include "Material.h"
 #include "MemoryAllocator.h"
 #include "SamplerManager.h"
 #include "TextureDescriptors.h"
+#include "TextureExporter.h"
+#include "TextureBatchLoader.h"
+#include "TextureCompressor.h"
+#include "TextureDeduplicator.h"
+#include "TextureFeedback.h"
+#include "TextureFolderIndex.h"
 #include "TextureOverrides.h"
+#include "TextureResidency.h"
+#include "TextureSlotAllocator.h"
+#include "TextureStreamer.h"
 #include "TextureUploader.h"
 
 namespace RTGL1
@@ -50,6 +60,7 @@ public:
                     std::shared_ptr< MemoryAllocator >      memAllocator,
                     std::shared_ptr< SamplerManager >       samplerManager,
                     std::shared_ptr< CommandBufferManager > cmdManager,
+                    std::shared_ptr< JobSystem >            jobSystem,
                     const std::filesystem::path&            waterNormalTexturePath,
                     const std::filesystem::path&            dirtMaskTexturePath,
                     const std::filesystem::path&            sceneBuildingTexturePath,
@@ -64,6 +75,21 @@ public:
 
     void PrepareForFrame( uint32_t frameIndex );
     void TryHotReload( VkCommandBuffer cmd, uint32_t frameIndex );
+    // Continue copying the textures that didn't fit the staging ring on previous frames
+    void UploadPending( VkCommandBuffer cmd );
+    // Upload textures that were loaded by the streamer, within a per-frame budget
+    void UploadStreamed( VkCommandBuffer cmd, uint32_t frameIndex );
+    // Replace original textures with their block-compressed versions, once they are written
+    void UploadCompressed( VkCommandBuffer cmd, uint32_t frameIndex );
+    // Read back the textures that were queued by the Export* functions, and write
+    // the files of the ones that were read back MAX_FRAMES_IN_FLIGHT frames ago
+    void RecordExports( VkCommandBuffer cmd, uint32_t frameIndex );
+    // Must be recorded before / after all texture sampling of a frame, to get the mip levels
+    // requested by shaders; no-op, if mip streaming is disabled
+    void ResetFeedback( VkCommandBuffer cmd );
+    void CopyFeedback( VkCommandBuffer cmd, uint32_t frameIndex );
+    // If shaders should write the feedback, i.e. if mip streaming is enabled
+    bool IsFeedbackEnabled() const;
 
     void SubmitDescriptors( uint32_t                         frameIndex,
                             const RgDrawFrameTexturesParams& texturesParams,
@@ -73,7 +99,7 @@ public:
     bool TryCreateMaterial( VkCommandBuffer              cmd,
                             uint32_t                     frameIndex,
                             const RgOriginalTextureInfo& info,
-                            const std::filesystem::path& ovrdFolder );
+                            const TextureFolderIndex&    ovrdIndex );
 
     bool TryCreateImportedMaterial( VkCommandBuffer                           cmd,
                                     uint32_t                                  frameIndex,
@@ -82,6 +108,20 @@ public:
                                     std::span< const SamplerManager::Handle > samplers,
                                     RgTextureSwizzling                        customPbrSwizzling,
                                     bool                                      isReplacement );
+
+    struct ImportedMaterial
+    {
+        std::string_view                          materialName;
+        std::span< const std::filesystem::path >  fullPaths;
+        std::span< const SamplerManager::Handle > samplers;
+        RgTextureSwizzling                        customPbrSwizzling;
+        bool                                      isReplacement;
+    };
+    // Same as TryCreateImportedMaterial for each, but the files of all materials are loaded
+    // on the job system, while the textures are uploaded in the order of the materials
+    void CreateImportedMaterials( VkCommandBuffer                     cmd,
+                                  uint32_t                            frameIndex,
+                                  std::span< const ImportedMaterial > imported );
     void FreeAllImportedMaterials( uint32_t frameIndex, bool freeReplacements );
 
     bool TryDestroyMaterial( uint32_t frameIndex, const char* materialName );
@@ -93,6 +133,12 @@ public:
     auto GetWaterNormalTextureIndex() const -> uint32_t;
     auto GetDirtMaskTextureIndex() const -> uint32_t;
     auto GetSceneBuildingTextureIndex() const -> uint32_t;
+    auto GetStreamingPendingCount() const -> uint32_t;
+    auto GetUploadStatistics() const -> TextureUploader::Statistics;
+    auto GetDeduplicator() const -> const TextureDeduplicator&;
+    auto GetExportPendingCount() const -> uint32_t;
+    // null, if mip streaming is disabled
+    auto GetResidency() const -> const TextureResidency*;
 
     auto GetMaterialTextures( const char* materialName ) const -> MaterialTextures;
 
@@ -111,6 +157,7 @@ public:
         RgSamplerFilter      filter{ RG_SAMPLER_FILTER_AUTO };
     };
 
+    // Files are written asynchronously, a few frames later, see RecordExports
     auto ExportMaterialTextures( const char*                  materialName,
                                  const std::filesystem::path& folder,
                                  bool                         overwriteExisting,
@@ -143,12 +190,30 @@ private:
                                          uint32_t                     frameIndex,
                                          const std::filesystem::path& filepath );
 
-    void MakeMaterial( VkCommandBuffer                                  cmd,
+    void MakeMaterialStreamed( VkCommandBuffer                                  cmd,
+                               uint32_t                                         frameIndex,
+                               const RgOriginalTextureInfo&                     info,
+                               const TextureFolderIndex&                        ovrdIndex,
+                               std::span< const VkFormat >                      formats,
+                               std::span< const SamplerManager::Handle >        samplers,
+                               std::span< std::optional< RgTextureSwizzling > > swizzlings );
+
+    // If the original pixels are used, replace them with their cached compressed version.
+    // Otherwise, returns the path to write the compressed version to, if it should be made.
+    auto UseCompressedOriginal( const TextureFolderIndex&          ovrdIndex,
+                                const RgOriginalTextureInfo&       info,
+                                VkFormat                           format,
+                                TextureOverrides&                  original,
+                                std::optional< TextureOverrides >& cached )
+        -> std::filesystem::path;
+
+    auto MakeMaterial( VkCommandBuffer                                  cmd,
                        uint32_t                                         frameIndex,
                        std::string_view                                 materialName,
                        std::span< TextureOverrides >                    ovrd,
                        std::span< const SamplerManager::Handle >        samplers,
-                       std::span< std::optional< RgTextureSwizzling > > swizzlings );
+                       std::span< std::optional< RgTextureSwizzling > > swizzlings )
+        -> MaterialTextures;
 
     uint32_t PrepareTexture( VkCommandBuffer                                 cmd,
                              uint32_t                                        frameIndex,
@@ -162,8 +227,30 @@ private:
                              std::vector< Texture >::iterator                targetSlot );
 
     void DestroyTexture( const Texture& texture );
+    // Texture must be in a slot
     void AddToBeDestroyed( uint32_t frameIndex, Texture& texture );
 
+    // End iterator, if there are no free slots
+    auto AllocateSlot() -> std::vector< Texture >::iterator;
+    void FreeSlot( uint32_t slotIndex );
+    // Must be called after a slot was changed
+    void UpdateDescriptor( uint32_t slotIndex );
+
+    // Also promotes the existing imported material, if isReplacement
+    bool ShouldCreateImportedMaterial( std::string_view                         materialName,
+                                       std::span< const std::filesystem::path > fullPaths,
+                                       bool                                     isReplacement );
+    void CreateImportedMaterial( VkCommandBuffer                           cmd,
+                                 uint32_t                                  frameIndex,
+                                 std::string_view                          materialName,
+                                 std::span< TextureOverrides >             loaded,
+                                 std::span< const SamplerManager::Handle > samplers,
+                                 RgTextureSwizzling                        customPbrSwizzling,
+                                 bool                                      isReplacement );
+    static auto LoadImportedTextures( std::span< const std::filesystem::path > fullPaths,
+                                      TextureOverrides::Loader                 loader )
+        -> std::unique_ptr< TextureBatchLoader::Textures >;
+
     void InsertMaterial( uint32_t         frameIndex,
                          std::string_view materialName,
                          const Material&  material );
@@ -211,12 +298,27 @@ private:
 
     std::shared_ptr< MemoryAllocator >      memAllocator;
     std::shared_ptr< CommandBufferManager > cmdManager;
+    std::shared_ptr< JobSystem >            jobs;
 
     std::shared_ptr< SamplerManager >     samplerMgr;
     std::shared_ptr< TextureDescriptors > textureDesc;
     std::shared_ptr< TextureUploader >    textureUploader;
+    // null, if streaming is disabled
+    std::unique_ptr< TextureStreamer >    textureStreamer;
+    std::unique_ptr< TextureFeedback >    textureFeedback;
+    // null, if mip streaming is disabled
+    std::unique_ptr< TextureResidency >   textureResidency;
+    // null, if texture compression is disabled
+    std::unique_ptr< TextureCompressor >  textureCompressor;
+    std::unique_ptr< TextureExporter >    textureExporter;
+
+    // requests that loaded the slots tracked by textureResidency, to reload other levels
+    std::vector< TextureStreamer::Request > streamSources;
+    uint64_t                                frameId;
 
     std::vector< Texture >               textures;
+    TextureSlotAllocator                 textureSlots{ TEXTURE_COUNT_MAX };
+    TextureDeduplicator                  textureDedup;
     // Textures are not destroyed immediately, but only when they are not in use anymore
     std::vector< Texture >               texturesToDestroy[ MAX_FRAMES_IN_FLIGHT ];
     std::vector< std::filesystem::path > texturesToReload;
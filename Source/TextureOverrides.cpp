@@ -26,6 +26,7 @@
 
 #include "Const.h"
 #include "ImageLoader.h"
+#include "TextureFolderIndex.h"
 #include "Utils.h"
 
 using namespace RTGL1;
@@ -61,6 +62,17 @@ namespace loader
 {
     namespace detail
     {
+        // packed texture is identified by the path of a loose file, that would override it
+        auto PackedPath( const TextureFolderIndex& ovrdIndex,
+                         std::string_view          name,
+                         std::string_view          postfix )
+        {
+            return TextureOverrides::GetTexturePath( ovrdIndex.GetFolder() / TEXTURES_FOLDER,
+                                                     name,
+                                                     postfix,
+                                                     ImageLoader::GetExtensions()[ 0 ] );
+        }
+
         template< typename T >
         auto LoadByFullPath( T& specificLoader, const std::filesystem::path& filepath )
         {
@@ -78,7 +90,7 @@ namespace loader
         template< size_t I, typename Loaders >
             requires( I >= std::tuple_size_v< Loaders > )
         auto LoadByIndex( Loaders&,
-                          const std::filesystem::path&,
+                          const TextureFolderIndex&,
                           std::string_view,
                           std::string_view,
                           std::filesystem::path& outPath )
@@ -89,32 +101,88 @@ namespace loader
 
         template< size_t I, typename Loaders >
             requires( I < std::tuple_size_v< Loaders > )
-        auto LoadByIndex( Loaders&                     loaders,
-                          const std::filesystem::path& ovrdFolder,
-                          std::string_view             name,
-                          std::string_view             postfix,
-                          std::filesystem::path&       outPath )
+        auto LoadByIndex( Loaders&                  loaders,
+                          const TextureFolderIndex& ovrdIndex,
+                          std::string_view          name,
+                          std::string_view          postfix,
+                          std::filesystem::path&    outPath )
         {
             if( auto l = std::get< I >( loaders ) )
             {
                 using LoaderType = std::remove_pointer_t< std::tuple_element_t< I, Loaders > >;
 
-                auto basePath = ovrdFolder / LoaderType::GetFolder();
+                auto filepath = ovrdIndex.Find(
+                    LoaderType::GetFolder(), LoaderType::GetExtensions(), name, postfix );
 
-                for( const char* ext : LoaderType::GetExtensions() )
+                // the index only contains existing files, no need to check
+                if( !filepath.empty() )
                 {
-                    auto filepath =
-                        TextureOverrides::GetTexturePath( basePath, name, postfix, ext );
-
-                    if( auto r = LoadByFullPath( *l, filepath ) )
+                    if( auto r = l->Load( filepath ) )
                     {
                         outPath = std::move( filepath );
                         return r;
                     }
                 }
+
+                // loose files take precedence over the packed ones
+                if constexpr( std::is_same_v< LoaderType, ImageLoader > )
+                {
+                    if( auto packed = ovrdIndex.FindPacked( name, postfix ); !packed.empty() )
+                    {
+                        if( auto r = l->Load( packed ) )
+                        {
+                            outPath = PackedPath( ovrdIndex, name, postfix );
+                            return r;
+                        }
+                    }
+                }
+            }
+
+            return LoadByIndex< I + 1 >( loaders, ovrdIndex, name, postfix, outPath );
+        }
+
+        template< size_t I, typename Loaders >
+            requires( I >= std::tuple_size_v< Loaders > )
+        auto FindByIndex( const Loaders&,
+                          const TextureFolderIndex&,
+                          std::string_view,
+                          std::string_view )
+        {
+            return TextureOverrides::OverrideFile{};
+        }
+
+        template< size_t I, typename Loaders >
+            requires( I < std::tuple_size_v< Loaders > )
+        auto FindByIndex( const Loaders&            loaders,
+                          const TextureFolderIndex& ovrdIndex,
+                          std::string_view          name,
+                          std::string_view          postfix )
+        {
+            if( std::get< I >( loaders ) )
+            {
+                using LoaderType = std::remove_pointer_t< std::tuple_element_t< I, Loaders > >;
+
+                auto filepath = ovrdIndex.Find(
+                    LoaderType::GetFolder(), LoaderType::GetExtensions(), name, postfix );
+
+                if( !filepath.empty() )
+                {
+                    return TextureOverrides::OverrideFile{ .path = std::move( filepath ) };
+                }
+
+                if constexpr( std::is_same_v< LoaderType, ImageLoader > )
+                {
+                    if( auto packed = ovrdIndex.FindPacked( name, postfix ); !packed.empty() )
+                    {
+                        return TextureOverrides::OverrideFile{
+                            .path   = PackedPath( ovrdIndex, name, postfix ),
+                            .packed = packed,
+                        };
+                    }
+                }
             }
 
-            return LoadByIndex< I + 1 >( loaders, ovrdFolder, name, postfix, outPath );
+            return FindByIndex< I + 1 >( loaders, ovrdIndex, name, postfix );
         }
 
         template< size_t I, typename Loaders >
@@ -141,13 +209,13 @@ namespace loader
     }
 
     template< typename Loaders >
-    auto Load( Loaders&                     loaders,
-               const std::filesystem::path& ovrdFolder,
-               std::string_view             name,
-               std::string_view             postfix,
-               std::filesystem::path&       outPath )
+    auto Load( Loaders&                  loaders,
+               const TextureFolderIndex& ovrdIndex,
+               std::string_view          name,
+               std::string_view          postfix,
+               std::filesystem::path&    outPath )
     {
-        return detail::LoadByIndex< 0 >( loaders, ovrdFolder, name, postfix, outPath );
+        return detail::LoadByIndex< 0 >( loaders, ovrdIndex, name, postfix, outPath );
     }
 
     template< typename Loaders >
@@ -156,6 +224,15 @@ namespace loader
         return detail::LoadByFullPathByIndex< 0 >( loaders, fullpath );
     }
 
+    template< typename Loaders >
+    auto Find( const Loaders&            loaders,
+               const TextureFolderIndex& ovrdIndex,
+               std::string_view          name,
+               std::string_view          postfix )
+    {
+        return detail::FindByIndex< 0 >( loaders, ovrdIndex, name, postfix );
+    }
+
     template< typename Loaders >
     void FreeLoaded( Loaders& loaders )
     {
@@ -177,13 +254,13 @@ namespace loader
 
 }
 
-TextureOverrides::TextureOverrides( const std::filesystem::path& _ovrdFolder,
-                                    std::string_view             _name,
-                                    std::string_view             _postfix,
-                                    const void*                  _defaultPixels,
-                                    const RgExtent2D&            _defaultSize,
-                                    VkFormat                     _defaultFormat,
-                                    Loader                       _loader )
+TextureOverrides::TextureOverrides( const TextureFolderIndex& _ovrdIndex,
+                                    std::string_view          _name,
+                                    std::string_view          _postfix,
+                                    const void*               _defaultPixels,
+                                    const RgExtent2D&         _defaultSize,
+                                    VkFormat                  _defaultFormat,
+                                    Loader                    _loader )
     : result{ std::nullopt }, debugname{}, iloader( std::move( _loader ) )
 {
     Utils::SafeCstrCopy( debugname, _name );
@@ -191,7 +268,7 @@ TextureOverrides::TextureOverrides( const std::filesystem::path& _ovrdFolder,
     
     std::visit(
         [ & ]( auto&& specific ) {
-            if( auto r = loader::Load( specific, _ovrdFolder, _name, _postfix, path ) )
+            if( auto r = loader::Load( specific, _ovrdIndex, _name, _postfix, path ) )
             {
                 r->format = Utils::IsSRGB( _defaultFormat ) ? Utils::ToSRGB( r->format )
                                                             : Utils::ToUnorm( r->format );
@@ -219,8 +296,11 @@ TextureOverrides::TextureOverrides( const std::filesystem::path& _ovrdFolder,
                     .dataSize       = *dataSize,
                     .baseSize       = _defaultSize,
                     .format         = _defaultFormat,
+                    .pZstdLevels    = nullptr,
+                    .contentHash    = 0,
                 };
-                path = GetTexturePath( _ovrdFolder / TEXTURES_FOLDER_DEV, _name, _postfix, "" );
+                path = GetTexturePath(
+                    _ovrdIndex.GetFolder() / TEXTURES_FOLDER_DEV, _name, _postfix, "" );
             }
         }
     }
@@ -246,6 +326,14 @@ TextureOverrides::TextureOverrides( const std::filesystem::path& _fullPath,
         iloader );
 }
 
+void TextureOverrides::GenerateMipmaps()
+{
+    if( result )
+    {
+        mipmaps.Generate( *result );
+    }
+}
+
 TextureOverrides::~TextureOverrides()
 {
     std::visit( []( auto&& specific ) { loader::FreeLoaded( specific ); }, iloader );
@@ -285,3 +373,13 @@ std::filesystem::path TextureOverrides::GetTexturePath( std::filesystem::path ba
 
     return basePath.append( validName ).make_preferred().concat( postfix ).concat( extension );
 }
+
+auto TextureOverrides::FindOverride( const TextureFolderIndex& ovrdIndex,
+                                     std::string_view          name,
+                                     std::string_view          postfix,
+                                     const Loader&             loader ) -> OverrideFile
+{
+    return std::visit(
+        [ & ]( auto&& specific ) { return loader::Find( specific, ovrdIndex, name, postfix ); },
+        loader );
+}
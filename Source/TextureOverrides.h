@@ -25,10 +25,13 @@
 #include "Common.h"
 #include "ImageLoader.h"
 #include "ImageLoaderDev.h"
+#include "MipmapGenerator.h"
 
 namespace RTGL1
 {
 
+class TextureFolderIndex;
+
 constexpr uint32_t TEXTURE_DEBUG_NAME_MAX_LENGTH = 32;
 
 // Struct for loading overriding texture files. Should be created on stack.
@@ -40,18 +43,22 @@ struct TextureOverrides
                                  std::tuple< ImageLoaderDev*, ImageLoader* > >;
 
 
-    explicit TextureOverrides( const std::filesystem::path& ovrdFolder,
-                               std::string_view             name,
-                               std::string_view             postfix,
-                               const void*                  defaultPixels,
-                               const RgExtent2D&            defaultSize,
-                               VkFormat                     defaultFormat,
-                               Loader                       loader );
+    explicit TextureOverrides( const TextureFolderIndex& ovrdIndex,
+                               std::string_view          name,
+                               std::string_view          postfix,
+                               const void*               defaultPixels,
+                               const RgExtent2D&         defaultSize,
+                               VkFormat                  defaultFormat,
+                               Loader                    loader );
 
     explicit TextureOverrides( const std::filesystem::path& fullPath, bool isSRGB, Loader loader );
 
     ~TextureOverrides();
 
+    // Build the mip chain of a raw image on CPU. Only for worker threads: on the calling
+    // thread, it's cheaper to leave the base level only, to generate the rest by GPU blits
+    void GenerateMipmaps();
+
     TextureOverrides( const TextureOverrides& other )                = delete;
     TextureOverrides( TextureOverrides&& other ) noexcept            = delete;
     TextureOverrides& operator=( const TextureOverrides& other )     = delete;
@@ -62,12 +69,28 @@ struct TextureOverrides
                                                  std::string_view      postfix,
                                                  std::string_view      extension );
 
+    struct OverrideFile
+    {
+        // empty, if there's no such file
+        std::filesystem::path path;
+        // if not empty, the KTX2 data is in the texture pack,
+        // and the path is where a loose file would override it
+        std::span< const uint8_t > packed;
+    };
+
+    // Find a file that would be loaded by the constructor, but without loading it.
+    static OverrideFile FindOverride( const TextureFolderIndex& ovrdIndex,
+                                      std::string_view          name,
+                                      std::string_view          postfix,
+                                      const Loader&             loader );
+
     std::optional< ImageLoader::ResultInfo > result;
     char                                     debugname[ TEXTURE_DEBUG_NAME_MAX_LENGTH ];
     std::filesystem::path                    path;
 
 private:
-    Loader iloader;
+    Loader          iloader;
+    MipmapGenerator mipmaps;
 };
 
 }
@@ -0,0 +1,197 @@
+/*
+
+Copyright (c) 2024 V.Shirokii
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#include "TexturePack.h"
+
+#include "DebugPrint.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+template< typename T >
+T ReadAt( std::span< const uint8_t > src, size_t offset )
+{
+    T t;
+    memcpy( &t, src.data() + offset, sizeof( T ) );
+    return t;
+}
+}
+
+std::string RTGL1::texturepack::MakeKey( std::string_view pathWithoutExtension )
+{
+    auto key = std::string( pathWithoutExtension );
+
+    for( char& c : key )
+    {
+        c = c == '\\' ? '/' : char( std::tolower( static_cast< unsigned char >( c ) ) );
+    }
+
+    return key;
+}
+
+uint64_t RTGL1::texturepack::HashKey( std::string_view key )
+{
+    // FNV-1a, to be the same in the packer and at runtime on any platform
+    uint64_t h = 14695981039346656037ull;
+    for( char c : key )
+    {
+        h ^= static_cast< unsigned char >( c );
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+auto RTGL1::texturepack::DescribeKtx2( std::span< const uint8_t > file ) -> std::optional< Entry >
+{
+    constexpr uint8_t identifier[] = {
+        0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n',
+    };
+    // identifier, 9 header fields, index
+    constexpr size_t levelIndexOffset = sizeof( identifier ) + 9 * sizeof( uint32_t ) +
+                                        4 * sizeof( uint32_t ) + 2 * sizeof( uint64_t );
+    constexpr size_t levelSize        = 3 * sizeof( uint64_t );
+
+    if( file.size() < levelIndexOffset || memcmp( file.data(), identifier, sizeof( identifier ) ) )
+    {
+        return std::nullopt;
+    }
+
+    auto header = [ & ]( uint32_t field ) {
+        return ReadAt< uint32_t >( file, sizeof( identifier ) + field * sizeof( uint32_t ) );
+    };
+
+    auto entry       = Entry{};
+    entry.vkFormat   = header( 0 );
+    entry.width      = header( 2 );
+    entry.height     = header( 3 );
+    entry.levelCount = std::clamp( header( 7 ), 1u, MaxLevels );
+
+    if( file.size() < levelIndexOffset + entry.levelCount * levelSize )
+    {
+        return std::nullopt;
+    }
+
+    for( uint32_t level = 0; level < entry.levelCount; level++ )
+    {
+        size_t at = levelIndexOffset + level * levelSize;
+
+        entry.levelOffsets[ level ] = ReadAt< uint64_t >( file, at );
+        entry.levelSizes[ level ]   = ReadAt< uint64_t >( file, at + sizeof( uint64_t ) );
+
+        if( entry.levelOffsets[ level ] + entry.levelSizes[ level ] > file.size() )
+        {
+            return std::nullopt;
+        }
+    }
+
+    return entry;
+}
+
+RTGL1::TexturePack::TexturePack( const std::filesystem::path& path ) : file{ path }
+{
+    if( !file.IsValid() )
+    {
+        return;
+    }
+
+    auto data = file.GetData();
+
+    if( data.size() < sizeof( texturepack::Header ) )
+    {
+        debug::Warning( "Texture pack is corrupted: {}", path.string() );
+        return;
+    }
+
+    auto header = ReadAt< texturepack::Header >( data, 0 );
+
+    if( memcmp( header.magic, texturepack::Magic, sizeof( header.magic ) ) != 0 ||
+        header.version != texturepack::Version )
+    {
+        debug::Warning( "Texture pack has unsupported version: {}", path.string() );
+        return;
+    }
+
+    uint64_t entriesEnd =
+        header.entriesOffset + uint64_t{ header.entryCount } * sizeof( texturepack::Entry );
+    uint64_t namesEnd = header.namesOffset + header.namesSize;
+
+    if( entriesEnd > data.size() || namesEnd > data.size() ||
+        header.entriesOffset % alignof( texturepack::Entry ) != 0 )
+    {
+        debug::Warning( "Texture pack is corrupted: {}", path.string() );
+        return;
+    }
+
+    // mapping is page-aligned, so the entries can be accessed in-place
+    entries = std::span{
+        reinterpret_cast< const texturepack::Entry* >( data.data() + header.entriesOffset ),
+        header.entryCount,
+    };
+    names = std::string_view{
+        reinterpret_cast< const char* >( data.data() + header.namesOffset ),
+        header.namesSize,
+    };
+
+    for( const auto& e : entries )
+    {
+        if( e.dataOffset + e.dataSize > data.size() ||
+            uint64_t{ e.nameOffset } + e.nameLength > names.size() )
+        {
+            debug::Warning( "Texture pack is corrupted: {}", path.string() );
+            entries = {};
+            names   = {};
+            return;
+        }
+    }
+
+    debug::Verbose( "Texture pack: {} textures from {}", entries.size(), path.string() );
+}
+
+auto RTGL1::TexturePack::Find( std::string_view pathWithoutExtension ) const
+    -> const texturepack::Entry*
+{
+    auto key  = texturepack::MakeKey( pathWithoutExtension );
+    auto hash = texturepack::HashKey( key );
+
+    auto [ begin, end ] =
+        std::ranges::equal_range( entries, hash, {}, &texturepack::Entry::keyHash );
+
+    for( auto it = begin; it != end; ++it )
+    {
+        if( names.substr( it->nameOffset, it->nameLength ) == key )
+        {
+            return &( *it );
+        }
+    }
+
+    return nullptr;
+}
+
+std::span< const uint8_t > RTGL1::TexturePack::GetData( const texturepack::Entry& entry ) const
+{
+    return file.GetData().subspan( entry.dataOffset, entry.dataSize );
+}
@@ -0,0 +1,113 @@
+/*
+
+Copyright (c) 2024 V.Shirokii
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#pragma once
+
+#include "MappedFile.h"
+
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace RTGL1
+{
+
+// Single-file archive of the KTX2 files from TEXTURES_FOLDER, built offline by
+// Tools/TexturePacker.cpp. Layout: Header, Entry array sorted by (keyHash, name),
+// name characters, then KTX2 files, each aligned to DataAlignment.
+// A key is a lowercase path relative to TEXTURES_FOLDER, without an extension.
+namespace texturepack
+{
+    constexpr char     Magic[ 4 ]    = { 'R', 'T', 'P', 'K' };
+    constexpr uint32_t Version       = 1;
+    constexpr uint32_t MaxLevels     = 16;
+    constexpr uint64_t DataAlignment = 16;
+
+    struct Header
+    {
+        char     magic[ 4 ];
+        uint32_t version;
+        uint32_t entryCount;
+        uint32_t namesSize;
+        uint64_t entriesOffset;
+        uint64_t namesOffset;
+    };
+    static_assert( sizeof( Header ) == 32 );
+
+    struct Entry
+    {
+        uint64_t keyHash;
+        // KTX2 file, relative to the pack start
+        uint64_t dataOffset;
+        uint64_t dataSize;
+        // key characters, relative to Header::namesOffset
+        uint32_t nameOffset;
+        uint32_t nameLength;
+        // from the KTX2 header, level offsets are relative to the KTX2 file start
+        uint32_t vkFormat;
+        uint32_t width;
+        uint32_t height;
+        uint32_t levelCount;
+        uint64_t levelOffsets[ MaxLevels ];
+        uint64_t levelSizes[ MaxLevels ];
+    };
+    static_assert( sizeof( Entry ) == 304 );
+
+    std::string MakeKey( std::string_view pathWithoutExtension );
+    uint64_t    HashKey( std::string_view key );
+
+    // Read the KTX2 header and level index. Offsets and the name are not set.
+    std::optional< Entry > DescribeKtx2( std::span< const uint8_t > file );
+}
+
+class TexturePack
+{
+public:
+    explicit TexturePack( const std::filesystem::path& path );
+    ~TexturePack() = default;
+
+    TexturePack( const TexturePack& other )                = delete;
+    TexturePack( TexturePack&& other ) noexcept            = delete;
+    TexturePack& operator=( const TexturePack& other )     = delete;
+    TexturePack& operator=( TexturePack&& other ) noexcept = delete;
+
+    bool IsValid() const { return !entries.empty(); }
+
+    // Returns null, if the pack doesn't contain such texture
+    const texturepack::Entry* Find( std::string_view pathWithoutExtension ) const;
+
+    // Whole KTX2 file of the entry; valid while the pack is alive
+    std::span< const uint8_t > GetData( const texturepack::Entry& entry ) const;
+
+    uint32_t GetEntryCount() const { return uint32_t( entries.size() ); }
+
+private:
+    MappedFile                            file;
+    std::span< const texturepack::Entry > entries;
+    std::string_view                      names;
+};
+
+}
@@ -0,0 +1,341 @@
+/*
+
+Copyright (c) 2024 V.Shirokii
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#include "TextureResidency.h"
+
+#include "Generated/ShaderCommonC.h"
+
+#include <algorithm>
+
+namespace
+{
+
+// see TextureFeedback::NotRequested
+constexpr uint32_t FeedbackNotRequested = 0xFFFFFFFF;
+
+// textures that weren't requested for this amount of frames can lose
+// their finest levels to make room for the ones that are visible
+constexpr uint64_t StaleFrameCount = 60;
+
+}
+
+RTGL1::TextureResidency::TextureResidency( uint32_t maxTextureCount, uint64_t budgetBytes )
+    : entries( maxTextureCount ), budget{ budgetBytes }
+{
+}
+
+uint64_t RTGL1::TextureResidency::BytesFrom( const Entry& e, uint32_t firstLevel )
+{
+    uint64_t sum = 0;
+    for( uint32_t i = firstLevel; i < e.levelCount; i++ )
+    {
+        sum += e.levelSizes[ i ];
+    }
+    return sum;
+}
+
+void RTGL1::TextureResidency::Track( uint32_t                  slot,
+                                     std::span< const size_t > levelSizes,
+                                     uint32_t                  firstLevel )
+{
+    assert( slot < entries.size() );
+    assert( !levelSizes.empty() && levelSizes.size() <= MAX_PREGENERATED_MIPMAP_LEVELS );
+    assert( firstLevel < levelSizes.size() );
+
+    Entry& e = entries[ slot ];
+
+    const bool wasTracked = e.tracked;
+    Untrack( slot );
+
+    e.tracked      = true;
+    e.levelCount   = uint32_t( levelSizes.size() );
+    e.firstLevel   = firstLevel;
+    e.trackedFrame = currentFrame;
+    std::ranges::copy( levelSizes, e.levelSizes );
+
+    if( !wasTracked )
+    {
+        // new texture: don't consider it stale right away
+        e.wantedLevel   = firstLevel;
+        e.lastRequested = currentFrame;
+    }
+    else
+    {
+        e.wantedLevel = std::min( e.wantedLevel, e.levelCount - 1 );
+    }
+
+    residentBytes += BytesFrom( e, e.firstLevel );
+    trackedCount++;
+}
+
+void RTGL1::TextureResidency::Untrack( uint32_t slot )
+{
+    assert( slot < entries.size() );
+    Entry& e = entries[ slot ];
+
+    if( !e.tracked )
+    {
+        return;
+    }
+
+    OnChangeFailed( slot );
+
+    assert( residentBytes >= BytesFrom( e, e.firstLevel ) );
+    residentBytes -= BytesFrom( e, e.firstLevel );
+    trackedCount--;
+
+    e.tracked = false;
+}
+
+void RTGL1::TextureResidency::OnChangeFailed( uint32_t slot )
+{
+    assert( slot < entries.size() );
+    Entry& e = entries[ slot ];
+
+    if( e.pending )
+    {
+        e.pending = false;
+        pendingCount--;
+    }
+}
+
+void RTGL1::TextureResidency::ApplyFeedback( std::span< const uint32_t > feedback,
+                                             uint64_t                    frameId )
+{
+    currentFrame = frameId;
+
+    const size_t count = std::min( feedback.size(), entries.size() );
+
+    for( size_t i = 0; i < count; i++ )
+    {
+        Entry& e = entries[ i ];
+
+        if( !e.tracked || feedback[ i ] == FeedbackNotRequested )
+        {
+            continue;
+        }
+
+        e.lastRequested = frameId;
+
+        // the feedback was written MAX_FRAMES_IN_FLIGHT frames ago, so if the levels were
+        // changed after that, it's relative to the previous first level; wait for a new one
+        if( frameId < e.trackedFrame + MAX_FRAMES_IN_FLIGHT )
+        {
+            continue;
+        }
+
+        const int lod = std::min( int( feedback[ i ] ), 2 * TEXTURE_FEEDBACK_LOD_BIAS ) -
+                        TEXTURE_FEEDBACK_LOD_BIAS;
+
+        e.wantedLevel =
+            uint32_t( std::clamp( int( e.firstLevel ) + lod, 0, int( e.levelCount ) - 1 ) );
+    }
+}
+
+void RTGL1::TextureResidency::CollectChanges( uint32_t maxCount, std::vector< Change >& out )
+{
+    if( maxCount == 0 )
+    {
+        return;
+    }
+
+    // what will be resident, when all pending changes are done
+    uint64_t projected = residentBytes;
+
+    std::vector< uint32_t > upgrades;
+    std::vector< uint32_t > evictable;
+
+    for( uint32_t i = 0; i < entries.size(); i++ )
+    {
+        const Entry& e = entries[ i ];
+
+        if( !e.tracked )
+        {
+            continue;
+        }
+
+        if( e.pending )
+        {
+            projected = projected + BytesFrom( e, e.pendingLevel ) - BytesFrom( e, e.firstLevel );
+            continue;
+        }
+
+        if( e.wantedLevel < e.firstLevel )
+        {
+            upgrades.push_back( i );
+        }
+
+        if( e.firstLevel + 1 < e.levelCount )
+        {
+            evictable.push_back( i );
+        }
+    }
+
+    if( upgrades.empty() && projected <= budget )
+    {
+        return;
+    }
+
+    // most recently requested first, and then the ones that are the most blurry
+    std::ranges::sort( upgrades, [ this ]( uint32_t a, uint32_t b ) {
+        const Entry& ea = entries[ a ];
+        const Entry& eb = entries[ b ];
+        if( ea.lastRequested != eb.lastRequested )
+        {
+            return ea.lastRequested > eb.lastRequested;
+        }
+        return ea.firstLevel - ea.wantedLevel > eb.firstLevel - eb.wantedLevel;
+    } );
+
+    // least recently requested first
+    std::ranges::sort( evictable, [ this ]( uint32_t a, uint32_t b ) {
+        return entries[ a ].lastRequested < entries[ b ].lastRequested;
+    } );
+
+    uint32_t added     = 0;
+    size_t   nextEvict = 0;
+
+    auto addChange = [ & ]( uint32_t slot, uint32_t firstLevel ) {
+        Entry& e = entries[ slot ];
+
+        projected = projected + BytesFrom( e, firstLevel ) - BytesFrom( e, e.firstLevel );
+
+        e.pending      = true;
+        e.pendingLevel = firstLevel;
+        pendingCount++;
+
+        out.push_back( Change{ .slot = slot, .firstLevel = firstLevel } );
+        added++;
+    };
+
+    // drop the finest levels of a texture that was requested before the given frame
+    auto evictOne = [ & ]( uint64_t requestedBefore ) {
+        while( nextEvict < evictable.size() )
+        {
+            const uint32_t slot = evictable[ nextEvict ];
+            const Entry&   e    = entries[ slot ];
+
+            if( e.lastRequested >= requestedBefore )
+            {
+                // sorted, others are more recent
+                return false;
+            }
+            nextEvict++;
+
+            if( e.pending )
+            {
+                continue;
+            }
+
+            // if the texture wants coarser levels anyway, drop to them right away
+            addChange( slot,
+                       std::max( e.firstLevel + 1, std::min( e.wantedLevel, e.levelCount - 1 ) ) );
+            return true;
+        }
+        return false;
+    };
+
+    // over budget: e.g. new textures were added, or the budget was exceeded by initial levels
+    while( projected > budget && added < maxCount )
+    {
+        if( !evictOne( UINT64_MAX ) )
+        {
+            break;
+        }
+    }
+
+    const uint64_t staleBefore =
+        currentFrame > StaleFrameCount ? currentFrame - StaleFrameCount : 0;
+
+    for( uint32_t slot : upgrades )
+    {
+        if( added >= maxCount )
+        {
+            break;
+        }
+
+        const Entry& e = entries[ slot ];
+
+        // not visible anymore
+        if( e.pending || e.lastRequested < staleBefore )
+        {
+            continue;
+        }
+
+        const uint64_t current = BytesFrom( e, e.firstLevel );
+
+        // make room, but only by textures that are not visible for some time,
+        // otherwise they would be evicted and requested again each frame
+        while( projected + BytesFrom( e, e.wantedLevel ) - current > budget &&
+               added + 1 < maxCount )
+        {
+            if( !evictOne( staleBefore ) )
+            {
+                break;
+            }
+        }
+
+        // if the wanted level doesn't fit, take the finest that does
+        for( uint32_t level = e.wantedLevel; level < e.firstLevel; level++ )
+        {
+            if( projected + BytesFrom( e, level ) - current <= budget )
+            {
+                addChange( slot, level );
+                break;
+            }
+        }
+    }
+}
+
+bool RTGL1::TextureResidency::IsTracked( uint32_t slot ) const
+{
+    return slot < entries.size() && entries[ slot ].tracked;
+}
+
+uint32_t RTGL1::TextureResidency::GetPendingLevel( uint32_t slot ) const
+{
+    assert( IsTracked( slot ) && entries[ slot ].pending );
+    return entries[ slot ].pendingLevel;
+}
+
+uint64_t RTGL1::TextureResidency::GetResidentBytes() const
+{
+    return residentBytes;
+}
+
+uint64_t RTGL1::TextureResidency::GetBudgetBytes() const
+{
+    return budget;
+}
+
+uint32_t RTGL1::TextureResidency::GetTrackedCount() const
+{
+    return trackedCount;
+}
+
+uint32_t RTGL1::TextureResidency::GetPendingCount() const
+{
+    return pendingCount;
+}
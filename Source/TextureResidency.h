@@ -0,0 +1,99 @@
+/*
+
+Copyright (c) 2024 V.Shirokii
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#pragma once
+
+#include "Common.h"
+#include "Const.h"
+
+#include <span>
+#include <vector>
+
+namespace RTGL1
+{
+
+// Decides which mip levels of each streamed texture should be resident.
+// A texture has a first (finest) resident level, and all coarser ones.
+// Texture feedback tells which level shaders want; finer levels are requested
+// while they fit the budget, and if the budget is exceeded, the least recently
+// requested textures lose their finest levels. Doesn't own any GPU resources:
+// the caller reloads a texture with the levels from a Change, and calls Track.
+class TextureResidency
+{
+public:
+    struct Change
+    {
+        uint32_t slot;
+        uint32_t firstLevel;
+    };
+
+public:
+    TextureResidency( uint32_t maxTextureCount, uint64_t budgetBytes );
+
+    // Levels starting from firstLevel are now resident; levelSizes is for a full mip chain
+    void Track( uint32_t slot, std::span< const size_t > levelSizes, uint32_t firstLevel );
+    void Untrack( uint32_t slot );
+    // A reload for a change was not successful, levels stay the same
+    void OnChangeFailed( uint32_t slot );
+
+    // Feedback values are relative to the first resident level, see TextureFeedback
+    void ApplyFeedback( std::span< const uint32_t > feedback, uint64_t frameId );
+    // Append at most maxCount changes; the slots are pending until Track or OnChangeFailed
+    void CollectChanges( uint32_t maxCount, std::vector< Change >& out );
+
+    bool IsTracked( uint32_t slot ) const;
+    auto GetPendingLevel( uint32_t slot ) const -> uint32_t;
+    auto GetResidentBytes() const -> uint64_t;
+    auto GetBudgetBytes() const -> uint64_t;
+    auto GetTrackedCount() const -> uint32_t;
+    auto GetPendingCount() const -> uint32_t;
+
+private:
+    struct Entry
+    {
+        bool     tracked{ false };
+        bool     pending{ false };
+        uint32_t levelCount{ 0 };
+        uint32_t firstLevel{ 0 };
+        uint32_t wantedLevel{ 0 };
+        uint32_t pendingLevel{ 0 };
+        // feedback that was written before this frame, was relative to other levels
+        uint64_t trackedFrame{ 0 };
+        uint64_t lastRequested{ 0 };
+        size_t   levelSizes[ MAX_PREGENERATED_MIPMAP_LEVELS ]{};
+    };
+
+    static uint64_t BytesFrom( const Entry& e, uint32_t firstLevel );
+
+private:
+    std::vector< Entry > entries;
+    uint64_t             budget;
+    uint64_t             residentBytes{ 0 };
+    uint64_t             currentFrame{ 0 };
+    uint32_t             trackedCount{ 0 };
+    uint32_t             pendingCount{ 0 };
+};
+
+}
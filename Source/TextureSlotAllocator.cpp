@@ -0,0 +1,110 @@
+/*
+
+Copyright (c) 2024 V.Shirokii
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#include "TextureSlotAllocator.h"
+
+#include <cassert>
+
+RTGL1::TextureSlotAllocator::TextureSlotAllocator( uint32_t maxCount ) : slots( maxCount )
+{
+    freeList.reserve( maxCount );
+
+    // reversed, as indices are taken from the back
+    for( uint32_t i = maxCount; i-- > 0; )
+    {
+        freeList.push_back( i );
+    }
+}
+
+auto RTGL1::TextureSlotAllocator::Allocate() -> std::optional< uint32_t >
+{
+    while( !freeList.empty() )
+    {
+        const uint32_t index = freeList.back();
+        freeList.pop_back();
+
+        Slot& s      = slots[ index ];
+        s.inFreeList = false;
+
+        if( !s.occupied )
+        {
+            s.occupied = true;
+            occupiedCount++;
+            return index;
+        }
+    }
+    return std::nullopt;
+}
+
+void RTGL1::TextureSlotAllocator::Claim( uint32_t index )
+{
+    assert( index < slots.size() );
+    Slot& s = slots[ index ];
+
+    if( !s.occupied )
+    {
+        s.occupied = true;
+        occupiedCount++;
+    }
+}
+
+void RTGL1::TextureSlotAllocator::Release( uint32_t index )
+{
+    assert( index < slots.size() );
+    Slot& s = slots[ index ];
+
+    if( !s.occupied )
+    {
+        return;
+    }
+
+    s.occupied = false;
+    s.generation++;
+    occupiedCount--;
+
+    if( !s.inFreeList )
+    {
+        s.inFreeList = true;
+        freeList.push_back( index );
+    }
+}
+
+bool RTGL1::TextureSlotAllocator::IsOccupied( uint32_t index ) const
+{
+    assert( index < slots.size() );
+    return slots[ index ].occupied;
+}
+
+auto RTGL1::TextureSlotAllocator::GetGeneration( uint32_t index ) const -> uint32_t
+{
+    assert( index < slots.size() );
+    return slots[ index ].generation;
+}
+
+bool RTGL1::TextureSlotAllocator::IsCurrent( uint32_t index, uint32_t generation ) const
+{
+    return index < slots.size() && slots[ index ].occupied &&
+           slots[ index ].generation == generation;
+}
@@ -0,0 +1,69 @@
+/*
+
+Copyright (c) 2024 V.Shirokii
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace RTGL1
+{
+
+// Free list of texture slots. Lowest indices are given out first on start, so
+// the textures that are created on init get their expected indices.
+// Each release increments the slot's generation, so an index that was saved
+// by an asynchronous request can be checked to still refer to the same texture.
+class TextureSlotAllocator
+{
+public:
+    explicit TextureSlotAllocator( uint32_t maxCount );
+
+    auto Allocate() -> std::optional< uint32_t >;
+    // Occupy a specific slot, e.g. to refill the slot that was just released
+    void Claim( uint32_t index );
+    // No-op, if the slot is not occupied
+    void Release( uint32_t index );
+
+    bool IsOccupied( uint32_t index ) const;
+    auto GetGeneration( uint32_t index ) const -> uint32_t;
+    bool IsCurrent( uint32_t index, uint32_t generation ) const;
+    auto GetOccupiedCount() const -> uint32_t { return occupiedCount; }
+
+private:
+    struct Slot
+    {
+        uint32_t generation{ 0 };
+        bool     occupied{ false };
+        // a claimed slot can still be in the free list, it's skipped on Allocate
+        bool     inFreeList{ true };
+    };
+
+    std::vector< Slot >     slots;
+    std::vector< uint32_t > freeList;
+    uint32_t                occupiedCount{ 0 };
+};
+
+}
@@ -0,0 +1,148 @@
+/*
+
+Copyright (c) 2024 V.Shirokii
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "TextureStreamer.h"
+
+#include "TextureDeduplicator.h"
+#include "Utils.h"
+
+#include <algorithm>
+
+RTGL1::TextureStreamer::TextureStreamer( std::shared_ptr< JobSystem > _jobSystem,
+                                         uint32_t                     _uploadBudgetKB )
+    : jobs{ std::move( _jobSystem ) }
+    , uploadBudget{ size_t{ std::max( _uploadBudgetKB, 1u ) } * 1024 }
+{
+}
+
+RTGL1::TextureStreamer::~TextureStreamer()
+{
+    for( auto& item : items )
+    {
+        jobs->Wait( item->job );
+        Free( *item );
+    }
+}
+
+void RTGL1::TextureStreamer::Load( Item& item )
+{
+    auto r = std::optional< ImageLoader::ResultInfo >{};
+
+    if( !item.request.packed.empty() )
+    {
+        r = item.loaderKtx.Load( item.request.packed );
+    }
+    else
+    {
+        const auto ext = item.request.path.extension().string();
+
+        const bool isKtx = std::ranges::any_of( ImageLoader::GetExtensions(),
+                                                [ & ]( const char* e ) { return ext == e; } );
+
+        r = isKtx ? item.loaderKtx.Load( item.request.path )
+                  : item.loaderRaw.Load( item.request.path );
+    }
+
+    if( r )
+    {
+        r->format = item.request.isSRGB ? Utils::ToSRGB( r->format ) : Utils::ToUnorm( r->format );
+        // raw images have only the base level, build the rest here on the worker
+        item.mipmaps.Generate( *r );
+        // hash here too, so the frame thread doesn't scan the whole image
+        r->contentHash = TextureDeduplicator::HashContents( *r );
+    }
+
+    item.result = r;
+}
+
+void RTGL1::TextureStreamer::Free( Item& item )
+{
+    item.result = std::nullopt;
+    item.loaderKtx.FreeLoaded();
+    item.loaderRaw.FreeLoaded();
+    item.mipmaps.FreeGenerated();
+}
+
+void RTGL1::TextureStreamer::Enqueue( Request&& request )
+{
+    auto item      = std::make_unique< Item >( *jobs );
+    item->request  = std::move( request );
+    item->canceled = false;
+
+    // item's address is stable, as it's owned by unique_ptr
+    Item* pItem = item.get();
+    item->job   = jobs->Submit( [ pItem ]() { Load( *pItem ); } );
+
+    items.push_back( std::move( item ) );
+}
+
+void RTGL1::TextureStreamer::Cancel( uint32_t slot )
+{
+    for( auto& item : items )
+    {
+        if( item->request.slot == slot && !item->canceled )
+        {
+            item->canceled = true;
+            return;
+        }
+    }
+}
+
+void RTGL1::TextureStreamer::ProcessReady( const OnReady& onReady )
+{
+    size_t uploaded = 0;
+
+    for( auto& item : items )
+    {
+        if( uploaded >= uploadBudget )
+        {
+            break;
+        }
+
+        if( !item->job->IsDone() )
+        {
+            continue;
+        }
+
+        if( !item->canceled )
+        {
+            onReady( item->request, item->result ? &item->result.value() : nullptr );
+
+            if( item->result )
+            {
+                uploaded += item->result->dataSize;
+            }
+        }
+
+        Free( *item );
+        item.reset();
+    }
+
+    std::erase( items, nullptr );
+}
+
+uint32_t RTGL1::TextureStreamer::GetPendingCount() const
+{
+    return static_cast< uint32_t >( items.size() );
+}
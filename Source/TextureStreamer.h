@@ -0,0 +1,105 @@
+/*
+
+Copyright (c) 2024 V.Shirokii
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "ImageLoader.h"
+#include "ImageLoaderDev.h"
+#include "JobSystem.h"
+#include "MipmapGenerator.h"
+#include "SamplerManager.h"
+#include "TextureOverrides.h"
+
+#include <deque>
+
+namespace RTGL1
+{
+
+// Loads and decodes texture files on the job system, so material creation
+// doesn't wait for disk I/O. The texture slot is reserved by the caller,
+// and shows the empty texture until the loaded data is uploaded.
+class TextureStreamer
+{
+public:
+    struct Request
+    {
+        uint32_t                            slot;
+        // to check that the slot was not reused, see TextureSlotAllocator
+        uint32_t                            generation;
+        std::filesystem::path               path;
+        // if not empty, load from the texture pack instead of the path
+        std::span< const uint8_t >          packed;
+        bool                                isSRGB;
+        SamplerManager::Handle              samplerHandle;
+        std::optional< RgTextureSwizzling > swizzling;
+        char                                debugname[ TEXTURE_DEBUG_NAME_MAX_LENGTH ];
+    };
+
+    using OnReady =
+        std::function< void( Request& request, const ImageLoader::ResultInfo* result ) >;
+
+public:
+    TextureStreamer( std::shared_ptr< JobSystem > jobSystem, uint32_t uploadBudgetKB );
+    ~TextureStreamer();
+
+    TextureStreamer( const TextureStreamer& other )                = delete;
+    TextureStreamer( TextureStreamer&& other ) noexcept            = delete;
+    TextureStreamer& operator=( const TextureStreamer& other )     = delete;
+    TextureStreamer& operator=( TextureStreamer&& other ) noexcept = delete;
+
+    void     Enqueue( Request&& request );
+    // The slot can be reused immediately, the loaded data will be discarded
+    void     Cancel( uint32_t slot );
+
+    // Call onReady for loaded textures, until the per-frame byte budget is exhausted.
+    // The result is null, if the file couldn't be loaded.
+    void     ProcessReady( const OnReady& onReady );
+
+    uint32_t GetPendingCount() const;
+
+private:
+    struct Item
+    {
+        explicit Item( JobSystem& jobs ) : loaderKtx{ false, &jobs } {}
+
+        Request                                  request;
+        JobSystem::Handle                        job;
+        std::optional< ImageLoader::ResultInfo > result;
+        // inflates on the workers into owned memory, as staging is only on the render thread
+        ImageLoader                              loaderKtx;
+        ImageLoaderDev                           loaderRaw;
+        MipmapGenerator                          mipmaps;
+        bool                                     canceled;
+    };
+
+    static void Load( Item& item );
+    static void Free( Item& item );
+
+private:
+    std::shared_ptr< JobSystem >          jobs;
+    std::deque< std::unique_ptr< Item > > items;
+    size_t                                uploadBudget;
+};
+
+}
@@ -21,9 +21,12 @@
 #include "TextureUploader.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <numeric>
 
 #include "Const.h"
+#include "ImageLoader.h"
 #include "Utils.h"
 
 namespace
@@ -298,16 +301,67 @@ auto GetFormatsWithBlitSupport( VkPhysicalDevice physDevice ) -> rgl::unordered_
     return result;
 }
 
+// Texel block height; 0 if it's not known, then a level can't be split into rows
+uint32_t GetBlockHeight( VkFormat format )
+{
+    if( format >= VK_FORMAT_BC1_RGB_UNORM_BLOCK && format <= VK_FORMAT_EAC_R11G11_SNORM_BLOCK )
+    {
+        return 4;
+    }
+    if( format >= VK_FORMAT_ASTC_4x4_UNORM_BLOCK )
+    {
+        return 0;
+    }
+    return 1;
+}
+
+// bufferOffset of a copy must be a multiple of 4 and of the texel block size
+VkDeviceSize GetStagingAlignment( VkFormat format, const RgExtent2D& size, size_t firstLevelSize )
+{
+    constexpr VkDeviceSize MinAlignment = 16;
+
+    const uint32_t blockSide = GetBlockHeight( format );
+    if( blockSide == 0 )
+    {
+        // ASTC blocks are 16 bytes
+        return MinAlignment;
+    }
+
+    const uint64_t blockCount = uint64_t{ ( size.width + blockSide - 1 ) / blockSide } *
+                                ( ( size.height + blockSide - 1 ) / blockSide );
+    const uint64_t blockBytes = std::max< uint64_t >( firstLevelSize / blockCount, 1 );
+
+    return std::lcm( MinAlignment, blockBytes );
+}
+
+// at most this part of the ring is used per frame by the uploads that didn't fit,
+// so the new ones still have space
+constexpr VkDeviceSize PendingRingShare = 2;
+
 }
 
 using namespace RTGL1;
 
 TextureUploader::TextureUploader( VkDevice                           _device,
-                                  std::shared_ptr< MemoryAllocator > _memAllocator )
+                                  std::shared_ptr< MemoryAllocator > _memAllocator,
+                                  VkDeviceSize                       _stagingRingSize,
+                                  std::shared_ptr< JobSystem >       _jobSystem )
     : device( _device )
     , memAllocator{ std::move( _memAllocator ) }
+    , jobs{ std::move( _jobSystem ) }
     , supportBlit{ GetFormatsWithBlitSupport( memAllocator->GetPhysicalDevice() ) }
 {
+    if( _stagingRingSize > 0 )
+    {
+        stagingBuffer.Init( *memAllocator,
+                            _stagingRingSize,
+                            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                            "Texture staging ring" );
+        stagingMapped = static_cast< uint8_t* >( stagingBuffer.Map() );
+        stagingRing.emplace( _stagingRingSize );
+    }
 }
 
 TextureUploader::~TextureUploader()
@@ -321,17 +375,35 @@ TextureUploader::~TextureUploader()
     {
         memAllocator->DestroyStagingSrcTextureBuffer( p.second.stagingBuffer );
     }
+
+    pending.clear();
+
+    if( stagingBuffer.IsInitted() )
+    {
+        stagingBuffer.TryUnmap();
+        stagingBuffer.Destroy();
+    }
 }
 
 void TextureUploader::ClearStaging( uint32_t frameIndex )
 {
     // clear unused staging
-    for( VkBuffer stagingBuffer : stagingToFree[ frameIndex ] )
+    for( VkBuffer b : stagingToFree[ frameIndex ] )
     {
-        memAllocator->DestroyStagingSrcTextureBuffer( stagingBuffer );
+        memAllocator->DestroyStagingSrcTextureBuffer( b );
     }
 
     stagingToFree[ frameIndex ].clear();
+
+    if( stagingRing )
+    {
+        stagingRing->BeginFrame( frameIndex );
+    }
+
+    lastFrameStats.uploadedBytes = frameUploadedBytes;
+    lastFrameStats.deferredCount = frameDeferredCount;
+    frameUploadedBytes           = 0;
+    frameDeferredCount           = 0;
 }
 
 bool TextureUploader::DoesFormatSupportBlit( VkFormat format ) const
@@ -447,13 +519,14 @@ void TextureUploader::PrepareMipmaps( VkCommandBuffer cmd,
 
 void TextureUploader::CopyStagingToImage( VkCommandBuffer   cmd,
                                           VkBuffer          staging,
+                                          VkDeviceSize      stagingOffset,
                                           VkImage           image,
                                           const RgExtent2D& size,
                                           uint32_t          baseLayer,
                                           uint32_t          layerCount )
 {
     VkBufferImageCopy copyRegion = {};
-    copyRegion.bufferOffset      = 0;
+    copyRegion.bufferOffset      = stagingOffset;
     // tigthly packed
     copyRegion.bufferRowLength                 = 0;
     copyRegion.bufferImageHeight               = 0;
@@ -470,6 +543,7 @@ void TextureUploader::CopyStagingToImage( VkCommandBuffer   cmd,
 
 void TextureUploader::CopyStagingToImageMipmaps( VkCommandBuffer   cmd,
                                                  VkBuffer          staging,
+                                                 VkDeviceSize      stagingOffset,
                                                  VkImage           image,
                                                  uint32_t          layerIndex,
                                                  const UploadInfo& info )
@@ -486,7 +560,7 @@ void TextureUploader::CopyStagingToImageMipmaps( VkCommandBuffer   cmd,
         auto& cr = copyRegions[ mipLevel ];
 
         cr                                 = {};
-        cr.bufferOffset                    = info.pLevelDataOffsets[ mipLevel ];
+        cr.bufferOffset                    = stagingOffset + info.pLevelDataOffsets[ mipLevel ];
         cr.bufferRowLength                 = 0;
         cr.bufferImageHeight               = 0;
         cr.imageExtent                     = { mipWidth, mipHeight, 1 };
@@ -536,10 +610,11 @@ bool TextureUploader::CreateImage( const UploadInfo& info, VkImage* result )
     return true;
 }
 
-void TextureUploader::PrepareImage( VkImage           image,
-                                    VkBuffer          staging[],
-                                    const UploadInfo& info,
-                                    ImagePrepareType  prepareType )
+void TextureUploader::PrepareImage( VkImage             image,
+                                    VkBuffer            staging,
+                                    const VkDeviceSize* stagingOffsets,
+                                    const UploadInfo&   info,
+                                    ImagePrepareType    prepareType )
 {
     VkCommandBuffer   cmd         = info.cmd;
     const RgExtent2D& size        = info.baseSize;
@@ -575,6 +650,12 @@ void TextureUploader::PrepareImage( VkImage           image,
         curStageMask =
             VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
     }
+    else if( prepareType == ImagePrepareType::INIT_ALREADY_COPIED )
+    {
+        curAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        curLayout     = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        curStageMask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    }
     else
     {
         curAccessMask = 0;
@@ -583,7 +664,7 @@ void TextureUploader::PrepareImage( VkImage           image,
     }
 
     // if need to copy from staging
-    if( prepareType != ImagePrepareType::INIT_WITHOUT_COPYING )
+    if( prepareType == ImagePrepareType::INIT || prepareType == ImagePrepareType::UPDATE )
     {
         if( AreMipmapsPregenerated( info ) )
         {
@@ -609,7 +690,8 @@ void TextureUploader::PrepareImage( VkImage           image,
             curLayout     = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
             curStageMask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
 
-            CopyStagingToImageMipmaps( cmd, staging[ layerIndex ], image, layerIndex, info );
+            CopyStagingToImageMipmaps(
+                cmd, staging, stagingOffsets[ layerIndex ], image, layerIndex, info );
         }
         else
         {
@@ -634,7 +716,7 @@ void TextureUploader::PrepareImage( VkImage           image,
                 curStageMask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
 
                 // copy only first mipmap
-                CopyStagingToImage( cmd, staging[ layer ], image, size, layer, 1 );
+                CopyStagingToImage( cmd, staging, stagingOffsets[ layer ], image, size, layer, 1 );
             }
         }
     }
@@ -806,104 +888,471 @@ VkImageView TextureUploader::CreateImageView( VkImage
     return view;
 }
 
-TextureUploader::UploadResult TextureUploader::UploadImage( const UploadInfo& info )
+bool TextureUploader::FillStaging( void* dst, const UploadInfo& info )
 {
-    // cubemaps are processed in other class
-    assert( !info.isCubemap );
+    if( info.isCubemap )
+    {
+        for( uint32_t i = 0; i < 6; i++ )
+        {
+            memcpy( static_cast< uint8_t* >( dst ) + i * info.dataSize,
+                    info.cubemap.pFaces[ i ],
+                    info.dataSize );
+        }
+        return true;
+    }
 
+    if( !info.pZstdLevels )
+    {
+        memcpy( dst, info.pData, info.dataSize );
+        return true;
+    }
 
-    const void*       data     = info.pData;
-    VkDeviceSize      dataSize = info.dataSize;
-    const RgExtent2D& size     = info.baseSize;
+    assert( info.pregeneratedLevelCount > 0 );
+    const uint32_t levelCount =
+        std::min( info.pregeneratedLevelCount, MAX_PREGENERATED_MIPMAP_LEVELS );
 
+    // one job per level, each is decompressed directly to its place in the staging buffer
+    auto failed     = std::atomic_bool{ false };
+    auto decompress = [ & ]( size_t begin, size_t end ) {
+        for( size_t i = begin; i < end; i++ )
+        {
+            if( !ImageLoader::DecompressLevel( info.pZstdLevels[ i ],
+                                               static_cast< uint8_t* >( dst ) +
+                                                   info.pLevelDataOffsets[ i ],
+                                               info.pLevelDataSizes[ i ] ) )
+            {
+                failed = true;
+            }
+        }
+    };
 
+    if( jobs && levelCount > 1 )
+    {
+        jobs->ParallelFor( levelCount, 1, decompress );
+    }
+    else
+    {
+        decompress( 0, levelCount );
+    }
+
+    if( failed )
+    {
+        debug::Warning( "Failed to decompress texture data: {}",
+                        Utils::SafeCstr( info.pDebugName ) );
+        return false;
+    }
+    return true;
+}
+
+TextureUploader::UploadResult TextureUploader::UploadImage( const UploadInfo& info )
+{
     // updateable can have null data, so it can be provided later
     if( !info.isUpdateable )
     {
-        assert( data != nullptr );
+        assert( info.pData != nullptr || info.pZstdLevels != nullptr || info.isCubemap );
     }
 
 
-    VkResult r;
-    void*    mappedData;
-    VkImage  image;
+    VkImage image;
+
+    bool wasCreated = CreateImage( info, &image );
+    if( !wasCreated )
+    {
+        return {};
+    }
+
+    bool wasFilled =
+        info.isUpdateable ? UploadUpdateable( info, image ) : UploadStatic( info, image );
+    if( !wasFilled )
+    {
+        // clean created resources
+        memAllocator->DestroyTextureImage( image );
+        return {};
+    }
+
+
+    // create image view
+    VkImageView imageView = CreateImageView(
+        image, info.format, info.isCubemap, GetMipmapCount( info.baseSize, info ), info.swizzling );
+    SET_DEBUG_NAME( device, imageView, VK_OBJECT_TYPE_IMAGE_VIEW, info.pDebugName );
+
+
+    return UploadResult{
+        .wasUploaded = true,
+        .image       = image,
+        .view        = imageView,
+    };
+}
 
+bool TextureUploader::UploadUpdateable( const UploadInfo& info, VkImage image )
+{
+    assert( !info.isCubemap );
 
-    // 1. Allocate and fill buffer
+    // for updateable images: staging buffer exists during the overall lifetime of an image,
+    // so the image data can be updated in the future
 
     VkBufferCreateInfo stagingInfo = {
         .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-        .size  = dataSize,
+        .size  = info.dataSize,
         .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
     };
 
-    VkBuffer stagingBuffer =
+    void*    mappedData;
+    VkBuffer buffer =
         memAllocator->CreateStagingSrcTextureBuffer( &stagingInfo, info.pDebugName, &mappedData );
-    if( stagingBuffer == VK_NULL_HANDLE )
+    if( buffer == VK_NULL_HANDLE )
     {
-        return {};
+        return false;
     }
-    SET_DEBUG_NAME( device, stagingBuffer, VK_OBJECT_TYPE_BUFFER, info.pDebugName );
+    SET_DEBUG_NAME( device, buffer, VK_OBJECT_TYPE_BUFFER, info.pDebugName );
 
 
-    bool wasCreated = CreateImage( info, &image );
-    if( !wasCreated )
+    // if the data is not provided yet
+    if( info.pData == nullptr )
     {
-        // clean created resources
-        memAllocator->DestroyStagingSrcTextureBuffer( stagingBuffer );
-        return {};
+        // create image without copying
+        PrepareImage(
+            image, VK_NULL_HANDLE, nullptr, info, ImagePrepareType::INIT_WITHOUT_COPYING );
     }
+    else
+    {
+        if( !FillStaging( mappedData, info ) )
+        {
+            memAllocator->DestroyStagingSrcTextureBuffer( buffer );
+            return false;
+        }
 
+        constexpr VkDeviceSize offset = 0;
+        PrepareImage( image, buffer, &offset, info, ImagePrepareType::INIT );
+    }
 
-    // if it's updateable but the data is not provided yet
-    if( info.isUpdateable && data == nullptr )
+    updateableImageInfos[ image ] = UpdateableImageInfo{
+        .stagingBuffer   = buffer,
+        .mappedData      = mappedData,
+        .dataSize        = static_cast< uint32_t >( info.dataSize ),
+        .imageSize       = info.baseSize,
+        .generateMipmaps = info.useMipmaps,
+        .format          = info.format,
+    };
+    return true;
+}
+
+bool TextureUploader::UploadStatic( const UploadInfo& info, VkImage image )
+{
+    if( !stagingRing )
     {
-        // create image without copying
-        PrepareImage( image, VK_NULL_HANDLE, info, ImagePrepareType::INIT_WITHOUT_COPYING );
+        return UploadDedicated( info, image );
     }
-    else
+
+    const uint32_t     layerCount = info.isCubemap ? 6 : 1;
+    const VkDeviceSize totalSize  = VkDeviceSize{ layerCount } * info.dataSize;
+    const VkDeviceSize alignment  = GetStagingAlignment(
+        info.format,
+        info.baseSize,
+        AreMipmapsPregenerated( info ) ? info.pLevelDataSizes[ 0 ] : info.dataSize );
+
+    // 1. Whole texture through the ring
+
+    if( auto offset = stagingRing->Allocate( totalSize, alignment ) )
+    {
+        if( !FillStaging( stagingMapped + *offset, info ) )
+        {
+            return false;
+        }
+
+        VkDeviceSize offsets[ 6 ];
+        for( uint32_t l = 0; l < layerCount; l++ )
+        {
+            offsets[ l ] = *offset + l * info.dataSize;
+        }
+
+        PrepareImage( image, stagingBuffer.GetBuffer(), offsets, info, ImagePrepareType::INIT );
+
+        frameUploadedBytes += totalSize;
+        return true;
+    }
+
+    // 2. In parts on the next frames, if each part can fit
+
+    auto p = MakePending( info, image );
+    p.alignment = alignment;
+
+    for( uint32_t level = 0; level < p.levelCount; level++ )
     {
-        // copy image data to buffer
-        memcpy( mappedData, data, dataSize );
+        if( GetRows( p, level ).size > stagingRing->GetCapacity() / PendingRingShare )
+        {
+            // 3. Too large to be split
+            return UploadDedicated( info, image );
+        }
+    }
 
-        // and copy it to image
-        PrepareImage( image, &stagingBuffer, info, ImagePrepareType::INIT );
+    p.data.resize( totalSize );
+    if( !FillStaging( p.data.data(), info ) )
+    {
+        return false;
     }
 
+    // levels are in TRANSFER_DST until all parts are copied
+    Utils::BarrierImage( info.cmd,
+                         image,
+                         0,
+                         VK_ACCESS_TRANSFER_WRITE_BIT,
+                         VK_IMAGE_LAYOUT_UNDEFINED,
+                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                         VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VkImageSubresourceRange{
+                             .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
+                             .baseMipLevel   = 0,
+                             .levelCount     = p.levelCount,
+                             .baseArrayLayer = 0,
+                             .layerCount     = p.layerCount,
+                         } );
+
+    pending.push_back( std::move( p ) );
+    frameDeferredCount++;
+    return true;
+}
 
-    // create image view
-    VkImageView imageView = CreateImageView(
-        image, info.format, info.isCubemap, GetMipmapCount( size, info ), info.swizzling );
-    SET_DEBUG_NAME( device, imageView, VK_OBJECT_TYPE_IMAGE_VIEW, info.pDebugName );
+bool TextureUploader::UploadDedicated( const UploadInfo& info, VkImage image )
+{
+    const uint32_t     layerCount = info.isCubemap ? 6 : 1;
+    const VkDeviceSize totalSize  = VkDeviceSize{ layerCount } * info.dataSize;
 
+    VkBufferCreateInfo stagingInfo = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size  = totalSize,
+        .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+    };
 
-    // save info about created image
-    if( info.isUpdateable )
+    void*    mappedData;
+    VkBuffer buffer =
+        memAllocator->CreateStagingSrcTextureBuffer( &stagingInfo, info.pDebugName, &mappedData );
+    if( buffer == VK_NULL_HANDLE )
     {
-        // for updateable images: save pointer for updating the image data in the future
+        return false;
+    }
+    SET_DEBUG_NAME( device, buffer, VK_OBJECT_TYPE_BUFFER, info.pDebugName );
 
-        updateableImageInfos[ image ] = UpdateableImageInfo{
-            .stagingBuffer   = stagingBuffer,
-            .mappedData      = mappedData,
-            .dataSize        = static_cast< uint32_t >( dataSize ),
-            .imageSize       = size,
-            .generateMipmaps = info.useMipmaps,
-            .format          = info.format,
-        };
+    if( !FillStaging( mappedData, info ) )
+    {
+        memAllocator->DestroyStagingSrcTextureBuffer( buffer );
+        return false;
+    }
+
+    VkDeviceSize offsets[ 6 ];
+    for( uint32_t l = 0; l < layerCount; l++ )
+    {
+        offsets[ l ] = l * info.dataSize;
+    }
+
+    PrepareImage( image, buffer, offsets, info, ImagePrepareType::INIT );
+
+    // push staging buffer to be deleted when it won't be in use
+    stagingToFree[ info.frameIndex ].push_back( buffer );
+    return true;
+}
+
+auto TextureUploader::MakePending( const UploadInfo& info, VkImage image ) const -> PendingUpload
+{
+    auto p = PendingUpload{
+        .image                  = image,
+        .baseSize               = info.baseSize,
+        .format                 = info.format,
+        .useMipmaps             = info.useMipmaps,
+        .pregeneratedLevelCount = info.pregeneratedLevelCount,
+        .isCubemap              = info.isCubemap,
+        .debugName              = Utils::SafeCstr( info.pDebugName ),
+        .data                   = {},
+        .layerSize              = info.dataSize,
+        .levelOffsets           = {},
+        .levelSizes             = {},
+        .layerCount             = info.isCubemap ? 6u : 1u,
+        .levelCount             = 1,
+        .blockHeight            = GetBlockHeight( info.format ),
+        .alignment              = 1,
+    };
+
+    if( AreMipmapsPregenerated( info ) )
+    {
+        // all levels are copied
+        p.levelCount = GetMipmapCount( info.baseSize, info );
+        std::copy_n( info.pLevelDataOffsets, p.levelCount, p.levelOffsets );
+        std::copy_n( info.pLevelDataSizes, p.levelCount, p.levelSizes );
     }
     else
     {
-        // for static images that won't be updated:
-        // push staging buffer to be deleted when it won't be in use
-        stagingToFree[ info.frameIndex ].push_back( stagingBuffer );
+        // only the first, others are generated on GPU
+        p.levelOffsets[ 0 ] = 0;
+        p.levelSizes[ 0 ]   = info.dataSize;
     }
 
+    return p;
+}
 
-    return UploadResult{
-        .wasUploaded = true,
-        .image       = image,
-        .view        = imageView,
+auto TextureUploader::GetRows( const PendingUpload& p, uint32_t level ) -> RowLayout
+{
+    const uint32_t height = std::max( p.baseSize.height >> level, 1u );
+
+    // if block size is unknown, a level is copied at once
+    const uint32_t rowHeight = p.blockHeight > 0 ? p.blockHeight : height;
+    const uint32_t rowCount  = ( height + rowHeight - 1 ) / rowHeight;
+
+    return RowLayout{
+        .height = rowHeight,
+        .count  = rowCount,
+        .size   = p.levelSizes[ level ] / rowCount,
+    };
+}
+
+bool TextureUploader::CopyPendingPart( VkCommandBuffer cmd, PendingUpload& p, VkDeviceSize& budget )
+{
+    assert( stagingRing );
+
+    const RowLayout rows   = GetRows( p, p.level );
+    const uint32_t  width  = std::max( p.baseSize.width >> p.level, 1u );
+    const uint32_t  height = std::max( p.baseSize.height >> p.level, 1u );
+
+    const VkDeviceSize available =
+        std::min( budget, stagingRing->GetMaxAllocationSize( p.alignment ) );
+    const auto count = static_cast< uint32_t >(
+        std::min< VkDeviceSize >( rows.count - p.row, available / rows.size ) );
+    if( count == 0 )
+    {
+        return false;
+    }
+
+    const VkDeviceSize partSize = VkDeviceSize{ count } * rows.size;
+
+    auto offset = stagingRing->Allocate( partSize, p.alignment );
+    if( !offset )
+    {
+        assert( 0 );
+        return false;
+    }
+
+    memcpy( stagingMapped + *offset,
+            p.data.data() + p.layer * p.layerSize + p.levelOffsets[ p.level ] +
+                size_t{ p.row } * rows.size,
+            partSize );
+
+    const uint32_t y = p.row * rows.height;
+
+    auto region = VkBufferImageCopy{
+        .bufferOffset      = *offset,
+        // tigthly packed
+        .bufferRowLength   = 0,
+        .bufferImageHeight = 0,
+        .imageSubresource  = {
+            .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
+            .mipLevel       = p.level,
+            .baseArrayLayer = p.layer,
+            .layerCount     = 1,
+        },
+        .imageOffset = { 0, static_cast< int32_t >( y ), 0 },
+        .imageExtent = { width, std::min( count * rows.height, height - y ), 1 },
     };
+
+    vkCmdCopyBufferToImage( cmd,
+                            stagingBuffer.GetBuffer(),
+                            p.image,
+                            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                            1,
+                            &region );
+
+    budget -= partSize;
+    frameUploadedBytes += partSize;
+
+    // next part
+    p.row += count;
+    if( p.row == rows.count )
+    {
+        p.row = 0;
+        p.level++;
+
+        if( p.level == p.levelCount )
+        {
+            p.level = 0;
+            p.layer++;
+        }
+    }
+    return true;
+}
+
+void TextureUploader::FinishPending( VkCommandBuffer cmd, const PendingUpload& p )
+{
+    auto info = UploadInfo{
+        .cmd                    = cmd,
+        .frameIndex             = 0,
+        .pData                  = nullptr,
+        .dataSize               = p.layerSize,
+        .cubemap                = {},
+        .baseSize               = p.baseSize,
+        .format                 = p.format,
+        .useMipmaps             = p.useMipmaps,
+        .pregeneratedLevelCount = p.pregeneratedLevelCount,
+        .pLevelDataOffsets      = p.levelOffsets,
+        .pLevelDataSizes        = p.levelSizes,
+        .pZstdLevels            = nullptr,
+        .isUpdateable           = false,
+        .pDebugName             = p.debugName.c_str(),
+        .isCubemap              = p.isCubemap,
+        .swizzling              = std::nullopt,
+    };
+
+    // generate mipmaps, if needed, and make readable by shaders
+    PrepareImage( p.image, VK_NULL_HANDLE, nullptr, info, ImagePrepareType::INIT_ALREADY_COPIED );
+}
+
+void TextureUploader::UploadPending( VkCommandBuffer cmd, std::vector< VkImage >& finished )
+{
+    if( pending.empty() )
+    {
+        return;
+    }
+    assert( stagingRing );
+
+    VkDeviceSize budget = stagingRing->GetCapacity() / PendingRingShare;
+
+    // in order, so the earliest textures become visible first
+    while( !pending.empty() )
+    {
+        PendingUpload& p = pending.front();
+
+        while( p.layer < p.layerCount )
+        {
+            if( !CopyPendingPart( cmd, p, budget ) )
+            {
+                return;
+            }
+        }
+
+        FinishPending( cmd, p );
+        finished.push_back( p.image );
+        pending.pop_front();
+    }
+}
+
+bool TextureUploader::IsPending( VkImage image ) const
+{
+    return std::ranges::any_of( pending,
+                                [ image ]( const PendingUpload& p ) { return p.image == image; } );
+}
+
+auto TextureUploader::GetStatistics() const -> Statistics
+{
+    auto stats = lastFrameStats;
+
+    stats.pendingCount = static_cast< uint32_t >( pending.size() );
+    stats.pendingBytes = 0;
+    for( const auto& p : pending )
+    {
+        stats.pendingBytes += p.data.size();
+    }
+
+    stats.stagingUsedBytes = stagingRing ? stagingRing->GetUsedBytes() : 0;
+    stats.stagingCapacity  = stagingRing ? stagingRing->GetCapacity() : 0;
+    return stats;
 }
 
 void TextureUploader::UpdateImage( VkCommandBuffer cmd, VkImage targetImage, const void* data )
@@ -927,7 +1376,9 @@ void TextureUploader::UpdateImage( VkCommandBuffer cmd, VkImage targetImage, con
         info.format     = updateInfo.format;
 
         // copy from staging
-        PrepareImage( targetImage, &updateInfo.stagingBuffer, info, ImagePrepareType::UPDATE );
+        constexpr VkDeviceSize offset = 0;
+        PrepareImage(
+            targetImage, updateInfo.stagingBuffer, &offset, info, ImagePrepareType::UPDATE );
     }
 }
 
@@ -945,6 +1396,9 @@ void TextureUploader::DestroyImage( VkImage image, VkImageView view )
         updateableImageInfos.erase( it );
     }
 
+    // stop copying the rest of its data
+    std::erase_if( pending, [ image ]( const PendingUpload& p ) { return p.image == image; } );
+
     memAllocator->DestroyTextureImage( image );
     vkDestroyImageView( device, view, nullptr );
 }
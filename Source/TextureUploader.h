@@ -20,20 +20,42 @@
 
 #pragma once
 
+#include <deque>
 #include <optional>
+#include <span>
+#include <string>
 #include <vector>
 
+#include "Buffer.h"
 #include "Common.h"
+#include "FrameRingAllocator.h"
+#include "JobSystem.h"
 #include "MemoryAllocator.h"
 #include "RTGL1/RTGL1.h"
 
 namespace RTGL1
 {
 
-// Uploads texture data to device.
+// Uploads texture data to device. Data is copied through a persistently mapped
+// staging ring; if a texture doesn't fit, it's kept on the CPU and copied in parts
+// on the next frames, the image is not visible to shaders until then, see IsPending.
 class TextureUploader
 {
 public:
+    struct Statistics
+    {
+        // copied to the staging ring during the last frame
+        uint64_t uploadedBytes;
+        // uploads of the last frame that didn't fit the staging ring
+        uint32_t deferredCount;
+        // uploads that are being copied in parts
+        uint32_t pendingCount;
+        // CPU memory that pending uploads hold
+        uint64_t pendingBytes;
+        uint64_t stagingUsedBytes;
+        uint64_t stagingCapacity;
+    };
+
     struct UploadResult
     {
         bool        wasUploaded = false;
@@ -55,10 +77,13 @@ public:
         VkFormat                            format;
         bool                                useMipmaps;
         // if count is 0, useMipmaps is true and format supports blit,
-        // then the mipmaps will be generated
+        // then the mipmaps will be generated on GPU; files loaded on workers
+        // come with the levels from MipmapGenerator instead
         uint32_t                            pregeneratedLevelCount;
         const size_t*                       pLevelDataOffsets;
         const size_t*                       pLevelDataSizes;
+        // if not null, pData is null, and levels are decompressed to staging, see ImageLoader
+        const std::span< const uint8_t >*   pZstdLevels;
         bool                                isUpdateable;
         const char*                         pDebugName;
         bool                                isCubemap;
@@ -66,7 +91,12 @@ public:
     };
 
 public:
-    TextureUploader( VkDevice device, std::shared_ptr< MemoryAllocator > memAllocator );
+    // Job system is used to decompress levels in parallel.
+    // If stagingRingSize is 0, each upload has a dedicated staging buffer
+    TextureUploader( VkDevice                           device,
+                     std::shared_ptr< MemoryAllocator > memAllocator,
+                     VkDeviceSize                       stagingRingSize,
+                     std::shared_ptr< JobSystem >       jobSystem = nullptr );
     virtual ~TextureUploader();
 
     TextureUploader( const TextureUploader& other )     = delete;
@@ -81,11 +111,20 @@ public:
     void                 UpdateImage( VkCommandBuffer cmd, VkImage targetImage, const void* data );
     void                 DestroyImage( VkImage image, VkImageView view );
 
+    // Continue copying the textures that didn't fit the staging ring,
+    // the images that became complete are appended to 'finished'
+    void                 UploadPending( VkCommandBuffer cmd, std::vector< VkImage >& finished );
+    // If true, the image must not be accessed by shaders yet
+    bool                 IsPending( VkImage image ) const;
+    auto                 GetStatistics() const -> Statistics;
+
 protected:
     enum class ImagePrepareType
     {
         INIT,
         INIT_WITHOUT_COPYING,
+        // data was already copied to the image in TRANSFER_DST layout
+        INIT_ALREADY_COPIED,
         UPDATE
     };
 
@@ -106,22 +145,28 @@ protected:
     // Image must have TRANSFER_DST layout
     static void CopyStagingToImage( VkCommandBuffer   cmd,
                                     VkBuffer          staging,
+                                    VkDeviceSize      stagingOffset,
                                     VkImage           image,
                                     const RgExtent2D& size,
                                     uint32_t          baseLayer,
                                     uint32_t          layerCount );
     void        CopyStagingToImageMipmaps( VkCommandBuffer   cmd,
                                            VkBuffer          staging,
+                                           VkDeviceSize      stagingOffset,
                                            VkImage           image,
                                            uint32_t          layerIndex,
                                            const UploadInfo& info );
 
+    // Copy or decompress the data of all levels (and all faces of a cubemap) to staging
+    bool        FillStaging( void* dst, const UploadInfo& info );
     bool        CreateImage( const UploadInfo& info, VkImage* result );
-    // Create mipmaps and prepare image for usage in shaders
-    void        PrepareImage( VkImage           image,
-                              VkBuffer          staging[],
-                              const UploadInfo& info,
-                              ImagePrepareType  prepareType );
+    // Create mipmaps and prepare image for usage in shaders;
+    // stagingOffsets has an offset in staging per layer
+    void        PrepareImage( VkImage             image,
+                              VkBuffer            staging,
+                              const VkDeviceSize* stagingOffsets,
+                              const UploadInfo&   info,
+                              ImagePrepareType    prepareType );
     VkImageView CreateImageView( VkImage                             image,
                                  VkFormat                            format,
                                  bool                                isCubemap,
@@ -139,15 +184,73 @@ private:
         VkFormat   format;
     };
 
+    struct PendingUpload
+    {
+        VkImage                image;
+        RgExtent2D             baseSize;
+        VkFormat               format;
+        bool                   useMipmaps;
+        uint32_t               pregeneratedLevelCount;
+        bool                   isCubemap;
+        std::string            debugName;
+
+        // all layers, each has levelCount levels
+        std::vector< uint8_t > data;
+        size_t                 layerSize;
+        size_t                 levelOffsets[ MAX_PREGENERATED_MIPMAP_LEVELS ];
+        size_t                 levelSizes[ MAX_PREGENERATED_MIPMAP_LEVELS ];
+        uint32_t               layerCount;
+        uint32_t               levelCount;
+        // in texels; a level is copied by rows of blocks
+        uint32_t               blockHeight;
+        VkDeviceSize           alignment;
+
+        // next part to copy
+        uint32_t               layer{ 0 };
+        uint32_t               level{ 0 };
+        uint32_t               row{ 0 };
+    };
+
+    struct RowLayout
+    {
+        // in texels
+        uint32_t height;
+        uint32_t count;
+        size_t   size;
+    };
+
+    bool        UploadUpdateable( const UploadInfo& info, VkImage image );
+    // Through the staging ring, or in parts on the next frames, or with a dedicated buffer
+    bool        UploadStatic( const UploadInfo& info, VkImage image );
+    bool        UploadDedicated( const UploadInfo& info, VkImage image );
+
+    auto        MakePending( const UploadInfo& info, VkImage image ) const -> PendingUpload;
+    static auto GetRows( const PendingUpload& p, uint32_t level ) -> RowLayout;
+    // Returns false, if the ring has no space for the next part
+    bool        CopyPendingPart( VkCommandBuffer cmd, PendingUpload& p, VkDeviceSize& budget );
+    void        FinishPending( VkCommandBuffer cmd, const PendingUpload& p );
+
 protected:
     VkDevice                                           device;
 
     std::shared_ptr< MemoryAllocator >                 memAllocator;
+    std::shared_ptr< JobSystem >                       jobs;
+
+    // Persistently mapped, regions are reused after the fence of the frame was waited
+    Buffer                                             stagingBuffer;
+    uint8_t*                                           stagingMapped{ nullptr };
+    std::optional< FrameRingAllocator >                stagingRing;
 
-    // Staging buffers that were used for uploading must be destroyed
-    // on the frame with same index when it'll be certainly not in use
+    // Dedicated staging buffers, if there's no ring, or a texture can't be split;
+    // must be destroyed on the frame with same index when it'll be certainly not in use
     std::vector< VkBuffer >                            stagingToFree[ MAX_FRAMES_IN_FLIGHT ];
 
+    std::deque< PendingUpload >                        pending;
+
+    uint64_t                                           frameUploadedBytes{ 0 };
+    uint32_t                                           frameDeferredCount{ 0 };
+    Statistics                                         lastFrameStats{};
+
     // Each dynamic image has its pointer to HOST_VISIBLE data for updating.
     rgl::unordered_map< VkImage, UpdateableImageInfo > updateableImageInfos;
 
@@ -0,0 +1,82 @@
+/*
+
+Copyright (c) 2024 V.Shirokii
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#include "UploadRing.h"
+
+namespace
+{
+// to keep regions on separate cache lines
+constexpr VkDeviceSize RegionAlignment = 64;
+}
+
+RTGL1::UploadRing::UploadRing( MemoryAllocator& allocator, VkDeviceSize capacity )
+    : ring( capacity )
+{
+    buffer.Init( allocator,
+                 capacity,
+                 VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                 "Upload ring" );
+    mapped = static_cast< uint8_t* >( buffer.Map() );
+}
+
+RTGL1::UploadRing::~UploadRing()
+{
+    buffer.TryUnmap();
+    buffer.Destroy();
+}
+
+void RTGL1::UploadRing::BeginFrame( uint32_t frameIndex )
+{
+    ring.BeginFrame( frameIndex );
+    frameId++;
+}
+
+auto RTGL1::UploadRing::Allocate( VkDeviceSize size ) -> std::optional< Region >
+{
+    if( auto offset = ring.Allocate( size, RegionAlignment ) )
+    {
+        return Region{
+            .offset = *offset,
+            .mapped = mapped + *offset,
+        };
+    }
+    return std::nullopt;
+}
+
+VkBuffer RTGL1::UploadRing::GetBuffer() const
+{
+    return buffer.GetBuffer();
+}
+
+VkDeviceSize RTGL1::UploadRing::GetUsedBytes() const
+{
+    return ring.GetUsedBytes();
+}
+
+VkDeviceSize RTGL1::UploadRing::GetCapacity() const
+{
+    return ring.GetCapacity();
+}
@@ -0,0 +1,77 @@
+/*
+
+Copyright (c) 2024 V.Shirokii
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#pragma once
+
+#include "Buffer.h"
+#include "FrameRingAllocator.h"
+
+#include <optional>
+
+namespace RTGL1
+{
+
+// One persistently mapped host-visible buffer for staging data that is written and copied
+// within one frame, so such buffers don't need a dedicated staging allocation per frame
+// in flight. Memory of a frame is reused after BeginFrame with the same index,
+// as its fence was waited by then. Must be used only on the frame thread.
+class UploadRing
+{
+public:
+    struct Region
+    {
+        VkDeviceSize offset;
+        uint8_t*     mapped;
+    };
+
+public:
+    UploadRing( MemoryAllocator& allocator, VkDeviceSize capacity );
+    ~UploadRing();
+
+    UploadRing( const UploadRing& other )                = delete;
+    UploadRing( UploadRing&& other ) noexcept            = delete;
+    UploadRing& operator=( const UploadRing& other )     = delete;
+    UploadRing& operator=( UploadRing&& other ) noexcept = delete;
+
+    void BeginFrame( uint32_t frameIndex );
+
+    // Returns nullopt, if there's no space until the frames in flight are finished
+    auto Allocate( VkDeviceSize size ) -> std::optional< Region >;
+
+    // Changed by each BeginFrame: a region is valid only if it was allocated with the same id
+    uint64_t     GetFrameId() const { return frameId; }
+    VkBuffer     GetBuffer() const;
+
+    VkDeviceSize GetUsedBytes() const;
+    VkDeviceSize GetCapacity() const;
+
+private:
+    Buffer             buffer;
+    uint8_t*           mapped{ nullptr };
+    FrameRingAllocator ring;
+    uint64_t           frameId{ 1 };
+};
+
+}
@@ -63,13 +63,15 @@ auto MakeUsage( bool isDynamic, bool accelStructureRead )
 
 }
 
-RTGL1::VertexCollector::VertexCollector( VkDevice         _device,
-                                         MemoryAllocator& _allocator,
+RTGL1::VertexCollector::VertexCollector( VkDevice                         _device,
+                                         MemoryAllocator&                 _allocator,
+                                         std::shared_ptr< StagingCopier > _stagingCopier,
                                          const size_t ( &_maxVertsPerLayer )[ 4 ],
-                                         const size_t     _maxIndices,
-                                         bool             _isDynamic,
-                                         std::string_view _debugName )
+                                         const size_t                     _maxIndices,
+                                         bool                             _isDynamic,
+                                         std::string_view                 _debugName )
     : device{ _device }
+    , copier{ std::move( _stagingCopier ) }
     , bufVertices{ _allocator,
                    _maxVertsPerLayer[ 0 ],
                    MakeUsage( _isDynamic, true ),
@@ -102,6 +104,7 @@ RTGL1::VertexCollector::VertexCollector( const VertexCollector& _src,
                                          MemoryAllocator&       _allocator,
                                          std::string_view       _debugName )
     : device{ _src.device }
+    , copier{ _src.copier }
     , bufVertices{ _src.bufVertices, _allocator, MakeName( "Vertices", _debugName ) }
     , bufIndices{ _src.bufIndices, _allocator, MakeName( "Indices", _debugName ) }
     , bufTexcoordLayer1{ _src.bufTexcoordLayer1,
@@ -237,6 +240,10 @@ void RTGL1::VertexCollector::CopyDataToStaging( const RgMeshPrimitiveInfo& info,
                                                 uint32_t                   texcIndex_2,
                                                 uint32_t                   texcIndex_3 )
 {
+    // vertices, indices, 3 texture coordinate layers
+    auto regions     = std::array< StagingCopier::Region, 5 >{};
+    auto regionCount = uint32_t{ 0 };
+
     {
         assert( bufVertices.mapped );
         assert( ( vertIndex + info.vertexCount ) * sizeof( ShVertex ) <
@@ -257,9 +264,11 @@ void RTGL1::VertexCollector::CopyDataToStaging( const RgMeshPrimitiveInfo& info,
         assert( idInStaging >= 0 );
         if( idInStaging >= 0 )
         {
-            memcpy( &bufVertices.mapped[ idInStaging ],
-                    info.pVertices,
-                    countInStaging * sizeof( ShVertex ) );
+            regions[ regionCount++ ] = StagingCopier::Region{
+                .dst  = &bufVertices.mapped[ idInStaging ],
+                .src  = info.pVertices,
+                .size = countInStaging * sizeof( ShVertex ),
+            };
         }
     }
 
@@ -274,9 +283,11 @@ void RTGL1::VertexCollector::CopyDataToStaging( const RgMeshPrimitiveInfo& info,
         assert( idInStaging >= 0 );
         if( idInStaging >= 0 )
         {
-            memcpy( &bufIndices.mapped[ idInStaging ],
-                    info.pIndices,
-                    countInStaging * sizeof( uint32_t ) );
+            regions[ regionCount++ ] = StagingCopier::Region{
+                .dst  = &bufIndices.mapped[ idInStaging ],
+                .src  = info.pIndices,
+                .size = countInStaging * sizeof( uint32_t ),
+            };
         }
     }
 
@@ -323,11 +334,28 @@ void RTGL1::VertexCollector::CopyDataToStaging( const RgMeshPrimitiveInfo& info,
             assert( idInStaging >= 0 );
             if( idInStaging >= 0 )
             {
-                memcpy(
-                    &dst.buffer->mapped[ idInStaging ], src, countInStaging * sizeof( RgFloat2D ) );
+                regions[ regionCount++ ] = StagingCopier::Region{
+                    .dst  = &dst.buffer->mapped[ idInStaging ],
+                    .src  = src,
+                    .size = countInStaging * sizeof( RgFloat2D ),
+                };
             }
         }
     }
+
+    // big primitives (e.g. terrain, replacements) are split across workers;
+    // staging is write-combined, so bypass the caches
+    if( copier )
+    {
+        copier->Copy( std::span{ regions.data(), regionCount } );
+    }
+    else
+    {
+        for( uint32_t i = 0; i < regionCount; i++ )
+        {
+            memcpy( regions[ i ].dst, regions[ i ].src, regions[ i ].size );
+        }
+    }
 }
 
 void RTGL1::VertexCollector::Reset( const CopyRanges* rangeToPreserve )
@@ -27,6 +27,7 @@
 #include "Buffer.h"
 #include "Common.h"
 #include "Material.h"
+#include "StagingCopy.h"
 #include "VertexCollectorFilter.h"
 #include "Utils.h"
 
@@ -43,12 +44,13 @@ class GeomInfoManager;
 class VertexCollector
 {
 public:
-    explicit VertexCollector( VkDevice         device,
-                              MemoryAllocator& allocator,
+    explicit VertexCollector( VkDevice                         device,
+                              MemoryAllocator&                 allocator,
+                              std::shared_ptr< StagingCopier > stagingCopier,
                               const size_t ( &maxVertsPerLayer )[ 4 ],
-                              const size_t     maxIndices,
-                              bool             isDynamic,
-                              std::string_view debugName );
+                              const size_t                     maxIndices,
+                              bool                             isDynamic,
+                              std::string_view                 debugName );
 
     // Create new vertex collector, but with shared device local buffers
     explicit VertexCollector( const VertexCollector& src,
@@ -145,7 +147,8 @@ private:
                             uint32_t                   texcIndex_3 );
 
 private:
-    VkDevice device;
+    VkDevice                         device;
+    std::shared_ptr< StagingCopier > copier;
 
 
     template< typename T >
@@ -26,6 +26,7 @@
 #include "RgException.h"
 #include "DX12_CopyFramebuf.h"
 #include "DX12_Interop.h"
+#include "UploadRing.h"
 #include "Utils.h"
 
 #include "Generated/ShaderCommonC.h"
@@ -156,6 +157,8 @@ VkCommandBuffer RTGL1::VulkanDevice::BeginFrame( const RgStartFrameInfo& info )
     cmdManager->PrepareForFrame( frameIndex );
 
     // clear the data that were created MAX_FRAMES_IN_FLIGHT ago
+    frameArenas->PrepareForFrame( frameIndex );
+    memAllocator->GetUploadRing().BeginFrame( frameIndex );
     worldSamplerManager->PrepareForFrame( frameIndex );
     genericSamplerManager->PrepareForFrame( frameIndex );
     textureManager->PrepareForFrame( frameIndex );
@@ -199,9 +202,15 @@ VkCommandBuffer RTGL1::VulkanDevice::BeginFrame( const RgStartFrameInfo& info )
     VkCommandBuffer cmd = cmdManager->StartGraphicsCmd();
     BeginCmdLabel( cmd, "Prepare for frame" );
 
+    textureManager->UploadPending( cmd );
+    textureManager->RecordExports( cmd, frameIndex );
     textureManager->TryHotReload( cmd, frameIndex );
+    textureManager->UploadStreamed( cmd, frameIndex );
+    textureManager->UploadCompressed( cmd, frameIndex );
+    textureManager->ResetFeedback( cmd );
     lightManager->PrepareForFrame( cmd, frameIndex );
     lightManager->SetLightstyles( info );
+    primitiveLightCache->PrepareForFrame();
     scene->PrepareForFrame( cmd,
                             frameIndex,
                             info.ignoreExternalGeometry ||
@@ -324,8 +333,9 @@ void RTGL1::VulkanDevice::FillUniform( RTGL1::ShGlobalUniform* gu,
     }
 
     {
-        gu->lightCount     = lightManager->GetLightCount();
-        gu->lightCountPrev = lightManager->GetLightCountPrev();
+        gu->lightCount         = lightManager->GetLightCount();
+        gu->lightCountPrev     = lightManager->GetLightCountPrev();
+        gu->lightTreeNodeCount = lightManager->GetLightTreeNodeCount();
 
         gu->directionalLightExists = lightManager->DoesDirectionalLightExist();
     }
@@ -402,7 +412,7 @@ void RTGL1::VulkanDevice::FillUniform( RTGL1::ShGlobalUniform* gu,
         gu->polyLightSpotlightFactor   = std::max( 0.0f, params.polygonalLightSpotlightFactor );
         gu->indirSecondBounce          = !!params.enableSecondBounceForIndirect;
         gu->lightIndexIgnoreFPVShadows = lightManager->GetLightIndexForShaders(
-            currentFrameState.GetFrameIndex(), params.lightUniqueIdIgnoreFirstPersonViewerShadows );
+            params.lightUniqueIdIgnoreFirstPersonViewerShadows );
         gu->cellWorldSize       = std::max( params.cellWorldSize, 0.001f );
         gu->gradientMultDiffuse = std::clamp( params.directDiffuseSensitivityToChange, 0.0f, 1.0f );
         gu->gradientMultIndirect =
@@ -482,6 +492,8 @@ void RTGL1::VulkanDevice::FillUniform( RTGL1::ShGlobalUniform* gu,
         RG_SET_VEC3_A( gu->fluidColor, fluidColor.data );
     }
 
+    gu->textureFeedbackEnabled = textureManager->IsFeedbackEnabled();
+
     {
         const auto& params = pnext::get< RgDrawFrameVolumetricParams >( drawInfo );
 
@@ -513,8 +525,8 @@ void RTGL1::VulkanDevice::FillUniform( RTGL1::ShGlobalUniform* gu,
             if( auto uniqueId = scene->TryGetVolumetricLight( *lightManager,
                                                               MakeCameraPosition( cameraInfo ) ) )
             {
-                gu->volumeLightSourceIndex = lightManager->GetLightIndexForShaders(
-                    currentFrameState.GetFrameIndex(), &uniqueId.value() );
+                gu->volumeLightSourceIndex =
+                    lightManager->GetLightIndexForShaders( &uniqueId.value() );
             }
             else
             {
@@ -652,6 +664,9 @@ auto RTGL1::VulkanDevice::Render( VkCommandBuffer& cmd, const RgDrawFrameInfo& d
 
         portalList->SubmitForFrame( cmd, frameIndex );
 
+        // light tree was being built since lightManager->SubmitForFrame
+        lightManager->SubmitLightTree( cmd, frameIndex );
+
         float volumetricMaxHistoryLen =
             resetHistory ? 0
                          : pnext::get< RgDrawFrameVolumetricParams >( drawInfo ).maxHistoryLength;
@@ -1126,9 +1141,14 @@ void RTGL1::VulkanDevice::EndFrame( VkCommandBuffer cmd, FramebufferImageIndex r
     const uint32_t    frameIndex        = currentFrameState.GetFrameIndex();
     const VkSemaphore initFrameFinished = currentFrameState.GetSemaphoreForWaitAndRemove();
 
+    // all texture sampling of the frame is recorded
+    textureManager->CopyFeedback( cmd, frameIndex );
+
     // present debug window
     if( debugWindows && !debugWindows->IsMinimized() )
     {
+        auto devmode = HeapAllocationCounter::ScopedPause{};
+
         VkCommandBuffer debugCmd = cmdManager->StartGraphicsCmd();
         debugWindows->SubmitForFrame( debugCmd, frameIndex );
 
@@ -1346,6 +1366,8 @@ void RTGL1::VulkanDevice::StartFrame( const RgStartFrameInfo* pOriginalInfo )
     }
 
     auto startFrame_Core = [ this ]( const RgStartFrameInfo& info ) {
+        HeapAllocationCounter::Begin();
+
         VkCommandBuffer newFrameCmd = BeginFrame( info );
         currentFrameState.OnBeginFrame( newFrameCmd );
     };
@@ -1412,10 +1434,17 @@ void RTGL1::VulkanDevice::DrawFrame( const RgDrawFrameInfo* pOriginalInfo )
 
         FramebufferImageIndex rendered;
 
+        // all lights of the frame are known
+        lightManager->ApplyBudget( currentFrameState.GetFrameIndex(),
+                                   scene->GetCamera( renderResolution.Aspect() ) );
+
         if( renderResolution.Width() > 0 && renderResolution.Height() > 0 )
         {
             FillUniform( uniform->GetData(), info );
-            Dev_Draw();
+            {
+                auto devmode = HeapAllocationCounter::ScopedPause{};
+                Dev_Draw();
+            }
             rendered = Render( cmd, info );
         }
         else
@@ -1426,6 +1455,9 @@ void RTGL1::VulkanDevice::DrawFrame( const RgDrawFrameInfo* pOriginalInfo )
         EndFrame( cmd, rendered );
         currentFrameState.OnEndFrame();
 
+        // everything from rgStartFrame to the submission of the frame: the uploads,
+        // the recording, and the submission of the frame's jobs
+        frameHeapAllocations = HeapAllocationCounter::End();
 
         sceneImportExport->TryExport( *textureManager, ovrdFolder );
     };
@@ -1672,50 +1704,12 @@ void RTGL1::VulkanDevice::UploadMeshPrimitive( const RgMeshInfo*          pMesh,
             // TODO: remove legacy way to attach lights
             if( auto attachedLight = pnext::find< RgMeshPrimitiveAttachedLightEXT >( &prim ) )
             {
-                bool quad = ( prim.indexCount == 6 && prim.vertexCount == 4 ) ||
-                            ( prim.indexCount == 0 && prim.vertexCount == 6 );
+                bool quad = PrimitiveLightCache::IsQuad( prim );
 
                 if( attachedLight->evenOnDynamic || quad )
                 {
-                    assert( tempStorageLights.empty() );
-
-                    if( quad )
-                    {
-                        auto center = RgFloat3D{ 0, 0, 0 };
-                        {
-                            for( uint32_t v = 0; v < prim.vertexCount; v++ )
-                            {
-                                center.data[ 0 ] += prim.pVertices[ v ].position[ 0 ];
-                                center.data[ 1 ] += prim.pVertices[ v ].position[ 1 ];
-                                center.data[ 2 ] += prim.pVertices[ v ].position[ 2 ];
-                            }
-                            center.data[ 0 ] /= float( prim.vertexCount );
-                            center.data[ 1 ] /= float( prim.vertexCount );
-                            center.data[ 2 ] /= float( prim.vertexCount );
-                        }
-
-                        center.data[ 0 ] += mesh.transform.matrix[ 0 ][ 3 ];
-                        center.data[ 1 ] += mesh.transform.matrix[ 1 ][ 3 ];
-                        center.data[ 2 ] += mesh.transform.matrix[ 2 ][ 3 ];
-
-                        tempStorageLights.emplace_back( RgLightSphericalEXT{
-                            .sType     = RG_STRUCTURE_TYPE_LIGHT_SPHERICAL_EXT,
-                            .pNext     = nullptr,
-                            .color     = attachedLight->color,
-                            .intensity = attachedLight->intensity,
-                            .position  = center,
-                            .radius    = 0.1f,
-                        } );
-                    }
-                    else
-                    {
-                        GltfExporter::MakeLightsForPrimitiveDynamic(
-                            mesh,
-                            prim,
-                            sceneImportExport->GetWorldScale(),
-                            tempStorageInit,
-                            tempStorageLights );
-                    }
+                    auto lights = primitiveLightCache->Get(
+                        mesh, prim, *attachedLight, sceneImportExport->GetWorldScale() );
 
                     auto hashCombine = []< typename T >( uint64_t seed, const T& v ) {
                         seed ^= std::hash< T >{}( v ) + 0x9e3779b9 + ( seed << 6 ) + ( seed >> 2 );
@@ -1733,7 +1727,7 @@ void RTGL1::VulkanDevice::UploadMeshPrimitive( const RgMeshInfo*          pMesh,
 
                     uint64_t counter = 0;
 
-                    for( AnyLightEXT& lext : tempStorageLights )
+                    for( AnyLightEXT lext : lights )
                     {
                         std::visit(
                             [ & ]< typename T >( T& specific ) {
@@ -1752,9 +1746,6 @@ void RTGL1::VulkanDevice::UploadMeshPrimitive( const RgMeshInfo*          pMesh,
 
                         counter++;
                     }
-
-                    tempStorageInit.clear();
-                    tempStorageLights.clear();
                 }
             }
         }
@@ -2000,13 +1991,14 @@ void RTGL1::VulkanDevice::UploadCamera( const RgCameraInfo* pInfo )
     }
 }
 
-void RTGL1::VulkanDevice::UploadLight( const RgLightInfo* pInfo )
+namespace
 {
-    if( pInfo == nullptr )
-    {
-        throw RgException( RG_RESULT_WRONG_FUNCTION_ARGUMENT, "Argument is null" );
-    }
-    if( pInfo->sType != RG_STRUCTURE_TYPE_LIGHT_INFO )
+
+auto MakeLightCopy( const RgLightInfo& info ) -> std::optional< RTGL1::LightCopy >
+{
+    using namespace RTGL1;
+
+    if( info.sType != RG_STRUCTURE_TYPE_LIGHT_INFO )
     {
         throw RgException( RG_RESULT_WRONG_STRUCTURE_TYPE );
     }
@@ -2043,19 +2035,19 @@ void RTGL1::VulkanDevice::UploadLight( const RgLightInfo* pInfo )
         return {};
     };
 
-    auto ext = findExt( *pInfo );
+    auto ext = findExt( info );
     if( !ext )
     {
         debug::Warning( "Couldn't find RgLightDirectionalEXT, RgLightSphericalEXT, RgLightSpotEXT "
                         "or RgLightPolygonalEXT on RgLightInfo (uniqueID={})",
-                        pInfo->uniqueID );
-        return;
+                        info.uniqueID );
+        return {};
     }
 
     auto light = LightCopy{
-        .base       = *pInfo,
+        .base       = info,
         .extension  = *ext,
-        .additional = findAdditional( *pInfo ),
+        .additional = findAdditional( info ),
     };
 
     // reset pNext, as using in-place members
@@ -2068,14 +2060,73 @@ void RTGL1::VulkanDevice::UploadLight( const RgLightInfo* pInfo )
         }
     }
 
+    return light;
+}
+
+}
+
+void RTGL1::VulkanDevice::UploadLight( const RgLightInfo* pInfo )
+{
+    if( pInfo == nullptr )
+    {
+        throw RgException( RG_RESULT_WRONG_FUNCTION_ARGUMENT, "Argument is null" );
+    }
+
+    auto light = MakeLightCopy( *pInfo );
+    if( !light )
+    {
+        return;
+    }
+
     UploadResult r =
-        scene->UploadLight( currentFrameState.GetFrameIndex(), light, *lightManager, false );
+        scene->UploadLight( currentFrameState.GetFrameIndex(), *light, *lightManager, false );
 
     if( auto e = sceneImportExport->TryGetExporter( false ) )
     {
         if( r == UploadResult::ExportableDynamic || r == UploadResult::ExportableStatic )
         {
-            e->AddLight( light );
+            e->AddLight( *light );
+        }
+    }
+}
+
+void RTGL1::VulkanDevice::UploadLights( const RgLightInfo* pInfos, uint32_t count )
+{
+    if( count == 0 )
+    {
+        return;
+    }
+    if( pInfos == nullptr )
+    {
+        throw RgException( RG_RESULT_WRONG_FUNCTION_ARGUMENT, "Argument is null" );
+    }
+
+    const uint32_t frameIndex = currentFrameState.GetFrameIndex();
+    auto&          arena      = frameArenas->Get( frameIndex );
+
+    auto lights = FrameVector< LightCopy >{ &arena };
+    lights.reserve( count );
+
+    for( const RgLightInfo& info : std::span{ pInfos, count } )
+    {
+        if( auto l = MakeLightCopy( info ) )
+        {
+            lights.push_back( *l );
+        }
+    }
+
+    auto results = FrameVector< UploadResult >( lights.size(), UploadResult::Fail, &arena );
+    scene->UploadLights( frameIndex, lights, *lightManager, arena, results );
+
+    if( auto e = sceneImportExport->TryGetExporter( false ) )
+    {
+        for( size_t i = 0; i < lights.size(); i++ )
+        {
+            if( results[ i ] == UploadResult::ExportableDynamic ||
+                results[ i ] == UploadResult::ExportableStatic )
+            {
+                e->AddLight( lights[ i ] );
+            }
         }
     }
 }
@@ -2095,7 +2146,7 @@ void RTGL1::VulkanDevice::ProvideOriginalTexture( const RgOriginalTextureInfo* p
     textureManager->TryCreateMaterial( currentFrameState.GetCmdBufferForMaterials( cmdManager ),
                                        currentFrameState.GetFrameIndex(),
                                        *pInfo,
-                                       ovrdFolder );
+                                       *textureFolderIndex );
 
     // SHIPPING_HACK begin
     if( !Utils::IsCstrEmpty( pInfo->pTextureName ) )
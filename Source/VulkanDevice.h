@@ -61,10 +61,14 @@
 #include "DebugWindows.h"
 #include "ScratchImmediate.h"
 #include "FolderObserver.h"
+#include "JobSystem.h"
+#include "FrameArena.h"
+#include "HeapAllocationCounter.h"
 #include "TextureMeta.h"
 #include "SceneMeta.h"
 #include "DrawFrameInfo.h"
 #include "Fluid.h"
+#include "PrimitiveLightCache.h"
 #include "VulkanDevice_Dev.h"
 // clang-format on
 
@@ -92,6 +96,7 @@ public:
     void UploadCamera( const RgCameraInfo* pInfo );
 
     void UploadLight( const RgLightInfo* pInfo );
+    void UploadLights( const RgLightInfo* pInfos, uint32_t count );
 
     void ProvideOriginalTexture( const RgOriginalTextureInfo* pInfo );
     void ProvideOriginalCubemapTexture( const RgOriginalCubemapInfo* pInfo );
@@ -175,6 +180,11 @@ private:
 
     std::shared_ptr< MemoryAllocator > memAllocator;
 
+    std::shared_ptr< JobSystem >   jobSystem;
+    std::shared_ptr< FrameArenas > frameArenas;
+    // Made by the library from StartFrame to the submission of the last frame
+    uint32_t                       frameHeapAllocations{ 0 };
+
     std::shared_ptr< CommandBufferManager > cmdManager;
 
     std::shared_ptr< Framebuffers >  framebuffers;
@@ -192,6 +202,7 @@ private:
     std::shared_ptr< Rasterizer >                rasterizer;
     std::shared_ptr< PortalList >                portalList;
     std::shared_ptr< LightManager >              lightManager;
+    std::shared_ptr< PrimitiveLightCache >       primitiveLightCache;
     std::shared_ptr< LightGrid >                 lightGrid;
     std::shared_ptr< Denoiser >                  denoiser;
     std::shared_ptr< Tonemapping >               tonemapping;
@@ -221,6 +232,7 @@ private:
     std::shared_ptr< SamplerManager >     worldSamplerManager;
     std::shared_ptr< SamplerManager >     genericSamplerManager;
     std::shared_ptr< BlueNoise >          blueNoise;
+    std::shared_ptr< TextureFolderIndex > textureFolderIndex;
     std::shared_ptr< TextureManager >     textureManager;
     std::shared_ptr< TextureMetaManager > textureMetaManager;
     std::shared_ptr< SceneMetaManager >   sceneMetaManager;
@@ -236,10 +248,6 @@ private:
     
     float lightmapScreenCoverage{ 0 };
 
-    // TODO: remove; used to not allocate on each call
-    std::vector< PositionNormal > tempStorageInit;
-    std::vector< AnyLightEXT >    tempStorageLights;
-
     std::unique_ptr< Devmode > devmode;
 
     bool rayCullBackFacingTriangles;
@@ -20,7 +20,9 @@
 
 #include "VulkanDevice.h"
 
+#include "LibraryConfig.h"
 #include "Matrix.h"
+#include "UploadRing.h"
 
 #include "Generated/ShaderCommonC.h"
 
@@ -544,6 +546,77 @@ void RTGL1::VulkanDevice::Dev_Draw() const
         ImGui::Text( "%.3f ms/frame (%.1f FPS)",
                      1000.0f / ImGui::GetIO().Framerate,
                      ImGui::GetIO().Framerate );
+        {
+            const FrameArena& arena = frameArenas->Get( currentFrameState.GetFrameIndex() );
+            ImGui::Text( "Frame arena: %zu / %zu KB, heap allocations: %u",
+                         arena.GetUsedBytes() / 1024,
+                         arena.GetCapacity() / 1024,
+                         arena.GetHeapAllocationCount() );
+
+            if constexpr( HeapAllocationCounter::IsEnabled() )
+            {
+                ImGui::Text( "Heap allocations in the last frame: %u", frameHeapAllocations );
+            }
+
+            const UploadRing& ring = memAllocator->GetUploadRing();
+            ImGui::Text( "Upload ring: %llu / %llu KB",
+                         static_cast< unsigned long long >( ring.GetUsedBytes() / 1024 ),
+                         static_cast< unsigned long long >( ring.GetCapacity() / 1024 ) );
+
+            const auto upload = textureManager->GetUploadStatistics();
+            ImGui::Text( "Texture staging: %llu / %llu KB, uploaded %llu KB last frame",
+                         static_cast< unsigned long long >( upload.stagingUsedBytes / 1024 ),
+                         static_cast< unsigned long long >( upload.stagingCapacity / 1024 ),
+                         static_cast< unsigned long long >( upload.uploadedBytes / 1024 ) );
+            ImGui::Text( "Textures split across frames: %u (%llu KB), deferred last frame: %u",
+                         upload.pendingCount,
+                         static_cast< unsigned long long >( upload.pendingBytes / 1024 ),
+                         upload.deferredCount );
+
+            const TextureDeduplicator& dedup = textureManager->GetDeduplicator();
+            ImGui::Text( "Shared texture images: %u, saved %llu KB",
+                         dedup.GetSharedImageCount(),
+                         static_cast< unsigned long long >( dedup.GetSavedBytes() / 1024 ) );
+
+            ImGui::Text( "Textures being exported: %u", textureManager->GetExportPendingCount() );
+
+            ImGui::Text( "Streamed textures pending: %u",
+                         textureManager->GetStreamingPendingCount() );
+            if( const TextureResidency* residency = textureManager->GetResidency() )
+            {
+                ImGui::Text( "Mip streaming: %llu / %llu MB, %u textures, %u level changes pending",
+                             static_cast< unsigned long long >( residency->GetResidentBytes() /
+                                                                1024 / 1024 ),
+                             static_cast< unsigned long long >( residency->GetBudgetBytes() /
+                                                                1024 / 1024 ),
+                             residency->GetTrackedCount(),
+                             residency->GetPendingCount() );
+            }
+            ImGui::Text( "Indexed override textures: %zu, packed: %u",
+                         textureFolderIndex->GetFileCount(),
+                         textureFolderIndex->GetPackedCount() );
+
+            const auto blas = scene->GetASManager()->GetBLASMemoryStatistics();
+            ImGui::Text( "BLAS memory: %llu / %llu KB, %u chunks, fragmentation: %.2f",
+                         static_cast< unsigned long long >( blas.used / 1024 ),
+                         static_cast< unsigned long long >( blas.capacity / 1024 ),
+                         blas.chunkCount,
+                         blas.Fragmentation() );
+            ImGui::Text( "Lights: %u, capacity: %u, tree nodes: %u",
+                         lightManager->GetLightCount(),
+                         lightManager->GetLightCapacity(),
+                         lightManager->GetLightTreeNodeCount() );
+            if( LibConfig().lightBudget > 0 || LibConfig().lightCullThreshold > 0 )
+            {
+                const auto& budget = lightManager->GetBudgetStats();
+                ImGui::Text( "Light budget: %u / %u dynamic kept, culled: %u by threshold, "
+                             "%u by budget",
+                             budget.Kept(),
+                             budget.candidates,
+                             budget.culledByThreshold,
+                             budget.culledByBudget );
+            }
+        }
         ImGui::EndTabItem();
 
         ImGui::Text( "Chosen volumetric light: %d",
@@ -232,6 +232,10 @@ RTGL1::VulkanDevice::VulkanDevice( const RgInstanceCreateInfo* info )
     ValidateAndOverrideCreateInfo( info );
 
 
+    jobSystem   = JobSystem::Create( pnext::get< RgInstanceJobSystemEXT >( *info ) );
+    frameArenas = std::make_shared< FrameArenas >( 1024 * 1024 );
+
+
     // init vulkan instance
     CreateInstance( *info );
 
@@ -304,7 +308,7 @@ RTGL1::VulkanDevice::VulkanDevice( const RgInstanceCreateInfo* info )
 
         devmode = std::make_unique<Devmode>();
 
-        observer = std::make_unique< FolderObserver >( ovrdFolder );
+        observer = std::make_unique< FolderObserver >( ovrdFolder, jobSystem );
     }
 
     // for world samplers with modifyable lod biad
@@ -321,11 +325,14 @@ RTGL1::VulkanDevice::VulkanDevice( const RgInstanceCreateInfo* info )
         memAllocator, 
         *cmdManager );
 
+    textureFolderIndex = std::make_shared< TextureFolderIndex >( ovrdFolder );
+
     textureManager = std::make_shared< TextureManager >(
         device, 
         memAllocator, 
         worldSamplerManager,
         cmdManager,
+        jobSystem,
         ovrdFolder / "WaterNormal_n.ktx2",
         ovrdFolder / "DirtMask.ktx2",
         ovrdFolder / "SceneBuildWarning.ktx2",
@@ -354,6 +361,8 @@ RTGL1::VulkanDevice::VulkanDevice( const RgInstanceCreateInfo* info )
         *physDevice,
         memAllocator, 
         cmdManager, 
+        jobSystem,
+        frameArenas,
         *uniform, 
         *shaderManager,
         info->replacementsMaxVertexCount,
@@ -367,6 +376,8 @@ RTGL1::VulkanDevice::VulkanDevice( const RgInstanceCreateInfo* info )
         ovrdFolder / REPLACEMENTS_FOLDER,
         *info );
 
+    primitiveLightCache = std::make_shared< PrimitiveLightCache >( jobSystem );
+
     tonemapping = std::make_shared< Tonemapping >(
         device, 
         framebuffers, 
@@ -403,7 +414,8 @@ RTGL1::VulkanDevice::VulkanDevice( const RgInstanceCreateInfo* info )
 
     lightManager = std::make_shared< LightManager >( 
         device, 
-        memAllocator );
+        memAllocator,
+        jobSystem );
 
     lightGrid = std::make_shared< LightGrid >(
         device,
@@ -547,6 +559,7 @@ RTGL1::VulkanDevice::VulkanDevice( const RgInstanceCreateInfo* info )
 
     if( observer )
     {
+        observer->Subscribe( textureFolderIndex );
         observer->Subscribe( textureManager );
         observer->Subscribe( textureMetaManager );
         observer->Subscribe( sceneMetaManager );
@@ -592,6 +605,8 @@ RTGL1::VulkanDevice::~VulkanDevice()
     effectHDRPrepare.reset();
     denoiser.reset();
     uniform.reset();
+    // frame-scoped objects reference the scene's resources
+    frameArenas->ResetAll();
     scene.reset();
     sceneImportExport.reset();
     shaderManager.reset();
@@ -600,6 +615,7 @@ RTGL1::VulkanDevice::~VulkanDevice()
     rasterizer.reset();
     portalList.reset();
     lightManager.reset();
+    primitiveLightCache.reset();
     lightGrid.reset();
     worldSamplerManager.reset();
     genericSamplerManager.reset();
@@ -610,6 +626,9 @@ RTGL1::VulkanDevice::~VulkanDevice()
     cubemapManager.reset();
     debugWindows.reset();
     devmode.reset();
+    // after all users, as pending jobs reference them
+    jobSystem.reset();
+    frameArenas.reset();
     memAllocator.reset();
 
     vkDestroySurfaceKHR( instance, surface, nullptr );
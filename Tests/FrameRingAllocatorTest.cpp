@@ -0,0 +1,188 @@
+/*
+
+Copyright (c) 2024 V.Shirokii
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+// Standalone checks of FrameRingAllocator, see RG_WITH_TESTS
+
+#include "FrameRingAllocator.h"
+#include "TestCheck.h"
+
+#include <random>
+#include <vector>
+
+using RTGL1::FrameRingAllocator;
+using RTGL1::MAX_FRAMES_IN_FLIGHT;
+
+namespace
+{
+static_assert( MAX_FRAMES_IN_FLIGHT == 2, "Offsets below assume 2 frames in flight" );
+
+void TestReclaimPerFrame()
+{
+    auto ring = FrameRingAllocator{ 100 };
+
+    ring.BeginFrame( 0 );
+    CHECK( ring.Allocate( 60, 1 ) == 0 );
+
+    ring.BeginFrame( 1 );
+    CHECK( ring.Allocate( 40, 1 ) == 60 );
+    CHECK( ring.GetUsedBytes() == 100 );
+    CHECK( !ring.Allocate( 1, 1 ) );
+    CHECK( ring.GetMaxAllocationSize( 1 ) == 0 );
+
+    // only frame 0 is released, frame 1 is still in flight
+    ring.BeginFrame( 0 );
+    CHECK( ring.GetUsedBytes() == 40 );
+    CHECK( !ring.Allocate( 61, 1 ) );
+    CHECK( ring.Allocate( 60, 1 ) == 0 );
+
+    ring.BeginFrame( 1 );
+    CHECK( ring.GetUsedBytes() == 60 );
+
+    // everything is released, so it starts from the beginning
+    ring.BeginFrame( 0 );
+    ring.BeginFrame( 1 );
+    CHECK( ring.GetUsedBytes() == 0 );
+    CHECK( ring.Allocate( 100, 1 ) == 0 );
+}
+
+void TestWrapSkip()
+{
+    auto ring = FrameRingAllocator{ 100 };
+
+    ring.BeginFrame( 0 );
+    CHECK( ring.Allocate( 30, 1 ) == 0 );
+    ring.BeginFrame( 1 );
+    CHECK( ring.Allocate( 50, 1 ) == 30 );
+
+    // [80, 100) is too small for 25 bytes, so it's skipped, and the allocation wraps to 0
+    ring.BeginFrame( 0 );
+    CHECK( ring.GetMaxAllocationSize( 1 ) == 30 );
+    CHECK( ring.Allocate( 25, 1 ) == 0 );
+    CHECK( ring.GetUsedBytes() == 50 + 20 + 25 );
+
+    // the skipped bytes belong to frame 0, they must not be released with frame 1
+    ring.BeginFrame( 1 );
+    CHECK( ring.GetUsedBytes() == 45 );
+    CHECK( !ring.Allocate( 56, 1 ) );
+    CHECK( ring.Allocate( 55, 1 ) == 25 );
+
+    ring.BeginFrame( 0 );
+    CHECK( ring.GetUsedBytes() == 55 );
+    ring.BeginFrame( 1 );
+    CHECK( ring.GetUsedBytes() == 0 );
+}
+
+void TestOverflow()
+{
+    auto ring = FrameRingAllocator{ 64 };
+
+    ring.BeginFrame( 0 );
+    CHECK( !ring.Allocate( 65, 1 ) );
+    CHECK( !ring.Allocate( 0, 1 ) );
+    CHECK( ring.GetUsedBytes() == 0 );
+
+    // alignment padding is consumed too
+    CHECK( ring.Allocate( 10, 1 ) == 0 );
+    CHECK( ring.Allocate( 12, 12 ) == 12 );
+    CHECK( ring.GetUsedBytes() == 24 );
+
+    const uint64_t maxSize = ring.GetMaxAllocationSize( 16 );
+    CHECK( maxSize == 64 - 32 );
+    CHECK( !ring.Allocate( maxSize + 1, 16 ) );
+    CHECK( ring.Allocate( maxSize, 16 ) == 32 );
+    CHECK( !ring.Allocate( 1, 1 ) );
+
+    // failed allocations must not leak
+    ring.BeginFrame( 1 );
+    ring.BeginFrame( 0 );
+    CHECK( ring.GetUsedBytes() == 0 );
+}
+
+// Allocations of the frames in flight must never overlap, whatever the sizes
+void TestRandomNoOverlap()
+{
+    struct Range
+    {
+        uint64_t begin, end;
+    };
+
+    constexpr uint64_t capacity = 1000;
+
+    auto ring = FrameRingAllocator{ capacity };
+    auto rnd  = std::mt19937{ 1 };
+
+    std::vector< Range > live[ MAX_FRAMES_IN_FLIGHT ];
+
+    for( uint32_t frame = 0; frame < 10000; frame++ )
+    {
+        const uint32_t frameIndex = frame % MAX_FRAMES_IN_FLIGHT;
+        ring.BeginFrame( frameIndex );
+        live[ frameIndex ].clear();
+
+        const auto count = std::uniform_int_distribution< int >{ 0, 8 }( rnd );
+        for( int i = 0; i < count; i++ )
+        {
+            const uint64_t size = std::uniform_int_distribution< uint64_t >{ 1, 300 }( rnd );
+            const uint64_t alignment =
+                std::uniform_int_distribution< uint64_t >{ 1, 4 }( rnd ) * 4;
+
+            const uint64_t maxSize = ring.GetMaxAllocationSize( alignment );
+            const auto     offset  = ring.Allocate( size, alignment );
+            CHECK( offset.has_value() == ( size <= maxSize ) );
+            if( !offset )
+            {
+                continue;
+            }
+
+            const auto r = Range{ *offset, *offset + size };
+            CHECK( r.begin % alignment == 0 );
+            CHECK( r.end <= capacity );
+
+            for( const auto& ranges : live )
+            {
+                for( const auto& other : ranges )
+                {
+                    CHECK( r.end <= other.begin || other.end <= r.begin );
+                }
+            }
+            live[ frameIndex ].push_back( r );
+
+            if( RTGL1::test::g_failed > 0 )
+            {
+                return;
+            }
+        }
+    }
+}
+}
+
+int main()
+{
+    TestReclaimPerFrame();
+    TestWrapSkip();
+    TestOverflow();
+    TestRandomNoOverlap();
+
+    return RTGL1::test::Finish( "FrameRingAllocator" );
+}
@@ -0,0 +1,532 @@
+/*
+
+Copyright (c) 2024 V.Shirokii
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+// Standalone checks of LightTree, see RG_WITH_TESTS
+
+#include "LightTree.h"
+#include "TestCheck.h"
+
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <span>
+#include <vector>
+
+using RTGL1::LightTree;
+using RTGL1::ShLightTreeNode;
+
+namespace
+{
+constexpr float PI = 3.14159265358979323846f;
+
+struct Vec3
+{
+    float x, y, z;
+};
+
+Vec3  operator+( Vec3 a, Vec3 b ) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+Vec3  operator-( Vec3 a, Vec3 b ) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+Vec3  operator*( Vec3 a, float k ) { return { a.x * k, a.y * k, a.z * k }; }
+float Dot( Vec3 a, Vec3 b ) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+Vec3  Normalize( Vec3 a ) { return a * ( 1.0f / std::sqrt( Dot( a, a ) ) ); }
+Vec3  ToVec3( const float ( &v )[ 3 ] ) { return { v[ 0 ], v[ 1 ], v[ 2 ] }; }
+
+float CosSubClamped( float sinA, float cosA, float sinB, float cosB )
+{
+    return cosA > cosB ? 1.0f : cosA * cosB + sinA * sinB;
+}
+
+float SinSubClamped( float sinA, float cosA, float sinB, float cosB )
+{
+    return cosA > cosB ? 0.0f : sinA * cosB - cosA * sinB;
+}
+
+// Same as getLightTreeNodeImportance in Shaders/LightTree.h
+float Importance( const float ( &boundsMin )[ 3 ],
+                  const float ( &boundsMax )[ 3 ],
+                  const float ( &axis )[ 3 ],
+                  float       cosTheta_o,
+                  float       cosTheta_e,
+                  float       power,
+                  Vec3        p,
+                  Vec3        n )
+{
+    const Vec3  center   = ( ToVec3( boundsMin ) + ToVec3( boundsMax ) ) * 0.5f;
+    const float radiusSq = Dot( ToVec3( boundsMax ) - center, ToVec3( boundsMax ) - center );
+
+    const float distSq = std::max( Dot( p - center, p - center ), std::sqrt( radiusSq ) );
+
+    const float sinTheta_o = std::sqrt( std::max( 0.0f, 1.0f - cosTheta_o * cosTheta_o ) );
+
+    const Vec3 wi = Normalize( p - center );
+
+    const float cosTheta_w = Dot( ToVec3( axis ), wi );
+    const float sinTheta_w = std::sqrt( std::max( 0.0f, 1.0f - cosTheta_w * cosTheta_w ) );
+
+    const float cosTheta_b =
+        distSq > radiusSq ? std::sqrt( std::max( 0.0f, 1.0f - radiusSq / distSq ) ) : -1.0f;
+    const float sinTheta_b = std::sqrt( std::max( 0.0f, 1.0f - cosTheta_b * cosTheta_b ) );
+
+    const float cosTheta_x = CosSubClamped( sinTheta_w, cosTheta_w, sinTheta_o, cosTheta_o );
+    const float sinTheta_x = SinSubClamped( sinTheta_w, cosTheta_w, sinTheta_o, cosTheta_o );
+    const float cosThetap  = CosSubClamped( sinTheta_x, cosTheta_x, sinTheta_b, cosTheta_b );
+
+    if( cosThetap <= cosTheta_e )
+    {
+        return 0.0f;
+    }
+
+    float importance = power * cosThetap / distSq;
+
+    const float cosTheta_i = std::abs( Dot( wi, n ) );
+    const float sinTheta_i = std::sqrt( std::max( 0.0f, 1.0f - cosTheta_i * cosTheta_i ) );
+    importance *= CosSubClamped( sinTheta_i, cosTheta_i, sinTheta_b, cosTheta_b );
+
+    return std::max( importance, 0.0f );
+}
+
+float NodeImportance( const ShLightTreeNode& node, Vec3 p, Vec3 n )
+{
+    const glm::vec2 cosThetaOE = glm::unpackHalf2x16( node.cosThetaOE );
+    return Importance( node.boundsMin,
+                       node.boundsMax,
+                       node.coneAxis,
+                       cosThetaOE.x,
+                       cosThetaOE.y,
+                       node.power,
+                       p,
+                       n );
+}
+
+// Exact, without the half precision of the nodes
+float ItemImportance( const LightTree::Item& item, Vec3 p, Vec3 n )
+{
+    return Importance( item.boundsMin,
+                       item.boundsMax,
+                       item.axis,
+                       item.cosThetaO,
+                       item.cosThetaE,
+                       item.power,
+                       p,
+                       n );
+}
+
+bool IsLeaf( const ShLightTreeNode& node )
+{
+    return ( node.childOrLightIndex & LIGHT_TREE_LEAF_FLAG ) != 0;
+}
+
+uint32_t LightOf( const ShLightTreeNode& node )
+{
+    return node.childOrLightIndex & ( LIGHT_TREE_LEAF_FLAG - 1 );
+}
+
+struct Traversal
+{
+    // Probability of choosing each light, as sampleLightTree in Shaders/LightTree.h
+    std::vector< double > pdfs;
+    // Lights that were reached by more than one path
+    uint32_t              duplicates{ 0 };
+    uint32_t              maxDepth{ 0 };
+    // Probability that the traversal stops without a light
+    double                lost{ 0 };
+};
+
+void Traverse( std::span< const ShLightTreeNode > nodes,
+               uint32_t                           index,
+               uint32_t                           depth,
+               double                             pdf,
+               Vec3                               p,
+               Vec3                               n,
+               Traversal&                         out )
+{
+    out.maxDepth = std::max( out.maxDepth, depth );
+
+    const ShLightTreeNode& node = nodes[ index ];
+    if( IsLeaf( node ) )
+    {
+        const uint32_t light = LightOf( node );
+        if( light >= out.pdfs.size() )
+        {
+            out.pdfs.resize( light + 1, -1.0 );
+        }
+        out.duplicates += out.pdfs[ light ] >= 0 ? 1 : 0;
+        out.pdfs[ light ] = pdf;
+        return;
+    }
+
+    if( depth + 1 >= LIGHT_TREE_MAX_DEPTH )
+    {
+        out.lost += pdf;
+        return;
+    }
+
+    const uint32_t childA = index + 1;
+    const uint32_t childB = node.childOrLightIndex;
+
+    const float importanceA = NodeImportance( nodes[ childA ], p, n );
+    const float importanceB = NodeImportance( nodes[ childB ], p, n );
+
+    if( importanceA + importanceB <= 0.0f )
+    {
+        // both subtrees are still visited, to check that all lights are there
+        out.lost += pdf;
+        Traverse( nodes, childA, depth + 1, 0.0, p, n, out );
+        Traverse( nodes, childB, depth + 1, 0.0, p, n, out );
+        return;
+    }
+
+    const double probA = double( importanceA ) / ( double( importanceA ) + importanceB );
+    Traverse( nodes, childA, depth + 1, pdf * probA, p, n, out );
+    Traverse( nodes, childB, depth + 1, pdf * ( 1.0 - probA ), p, n, out );
+}
+
+auto MakeItems( uint32_t count, uint32_t seed ) -> std::vector< LightTree::Item >
+{
+    auto rnd   = std::mt19937{ seed };
+    auto u     = std::uniform_real_distribution< float >{ 0.0f, 1.0f };
+    auto items = std::vector< LightTree::Item >{};
+
+    for( uint32_t i = 0; i < count; i++ )
+    {
+        const Vec3  c      = { u( rnd ) * 200 - 100, u( rnd ) * 200 - 100, u( rnd ) * 50 - 25 };
+        const float radius = 0.1f + u( rnd ) * 2;
+        const Vec3  axis   = Normalize( { u( rnd ) * 2 - 1, u( rnd ) * 2 - 1, u( rnd ) * 2 - 1 } );
+
+        auto item = LightTree::Item{
+            .boundsMin  = { c.x - radius, c.y - radius, c.z - radius },
+            .boundsMax  = { c.x + radius, c.y + radius, c.z + radius },
+            .axis       = { axis.x, axis.y, axis.z },
+            .cosThetaO  = -1.0f,
+            .cosThetaE  = 0.0f,
+            .power      = 0.1f + u( rnd ) * 10,
+            .lightIndex = i,
+        };
+
+        switch( i % 3 )
+        {
+            case 0: break; // sphere
+            case 1:        // spot
+                item.cosThetaO = 1.0f;
+                item.cosThetaE = std::cos( u( rnd ) * PI * 0.5f );
+                break;
+            case 2: // one-sided triangle
+                item.cosThetaO = 1.0f;
+                item.cosThetaE = 0.0f;
+                break;
+        }
+
+        items.push_back( item );
+    }
+    return items;
+}
+
+auto WriteNodes( const LightTree& tree ) -> std::vector< ShLightTreeNode >
+{
+    auto nodes = std::vector< ShLightTreeNode >( tree.GetNodeCount() );
+    tree.WriteNodes( nodes, 0 );
+    return nodes;
+}
+
+bool IsSame( std::span< const ShLightTreeNode > a, std::span< const ShLightTreeNode > b )
+{
+    return a.size() == b.size() && std::memcmp( a.data(), b.data(), a.size_bytes() ) == 0;
+}
+
+// Every light is in exactly one leaf, pdfs sum to 1, and a light that contributes
+// to a point is never cut off by the bounds of its parents
+void CheckSampling( std::span< const ShLightTreeNode >  nodes,
+                    std::span< const LightTree::Item > items,
+                    uint32_t                           seed )
+{
+    auto rnd = std::mt19937{ seed };
+    auto u   = std::uniform_real_distribution< float >{ 0.0f, 1.0f };
+
+    for( int test = 0; test < 16; test++ )
+    {
+        const Vec3 p = { u( rnd ) * 240 - 120, u( rnd ) * 240 - 120, u( rnd ) * 60 - 30 };
+        const Vec3 n = Normalize( { u( rnd ) * 2 - 1, u( rnd ) * 2 - 1, u( rnd ) * 2 - 1 } );
+
+        auto t = Traversal{};
+        Traverse( nodes, 0, 0, 1.0, p, n, t );
+
+        CHECK( t.duplicates == 0 );
+        CHECK( t.maxDepth < LIGHT_TREE_MAX_DEPTH );
+
+        double   sum     = t.lost;
+        uint32_t missing = 0;
+        uint32_t cut     = 0;
+        float    maxItem = 0;
+
+        for( const auto& item : items )
+        {
+            if( item.lightIndex >= t.pdfs.size() || t.pdfs[ item.lightIndex ] < 0 )
+            {
+                missing++;
+                continue;
+            }
+            sum += t.pdfs[ item.lightIndex ];
+            maxItem = std::max( maxItem, ItemImportance( item, p, n ) );
+        }
+        for( const auto& item : items )
+        {
+            // ignore the lights that are at the edge of float precision
+            if( missing == 0 && ItemImportance( item, p, n ) > maxItem * 1e-4f &&
+                t.pdfs[ item.lightIndex ] <= 0 )
+            {
+                cut++;
+            }
+        }
+
+        CHECK( missing == 0 );
+        CHECK( std::abs( sum - 1.0 ) < 1e-6 );
+        CHECK( cut == 0 );
+    }
+}
+
+// Each node's cone contains the exact cones of all lights below it
+void CheckCones( std::span< const ShLightTreeNode >  nodes,
+                 std::span< const LightTree::Item > items,
+                 uint32_t                           index,
+                 std::vector< uint32_t >&           lightsBelow )
+{
+    const ShLightTreeNode& node = nodes[ index ];
+    if( IsLeaf( node ) )
+    {
+        lightsBelow.push_back( LightOf( node ) );
+        return;
+    }
+
+    const size_t first = lightsBelow.size();
+    CheckCones( nodes, items, index + 1, lightsBelow );
+    CheckCones( nodes, items, node.childOrLightIndex, lightsBelow );
+
+    const glm::vec2 cosThetaOE = glm::unpackHalf2x16( node.cosThetaOE );
+    const float     thetaO     = std::acos( cosThetaOE.x );
+
+    for( size_t i = first; i < lightsBelow.size(); i++ )
+    {
+        const LightTree::Item& item = items[ lightsBelow[ i ] ];
+        CHECK( item.lightIndex == lightsBelow[ i ] );
+
+        CHECK( cosThetaOE.y <= item.cosThetaE );
+
+        if( thetaO >= PI * 0.999f )
+        {
+            continue;
+        }
+
+        const float cosD =
+            std::clamp( Dot( ToVec3( node.coneAxis ), ToVec3( item.axis ) ), -1.0f, 1.0f );
+
+        CHECK( std::acos( cosD ) + std::acos( item.cosThetaO ) <= thetaO + 1e-4f );
+    }
+}
+
+void TestSampling()
+{
+    const auto items = MakeItems( 2000, 1 );
+
+    auto tree = LightTree{};
+    tree.Build( items );
+    CHECK( tree.GetNodeCount() == LightTree::CalcNodeCount( items.size() ) );
+
+    const auto nodes = WriteNodes( tree );
+    CheckSampling( nodes, items, 2 );
+
+    auto leaves = std::vector< uint32_t >{};
+    CheckCones( nodes, items, 0, leaves );
+    CHECK( leaves.size() == items.size() );
+
+    // single light
+    tree.Build( std::span( items ).first( 1 ) );
+    CHECK( tree.GetNodeCount() == 1 );
+    CheckSampling( WriteNodes( tree ), std::span( items ).first( 1 ), 3 );
+}
+
+void TestDepth()
+{
+    auto l_maxDepth = []( const LightTree& tree ) {
+        const auto nodes = WriteNodes( tree );
+
+        auto t = Traversal{};
+        Traverse( nodes, 0, 0, 1.0, { 0, 0, 0 }, { 0, 0, 1 }, t );
+        return t.maxDepth;
+    };
+
+    // all at the same point: only median splits
+    {
+        auto items = std::vector< LightTree::Item >( 100000, MakeItems( 1, 4 )[ 0 ] );
+        for( uint32_t i = 0; i < items.size(); i++ )
+        {
+            items[ i ].lightIndex = i;
+        }
+
+        auto tree = LightTree{};
+        tree.Build( items );
+        CHECK( l_maxDepth( tree ) <= 17 );
+    }
+
+    // exponentially spaced, so SAH peels off one light at a time
+    {
+        auto items = MakeItems( 5000, 5 );
+        for( uint32_t i = 0; i < items.size(); i++ )
+        {
+            const float x = std::pow( 1.015f, float( i ) );
+            items[ i ].boundsMin[ 0 ] = x;
+            items[ i ].boundsMax[ 0 ] = x;
+            items[ i ].power          = 1.0f;
+        }
+
+        auto tree = LightTree{};
+        tree.Build( items );
+
+        // one more for a joined root
+        CHECK( l_maxDepth( tree ) + 1 < LIGHT_TREE_MAX_DEPTH );
+    }
+}
+
+void TestRefit()
+{
+    const auto items = MakeItems( 3000, 6 );
+
+    auto moved = items;
+    {
+        auto rnd = std::mt19937{ 7 };
+        auto u   = std::uniform_real_distribution< float >{ -1.0f, 1.0f };
+        for( auto& item : moved )
+        {
+            const float d[] = { u( rnd ), u( rnd ), u( rnd ) };
+            for( int k = 0; k < 3; k++ )
+            {
+                item.boundsMin[ k ] += d[ k ];
+                item.boundsMax[ k ] += d[ k ];
+            }
+            item.power *= 1.0f + 0.5f * u( rnd );
+        }
+    }
+
+    auto built = LightTree{};
+    built.Build( items );
+    const auto builtNodes = WriteNodes( built );
+
+    auto refitted = LightTree{};
+    refitted.Build( items );
+
+    // same items: exactly the same nodes
+    CHECK( refitted.Refit( items ) );
+    CHECK( IsSame( WriteNodes( refitted ), builtNodes ) );
+
+    // moved items: a valid tree over them, with the same root as a fresh build has
+    CHECK( refitted.Refit( moved ) );
+    {
+        auto fresh = LightTree{};
+        fresh.Build( moved );
+
+        const auto a = WriteNodes( refitted );
+        const auto b = WriteNodes( fresh );
+
+        for( int k = 0; k < 3; k++ )
+        {
+            CHECK( a[ 0 ].boundsMin[ k ] == b[ 0 ].boundsMin[ k ] );
+            CHECK( a[ 0 ].boundsMax[ k ] == b[ 0 ].boundsMax[ k ] );
+        }
+        CHECK( std::abs( a[ 0 ].power - b[ 0 ].power ) <= b[ 0 ].power * 1e-4f );
+
+        CheckSampling( a, moved, 8 );
+
+        auto leaves = std::vector< uint32_t >{};
+        CheckCones( a, moved, 0, leaves );
+    }
+
+    // and back
+    CHECK( refitted.Refit( items ) );
+    CHECK( IsSame( WriteNodes( refitted ), builtNodes ) );
+
+    // other items
+    CHECK( !refitted.Refit( std::span( items ).first( items.size() - 1 ) ) );
+
+    // too spread out
+    auto scattered = items;
+    for( auto& item : scattered )
+    {
+        for( int k = 0; k < 3; k++ )
+        {
+            item.boundsMin[ k ] *= 100.0f;
+            item.boundsMax[ k ] *= 100.0f;
+        }
+        std::swap( item.boundsMin[ 0 ], item.boundsMin[ 1 ] );
+        std::swap( item.boundsMax[ 0 ], item.boundsMax[ 1 ] );
+    }
+    CHECK( !refitted.Refit( scattered ) );
+}
+
+// Static and dynamic trees in one array, as LightManager places them
+void TestJoined()
+{
+    auto staticItems  = MakeItems( 1500, 9 );
+    auto dynamicItems = MakeItems( 500, 10 );
+    for( auto& item : dynamicItems )
+    {
+        item.lightIndex += uint32_t( staticItems.size() );
+    }
+
+    auto staticTree  = LightTree{};
+    auto dynamicTree = LightTree{};
+    staticTree.Build( staticItems );
+    dynamicTree.Build( dynamicItems );
+
+    const uint32_t dynamicOffset = 1 + staticTree.GetNodeCount();
+
+    auto nodes = std::vector< ShLightTreeNode >(
+        LightTree::CalcNodeCount( staticItems.size() + dynamicItems.size() ) );
+    CHECK( nodes.size() == dynamicOffset + dynamicTree.GetNodeCount() );
+
+    LightTree::WriteJoinedRoot( staticTree, dynamicTree, dynamicOffset, nodes[ 0 ] );
+    staticTree.WriteNodes( std::span( nodes ).subspan( 1, staticTree.GetNodeCount() ), 1 );
+    dynamicTree.WriteNodes( std::span( nodes ).subspan( dynamicOffset ), dynamicOffset );
+
+    auto all = staticItems;
+    all.insert( all.end(), dynamicItems.begin(), dynamicItems.end() );
+
+    CheckSampling( nodes, all, 11 );
+
+    auto leaves = std::vector< uint32_t >{};
+    CheckCones( nodes, all, 0, leaves );
+    CHECK( leaves.size() == all.size() );
+}
+}
+
+int main()
+{
+    TestSampling();
+    TestDepth();
+    TestRefit();
+    TestJoined();
+
+    return RTGL1::test::Finish( "LightTree" );
+}
@@ -0,0 +1,63 @@
+/*
+
+Copyright (c) 2024 V.Shirokii
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+// Checks shared by the standalone tests, see RG_WITH_TESTS
+
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+namespace RTGL1::test
+{
+
+// Count of the failed CHECKs in this test executable
+inline int g_failed = 0;
+
+// Print the result, and return the exit code for main
+inline int Finish( const char* testName )
+{
+    if( g_failed > 0 )
+    {
+        std::printf( "%s: %d check(s) failed\n", testName, g_failed );
+        return EXIT_FAILURE;
+    }
+
+    std::printf( "%s: OK\n", testName );
+    return EXIT_SUCCESS;
+}
+
+}
+
+// Unlike assert, doesn't stop the test, and is not removed in release builds
+#define CHECK( x )                                                              \
+    do                                                                          \
+    {                                                                           \
+        if( !( x ) )                                                            \
+        {                                                                       \
+            std::printf( "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #x ); \
+            RTGL1::test::g_failed++;                                            \
+        }                                                                       \
+    } while( false )
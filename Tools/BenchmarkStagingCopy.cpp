@@ -0,0 +1,80 @@
+// Compares plain memcpy against RTGL1::StagingCopier
+// (streaming stores, split across job system's worker threads).
+//
+// Built as the RtglBenchmarkStagingCopy target, if RG_WITH_TOOLS is enabled.
+//
+// Note: the destination here is ordinary cached memory. To measure
+// the real-world case, the destination must be a mapped HOST_VISIBLE
+// (write-combined) Vulkan allocation, e.g. VertexCollector's staging.
+
+#include "DebugPrint.h"
+#include "StagingCopy.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+// normally defined in RTGL1.cpp
+namespace RTGL1::debug::detail
+{
+DebugPrintFn           g_print{};
+RgMessageSeverityFlags g_printSeverity{ 0 };
+bool                   g_breakOnError{ false };
+}
+
+namespace
+{
+
+template< typename F >
+double MeasureGBps( size_t size, int iterations, F&& f )
+{
+    f(); // warm up
+
+    auto begin = std::chrono::high_resolution_clock::now();
+    for( int i = 0; i < iterations; i++ )
+    {
+        f();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    double seconds = std::chrono::duration< double >( end - begin ).count();
+    return double( size ) * iterations / seconds / ( 1024.0 * 1024.0 * 1024.0 );
+}
+
+}
+
+int main()
+{
+    const size_t   sizes[]   = { 64 * 1024, 1024 * 1024, 16 * 1024 * 1024, 128 * 1024 * 1024 };
+    const uint32_t workers[] = { 0, 1, 3, 7 };
+
+    auto jobSystem = std::make_shared< RTGL1::JobSystem >( 7 );
+
+    for( size_t size : sizes )
+    {
+        auto src = std::vector< uint8_t >( size, 0xAB );
+        auto dst = std::vector< uint8_t >( size, 0 );
+
+        const int iterations = int( std::max< size_t >( 4, ( 1024ull * 1024 * 1024 ) / size ) );
+
+        double plain = MeasureGBps(
+            size, iterations, [ & ] { memcpy( dst.data(), src.data(), size ); } );
+
+        printf( "%9zu KB | memcpy: %6.2f GB/s", size / 1024, plain );
+
+        for( uint32_t w : workers )
+        {
+            auto copier = RTGL1::StagingCopier{ jobSystem, w, 0 };
+
+            double streaming = MeasureGBps(
+                size, iterations, [ & ] { copier.Copy( dst.data(), src.data(), size ); } );
+
+            printf( " | %u workers: %6.2f GB/s", w, streaming );
+        }
+        printf( "\n" );
+    }
+
+    return 0;
+}
@@ -0,0 +1,218 @@
+// Packs all KTX2 files of an override folder's "mat" subfolder into a single
+// texture pack file, that RTGL1 memory-maps instead of opening loose files.
+// Loose files still take precedence over the packed ones at runtime.
+//
+// Usage:
+//   RtglTexturePacker <override folder> [output file]
+// Output defaults to "<override folder>/mat.rtpack".
+//
+// Build with RG_WITH_TOOLS CMake option, or, for example:
+//   g++ -std=c++23 -O2 -I../Source -I../Include TexturePacker.cpp
+//       ../Source/TexturePack.cpp ../Source/MappedFile.cpp
+
+#include "Const.h"
+#include "DebugPrint.h"
+#include "TexturePack.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <tuple>
+#include <vector>
+
+// normally defined in RTGL1.cpp
+namespace RTGL1::debug::detail
+{
+DebugPrintFn           g_print{};
+RgMessageSeverityFlags g_printSeverity{ 0 };
+bool                   g_breakOnError{ false };
+}
+
+namespace fs = std::filesystem;
+using namespace RTGL1;
+
+namespace
+{
+
+struct Source
+{
+    fs::path           path;
+    std::string        key;
+    texturepack::Entry entry;
+};
+
+std::vector< uint8_t > ReadFile( const fs::path& path )
+{
+    auto f = std::ifstream( path, std::ios::binary | std::ios::ate );
+    if( !f )
+    {
+        return {};
+    }
+
+    auto bytes = std::vector< uint8_t >( size_t( f.tellg() ) );
+    f.seekg( 0 );
+    f.read( reinterpret_cast< char* >( bytes.data() ), std::streamsize( bytes.size() ) );
+    return f ? bytes : std::vector< uint8_t >{};
+}
+
+uint64_t AlignUp( uint64_t v, uint64_t alignment )
+{
+    return ( v + alignment - 1 ) / alignment * alignment;
+}
+
+bool IsKtx2( const fs::path& p )
+{
+    auto ext = p.extension().string();
+    std::ranges::transform( ext, ext.begin(), []( unsigned char c ) { return std::tolower( c ); } );
+    return ext == ".ktx2";
+}
+
+}
+
+int main( int argc, char* argv[] )
+{
+    if( argc < 2 )
+    {
+        std::printf( "Usage: %s <override folder> [output file]\n", argv[ 0 ] );
+        return 1;
+    }
+
+    const auto texturesFolder = fs::path( argv[ 1 ] ) / TEXTURES_FOLDER;
+    const auto outputPath =
+        argc >= 3 ? fs::path( argv[ 2 ] ) : fs::path( argv[ 1 ] ) / TEXTURES_PACK;
+
+    if( !fs::is_directory( texturesFolder ) )
+    {
+        std::printf( "Folder doesn't exist: %s\n", texturesFolder.string().c_str() );
+        return 1;
+    }
+
+
+    auto sources = std::vector< Source >{};
+
+    for( const auto& e : fs::recursive_directory_iterator( texturesFolder ) )
+    {
+        if( !e.is_regular_file() || !IsKtx2( e.path() ) )
+        {
+            continue;
+        }
+
+        auto bytes = ReadFile( e.path() );
+        auto entry = texturepack::DescribeKtx2( bytes );
+        if( !entry )
+        {
+            std::printf( "Skipping, not a valid KTX2: %s\n", e.path().string().c_str() );
+            continue;
+        }
+
+        auto relative = e.path().lexically_relative( texturesFolder ).replace_extension();
+
+        sources.push_back( Source{
+            .path  = e.path(),
+            .key   = texturepack::MakeKey( relative.generic_string() ),
+            .entry = *entry,
+        } );
+    }
+
+    for( auto& s : sources )
+    {
+        s.entry.keyHash = texturepack::HashKey( s.key );
+    }
+
+    std::ranges::sort( sources, []( const Source& a, const Source& b ) {
+        return std::tie( a.entry.keyHash, a.key ) < std::tie( b.entry.keyHash, b.key );
+    } );
+
+    // keys are case-insensitive, keep only the first
+    {
+        auto dups = std::ranges::unique( sources, []( const Source& a, const Source& b ) {
+            return a.key == b.key;
+        } );
+        for( const auto& d : dups )
+        {
+            std::printf( "Skipping, same name differs only in case: %s\n",
+                         d.path.string().c_str() );
+        }
+        sources.erase( dups.begin(), dups.end() );
+    }
+
+
+    // layout
+    auto header = texturepack::Header{
+        .magic         = {},
+        .version       = texturepack::Version,
+        .entryCount    = uint32_t( sources.size() ),
+        .namesSize     = 0,
+        .entriesOffset = sizeof( texturepack::Header ),
+        .namesOffset   = 0,
+    };
+    std::ranges::copy( texturepack::Magic, header.magic );
+
+    auto names = std::string{};
+    for( auto& s : sources )
+    {
+        s.entry.nameOffset = uint32_t( names.size() );
+        s.entry.nameLength = uint32_t( s.key.size() );
+        names += s.key;
+    }
+    header.namesOffset = header.entriesOffset + sources.size() * sizeof( texturepack::Entry );
+    header.namesSize   = uint32_t( names.size() );
+
+    uint64_t dataOffset = header.namesOffset + header.namesSize;
+    for( auto& s : sources )
+    {
+        dataOffset         = AlignUp( dataOffset, texturepack::DataAlignment );
+        s.entry.dataOffset = dataOffset;
+        s.entry.dataSize   = fs::file_size( s.path );
+        dataOffset += s.entry.dataSize;
+    }
+
+
+    // write
+    auto out = std::ofstream( outputPath, std::ios::binary | std::ios::trunc );
+    if( !out )
+    {
+        std::printf( "Can't open for writing: %s\n", outputPath.string().c_str() );
+        return 1;
+    }
+
+    auto writeAt = [ &out ]( uint64_t offset, const void* data, size_t size ) {
+        // fill alignment gaps with zeros
+        while( uint64_t( out.tellp() ) < offset )
+        {
+            out.put( 0 );
+        }
+        out.write( static_cast< const char* >( data ), std::streamsize( size ) );
+    };
+
+    writeAt( 0, &header, sizeof( header ) );
+    for( size_t i = 0; i < sources.size(); i++ )
+    {
+        writeAt( header.entriesOffset + i * sizeof( texturepack::Entry ),
+                 &sources[ i ].entry,
+                 sizeof( texturepack::Entry ) );
+    }
+    writeAt( header.namesOffset, names.data(), names.size() );
+    for( const auto& s : sources )
+    {
+        auto bytes = ReadFile( s.path );
+        if( bytes.size() != s.entry.dataSize )
+        {
+            std::printf( "File was changed while packing: %s\n", s.path.string().c_str() );
+            return 1;
+        }
+        writeAt( s.entry.dataOffset, bytes.data(), bytes.size() );
+    }
+
+    if( !out )
+    {
+        std::printf( "Failed to write: %s\n", outputPath.string().c_str() );
+        return 1;
+    }
+
+    std::printf( "Packed %zu textures into %s (%llu KB)\n",
+                 sources.size(),
+                 outputPath.string().c_str(),
+                 static_cast< unsigned long long >( dataOffset / 1024 ) );
+    return 0;
+}